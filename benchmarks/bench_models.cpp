@@ -0,0 +1,29 @@
+#define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_NO_STB_IMAGE
+#define TINYGLTF_NO_STB_IMAGE_WRITE
+#define TINYGLTF_NO_EXTERNAL_IMAGE
+#include "bench_models.h"
+
+#include <stdexcept>
+
+namespace {
+    bool KeepImageBytes(tinygltf::Image* image, const int image_idx, std::string* err, std::string* warn, int req_width, int req_height, const unsigned char* bytes, int size, void* user_data) {
+        image->image.assign(bytes, bytes + size);
+        return true;
+    }
+}
+
+std::filesystem::path getBenchModelPath(const std::string& file_name) {
+    return std::filesystem::path(MASIC_OBJECTS_DIR) / file_name;
+}
+
+void loadBenchModel(const std::filesystem::path& model_path, tinygltf::Model& model) {
+    tinygltf::TinyGLTF gltf_ctx;
+    gltf_ctx.SetImageLoader(KeepImageBytes, nullptr);
+
+    std::string load_error;
+    std::string load_warning;
+    if(!gltf_ctx.LoadASCIIFromFile(&model, &load_error, &load_warning, model_path.string())) {
+        throw std::runtime_error("failed to load " + model_path.string() + ": " + load_error + " !");
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "tiny_gltf.h"
+
+#include <filesystem>
+#include <string>
+
+// glTF models of data/objects for the benchmarks. Images keep their encoded bytes, external ones are not read.
+std::filesystem::path getBenchModelPath(const std::string& file_name);
+// Throws when the file does not load.
+void loadBenchModel(const std::filesystem::path& model_path, tinygltf::Model& model);
@@ -0,0 +1,60 @@
+#include <benchmark/benchmark.h>
+
+#include "../src/tools/bounded_mpmc_queue.h"
+#include "../src/tools/thread_safe_queue.h"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Throughput of the two ConcurrentQueue backends: producers push their share of the values through one queue while
+// consumers pop theirs with WaitAndPop. The ring keeps its default capacity, producers block on it while it is full.
+namespace {
+    constexpr uint64_t VALUES_PER_ITERATION = 1u << 16u;
+
+    template<typename Queue>
+    void BM_QueueThroughput(benchmark::State& state) {
+        const uint64_t producers = static_cast<uint64_t>(state.range(0));
+        const uint64_t consumers = static_cast<uint64_t>(state.range(1));
+        const uint64_t values_per_producer = VALUES_PER_ITERATION / producers;
+        const uint64_t values_per_consumer = values_per_producer * producers / consumers;
+
+        Queue queue;
+        for(auto _ : state) {
+            std::vector<std::thread> threads;
+            threads.reserve(producers + consumers);
+            for(uint64_t consumer = 0u; consumer < consumers; ++consumer) {
+                threads.emplace_back([&queue, values_per_consumer]() {
+                    uint64_t value = 0u;
+                    for(uint64_t i = 0u; i < values_per_consumer; ++i) {
+                        queue.WaitAndPop(value);
+                    }
+                    benchmark::DoNotOptimize(value);
+                });
+            }
+            for(uint64_t producer = 0u; producer < producers; ++producer) {
+                threads.emplace_back([&queue, values_per_producer]() {
+                    for(uint64_t i = 0u; i < values_per_producer; ++i) {
+                        queue.Push(i);
+                    }
+                });
+            }
+            for(std::thread& thread : threads) {
+                thread.join();
+            }
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * values_per_producer * producers));
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_QueueThroughput, ThreadSafeQueue<uint64_t>)
+    ->ArgsProduct({{1, 4, 16}, {1, 4}})
+    ->ArgNames({"producers", "consumers"})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(BM_QueueThroughput, BoundedMPMCQueue<uint64_t>)
+    ->ArgsProduct({{1, 4, 16}, {1, 4}})
+    ->ArgNames({"producers", "consumers"})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
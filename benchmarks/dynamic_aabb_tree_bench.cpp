@@ -0,0 +1,114 @@
+#include <benchmark/benchmark.h>
+
+#include "../src/physics/dynamic_aabb_tree.h"
+#include "../src/physics/frustum_culler.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// DynamicAABBTree against the flat FrustumCuller it is meant to sit in front of. The boxes are scattered through a
+// cube whose side grows with the count so the density stays the same, the camera sees a fixed fraction of them.
+namespace {
+    std::vector<BoundingBox> scatterBoxes(size_t count) {
+        const float half_side = 10.0f * std::cbrt(static_cast<float>(count));
+        std::mt19937 rng(42u);
+        std::uniform_real_distribution<float> position(-half_side, half_side);
+        std::uniform_real_distribution<float> size(0.2f, 2.0f);
+        std::vector<BoundingBox> boxes;
+        boxes.reserve(count);
+        for (size_t i = 0u; i < count; ++i) {
+            boxes.emplace_back(glm::vec3(position(rng), position(rng), position(rng)), glm::vec3(size(rng), size(rng), size(rng)));
+        }
+        return boxes;
+    }
+
+    BoundingFrustum cameraFrustum(size_t count) {
+        const float far_plane = 10.0f * std::cbrt(static_cast<float>(count));
+        const BoundingFrustum view_frustum(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, far_plane));
+        BoundingFrustum world_frustum;
+        view_frustum.Transform(world_frustum, glm::rotate(glm::mat4(1.0f), glm::radians(30.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+        return world_frustum;
+    }
+
+    void BM_TreeBuild(benchmark::State& state) {
+        const std::vector<BoundingBox> boxes = scatterBoxes(static_cast<size_t>(state.range(0)));
+        for (auto _ : state) {
+            DynamicAABBTree tree;
+            for (uint32_t i = 0u; i < boxes.size(); ++i) {
+                tree.createProxy(boxes[i], i);
+            }
+            benchmark::DoNotOptimize(tree.getHeight());
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * boxes.size()));
+    }
+
+    // Every proxy moves once per iteration, a small step stays inside the fat box, a large one reinserts the leaf.
+    void BM_TreeMove(benchmark::State& state) {
+        std::vector<BoundingBox> boxes = scatterBoxes(static_cast<size_t>(state.range(0)));
+        const float step = static_cast<float>(state.range(1)) * 0.01f;
+        DynamicAABBTree tree;
+        std::vector<DynamicAABBTree::ProxyId> proxies;
+        proxies.reserve(boxes.size());
+        for (uint32_t i = 0u; i < boxes.size(); ++i) {
+            proxies.push_back(tree.createProxy(boxes[i], i));
+        }
+
+        float direction = 1.0f;
+        for (auto _ : state) {
+            size_t reinserted = 0u;
+            for (size_t i = 0u; i < boxes.size(); ++i) {
+                boxes[i].Center.x += step * direction;
+                reinserted += tree.moveProxy(proxies[i], boxes[i]) ? 1u : 0u;
+            }
+            direction = -direction;
+            benchmark::DoNotOptimize(reinserted);
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * boxes.size()));
+    }
+
+    void BM_TreeQueryFrustum(benchmark::State& state) {
+        const std::vector<BoundingBox> boxes = scatterBoxes(static_cast<size_t>(state.range(0)));
+        DynamicAABBTree tree;
+        for (uint32_t i = 0u; i < boxes.size(); ++i) {
+            tree.createProxy(boxes[i], i);
+        }
+        const BoundingFrustum frustum = cameraFrustum(boxes.size());
+
+        std::vector<uint32_t> visible(boxes.size());
+        size_t count = 0u;
+        for (auto _ : state) {
+            count = tree.queryFrustum(frustum, visible.data(), visible.size());
+            benchmark::DoNotOptimize(visible.data());
+        }
+        state.counters["visible"] = static_cast<double>(count);
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * boxes.size()));
+    }
+
+    void BM_CullerFrustum(benchmark::State& state) {
+        const std::vector<BoundingBox> boxes = scatterBoxes(static_cast<size_t>(state.range(0)));
+        FrustumCuller culler;
+        culler.reserve(boxes.size());
+        for (const BoundingBox& box : boxes) {
+            culler.add(box);
+        }
+        culler.setFrustum(cameraFrustum(boxes.size()));
+
+        std::vector<uint32_t> visible;
+        visible.reserve(boxes.size());
+        for (auto _ : state) {
+            culler.cull(visible);
+            benchmark::DoNotOptimize(visible.data());
+        }
+        state.counters["visible"] = static_cast<double>(visible.size());
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * boxes.size()));
+    }
+}
+
+BENCHMARK(BM_TreeBuild)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TreeMove)->ArgsProduct({{10000, 100000}, {5, 50}})->ArgNames({"proxies", "step_cm"})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TreeQueryFrustum)->Arg(10000)->Arg(100000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CullerFrustum)->Arg(10000)->Arg(100000)->Unit(benchmark::kMicrosecond);
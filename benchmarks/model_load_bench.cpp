@@ -0,0 +1,180 @@
+#include <benchmark/benchmark.h>
+
+#include "bench_models.h"
+#include "../src/scene/gltf_geometry.h"
+#include "../src/scene/gltf_model_snapshot.h"
+#include "../src/scene/mesh_cache.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The stages of loading woman.gltf that MeshNodeLoader goes through: the tinygltf parse and the conversion of its
+// primitives, or a hit in the mesh cache that reads back the model snapshot and the converted primitives instead.
+namespace {
+    // Vertex input of phong_anim.vert, the skinned Phong shader. woman.gltf has no tangents, they are left zeroed.
+    GltfVertexLayout getSkinnedLayout(const tinygltf::Primitive& primitive) {
+        const GltfVertexAttribute shader_attributes[] = {
+            { "POSITION", 0u, VertexComponentType::FLOAT32, 3u },
+            { "NORMAL", 12u, VertexComponentType::FLOAT32, 3u },
+            { "TANGENT", 24u, VertexComponentType::FLOAT32, 3u },
+            { "TEXCOORD_0", 36u, VertexComponentType::FLOAT32, 2u },
+            { "JOINTS_0", 44u, VertexComponentType::UINT32, 4u },
+            { "WEIGHTS_0", 60u, VertexComponentType::FLOAT32, 4u },
+        };
+
+        GltfVertexLayout layout;
+        layout.vertex_size = 76u;
+        for (const GltfVertexAttribute& attribute : shader_attributes) {
+            if (primitive.attributes.contains(attribute.semantic)) {
+                layout.attributes.push_back(attribute);
+            }
+        }
+        return layout;
+    }
+
+    std::vector<GltfPrimitiveGeometry> makeGeometries(const tinygltf::Model& model, bool optimize) {
+        std::vector<GltfPrimitiveGeometry> geometries;
+        for (size_t mesh_idx = 0u; mesh_idx < model.meshes.size(); ++mesh_idx) {
+            for (size_t primitive_idx = 0u; primitive_idx < model.meshes[mesh_idx].primitives.size(); ++primitive_idx) {
+                GltfPrimitiveGeometry& geometry = geometries.emplace_back();
+                geometry.mesh_idx = static_cast<int>(mesh_idx);
+                geometry.primitive_idx = static_cast<int>(primitive_idx);
+                geometry.layout = getSkinnedLayout(model.meshes[mesh_idx].primitives[primitive_idx]);
+                geometry.optimize = optimize;
+            }
+        }
+        return geometries;
+    }
+
+    const tinygltf::Model& getWomanModel() {
+        static const tinygltf::Model model = []() {
+            tinygltf::Model model;
+            loadBenchModel(getBenchModelPath("woman.gltf"), model);
+            return model;
+        }();
+        return model;
+    }
+
+    std::vector<std::string> getExternalUris(const tinygltf::Model& model) {
+        std::vector<std::string> external_uris;
+        for (const tinygltf::Buffer& buffer : model.buffers) {
+            external_uris.push_back(buffer.uri);
+        }
+        for (const tinygltf::Image& image : model.images) {
+            external_uris.push_back(image.uri);
+        }
+        return external_uris;
+    }
+
+    // Written once per run to the temp directory, the models in the source tree keep their own cache files.
+    struct WomanCache {
+        std::filesystem::path cache_path;
+        std::vector<uint64_t> keys;
+    };
+
+    const WomanCache& getWomanCache() {
+        static const WomanCache woman = []() {
+            const tinygltf::Model& model = getWomanModel();
+            WomanCache woman;
+            woman.cache_path = std::filesystem::temp_directory_path() / "masic_bench_woman.meshcache";
+
+            std::vector<GltfPrimitiveGeometry> geometries = makeGeometries(model, true);
+            convertGltfPrimitives(model, geometries, nullptr);
+
+            MeshCache cache;
+            cache.open(woman.cache_path, getBenchModelPath("woman.gltf"));
+            cache.setModel(writeGltfModelSnapshot(model), getExternalUris(model));
+            for (GltfPrimitiveGeometry& geometry : geometries) {
+                const uint64_t key = MeshCache::makeKey(geometry.mesh_idx, static_cast<size_t>(geometry.primitive_idx), geometry.layout, true);
+                cache.add(key, std::move(geometry.vertices), std::move(geometry.indices), geometry.aabb);
+                woman.keys.push_back(key);
+            }
+            cache.save();
+            return woman;
+        }();
+        return woman;
+    }
+
+    void BM_WomanParse(benchmark::State& state) {
+        const std::filesystem::path model_path = getBenchModelPath("woman.gltf");
+        for (auto _ : state) {
+            tinygltf::Model model;
+            loadBenchModel(model_path, model);
+            benchmark::DoNotOptimize(model.accessors.data());
+        }
+    }
+
+    // Arg: 1 with the vertex cache, overdraw and fetch optimization, 0 conversion only.
+    void BM_WomanConvertPrimitives(benchmark::State& state) {
+        const tinygltf::Model& model = getWomanModel();
+        const bool optimize = state.range(0) != 0;
+        size_t vertex_bytes = 0u;
+        for (auto _ : state) {
+            std::vector<GltfPrimitiveGeometry> geometries = makeGeometries(model, optimize);
+            convertGltfPrimitives(model, geometries, nullptr);
+            vertex_bytes = 0u;
+            for (const GltfPrimitiveGeometry& geometry : geometries) {
+                vertex_bytes += geometry.vertices.size() + geometry.indices.size() * sizeof(uint32_t);
+            }
+            benchmark::DoNotOptimize(geometries.data());
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * vertex_bytes));
+    }
+
+    // Opening the cache: the stamp of the model and its external files, the header and the entry table.
+    void BM_WomanMeshCacheOpen(benchmark::State& state) {
+        const WomanCache& woman = getWomanCache();
+        const std::filesystem::path model_path = getBenchModelPath("woman.gltf");
+        for (auto _ : state) {
+            MeshCache cache;
+            if (!cache.open(woman.cache_path, model_path)) {
+                state.SkipWithError("the mesh cache did not open");
+                break;
+            }
+        }
+    }
+
+    // A whole hit, what replaces the parse and the conversion: opening the cache, reading the model back from its
+    // snapshot and copying every primitive out, as to staging.
+    void BM_WomanMeshCacheHit(benchmark::State& state) {
+        const WomanCache& woman = getWomanCache();
+        const std::filesystem::path model_path = getBenchModelPath("woman.gltf");
+        std::vector<char> staging;
+        size_t vertex_bytes = 0u;
+        for (auto _ : state) {
+            MeshCache cache;
+            const unsigned char* snapshot = nullptr;
+            size_t snapshot_size = 0u;
+            tinygltf::Model model;
+            if (!cache.open(woman.cache_path, model_path) || !cache.findModel(snapshot, snapshot_size) || !readGltfModelSnapshot(snapshot, snapshot_size, model)) {
+                state.SkipWithError("the model is missing from the mesh cache");
+                break;
+            }
+            vertex_bytes = 0u;
+            for (uint64_t key : woman.keys) {
+                MeshCache::Primitive primitive;
+                if (!cache.find(key, primitive)) {
+                    state.SkipWithError("a primitive is missing from the mesh cache");
+                    break;
+                }
+                const size_t index_size = primitive.index_count * sizeof(uint32_t);
+                staging.resize(primitive.vertices_size + index_size);
+                std::memcpy(staging.data(), primitive.vertices, primitive.vertices_size);
+                std::memcpy(staging.data() + primitive.vertices_size, primitive.indices, index_size);
+                vertex_bytes += staging.size();
+            }
+            benchmark::DoNotOptimize(model.accessors.data());
+            benchmark::DoNotOptimize(staging.data());
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * vertex_bytes));
+    }
+}
+
+BENCHMARK(BM_WomanParse)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_WomanConvertPrimitives)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_WomanMeshCacheOpen)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_WomanMeshCacheHit)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,95 @@
+#include <benchmark/benchmark.h>
+
+#include "../src/scene/scene.h"
+#include "../src/tools/thread_pool.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Global transform propagation over a synthetic hierarchy, every node has BRANCHING children so 100k nodes are nine
+// levels deep. BM_PropagationEagerInverse is the propagation before the dirty queue and the lazy inverses: one glm
+// multiply and one general glm::inverse per node, serial. The others run Scene::recalculateGlobalTransforms() after
+// the whole tree was marked, BM_PropagationResolveInverses also reads every inverse back so it does the same work.
+namespace {
+    constexpr Scene::NodeIndex BRANCHING = 4u;
+
+    glm::mat4 nodeTransform(Scene::NodeIndex node) {
+        const float angle = 0.01f * static_cast<float>(node % 628u);
+        const glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f));
+        return glm::translate(rotation, glm::vec3(1.0f, 0.5f, 0.0f));
+    }
+
+    std::shared_ptr<Scene> makeHierarchy(size_t count) {
+        std::shared_ptr<Scene> scene = std::make_shared<Scene>("propagation");
+        for (Scene::NodeIndex node = 1u; node < count; ++node) {
+            scene->addNode(nodeTransform(node), (node - 1u) / BRANCHING);
+        }
+        scene->recalculateGlobalTransforms();
+        return scene;
+    }
+
+    void BM_PropagationEagerInverse(benchmark::State& state) {
+        const std::shared_ptr<Scene> scene = makeHierarchy(static_cast<size_t>(state.range(0)));
+        const std::vector<Scene::Hierarchy>& hierarchy = scene->getHierarchy();
+        const std::vector<glm::mat4>& local_transforms = scene->getNodeLocalTransforms();
+        std::vector<glm::mat4> global_transforms = scene->getNodeGlobalTransforms();
+        std::vector<glm::mat4> inv_global_transforms(global_transforms.size());
+
+        std::vector<std::vector<Scene::NodeIndex>> nodes_at_level;
+        for (Scene::NodeIndex node = 1u; node < hierarchy.size(); ++node) {
+            if (hierarchy[node].level >= nodes_at_level.size()) {
+                nodes_at_level.resize(hierarchy[node].level + 1u);
+            }
+            nodes_at_level[hierarchy[node].level].push_back(node);
+        }
+
+        for (auto _ : state) {
+            for (const std::vector<Scene::NodeIndex>& nodes : nodes_at_level) {
+                for (Scene::NodeIndex node : nodes) {
+                    global_transforms[node] = global_transforms[hierarchy[node].parent] * local_transforms[node];
+                    inv_global_transforms[node] = glm::inverse(global_transforms[node]);
+                }
+            }
+            benchmark::DoNotOptimize(inv_global_transforms.data());
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * hierarchy.size()));
+    }
+
+    void runPropagation(benchmark::State& state, const std::shared_ptr<Scene>& scene, bool resolve_inverses) {
+        for (auto _ : state) {
+            scene->markAsChanged(0u);
+            scene->recalculateGlobalTransforms();
+            if (resolve_inverses) {
+                benchmark::DoNotOptimize(scene->getNodeInvGlobalTransforms().data());
+            }
+            benchmark::DoNotOptimize(scene->getNodeGlobalTransforms().data());
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * scene->getHierarchy().size()));
+    }
+
+    void BM_Propagation(benchmark::State& state) {
+        runPropagation(state, makeHierarchy(static_cast<size_t>(state.range(0))), false);
+    }
+
+    void BM_PropagationResolveInverses(benchmark::State& state) {
+        runPropagation(state, makeHierarchy(static_cast<size_t>(state.range(0))), true);
+    }
+
+    // Arg 1: pool workers, the calling thread takes a block of its own. More workers than cores only adds switching,
+    // compare the counts up to the cores of the machine.
+    void BM_PropagationThreadPool(benchmark::State& state) {
+        const std::shared_ptr<Scene> scene = makeHierarchy(static_cast<size_t>(state.range(0)));
+        scene->setThreadPool(std::make_shared<ThreadPool>(static_cast<unsigned>(state.range(1))));
+        runPropagation(state, scene, false);
+        state.counters["cores"] = static_cast<double>(std::thread::hardware_concurrency());
+    }
+}
+
+BENCHMARK(BM_PropagationEagerInverse)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Propagation)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PropagationResolveInverses)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PropagationThreadPool)->ArgsProduct({{100000}, {1, 3, 7, 15}})->ArgNames({"nodes", "workers"})->Unit(benchmark::kMillisecond);
@@ -0,0 +1,132 @@
+#include <benchmark/benchmark.h>
+
+#include "bench_models.h"
+#include "../src/scene/scene.h"
+#include "../src/scene/nodes/scene_node.h"
+#include "../src/scene/nodes/bone_node.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Node lookups on the scene woman.gltf loads into: a named node per glTF node and a bone on every joint, the way
+// MeshNodeLoader::MakeNodesHierarchy builds it. The LinearScan and MapScan variants are the lookups as they were
+// before the name and type indices, written against the public maps.
+namespace {
+    struct WomanScene {
+        std::shared_ptr<Scene> scene;
+        std::vector<std::string> names; // Every glTF node name, then one no node has
+    };
+
+    void addGltfNode(const tinygltf::Model& model, const std::unordered_set<int>& joints, int gltf_node_idx, Scene::NodeIndex parent, const std::shared_ptr<Scene>& scene) {
+        const tinygltf::Node& gltf_node = model.nodes[gltf_node_idx];
+        std::shared_ptr<SceneNode> transform_node = std::make_shared<SceneNode>(scene, gltf_node.name, parent);
+        scene->addProperty(transform_node);
+        if (joints.contains(gltf_node_idx)) {
+            scene->addProperty(std::make_shared<BoneNode>(scene, transform_node->VGetNodeIndex()));
+        }
+        for (int child_idx : gltf_node.children) {
+            addGltfNode(model, joints, child_idx, transform_node->VGetNodeIndex(), scene);
+        }
+    }
+
+    const WomanScene& getWomanScene() {
+        static const WomanScene woman = []() {
+            tinygltf::Model model;
+            loadBenchModel(getBenchModelPath("woman.gltf"), model);
+
+            std::unordered_set<int> joints;
+            for (const tinygltf::Skin& skin : model.skins) {
+                joints.insert(skin.joints.begin(), skin.joints.end());
+            }
+
+            WomanScene woman;
+            woman.scene = std::make_shared<Scene>("woman");
+            const int scene_idx = model.defaultScene > -1 ? model.defaultScene : 0;
+            for (int root_idx : model.scenes[scene_idx].nodes) {
+                addGltfNode(model, joints, root_idx, 0u, woman.scene);
+            }
+            for (const tinygltf::Node& gltf_node : model.nodes) {
+                woman.names.push_back(gltf_node.name);
+            }
+            woman.names.push_back("no_such_node");
+            return woman;
+        }();
+        return woman;
+    }
+
+    int findNodeByNameLinearScan(const Scene& scene, const std::string& name) {
+        const std::unordered_map<Scene::NodeIndex, Scene::NameIndex>& node_name_map = scene.getNodeNameMap();
+        const std::vector<std::string>& node_names = scene.getNodeNames();
+        for (size_t n = 0u; n < scene.getHierarchy().size(); ++n) {
+            auto it = node_name_map.find(static_cast<Scene::NodeIndex>(n));
+            if (it != node_name_map.end() && it->second != Scene::NO_INDEX && node_names[it->second] == name) {
+                return static_cast<int>(n);
+            }
+        }
+        return Scene::NO_INDEX;
+    }
+
+    void BM_WomanFindNodeByName(benchmark::State& state) {
+        const WomanScene& woman = getWomanScene();
+        for (auto _ : state) {
+            for (const std::string& name : woman.names) {
+                benchmark::DoNotOptimize(woman.scene->findNodeByName(name));
+            }
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * woman.names.size()));
+    }
+
+    void BM_WomanFindNodeByNameLinearScan(benchmark::State& state) {
+        const WomanScene& woman = getWomanScene();
+        for (auto _ : state) {
+            for (const std::string& name : woman.names) {
+                benchmark::DoNotOptimize(findNodeByNameLinearScan(*woman.scene, name));
+            }
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * woman.names.size()));
+    }
+
+    // Every bone and its property, as the skeleton binding walks them.
+    void BM_WomanBoneNodes(benchmark::State& state) {
+        const WomanScene& woman = getWomanScene();
+        size_t bones = 0u;
+        for (auto _ : state) {
+            bones = 0u;
+            for (Scene::NodeIndex node : woman.scene->getNodesOfType(Scene::NODE_TYPE_FLAG_BONE)) {
+                benchmark::DoNotOptimize(woman.scene->getProperty(node, Scene::NODE_TYPE_FLAG_BONE).get());
+                ++bones;
+            }
+        }
+        state.counters["bones"] = static_cast<double>(bones);
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * woman.scene->getHierarchy().size()));
+    }
+
+    void BM_WomanBoneNodesMapScan(benchmark::State& state) {
+        const WomanScene& woman = getWomanScene();
+        const std::unordered_map<Scene::NodeIndex, Scene::NodeTypeFlags>& type_flags_map = woman.scene->getNodeTypeFlagsMap();
+        const std::unordered_map<Scene::NodeIndex, Scene::PropertyIndex>& property_map = woman.scene->getNodePropertyMap();
+        const std::vector<std::shared_ptr<Scene::Properties>>& properties = woman.scene->getProperties();
+        size_t bones = 0u;
+        for (auto _ : state) {
+            bones = 0u;
+            for (size_t n = 0u; n < woman.scene->getHierarchy().size(); ++n) {
+                const Scene::NodeIndex node = static_cast<Scene::NodeIndex>(n);
+                auto flags = type_flags_map.find(node);
+                if (flags == type_flags_map.end() || !(flags->second & Scene::NODE_TYPE_FLAG_BONE)) continue;
+                benchmark::DoNotOptimize(properties[property_map.at(node)]->at(Scene::NODE_TYPE_FLAG_BONE).get());
+                ++bones;
+            }
+        }
+        state.counters["bones"] = static_cast<double>(bones);
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * woman.scene->getHierarchy().size()));
+    }
+}
+
+BENCHMARK(BM_WomanFindNodeByName)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_WomanFindNodeByNameLinearScan)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_WomanBoneNodes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_WomanBoneNodesMapScan)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,41 @@
+#version 450
+
+layout(set = 0, binding = 0) uniform MatrixBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+layout(set = 0, binding = 1) uniform InvMatrixBufferObject {
+    mat4 inv_model;
+    mat4 inv_view;
+    mat4 inv_proj;
+} inv_ubo;
+
+struct InstanceData {
+    mat4 model;
+    mat4 inv_model;
+    uvec4 material; // Used by the bindless variant only
+};
+
+layout(std430, set = 0, binding = 5) readonly buffer InstanceBufferObject {
+    InstanceData instances[];
+} instance_ssbo;
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec3 in_normal;
+layout(location = 2) in vec3 in_tangent;
+layout(location = 3) in vec2 in_uv;
+
+layout(location = 0) out vec3 out_normal;
+layout(location = 1) out vec4 out_world_pos;
+layout(location = 2) out vec2 out_uv;
+
+void main() {
+    InstanceData instance = instance_ssbo.instances[gl_InstanceIndex];
+    out_world_pos = instance.model * vec4(in_position, 1.0f);
+    gl_Position = ubo.proj * ubo.view * out_world_pos;
+
+    out_normal = transpose(mat3(instance.inv_model)) * in_normal;
+    out_uv = in_uv;
+}
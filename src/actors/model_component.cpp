@@ -67,6 +67,7 @@ bool ModelComponent::Init(const pugi::xml_node& data) {
     std::shared_ptr<SceneNode> transform_node = tc->GetSceneNode();
 
     MeshNodeLoader node_loader;
+    node_loader.SetOptimizeMeshes(data.child("OptimizeMeshes").text().as_bool(true));
     m_loaded_scene_node = node_loader.ImportSceneNode(p, shader_manager, transform_node);
 
 	return !!m_loaded_scene_node;
@@ -140,6 +140,10 @@ GameTimer& Application::GetTimer() {
     return m_timer;
 }
 
+const std::shared_ptr<ThreadPool>& Application::GetThreadPool() const {
+    return m_thread_pool;
+}
+
 const std::shared_ptr<BaseEngineLogic>& Application::GetGameLogic() const {
     return m_game;
 };
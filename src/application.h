@@ -44,6 +44,7 @@ public:
 
     const ApplicationOptions& GetApplicationOptions() const;
     GameTimer& GetTimer();
+    const std::shared_ptr<ThreadPool>& GetThreadPool() const;
     const std::shared_ptr<BaseEngineLogic>& GetGameLogic() const;
     
     void mainLoop();
@@ -25,6 +25,10 @@ bool ApplicationOptions::Init(const std::string& xml_file_name) {
 		RunFullSpeed = graphics_node.child("RunFullSpeed").text().as_bool(RunFullSpeed);
 		ScreenHeight = graphics_node.child("Height").text().as_int(ScreenHeight);
 		ScreenWidth = graphics_node.child("Width").text().as_int(ScreenWidth);
+		StagingBufferSizeMB = graphics_node.child("StagingBufferSizeMB").text().as_uint(StagingBufferSizeMB);
+		TextureStreaming = graphics_node.child("TextureStreaming").text().as_bool(TextureStreaming);
+		TextureUploadBudgetKB = graphics_node.child("TextureUploadBudgetKB").text().as_uint(TextureUploadBudgetKB);
+		TextureResidentBudgetMB = graphics_node.child("TextureResidentBudgetMB").text().as_uint(TextureResidentBudgetMB);
 
 		pugi::xml_node renderer_node = graphics_node.child("Renderer");
 		if (renderer_node) {
@@ -16,6 +16,10 @@ struct ApplicationOptions {
 	int ScreenWidth = 800;
 	int ScreenHeight = 600;
 	bool DebugUI = true;
+	unsigned StagingBufferSizeMB = 64u;
+	bool TextureStreaming = true;
+	unsigned TextureUploadBudgetKB = 8192u; // Per frame
+	unsigned TextureResidentBudgetMB = 1024u;
 
     std::string WindowTitle = "Vulkan Test";
     std::string AppName = "Hello Triangle";
@@ -37,6 +37,7 @@ HumanView::HumanView(std::shared_ptr<ProcessManager> process_manager) {
 	m_base_game_state = BaseEngineState::BGS_Initializing;
 
 	m_scene = std::make_shared<ScreenElementScene>();
+	m_scene->setThreadPool(Application::Get().GetThreadPool());
 
 	if (m_bShow_debug_ui) {
 		m_gui = std::make_shared<ImGUIDrawable>();
@@ -120,6 +121,7 @@ void HumanView::VOnUpdate(const GameTimerDelta& delta, uint32_t image_index) {
 	for (ScreenElementList::iterator i = m_screen_elements.begin(); i != m_screen_elements.end(); ++i) {
 		(*i)->VOnUpdate(delta, image_index);
 	}
+	m_scene->resetInverseCounters();
 	m_scene->getAnimationManager()->Update(delta);
 	m_scene->recalculateGlobalTransforms();
 	m_scene->getSkeletonManager()->recalculateSkinnedData();
@@ -6,7 +6,7 @@
 #include <string>
 
 #include "ievent_manager.h"
-#include "../tools/thread_safe_queue.h"
+#include "../tools/concurrent_queue.h"
 #include "../tools/game_timer.h"
 
 const unsigned int EVENTMANAGER_NUM_QUEUES = 2;
@@ -16,7 +16,7 @@ class EventManager : public IEventManager {
 private:
 	using EventListenerMap = std::unordered_map<EventTypeId, std::list<EventListenerDelegate>>;
 	using EventsList = std::list<IEventDataPtr>;
-	using ThreadSafeEventQueue = ThreadSafeQueue<IEventDataPtr>;
+	using ThreadSafeEventQueue = ConcurrentQueue<IEventDataPtr>;
 
 	EventListenerMap m_event_listeners;
 	EventsList m_queues[EVENTMANAGER_NUM_QUEUES];
@@ -7,6 +7,7 @@
 #include "../../application.h"
 #include "../vulkan_renderer.h"
 #include "vulkan_resources_manager.h"
+#include "vulkan_upload_manager.h"
 
 VulkanBuffer::VulkanBuffer(std::shared_ptr<VulkanDevice> device, std::string name) : m_device(std::move(device)), m_name(std::move(name)) {}
 VulkanBuffer::VulkanBuffer(std::shared_ptr<VulkanDevice> device) : m_device(std::move(device)), m_name(std::to_string(rand())) {};
@@ -37,26 +38,16 @@ bool VulkanBuffer::init(const void* data, std::shared_ptr<BufferConfig> buffer_c
     
     VkMemoryRequirements mem_req;
     vkGetBufferMemoryRequirements(m_device->getDevice(), m_buffer, &mem_req);
-    uint32_t mem_type_idx = m_device->findMemoryType(mem_req.memoryTypeBits, m_buffer_config->getMemoryProperties());
     m_buffer_config->setAlignedSize(mem_req.size);
     m_buffer_config->setAlignment(mem_req.alignment);
-  
-    VkMemoryAllocateInfo alloc_info = {};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.pNext = nullptr;
-    alloc_info.allocationSize = mem_req.size;
-    alloc_info.memoryTypeIndex = mem_type_idx;
- 
-    result = vkAllocateMemory(m_device->getDevice(), &alloc_info, nullptr, &m_memory);
-    if(result != VK_SUCCESS) {
+
+    if(!m_device->getMemoryAllocator()->allocate(mem_req, m_buffer_config->getMemoryProperties(), VulkanDeviceMemoryAllocator::AllocationMode::LINEAR, m_allocation)) {
         throw std::runtime_error("failed to allocate buffer memory!");
     }
-    VkDeviceSize offset = 0u;
-    vkBindBufferMemory(m_device->getDevice(), m_buffer, m_memory, offset);
+    m_memory = m_allocation.get_memory();
+    vkBindBufferMemory(m_device->getDevice(), m_buffer, m_memory, m_allocation.get_offset());
 
-    if(m_buffer_config->getMemoryProperties() & (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
-        vkMapMemory(m_device->getDevice(), m_memory, 0, mem_req.size, 0u, &m_mapped);
-    }
+    m_mapped = m_allocation.get_host_pointer();
 
     for(const auto&[view_type_name, view_cfg_ptr] : m_buffer_config->getViewMap()) {
         view_cfg_ptr->view_info.buffer = m_buffer;
@@ -101,11 +92,8 @@ void VulkanBuffer::destroy() {
             vk_view = VK_NULL_HANDLE;
         }
 
-        if(m_buffer_config->getMemoryProperties() & (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
-            vkUnmapMemory(m_device->getDevice(), m_memory);
-        }
         vkDestroyBuffer(m_device->getDevice(), m_buffer, nullptr);
-        vkFreeMemory(m_device->getDevice(), m_memory, nullptr);
+        m_device->getMemoryAllocator()->free(m_allocation);
         m_memory = VK_NULL_HANDLE;
         m_buffer = VK_NULL_HANDLE;
         m_mapped = nullptr;
@@ -125,6 +113,10 @@ VkDeviceMemory VulkanBuffer::getMemory() const {
     return m_memory;
 }
 
+const DeviceAllocation& VulkanBuffer::getAllocation() const {
+    return m_allocation;
+}
+
 void* VulkanBuffer::getMappedBuffer() const {
     if (m_buffer_config->getMemoryProperties() & (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
         return m_mapped;
@@ -179,12 +171,7 @@ void VulkanBuffer::update(const void* src_data, VkDeviceSize buffer_size) {
     }
     else if(m_buffer_config->getMemoryProperties() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
         memcpy(m_mapped, src_data, buffer_size);
-        VkMappedMemoryRange range{};
-        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        range.pNext = nullptr;
-        range.memory = m_memory;
-        range.offset = 0u;
-        range.size = VK_WHOLE_SIZE;
+        VkMappedMemoryRange range = m_device->getMemoryAllocator()->getMappedRange(m_allocation);
         VkResult result = vkFlushMappedMemoryRanges(m_device->getDevice(), 1u, &range);
         if (result != VK_SUCCESS) {
             throw std::runtime_error("failed to flush buffer to device!");
@@ -192,12 +179,7 @@ void VulkanBuffer::update(const void* src_data, VkDeviceSize buffer_size) {
         return;
     }
     else {
-        std::shared_ptr<CommandBatch> command_buffer_ptr = m_device->getCommandManager()->allocCommandBufferPtr(PoolTypeEnum::TRANSFER);
-        update(*command_buffer_ptr, src_data, buffer_size);
-        m_device->getCommandManager()->submitCommandBuffer(command_buffer_ptr);
-        m_device->getCommandManager()->wait(PoolTypeEnum::TRANSFER);
-        command_buffer_ptr->destroy();
-
+        Application::Get().GetRenderer().getUploadManager()->uploadBuffer(m_buffer, m_buffer_config->getBufferInfo().sharingMode, src_data, buffer_size, 0u, VulkanDevice::getDstAccessMask(m_buffer_config->getBufferInfo().usage), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
         return;
     }
 }
@@ -220,12 +202,7 @@ void VulkanBuffer::update(CommandBatch& command_buffer, const void* src_data, Vk
         return;
     }
     if(m_buffer_config->getMemoryProperties() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
-        VkMappedMemoryRange range{};
-        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        range.pNext = nullptr;
-        range.memory = m_memory;
-        range.offset = 0u;
-        range.size = VK_WHOLE_SIZE;
+        VkMappedMemoryRange range = m_device->getMemoryAllocator()->getMappedRange(m_allocation);
 
         VkResult result{};
         // send data from GPU
@@ -245,18 +222,12 @@ void VulkanBuffer::update(CommandBatch& command_buffer, const void* src_data, Vk
         return;
     }
 
-    Application& app = Application::Get();
-    VulkanRenderer& renderer = app.GetRenderer();
-    std::shared_ptr<VulkanBuffer> staging_buffer = Application::Get().GetRenderer().getResourcesManager()->create_buffer(src_data, m_buffer_config->getBufferInfo().size, "basic_staging_buffer"s);
-    command_buffer.addResource(staging_buffer);
-
-    m_device->getCommandManager()->copyBuffer(command_buffer.getCommandBufer(), staging_buffer->getBuffer(), m_buffer, buffer_size);
+    // Device local destination, the copy goes through the staging ring on the transfer queue and is ordered before
+    // the next graphics submit instead of being recorded into the caller's batch.
+    Application::Get().GetRenderer().getUploadManager()->uploadBuffer(m_buffer, m_buffer_config->getBufferInfo().sharingMode, src_data, buffer_size, 0u, dstAccessMask, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
 
     // alternative to vkCmdCopyBuffer from m_device->getCommandManager().copyBuffer, the data is consumed from host memory as soon as vkCmdUpdateBuffer() is called, Vulkan make a copy of the data you’ve supplied! Data is not written into the buffer until vkCmdUpdateBuffer() is executed by the device after the command buffer has been submitted! The maximum size of data that can be placed in a buffer with vkCmdUpdateBuffer() is 65,536 bytes.
     // vkCmdUpdateBuffer(command_buffer.getCommandBufer(), m_buffer, 0u, buffer_size, src_data);
-
-    //setGlobalMemoryUpdateBarier(command_buffer, dstAccessMask);
-    setMemoryUpdateBarier(command_buffer, dstAccessMask);
 }
 
 void VulkanBuffer::update(CommandBatch& command_buffer, const void* src_data, VkDeviceSize buffer_size) {
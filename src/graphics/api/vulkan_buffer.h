@@ -1,7 +1,6 @@
 #pragma once
 
-#define GLFW_INCLUDE_VULKAN
-#include <GLFW/glfw3.h>
+#include <vulkan/vulkan.h>
 
 #include <cstdint>
 #include <string>
@@ -10,6 +9,7 @@
 
 #include "../pod/render_resource.h"
 #include "vulkan_command_buffer.h"
+#include "vulkan_device_memory_allocation.h"
 
 class VulkanDevice;
 class BufferConfig;
@@ -27,6 +27,7 @@ public:
     VkBuffer getBuffer() const;
     VkBuffer* getBufferPtr();
     VkDeviceMemory getMemory() const;
+    const DeviceAllocation& getAllocation() const;
     void* getMappedBuffer() const;
     VkDeviceSize getAlignedSize() const;
     VkDeviceSize getNotAlignedSize() const;
@@ -54,6 +55,7 @@ protected:
 
     VkBuffer m_buffer;
     VkDeviceMemory m_memory;
+    DeviceAllocation m_allocation;
     void* m_mapped;
 
     std::unordered_map<std::string, VkBufferView> m_buffer_view_map;
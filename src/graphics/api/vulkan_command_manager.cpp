@@ -1,5 +1,6 @@
 #include "vulkan_command_manager.h"
 #include "vulkan_device.h"
+#include "vulkan_layout_tracker.h"
 #include "../pod/render_resource.h"
 #include "../../application.h"
 #include "../vulkan_renderer.h"
@@ -17,56 +18,10 @@ bool VulkanCommandManager::init(VkPhysicalDevice physical_device, VkDevice logic
 
     createCommandPools();
 
-    m_command_buffers.resize(MAX_COMMAND_BUFFERS);
-    VkCommandBufferAllocateInfo command_alloc_info{};
-    command_alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    command_alloc_info.commandPool = getCommandPool(PoolTypeEnum::TRANSFER);
-    command_alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    command_alloc_info.commandBufferCount = MAX_COMMAND_BUFFERS;
-
-	VkResult result = vkAllocateCommandBuffers(m_device, &command_alloc_info, m_command_buffers.data());
-    if(result != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate command buffers!");
-    }
-
-    for (uint32_t i = 0u; i < MAX_COMMAND_BUFFERS; ++i) {
-        m_free_cmd_idx.Push(i);
-    }
-
-    m_cmd_buff_thread = std::thread(
-        [this]() {
-            while(true) {
-                std::shared_ptr<CommandBatch> work_in_progress_ptr;
-                m_work_in_progress.WaitAndPop(work_in_progress_ptr);
-                if(work_in_progress_ptr->Noop()) {
-                    work_in_progress_ptr->destroy();
-                    break;
-                }
-
-                vkWaitForFences(m_device, 1u, work_in_progress_ptr->getRenderFencePtr(), VK_TRUE, UINT64_MAX);
-                work_in_progress_ptr->reset();
-
-                std::vector<size_t> cmd_idx = m_submit_to_buf_id.ValueFor(work_in_progress_ptr->getId(), {});
-                for (size_t i : cmd_idx) {
-                    m_free_cmd_idx.Push(i);
-                }
-                m_submit_to_buf_id.RemoveMapping(work_in_progress_ptr->getId());
-
-                for(const std::shared_ptr<RenderResource>& resource : work_in_progress_ptr->getResources()) {
-                    resource->destroy();
-                }
-            }
-            return;
-        }
-    );
-
     return true;
 }
 
 void VulkanCommandManager::destroy() {
-    std::shared_ptr<CommandBatch> noop_ptr = std::make_shared<CommandBatch>(m_device, Application::GetRenderer().getSemaphoreManager(), Application::GetRenderer().getFenceManager(), "NOOP");
-    noop_ptr->setNoop();
-    m_work_in_progress.Push(std::move(noop_ptr));
     if(m_grapics_cmd_pool != m_transfer_cmd_pool) {
         vkDestroyCommandPool(m_device, m_grapics_cmd_pool, nullptr);
         vkDestroyCommandPool(m_device, m_transfer_cmd_pool, nullptr);
@@ -74,7 +29,6 @@ void VulkanCommandManager::destroy() {
     else {
         vkDestroyCommandPool(m_device, m_grapics_cmd_pool, nullptr);
     }
-    //noop_ptr->destroy();
 }
 
 const QueueFamilyIndices& VulkanCommandManager::getQueueFamilyIndices() const {
@@ -112,24 +66,6 @@ CommandBatch VulkanCommandManager::allocCommandBuffer(PoolTypeEnum pool_type, si
     std::shared_ptr<VulkanFenceManager>& fence_manager = Application::GetRenderer().getFenceManager();
     std::shared_ptr<VulkanSemaphoresManager>& semaphores_manager = Application::GetRenderer().getSemaphoreManager();
 
-    if(pool_type == PoolTypeEnum::TRANSFER) {
-        std::vector<size_t> cmd_idx;
-        cmd_idx.reserve(buffers_count);
-        for(size_t i = 0u; i < buffers_count; ++i) {
-            size_t command_buf_idx = -1;
-            m_free_cmd_idx.WaitAndPop(command_buf_idx);
-            command_buffers[i] = m_command_buffers[command_buf_idx];
-            cmd_idx.push_back(command_buf_idx);
-        }
-
-        CommandBatch result_buffers(m_device, semaphores_manager, fence_manager, std::move(name));
-        result_buffers.init(std::move(command_buffers), pool_type, m_queue_family_indices.getFamilyIdx(pool_type).value(), LAST_COMMAND_BUFFER_ID++);
-        result_buffers.reset();
-        VulkanCommandManager::beginCommandBuffer(result_buffers);
-        m_submit_to_buf_id.AddOrUpdateMapping(result_buffers.getId(), cmd_idx);
-
-        return result_buffers;
-    }
 
 	if (command_buffer_info) {
         command_buffer_info->commandBufferCount = static_cast<uint32_t>(command_buffers.size());
@@ -165,24 +101,6 @@ std::shared_ptr<CommandBatch> VulkanCommandManager::allocCommandBufferPtr(PoolTy
     std::shared_ptr<VulkanFenceManager>& fence_manager = Application::GetRenderer().getFenceManager();
     std::shared_ptr<VulkanSemaphoresManager>& semaphores_manager = Application::GetRenderer().getSemaphoreManager();
 
-    if(pool_type == PoolTypeEnum::TRANSFER) {
-        std::vector<size_t> cmd_idx;
-        cmd_idx.reserve(buffers_count);
-        for(size_t i = 0u; i < buffers_count; ++i) {
-            size_t command_buf_idx = -1;
-            m_free_cmd_idx.WaitAndPop(command_buf_idx);
-            command_buffers[i] = m_command_buffers[command_buf_idx];
-            cmd_idx.push_back(command_buf_idx);
-        }
-
-        std::shared_ptr<CommandBatch> result_buffers = std::make_shared<CommandBatch>(m_device, semaphores_manager, fence_manager, std::move(name));
-        result_buffers->init(std::move(command_buffers), pool_type, m_queue_family_indices.getFamilyIdx(pool_type).value(), LAST_COMMAND_BUFFER_ID++);
-        result_buffers->reset();
-        VulkanCommandManager::beginCommandBuffer(*result_buffers);
-        m_submit_to_buf_id.AddOrUpdateMapping(result_buffers->getId(), cmd_idx);
-
-        return result_buffers;
-    }
 
 	if (command_buffer_info) {
         command_buffer_info->commandBufferCount = static_cast<uint32_t>(command_buffers.size());
@@ -283,31 +201,8 @@ void VulkanCommandManager::endCommandBuffer(CommandBatch& command_buffer, size_t
 }
 
 void VulkanCommandManager::submitCommandBuffer(std::shared_ptr<CommandBatch>& command_buffer, size_t index, VkSubmitInfo* p_submit_info) {
-    if(command_buffer->getPoolType() == PoolTypeEnum::TRANSFER) {
-        VulkanCommandManager::endCommandBuffer(*command_buffer);
-        if (p_submit_info) {
-            VkResult result = vkQueueSubmit(getQueue(command_buffer->getPoolType()), 1u, p_submit_info, command_buffer->getRenderFence());
-            if (result != VK_SUCCESS) {
-                throw std::runtime_error("failed to submit draw command buffer!");
-            }
-            return;
-        }
-        else {
-            VkSubmitInfo submit_info = command_buffer->getSubmitInfo();
-            VkResult result = vkQueueSubmit(getQueue(command_buffer->getPoolType()), 1u, &submit_info, command_buffer->getRenderFence());
-            if (result != VK_SUCCESS) {
-                throw std::runtime_error("failed to submit draw command buffer!");
-            }
-        }
-        m_work_in_progress.Push(command_buffer);
-        return;
-    }
-
     if (p_submit_info) {
-        VkResult result = vkQueueSubmit(getQueue(command_buffer->getPoolType()), 1u, p_submit_info, command_buffer->getRenderFence());
-        if (result != VK_SUCCESS) {
-            throw std::runtime_error("failed to submit draw command buffer!");
-        }
+        queueSubmit(command_buffer->getPoolType(), 1u, p_submit_info, command_buffer->getRenderFence());
         return;
     }
 
@@ -317,76 +212,52 @@ void VulkanCommandManager::submitCommandBuffer(std::shared_ptr<CommandBatch>& co
         submit_info.pCommandBuffers = command_buffer->getCommandBuferPtr(index);
     }
 
-    VkResult result = vkQueueSubmit(getQueue(command_buffer->getPoolType()), 1u, &submit_info, command_buffer->getRenderFence());
+    queueSubmit(command_buffer->getPoolType(), 1u, &submit_info, command_buffer->getRenderFence());
+}
+
+void VulkanCommandManager::queueSubmit(PoolTypeEnum pool_type, uint32_t submit_count, const VkSubmitInfo* p_submits, VkFence fence) {
+    std::lock_guard<std::mutex> lock(m_queue_mutex);
+    VkResult result = vkQueueSubmit(getQueue(pool_type), submit_count, p_submits, fence);
     if (result != VK_SUCCESS) {
         throw std::runtime_error("failed to submit draw command buffer!");
     }
 }
 
+VkResult VulkanCommandManager::queuePresent(const VkPresentInfoKHR& present_info) {
+    std::lock_guard<std::mutex> lock(m_queue_mutex);
+    return vkQueuePresentKHR(getQueue(PoolTypeEnum::GRAPICS), &present_info);
+}
+
 void VulkanCommandManager::wait(PoolTypeEnum pool_type) {
+    std::lock_guard<std::mutex> lock(m_queue_mutex);
     vkQueueWaitIdle(getQueue(pool_type));
 }
 
 void VulkanCommandManager::transitionImageLayout(VkCommandBuffer command_buffer, VkImage image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout, uint32_t mip_levels) {
-    VkPipelineStageFlags source_stage;
-    VkPipelineStageFlags destination_stage;
-    
-    VkImageMemoryBarrier barrier{};
-    if (new_layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
-        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-        if (VulkanDevice::hasStencilComponent(format)) {
-            barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
-        }
-    }
-    else {
-        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    }
-    
-    if(old_layout == VK_IMAGE_LAYOUT_UNDEFINED && new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        barrier.srcAccessMask = 0u;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destination_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    }
-    else if(old_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destination_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    }
-    else if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED && new_layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
-        barrier.srcAccessMask = 0u;
-        barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-        source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destination_stage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    }
-    else if(old_layout == VK_IMAGE_LAYOUT_UNDEFINED && new_layout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR) {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-        source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destination_stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-    }
-    else if(old_layout == VK_IMAGE_LAYOUT_UNDEFINED && new_layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-        source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destination_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    }
-    else {
-        throw std::invalid_argument("unsupported layout transition!");
-    }
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    // The old layout's typical accesses are waited for and made visible to the new layout's typical accesses.
+    const VulkanLayoutTracker::Access src = VulkanLayoutTracker::getLayoutAccess(old_layout);
+    const VulkanLayoutTracker::Access dst = VulkanLayoutTracker::getLayoutAccess(new_layout);
+
+    VulkanLayoutTracker::Barriers barriers;
+    VkImageMemoryBarrier2& barrier = barriers.image_barriers.emplace_back();
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    barrier.srcStageMask = src.stage;
+    barrier.srcAccessMask = VulkanLayoutTracker::getWriteAccess(src.access);
+    barrier.dstStageMask = dst.stage;
+    barrier.dstAccessMask = dst.access;
     barrier.oldLayout = old_layout;
     barrier.newLayout = new_layout;
     barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     barrier.image = image;
-    //barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.aspectMask = VulkanLayoutTracker::getFormatAspect(format);
     barrier.subresourceRange.baseMipLevel = 0u;
     barrier.subresourceRange.levelCount = mip_levels;
     barrier.subresourceRange.baseArrayLayer = 0u;
     barrier.subresourceRange.layerCount = 1u;
-    vkCmdPipelineBarrier(command_buffer, source_stage, destination_stage, 0u, 0u, nullptr, 0u, nullptr, 1u, &barrier);
+
+    // Mostly one-off upload command buffers, the synchronization1 path is valid on every device.
+    VulkanLayoutTracker::recordBarriers(command_buffer, barriers, false);
 }
 
 void VulkanCommandManager::copyBufferToImage(VkCommandBuffer command_buffer, VkBuffer buffer, VkImage image, VkExtent3D extent, VkImageLayout image_layout) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <utility>
 #include <vector>
 
@@ -10,14 +11,11 @@
 #include "vulkan_queue_family.h"
 #include "vulkan_command_pool_type.h"
 #include "vulkan_command_buffer.h"
-#include "../../tools/thread_safe_queue.h"
 #include "../../tools/thread_pool.h"
-#include "../../tools/thread_safe_lookup_table.h"
 
 class VulkanCommandManager {
 public:
     static constexpr size_t SELECT_ALL_BUFFERS = -1;
-    static constexpr uint32_t MAX_COMMAND_BUFFERS = 16u;
 
     bool init(VkPhysicalDevice physical_device, VkDevice logical_device, VkSurfaceKHR surface, std::shared_ptr<ThreadPool> thread_pool);
     void destroy();
@@ -34,6 +32,9 @@ public:
 	static void endCommandBuffer(CommandBatch& command_buffer, size_t index = 0u);
 
     void submitCommandBuffer(std::shared_ptr<CommandBatch>& command_buffer, size_t index = 0u, VkSubmitInfo* p_submit_info = nullptr);
+    // Queues may alias each other when families are shared, every vkQueueSubmit and vkQueuePresentKHR goes through here.
+    void queueSubmit(PoolTypeEnum pool_type, uint32_t submit_count, const VkSubmitInfo* p_submits, VkFence fence);
+    VkResult queuePresent(const VkPresentInfoKHR& present_info);
     void wait(PoolTypeEnum pool_type);
 
     void transitionImageLayout(VkCommandBuffer command_buffer, VkImage image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout, uint32_t mip_levels);
@@ -54,12 +55,7 @@ private:
     VkQueue m_compute_queue = VK_NULL_HANDLE;
     VkQueue m_transfer_queue = VK_NULL_HANDLE;
 
-    ThreadSafeQueue<std::shared_ptr<CommandBatch>> m_work_in_progress;
-
-    std::vector<VkCommandBuffer> m_command_buffers;
-    ThreadSafeLookupTable<unsigned int, std::vector<size_t>> m_submit_to_buf_id;
-    ThreadSafeQueue<size_t> m_free_cmd_idx;
+    std::mutex m_queue_mutex;
 
     std::shared_ptr<ThreadPool> m_thread_pool;
-    scope_thread m_cmd_buff_thread;
 };
\ No newline at end of file
@@ -214,6 +214,46 @@ void VulkanDescriptor::updateDescBuffer(uint32_t binding, VkBuffer buffer, VkDev
     vkUpdateDescriptorSets(m_device, 1u, &desc_write, 0u, nullptr);
 }
 
+void VulkanDescriptor::updateDescArrayImage(uint32_t binding, uint32_t array_element, VkSampler sampler, VkImageView image_view, VkImageLayout image_layout) {
+    VkDescriptorImageInfo image_info{};
+    image_info.imageLayout = image_layout;
+    image_info.imageView = image_view;
+    image_info.sampler = sampler;
+
+    VkWriteDescriptorSet desc_write{};
+    desc_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    desc_write.dstSet = m_descriptor_set;
+    desc_write.dstBinding = binding;
+    desc_write.dstArrayElement = array_element;
+    desc_write.descriptorType = m_layout->getBinding(binding).descriptorType;
+    desc_write.descriptorCount = 1u;
+    desc_write.pImageInfo = &image_info;
+    desc_write.pBufferInfo = nullptr;
+    desc_write.pTexelBufferView = nullptr;
+
+    vkUpdateDescriptorSets(m_device, 1u, &desc_write, 0u, nullptr);
+}
+
+void VulkanDescriptor::updateDescArrayBuffer(uint32_t binding, uint32_t array_element, VkBuffer buffer, VkDeviceSize size, VkDeviceSize offset) {
+    VkDescriptorBufferInfo buffer_info{};
+    buffer_info.buffer = buffer;
+    buffer_info.offset = offset;
+    buffer_info.range = size;
+
+    VkWriteDescriptorSet desc_write{};
+    desc_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    desc_write.dstSet = m_descriptor_set;
+    desc_write.dstBinding = binding;
+    desc_write.dstArrayElement = array_element;
+    desc_write.descriptorType = m_layout->getBinding(binding).descriptorType;
+    desc_write.descriptorCount = 1u;
+    desc_write.pBufferInfo = &buffer_info;
+    desc_write.pImageInfo = nullptr;
+    desc_write.pTexelBufferView = nullptr;
+
+    vkUpdateDescriptorSets(m_device, 1u, &desc_write, 0u, nullptr);
+}
+
 void VulkanDescriptor::updateDescTexel(VkBufferView buffer_view) {
     VkWriteDescriptorSet desc_write{};
     desc_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -34,6 +34,10 @@ public:
     void updateDescImageInfo(uint32_t binding, VkSampler sampler, VkImageView image_view, VkImageLayout image_layout);
     void updateDescBuffer(uint32_t binding, VkBuffer buffer, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0u);
 
+    // Single element of an arrayed binding, e.g. one slot of a bindless table.
+    void updateDescArrayImage(uint32_t binding, uint32_t array_element, VkSampler sampler, VkImageView image_view, VkImageLayout image_layout);
+    void updateDescArrayBuffer(uint32_t binding, uint32_t array_element, VkBuffer buffer, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0u);
+
     void updateDescTexel(VkBufferView buffer_view);
     void updateDescTexel(VkBufferView buffer_view, uint32_t binding);
 
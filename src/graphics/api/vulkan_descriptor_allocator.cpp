@@ -2,6 +2,8 @@
 
 #include "vulkan_descriptor_allocator_page.h"
 
+#include <stdexcept>
+
 bool DescriptorAllocator::init(std::shared_ptr<VulkanDevice> device, std::string name, std::vector<std::shared_ptr<DescSetLayout>> layouts, VkDescriptorPoolCreateFlags flags, uint32_t num_descriptors_per_heap) {
     m_device = std::move(device);
     m_num_descriptors_per_heap = num_descriptors_per_heap;
@@ -55,6 +57,16 @@ std::vector<VkDescriptorSet> DescriptorAllocator::Allocate(const std::string& de
     return new_page->Allocate(num_descriptors);
 }
 
+void DescriptorAllocator::Free(const std::string& desc_layout_name, VkDescriptorSet desc) {
+    for(std::shared_ptr<DescriptorAllocatorPage>& page : m_heap_pool.at(desc_layout_name)) {
+        if(page->Owns(desc)) {
+            page->Free(desc);
+            return;
+        }
+    }
+    throw std::runtime_error("descriptor set was not allocated by " + m_name + "!");
+}
+
 void DescriptorAllocator::ReleaseStaleDescriptors() {
     for(auto&[desc_name, pool] : m_heap_pool) {
         for(std::shared_ptr<DescriptorAllocatorPage>& page : pool) {
@@ -22,6 +22,7 @@ public:
 
 	VkDescriptorSet Allocate(const std::string& desc_layout_name);
     std::vector<VkDescriptorSet> Allocate(const std::string& desc_layout_name, uint32_t num_descriptors);
+	void Free(const std::string& desc_layout_name, VkDescriptorSet desc);
 	void ReleaseStaleDescriptors();
 
     const std::string& getName() const;
@@ -3,6 +3,7 @@
 #include "vulkan_device.h"
 #include "../../application.h"
 
+#include <algorithm>
 #include <numeric>
 
 bool DescriptorAllocatorPage::init(std::shared_ptr<VulkanDevice> device, std::shared_ptr<DescSetLayout> layout, VkDescriptorPoolCreateFlags flags, uint32_t num_descriptors_per_heap) {
@@ -73,6 +74,8 @@ bool DescriptorAllocatorPage::init(std::shared_ptr<VulkanDevice> device, std::sh
     if(result != VK_SUCCESS) {
         throw std::runtime_error("failed to allocate descriptor sets!");
     }
+    m_owned_desc_sets = m_desc_sets;
+    std::sort(m_owned_desc_sets.begin(), m_owned_desc_sets.end());
 
 #ifndef NDEBUG
     for(size_t desc_set_idx = 0u; desc_set_idx < num_descriptors_per_heap; ++desc_set_idx) {
@@ -105,7 +108,11 @@ std::shared_ptr<DescSetLayout> DescriptorAllocatorPage::GetDescSetLayout() const
 }
 
 bool DescriptorAllocatorPage::HasSpace(uint32_t num_descriptors) const {
-    return m_desc_sets.size() > num_descriptors;
+    return m_desc_sets.size() >= num_descriptors;
+}
+
+bool DescriptorAllocatorPage::Owns(VkDescriptorSet desc) const {
+    return std::binary_search(m_owned_desc_sets.begin(), m_owned_desc_sets.end(), desc);
 }
 
 uint32_t DescriptorAllocatorPage::NumFreeHandles() const {
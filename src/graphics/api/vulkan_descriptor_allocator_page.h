@@ -21,6 +21,7 @@ public:
 
 	std::shared_ptr<DescSetLayout> GetDescSetLayout() const;
 	bool HasSpace(uint32_t num_descriptors) const;
+	bool Owns(VkDescriptorSet desc) const;
 	uint32_t NumFreeHandles() const;
 
 	std::vector<VkDescriptorSet> Allocate(uint32_t num_descriptors);
@@ -44,4 +45,5 @@ private:
 
     std::vector<VkDescriptorSet> m_desc_sets;
     std::vector<VkDescriptorSet> m_stale_desc_sets;
+    std::vector<VkDescriptorSet> m_owned_desc_sets; // Sorted, every set allocated from m_descriptor_pool
 };
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "vulkan_descriptor_cache.h"
+
+#include "vulkan_descriptor.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+    template<typename T>
+    void hashCombine(size_t& seed, const T& value) {
+        seed ^= std::hash<T>{}(value) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+    }
+}
+
+void VulkanDescriptorCache::init(uint32_t evict_after_frames) {
+    m_evict_after_frames = evict_after_frames;
+    m_frame = 0u;
+    m_stats = Stats{};
+}
+
+void VulkanDescriptorCache::clear() {
+    m_entries.clear();
+    m_retired.clear();
+    m_stats.entries = 0u;
+}
+
+std::shared_ptr<VulkanDescriptor> VulkanDescriptorCache::find(const std::string& layout_name, const Bindings& bindings) {
+    auto it = m_entries.find(KeyView{&layout_name, &bindings, hashKey(layout_name, bindings)});
+    if(it == m_entries.end()) {
+        ++m_stats.misses;
+        return nullptr;
+    }
+
+    ++m_stats.hits;
+    it->second.last_used_frame = m_frame;
+    return it->second.descriptor;
+}
+
+void VulkanDescriptorCache::insert(const std::string& layout_name, const Bindings& bindings, std::shared_ptr<VulkanDescriptor> descriptor) {
+    Key key{layout_name, bindings, hashKey(layout_name, bindings)};
+    m_entries.insert_or_assign(std::move(key), Entry{std::move(descriptor), m_frame});
+    m_stats.entries = m_entries.size();
+}
+
+void VulkanDescriptorCache::invalidateImageView(VkImageView image_view) {
+    invalidateIf([image_view](const Binding& binding) { return binding.image_view == image_view; });
+}
+
+void VulkanDescriptorCache::invalidateBuffer(VkBuffer buffer) {
+    invalidateIf([buffer](const Binding& binding) { return binding.buffer == buffer; });
+}
+
+template<typename Pred>
+void VulkanDescriptorCache::invalidateIf(Pred pred) {
+    for(auto it = m_entries.begin(); it != m_entries.end();) {
+        if(std::none_of(it->first.bindings.begin(), it->first.bindings.end(), pred)) {
+            ++it;
+            continue;
+        }
+
+        m_retired.push_back(RetiredEntry{it->first.layout_name, std::move(it->second)});
+        ++m_stats.invalidations;
+        it = m_entries.erase(it);
+    }
+    m_stats.entries = m_entries.size();
+}
+
+void VulkanDescriptorCache::nextFrame(std::vector<EvictedSet>& evicted) {
+    ++m_frame;
+
+    for(auto it = m_entries.begin(); it != m_entries.end();) {
+        if(!expired(it->second)) {
+            ++it;
+            continue;
+        }
+
+        evicted.emplace_back(it->first.layout_name, it->second.descriptor->getDescriptorSet());
+        ++m_stats.evictions;
+        it = m_entries.erase(it);
+    }
+    m_stats.entries = m_entries.size();
+
+    auto retired_end = std::remove_if(m_retired.begin(), m_retired.end(), [this, &evicted](RetiredEntry& retired) {
+        if(!expired(retired.entry)) return false;
+
+        evicted.emplace_back(retired.layout_name, retired.entry.descriptor->getDescriptorSet());
+        ++m_stats.evictions;
+        return true;
+    });
+    m_retired.erase(retired_end, m_retired.end());
+}
+
+// Referenced entries count as used this frame.
+bool VulkanDescriptorCache::expired(Entry& entry) const {
+    if(entry.descriptor.use_count() > 1) {
+        entry.last_used_frame = m_frame;
+        return false;
+    }
+    return m_frame - entry.last_used_frame > m_evict_after_frames;
+}
+
+const VulkanDescriptorCache::Stats& VulkanDescriptorCache::getStats() const {
+    return m_stats;
+}
+
+size_t VulkanDescriptorCache::hashKey(const std::string& layout_name, const Bindings& bindings) {
+    size_t seed = std::hash<std::string>{}(layout_name);
+    for(const Binding& binding : bindings) {
+        hashCombine(seed, binding.binding);
+        hashCombine(seed, static_cast<uint32_t>(binding.type));
+        hashCombine(seed, binding.sampler);
+        hashCombine(seed, binding.image_view);
+        hashCombine(seed, static_cast<uint32_t>(binding.image_layout));
+        hashCombine(seed, binding.buffer);
+        hashCombine(seed, binding.offset);
+        hashCombine(seed, binding.range);
+    }
+    return seed;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class VulkanDescriptor;
+
+// Descriptor sets keyed by layout and bound contents, nodes binding the same resources share one VkDescriptorSet.
+// Entries nobody references anymore are evicted a number of frames later, once no command buffer can still use them.
+// Keys hold raw handles, the driver may reuse them once a resource is destroyed, so deleting a resource has to
+// invalidate the entries binding it.
+class VulkanDescriptorCache {
+public:
+    struct Binding {
+        uint32_t binding = 0u;
+        VkDescriptorType type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+        VkSampler sampler = VK_NULL_HANDLE;
+        VkImageView image_view = VK_NULL_HANDLE;
+        VkImageLayout image_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0u;
+        VkDeviceSize range = VK_WHOLE_SIZE;
+
+        bool operator==(const Binding& other) const = default;
+    };
+    using Bindings = std::vector<Binding>;
+    using EvictedSet = std::pair<std::string, VkDescriptorSet>; // Layout name, set
+
+    struct Stats {
+        uint64_t hits = 0u;
+        uint64_t misses = 0u;
+        uint64_t evictions = 0u;
+        uint64_t invalidations = 0u;
+        size_t entries = 0u;
+    };
+
+    void init(uint32_t evict_after_frames);
+    void clear();
+
+    // Counts a hit or a miss, on a miss the caller allocates and writes the set and hands it to insert().
+    std::shared_ptr<VulkanDescriptor> find(const std::string& layout_name, const Bindings& bindings);
+    void insert(const std::string& layout_name, const Bindings& bindings, std::shared_ptr<VulkanDescriptor> descriptor);
+
+    // Drops the entries binding the handle from lookups. Their sets stay alive and are evicted by nextFrame() under
+    // the usual rule, nodes and command buffers in flight may still use them.
+    void invalidateImageView(VkImageView image_view);
+    void invalidateBuffer(VkBuffer buffer);
+
+    // Advances the frame counter and moves the sets unreferenced for more than evict_after_frames to evicted.
+    void nextFrame(std::vector<EvictedSet>& evicted);
+
+    const Stats& getStats() const;
+
+private:
+    struct Key {
+        std::string layout_name;
+        Bindings bindings;
+        size_t hash = 0u;
+    };
+
+    // Lookups hash a view of the caller's bindings instead of copying them into a Key.
+    struct KeyView {
+        const std::string* layout_name;
+        const Bindings* bindings;
+        size_t hash;
+    };
+
+    struct KeyHash {
+        using is_transparent = void;
+        size_t operator()(const Key& key) const { return key.hash; }
+        size_t operator()(const KeyView& key) const { return key.hash; }
+    };
+
+    struct KeyEqual {
+        using is_transparent = void;
+        bool operator()(const Key& a, const Key& b) const { return a.hash == b.hash && a.layout_name == b.layout_name && a.bindings == b.bindings; }
+        bool operator()(const KeyView& a, const Key& b) const { return a.hash == b.hash && *a.layout_name == b.layout_name && *a.bindings == b.bindings; }
+        bool operator()(const Key& a, const KeyView& b) const { return (*this)(b, a); }
+    };
+
+    struct Entry {
+        std::shared_ptr<VulkanDescriptor> descriptor;
+        uint64_t last_used_frame = 0u;
+    };
+
+    struct RetiredEntry {
+        std::string layout_name;
+        Entry entry;
+    };
+
+    static size_t hashKey(const std::string& layout_name, const Bindings& bindings);
+    template<typename Pred>
+    void invalidateIf(Pred pred);
+    bool expired(Entry& entry) const;
+
+    std::unordered_map<Key, Entry, KeyHash, KeyEqual> m_entries;
+    std::vector<RetiredEntry> m_retired;
+    uint32_t m_evict_after_frames = 0u;
+    uint64_t m_frame = 0u;
+    Stats m_stats;
+};
@@ -3,6 +3,8 @@
 #include "vulkan_device.h"
 #include "vulkan_descriptor_allocator.h"
 #include "vulkan_descriptor.h"
+#include "vulkan_image_buffer.h"
+#include "vulkan_buffer.h"
 
 bool VulkanDescriptorsManager::init(std::shared_ptr<VulkanDevice> device, const std::string& rg_file_name) {
     m_device = std::move(device);
@@ -19,6 +21,8 @@ bool VulkanDescriptorsManager::init(std::shared_ptr<VulkanDevice> device, const
     pugi::xml_node dscriptors_node = root_node.child("Descriptors");
 	if (dscriptors_node) {
 		for (pugi::xml_node descriptor_node = dscriptors_node.first_child(); descriptor_node; descriptor_node = descriptor_node.next_sibling()) {
+            if(!m_device->isFeatureEnabled(descriptor_node.attribute("device_feature").as_string())) continue;
+
             std::shared_ptr<DescSetLayout> layout = std::make_shared<DescSetLayout>();
 			layout->init(m_device, descriptor_node);
             m_name_layout_map.insert({layout->getName(), layout});
@@ -50,10 +54,14 @@ bool VulkanDescriptorsManager::init(std::shared_ptr<VulkanDevice> device, const
         }
     }
 
+    m_cache.init(CACHE_EVICT_AFTER_FRAMES);
+
     return true;
 }
 
 void VulkanDescriptorsManager::destroy() {
+    m_cache.clear();
+
     std::unordered_set<std::shared_ptr<DescriptorAllocator>> all_allocators;
     for (auto&[desc_name, allocator_ptr] : m_desc_alloc_map) {
         all_allocators.insert(allocator_ptr);
@@ -73,6 +81,10 @@ const std::shared_ptr<DescSetLayout>& VulkanDescriptorsManager::getDescSetLayout
     return m_name_layout_map.at(desc_set_name);
 }
 
+bool VulkanDescriptorsManager::hasDescSetLayout(const std::string& desc_set_name) const {
+    return m_name_layout_map.contains(desc_set_name);
+}
+
 std::shared_ptr<VulkanDescriptor> VulkanDescriptorsManager::allocateDescriptorSet(const std::string& desc_set_name) {
     std::shared_ptr<VulkanDescriptor> desc = std::make_shared<VulkanDescriptor>();
 
@@ -80,4 +92,64 @@ std::shared_ptr<VulkanDescriptor> VulkanDescriptorsManager::allocateDescriptorSe
     desc->init(m_device->getDevice(), m_name_layout_map.at(desc_set_name), vkdesc_set);
 
     return desc;
+}
+
+std::shared_ptr<VulkanDescriptor> VulkanDescriptorsManager::acquireDescriptorSet(const std::string& desc_set_name, const VulkanDescriptorCache::Bindings& bindings) {
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+
+    std::shared_ptr<VulkanDescriptor> desc = m_cache.find(desc_set_name, bindings);
+    if(desc) return desc;
+
+    desc = allocateDescriptorSet(desc_set_name);
+    writeDescriptorSet(*desc, bindings);
+    m_cache.insert(desc_set_name, bindings, desc);
+
+    return desc;
+}
+
+void VulkanDescriptorsManager::invalidateResource(const std::shared_ptr<RenderResource>& resource) {
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+
+    if(resource->getType() == RenderResource::Type::BUFFER) {
+        m_cache.invalidateBuffer(std::static_pointer_cast<VulkanBuffer>(resource)->getBuffer());
+        return;
+    }
+    if(resource->getType() != RenderResource::Type::IMAGE) return;
+
+    for(const auto&[view_name, image_view] : std::static_pointer_cast<VulkanImageBuffer>(resource)->getImageViewMap()) {
+        m_cache.invalidateImageView(image_view);
+    }
+}
+
+void VulkanDescriptorsManager::nextFrame() {
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+
+    m_evicted_sets.clear();
+    m_cache.nextFrame(m_evicted_sets);
+    if(m_evicted_sets.empty()) return;
+
+    std::unordered_set<std::shared_ptr<DescriptorAllocator>> touched_allocators;
+    for(const auto&[desc_set_name, desc_set] : m_evicted_sets) {
+        const std::shared_ptr<DescriptorAllocator>& allocator = m_desc_alloc_map.at(desc_set_name);
+        allocator->Free(desc_set_name, desc_set);
+        touched_allocators.insert(allocator);
+    }
+    for(const std::shared_ptr<DescriptorAllocator>& allocator : touched_allocators) {
+        allocator->ReleaseStaleDescriptors();
+    }
+}
+
+const VulkanDescriptorCache::Stats& VulkanDescriptorsManager::getCacheStats() const {
+    return m_cache.getStats();
+}
+
+void VulkanDescriptorsManager::writeDescriptorSet(VulkanDescriptor& descriptor, const VulkanDescriptorCache::Bindings& bindings) const {
+    for(const VulkanDescriptorCache::Binding& binding : bindings) {
+        if(binding.buffer != VK_NULL_HANDLE) {
+            descriptor.updateDescBuffer(binding.binding, binding.buffer, binding.range, binding.offset);
+        }
+        else {
+            descriptor.updateDescImageInfo(binding.binding, binding.sampler, binding.image_view, binding.image_layout);
+        }
+    }
 }
\ No newline at end of file
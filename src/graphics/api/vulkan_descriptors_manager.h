@@ -9,8 +9,11 @@
 #include <string>
 #include "unordered_map"
 #include "unordered_set"
+#include <mutex>
+#include <vector>
 
 #include "../pod/descriptor_set_layout.h"
+#include "vulkan_descriptor_cache.h"
 
 class VulkanDevice;
 class DescriptorAllocator;
@@ -25,10 +28,27 @@ public:
     void destroy();
 
     const std::shared_ptr<DescSetLayout>& getDescSetLayout(const std::string& desc_set_name) const;
+    bool hasDescSetLayout(const std::string& desc_set_name) const; // False for sets skipped for a missing device feature
     std::shared_ptr<VulkanDescriptor> allocateDescriptorSet(const std::string& desc_set_name);
+    // Shares one set between callers binding the same contents, only cache misses allocate and write a set.
+    std::shared_ptr<VulkanDescriptor> acquireDescriptorSet(const std::string& desc_set_name, const VulkanDescriptorCache::Bindings& bindings);
+    // Cached sets binding a deleted image's views or a deleted buffer are no longer handed out.
+    void invalidateResource(const std::shared_ptr<RenderResource>& resource);
+    // Call once per frame after the frame fence, returns long unreferenced cached sets to their allocators.
+    void nextFrame();
+    const VulkanDescriptorCache::Stats& getCacheStats() const;
+
+    // Unreferenced cached sets live this many frames, well above the number of frames in flight.
+    static constexpr uint32_t CACHE_EVICT_AFTER_FRAMES = 8u;
 
 private:
+    void writeDescriptorSet(VulkanDescriptor& descriptor, const VulkanDescriptorCache::Bindings& bindings) const;
+
     std::shared_ptr<VulkanDevice> m_device;
     std::unordered_map<DescriptorSetName, std::shared_ptr<DescSetLayout>> m_name_layout_map;
     std::unordered_map<DescriptorSetName, std::shared_ptr<DescriptorAllocator>> m_desc_alloc_map;
+
+    std::mutex m_cache_mutex;
+    VulkanDescriptorCache m_cache;
+    std::vector<VulkanDescriptorCache::EvictedSet> m_evicted_sets;
 };
\ No newline at end of file
@@ -9,7 +9,11 @@ bool VulkanDevice::init(const VulkanInstance& instance, VkSurfaceKHR surface, st
     m_surface = surface;
     m_thread_pool = std::move(thread_pool);
     m_device_abilities = pickPhysicalDevice(instance.getInstance(), surface);
-    bool all_device_ext_supported = m_extensions.init(m_device_abilities.physical_device, getRequiredDeviceExtensions<std::unordered_set<std::string>>());
+    std::unordered_set<std::string> device_extensions = getRequiredDeviceExtensions<std::unordered_set<std::string>>();
+    if(m_device_abilities.index_type_uint8) {
+        device_extensions.insert(VK_EXT_INDEX_TYPE_UINT8_EXTENSION_NAME);
+    }
+    bool all_device_ext_supported = m_extensions.init(m_device_abilities.physical_device, std::move(device_extensions));
 
 #ifndef NDEBUG
         printInfo("Supported device extensions", m_extensions.getRequestedExtensions());
@@ -22,11 +26,14 @@ bool VulkanDevice::init(const VulkanInstance& instance, VkSurfaceKHR surface, st
     m_device = createLogicalDevice(m_device_abilities, queue_family_indices.getFamilies(), m_extensions, instance.getLayersAndExtensions());
     m_command_manager = std::make_shared<VulkanCommandManager>();
     m_command_manager->init(m_device_abilities.physical_device, m_device, surface, m_thread_pool);
+    m_memory_allocator = std::make_shared<VulkanDeviceMemoryAllocator>();
+    m_memory_allocator->init(m_device, m_device_abilities.props, m_device_abilities.memory_properties);
 
     return all_device_ext_supported;
 }
 
 void VulkanDevice::destroy() {
+    m_memory_allocator->destroy();
     vkDestroyDevice(m_device, nullptr);
 }
 
@@ -56,6 +63,18 @@ bool VulkanDevice::checkFeaturesSupported(const VkPhysicalDeviceFeatures& featur
     return (device_features_flags & to_check_features_flags) == to_check_features_flags;
 }
 
+bool VulkanDevice::isFeatureEnabled(const std::string& feature_name) const {
+    using namespace std::literals;
+
+    if(feature_name.empty()) return true;
+    if(feature_name == "timeline_semaphore"s) return m_device_abilities.timeline_semaphore;
+    if(feature_name == "synchronization2"s) return m_device_abilities.synchronization2;
+    if(feature_name == "descriptor_indexing"s) return m_device_abilities.descriptor_indexing;
+    if(feature_name == "index_type_uint8"s) return m_device_abilities.index_type_uint8;
+
+    throw std::runtime_error("unknown device feature " + feature_name + "!");
+}
+
 const std::shared_ptr<VulkanCommandManager>& VulkanDevice::getCommandManager() const {
     return m_command_manager;
 }
@@ -64,6 +83,10 @@ std::shared_ptr<VulkanCommandManager>& VulkanDevice::getCommandManager() {
     return m_command_manager;
 }
 
+const std::shared_ptr<VulkanDeviceMemoryAllocator>& VulkanDevice::getMemoryAllocator() const {
+    return m_memory_allocator;
+}
+
 uint32_t VulkanDevice::findMemoryType(uint32_t type_filter, VkMemoryPropertyFlags properties) const {
     VkPhysicalDeviceMemoryProperties mem_prop{};
     vkGetPhysicalDeviceMemoryProperties(getDeviceAbilities().physical_device, &mem_prop);
@@ -1049,6 +1072,10 @@ DeviceAbilities VulkanDevice::rateDeviceSuitability(VkPhysicalDevice device, VkS
     vkGetPhysicalDeviceMemoryProperties(device, &device_abilities.memory_properties);
 
     device_abilities.host_visible_single_heap_memory = isHostVisibleSingleHeapMemory(device);
+    device_abilities.timeline_semaphore = isTimelineSemaphoreSupported(device, device_abilities.props);
+    device_abilities.synchronization2 = isSynchronization2Supported(device, device_abilities.props);
+    device_abilities.descriptor_indexing = isDescriptorIndexingSupported(device, device_abilities.props);
+    device_abilities.index_type_uint8 = isIndexTypeUint8Supported(device, device_abilities.props);
     
     if(device_abilities.props.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
         device_abilities.score += 1000;
@@ -1145,9 +1172,43 @@ VkDevice VulkanDevice::createLogicalDevice(const DeviceAbilities& physical_devic
     if(!all_features_supported) {
         throw std::runtime_error("failed to create logical device! Not all features supported!");
     }
+    // Optional, batched instanced drawing needs a non zero firstInstance in indirect commands.
+    req_device_features.drawIndirectFirstInstance = physical_device.features.drawIndirectFirstInstance;
+
+    VkPhysicalDeviceVulkan12Features req_device_features_12{};
+    req_device_features_12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    req_device_features_12.timelineSemaphore = physical_device.timeline_semaphore ? VK_TRUE : VK_FALSE;
+
+    // Bindless rendering, see the bindless table in VulkanResourcesManager.
+    if(physical_device.descriptor_indexing) {
+        req_device_features_12.runtimeDescriptorArray = VK_TRUE;
+        req_device_features_12.descriptorBindingPartiallyBound = VK_TRUE;
+        req_device_features_12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        req_device_features_12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        req_device_features_12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        req_device_features_12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    }
+
+    // Render graph barriers go through vkCmdPipelineBarrier2 when available, see VulkanLayoutTracker.
+    VkPhysicalDeviceVulkan13Features req_device_features_13{};
+    req_device_features_13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    req_device_features_13.synchronization2 = VK_TRUE;
+    req_device_features_12.pNext = physical_device.synchronization2 ? &req_device_features_13 : nullptr;
+
+    // 8 bit index buffers of small meshes, see MeshNodeLoader::MakeRenderNode().
+    VkPhysicalDeviceIndexTypeUint8FeaturesEXT req_index_type_uint8_features{};
+    req_index_type_uint8_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_INDEX_TYPE_UINT8_FEATURES_EXT;
+    req_index_type_uint8_features.indexTypeUint8 = VK_TRUE;
+
+    void* req_features_chain = (physical_device.timeline_semaphore || physical_device.synchronization2 || physical_device.descriptor_indexing) ? &req_device_features_12 : nullptr;
+    if(physical_device.index_type_uint8) {
+        req_index_type_uint8_features.pNext = req_features_chain;
+        req_features_chain = &req_index_type_uint8_features;
+    }
 
     VkDeviceCreateInfo device_create_info{};
     device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    device_create_info.pNext = req_features_chain;
     device_create_info.pQueueCreateInfos = queue_create_infos.data();
     device_create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
     device_create_info.pEnabledFeatures = &req_device_features;
@@ -1257,4 +1318,83 @@ bool VulkanDevice::isHostVisibleSingleHeapMemory(VkPhysicalDevice physical_devic
     }
 
     return false;
+}
+
+bool VulkanDevice::isTimelineSemaphoreSupported(VkPhysicalDevice physical_device, const VkPhysicalDeviceProperties& props) {
+    if(props.apiVersion < VK_API_VERSION_1_2 || VulkanInstance::getVkApiVersion() < VK_API_VERSION_1_2) {
+        return false;
+    }
+
+    VkPhysicalDeviceVulkan12Features features_12{};
+    features_12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &features_12;
+    vkGetPhysicalDeviceFeatures2(physical_device, &features);
+
+    return features_12.timelineSemaphore == VK_TRUE;
+}
+
+bool VulkanDevice::isSynchronization2Supported(VkPhysicalDevice physical_device, const VkPhysicalDeviceProperties& props) {
+    if(props.apiVersion < VK_API_VERSION_1_3 || VulkanInstance::getVkApiVersion() < VK_API_VERSION_1_3) {
+        return false;
+    }
+
+    VkPhysicalDeviceVulkan13Features features_13{};
+    features_13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &features_13;
+    vkGetPhysicalDeviceFeatures2(physical_device, &features);
+
+    return features_13.synchronization2 == VK_TRUE;
+}
+
+bool VulkanDevice::isDescriptorIndexingSupported(VkPhysicalDevice physical_device, const VkPhysicalDeviceProperties& props) {
+    if(props.apiVersion < VK_API_VERSION_1_2 || VulkanInstance::getVkApiVersion() < VK_API_VERSION_1_2) {
+        return false;
+    }
+
+    VkPhysicalDeviceVulkan12Features features_12{};
+    features_12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &features_12;
+    vkGetPhysicalDeviceFeatures2(physical_device, &features);
+
+    return
+        features_12.runtimeDescriptorArray == VK_TRUE &&
+        features_12.descriptorBindingPartiallyBound == VK_TRUE &&
+        features_12.descriptorBindingUpdateUnusedWhilePending == VK_TRUE &&
+        features_12.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE &&
+        features_12.descriptorBindingStorageBufferUpdateAfterBind == VK_TRUE &&
+        features_12.shaderSampledImageArrayNonUniformIndexing == VK_TRUE;
+}
+
+bool VulkanDevice::isIndexTypeUint8Supported(VkPhysicalDevice physical_device, const VkPhysicalDeviceProperties& props) {
+    if(props.apiVersion < VK_API_VERSION_1_1 || VulkanInstance::getVkApiVersion() < VK_API_VERSION_1_1) {
+        return false;
+    }
+
+    std::unordered_set<std::string> available_extensions = VulkanDeviceExtensions::getDeviceExtensionsFn<std::unordered_set<std::string>>(
+        physical_device,
+        nullptr,
+        [](const VkExtensionProperties& prop) { return std::string(prop.extensionName); }
+    );
+    if(!available_extensions.contains(VK_EXT_INDEX_TYPE_UINT8_EXTENSION_NAME)) {
+        return false;
+    }
+
+    VkPhysicalDeviceIndexTypeUint8FeaturesEXT index_type_uint8_features{};
+    index_type_uint8_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_INDEX_TYPE_UINT8_FEATURES_EXT;
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &index_type_uint8_features;
+    vkGetPhysicalDeviceFeatures2(physical_device, &features);
+
+    return index_type_uint8_features.indexTypeUint8 == VK_TRUE;
 }
\ No newline at end of file
@@ -13,6 +13,7 @@
 #include "vulkan_device_extensions.h"
 #include "vulkan_command_manager.h"
 #include "vulkan_buffer.h"
+#include "vulkan_device_memory_allocator.h"
 #include "../../tools/thread_pool.h"
 
 struct DeviceAbilities {
@@ -21,6 +22,10 @@ struct DeviceAbilities {
     VkPhysicalDeviceFeatures features;
     VkPhysicalDeviceMemoryProperties memory_properties;
     bool host_visible_single_heap_memory;
+    bool timeline_semaphore;
+    bool synchronization2;
+    bool descriptor_indexing;
+    bool index_type_uint8; // VK_EXT_index_type_uint8, enabled when supported
     int score;
 };
 
@@ -106,8 +111,11 @@ public:
     const DeviceAbilities& getDeviceAbilities() const;
     VkSampleCountFlagBits getMsaaSamples() const;
     bool checkFeaturesSupported(const VkPhysicalDeviceFeatures& features);
+    // Optional feature named by the device_feature attribute of render graph entries, an empty name is always enabled.
+    bool isFeatureEnabled(const std::string& feature_name) const;
     const std::shared_ptr<VulkanCommandManager>& getCommandManager() const;
     std::shared_ptr<VulkanCommandManager>& getCommandManager();
+    const std::shared_ptr<VulkanDeviceMemoryAllocator>& getMemoryAllocator() const;
 
     uint32_t findMemoryType(uint32_t type_filter, VkMemoryPropertyFlags properties) const;
     VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features, VkImageUsageFlags usage, VkExtent2D extent, uint32_t mip_levels, VkSampleCountFlags sample_count, VkImageCreateFlags flags = 0u, bool bgr_native = false) const;
@@ -147,6 +155,10 @@ private:
     static VkDevice createLogicalDevice(const DeviceAbilities& physical_device, const std::unordered_set<uint32_t>& family_indices, const VulkanDeviceExtensions& device_extensions, const VulkanInstanceLayersAndExtensions& instance_layers_and_extensions);
     static bool checkFeatures(const VkPhysicalDeviceFeatures& device_features, const VkPhysicalDeviceFeatures& features_to_check);
     static bool isHostVisibleSingleHeapMemory(VkPhysicalDevice physical_device);
+    static bool isTimelineSemaphoreSupported(VkPhysicalDevice physical_device, const VkPhysicalDeviceProperties& props);
+    static bool isSynchronization2Supported(VkPhysicalDevice physical_device, const VkPhysicalDeviceProperties& props);
+    static bool isDescriptorIndexingSupported(VkPhysicalDevice physical_device, const VkPhysicalDeviceProperties& props);
+    static bool isIndexTypeUint8Supported(VkPhysicalDevice physical_device, const VkPhysicalDeviceProperties& props);
     static uint64_t getFeaturesVector(const VkPhysicalDeviceFeatures& device_features);
 
     VulkanDeviceExtensions m_extensions;
@@ -154,6 +166,7 @@ private:
     VkSurfaceKHR m_surface;
     DeviceAbilities m_device_abilities;
     std::shared_ptr<VulkanCommandManager> m_command_manager;
+    std::shared_ptr<VulkanDeviceMemoryAllocator> m_memory_allocator;
     std::shared_ptr<ThreadPool> m_thread_pool;
 
     VkSampleCountFlagBits m_msaa_samples = VK_SAMPLE_COUNT_1_BIT;
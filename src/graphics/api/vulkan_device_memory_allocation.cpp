@@ -4,10 +4,26 @@ VkDeviceMemory DeviceAllocation::get_memory() const {
 	return m_base;
 }
 
-uint32_t DeviceAllocation::get_offset() const {
+VkDeviceSize DeviceAllocation::get_offset() const {
 	return m_offset;
 }
 
-uint32_t DeviceAllocation::get_size() const {
+VkDeviceSize DeviceAllocation::get_size() const {
 	return m_size;
-}
\ No newline at end of file
+}
+
+uint8_t* DeviceAllocation::get_host_pointer() const {
+	return m_host_base ? m_host_base + m_offset : nullptr;
+}
+
+uint32_t DeviceAllocation::get_memory_type() const {
+	return m_memory_type;
+}
+
+DeviceAllocation::Kind DeviceAllocation::get_kind() const {
+	return m_kind;
+}
+
+bool DeviceAllocation::is_valid() const {
+	return m_kind != Kind::NONE;
+}
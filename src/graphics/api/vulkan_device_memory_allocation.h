@@ -1,17 +1,42 @@
 #pragma once
 
-#define GLFW_INCLUDE_VULKAN
-#include <GLFW/glfw3.h>
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+
+#include "../../tools/arena_allocator.h"
+
+class VulkanDeviceMemoryAllocator;
 
 class DeviceAllocation {
 public:
+	enum class Kind : uint8_t {
+		NONE,
+		DEDICATED,
+		BUDDY,
+		SLAB
+	};
+
 	VkDeviceMemory get_memory() const;
-	uint32_t get_offset() const;
-	uint32_t get_size() const;
+	VkDeviceSize get_offset() const;
+	VkDeviceSize get_size() const;
+	uint8_t* get_host_pointer() const;
+	uint32_t get_memory_type() const;
+	Kind get_kind() const;
+	bool is_valid() const;
 
 private:
+	friend class VulkanDeviceMemoryAllocator;
+
 	VkDeviceMemory m_base = VK_NULL_HANDLE;
 	uint8_t *m_host_base = nullptr;
-	uint32_t m_offset = 0;
-	uint32_t m_size = 0;
-};
\ No newline at end of file
+	VkDeviceSize m_offset = 0;
+	VkDeviceSize m_size = 0;
+	uint32_t m_memory_type = 0;
+	Kind m_kind = Kind::NONE;
+
+	uint32_t m_pool_index = 0;
+	uint32_t m_slab_tier = 0;
+	void* m_block = nullptr;
+	ArenaAllocation m_slab_allocation;
+};
@@ -0,0 +1,273 @@
+#include "vulkan_device_memory_allocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+bool VulkanDeviceMemoryAllocator::init(VkDevice device, const VkPhysicalDeviceProperties& props, const VkPhysicalDeviceMemoryProperties& memory_properties) {
+    m_device = device;
+    m_memory_properties = memory_properties;
+    m_buffer_image_granularity = std::max<VkDeviceSize>(props.limits.bufferImageGranularity, 1u);
+    m_non_coherent_atom_size = std::max<VkDeviceSize>(props.limits.nonCoherentAtomSize, 1u);
+
+    uint32_t mode_count = static_cast<uint32_t>(AllocationMode::COUNT);
+    m_pools.resize(m_memory_properties.memoryTypeCount * mode_count);
+    for(uint32_t memory_type = 0u; memory_type < m_memory_properties.memoryTypeCount; ++memory_type) {
+        VkDeviceSize heap_size = m_memory_properties.memoryHeaps[m_memory_properties.memoryTypes[memory_type].heapIndex].size;
+        VkDeviceSize block_size = DEFAULT_BLOCK_SIZE;
+        if(heap_size <= 1024u * 1024u * 1024u) {
+            block_size = std::bit_floor(std::max<VkDeviceSize>(heap_size / 8u, MIN_BUDDY_BLOCK_SIZE));
+        }
+        for(uint32_t mode = 0u; mode < mode_count; ++mode) {
+            m_pools[memory_type * mode_count + mode] = std::make_unique<MemoryPool>(this, memory_type, block_size);
+        }
+    }
+
+    return true;
+}
+
+void VulkanDeviceMemoryAllocator::destroy() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(std::unique_ptr<MemoryPool>& pool : m_pools) {
+        pool->destroy();
+    }
+    m_pools.clear();
+}
+
+bool VulkanDeviceMemoryAllocator::allocate(const VkMemoryRequirements& mem_req, VkMemoryPropertyFlags properties, AllocationMode mode, DeviceAllocation& out_allocation) {
+    uint32_t memory_type = findMemoryType(mem_req.memoryTypeBits, properties);
+    VkDeviceSize size = mem_req.size;
+    VkDeviceSize alignment = std::max<VkDeviceSize>(mem_req.alignment, 1u);
+    if(isHostVisible(memory_type) && !isHostCoherent(memory_type)) {
+        alignment = std::max(alignment, m_non_coherent_atom_size);
+        size = (size + m_non_coherent_atom_size - 1u) / m_non_coherent_atom_size * m_non_coherent_atom_size;
+    }
+
+    out_allocation = DeviceAllocation{};
+    out_allocation.m_memory_type = memory_type;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t pool_index = getPoolIndex(memory_type, mode);
+    MemoryPool& pool = *m_pools[pool_index];
+    out_allocation.m_pool_index = pool_index;
+
+    for(uint32_t tier = 0u; tier < SLAB_TIER_COUNT; ++tier) {
+        ArenaAllocator& slab = pool.slabs[tier];
+        if(size > slab.get_max_allocation_size() || alignment > slab.get_block_alignment()) continue;
+        if(!slab.allocate(size, out_allocation.m_slab_allocation)) break;
+
+        MemoryBlock* block = static_cast<MemoryBlock*>(out_allocation.m_slab_allocation.heap->allocation.owner);
+        out_allocation.m_kind = DeviceAllocation::Kind::SLAB;
+        out_allocation.m_slab_tier = tier;
+        out_allocation.m_block = block;
+        out_allocation.m_base = block->memory;
+        out_allocation.m_host_base = block->mapped;
+        out_allocation.m_offset = out_allocation.m_slab_allocation.range.offset;
+        out_allocation.m_size = out_allocation.m_slab_allocation.range.size;
+        return true;
+    }
+
+    if(size <= pool.block_size / 2u && alignment <= pool.block_size) {
+        MemoryBlock* block = nullptr;
+        VkDeviceSize offset = 0u;
+        VkDeviceSize range_size = 0u;
+        if(pool.allocateRange(size, alignment, block, offset, range_size)) {
+            out_allocation.m_kind = DeviceAllocation::Kind::BUDDY;
+            out_allocation.m_block = block;
+            out_allocation.m_base = block->memory;
+            out_allocation.m_host_base = block->mapped;
+            out_allocation.m_offset = offset;
+            out_allocation.m_size = range_size;
+            return true;
+        }
+    }
+
+    uint8_t* mapped = nullptr;
+    VkDeviceMemory memory = allocateDeviceMemory(memory_type, size, &mapped);
+    if(memory == VK_NULL_HANDLE) {
+        return false;
+    }
+    out_allocation.m_kind = DeviceAllocation::Kind::DEDICATED;
+    out_allocation.m_base = memory;
+    out_allocation.m_host_base = mapped;
+    out_allocation.m_offset = 0u;
+    out_allocation.m_size = size;
+
+    return true;
+}
+
+void VulkanDeviceMemoryAllocator::free(DeviceAllocation& allocation) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    switch(allocation.m_kind) {
+        case DeviceAllocation::Kind::SLAB: {
+            m_pools[allocation.m_pool_index]->slabs[allocation.m_slab_tier].free(allocation.m_slab_allocation);
+            break;
+        }
+        case DeviceAllocation::Kind::BUDDY: {
+            m_pools[allocation.m_pool_index]->freeRange(static_cast<MemoryBlock*>(allocation.m_block), allocation.m_offset, allocation.m_size);
+            break;
+        }
+        case DeviceAllocation::Kind::DEDICATED: {
+            m_allocated_bytes -= allocation.m_size;
+            freeDeviceMemory(allocation.m_base, allocation.m_host_base != nullptr);
+            break;
+        }
+        default: break;
+    }
+    allocation = DeviceAllocation{};
+}
+
+VkMappedMemoryRange VulkanDeviceMemoryAllocator::getMappedRange(const DeviceAllocation& allocation) const {
+    VkMappedMemoryRange range{};
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.pNext = nullptr;
+    range.memory = allocation.get_memory();
+    range.offset = allocation.get_offset();
+    range.size = allocation.get_kind() == DeviceAllocation::Kind::DEDICATED ? VK_WHOLE_SIZE : allocation.get_size();
+    return range;
+}
+
+uint32_t VulkanDeviceMemoryAllocator::getDeviceAllocationCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_device_allocation_count;
+}
+
+VkDeviceSize VulkanDeviceMemoryAllocator::getAllocatedBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_allocated_bytes;
+}
+
+VkDeviceMemory VulkanDeviceMemoryAllocator::allocateDeviceMemory(uint32_t memory_type, VkDeviceSize size, uint8_t** out_mapped) {
+    VkMemoryAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.pNext = nullptr;
+    alloc_info.allocationSize = size;
+    alloc_info.memoryTypeIndex = memory_type;
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkResult result = vkAllocateMemory(m_device, &alloc_info, nullptr, &memory);
+    if(result != VK_SUCCESS) {
+        return VK_NULL_HANDLE;
+    }
+    ++m_device_allocation_count;
+    m_allocated_bytes += size;
+
+    *out_mapped = nullptr;
+    if(isHostVisible(memory_type)) {
+        void* mapped = nullptr;
+        result = vkMapMemory(m_device, memory, 0u, VK_WHOLE_SIZE, 0u, &mapped);
+        if(result != VK_SUCCESS) {
+            throw std::runtime_error("failed to map device memory!");
+        }
+        *out_mapped = static_cast<uint8_t*>(mapped);
+    }
+
+    return memory;
+}
+
+void VulkanDeviceMemoryAllocator::freeDeviceMemory(VkDeviceMemory memory, bool mapped) {
+    if(mapped) {
+        vkUnmapMemory(m_device, memory);
+    }
+    vkFreeMemory(m_device, memory, nullptr);
+    --m_device_allocation_count;
+}
+
+uint32_t VulkanDeviceMemoryAllocator::findMemoryType(uint32_t type_filter, VkMemoryPropertyFlags properties) const {
+    for(uint32_t i = 0u; i < m_memory_properties.memoryTypeCount; ++i) {
+        bool is_type_suit = type_filter & (1 << i);
+        bool is_type_adequate = m_memory_properties.memoryTypes[i].propertyFlags & properties;
+        if(is_type_suit && is_type_adequate) {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("failed to find suitable memory type!");
+}
+
+bool VulkanDeviceMemoryAllocator::isHostVisible(uint32_t memory_type) const {
+    return m_memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+}
+
+bool VulkanDeviceMemoryAllocator::isHostCoherent(uint32_t memory_type) const {
+    return m_memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+}
+
+uint32_t VulkanDeviceMemoryAllocator::getPoolIndex(uint32_t memory_type, AllocationMode mode) const {
+    if(m_buffer_image_granularity <= 1u) {
+        mode = AllocationMode::LINEAR;
+    }
+    return memory_type * static_cast<uint32_t>(AllocationMode::COUNT) + static_cast<uint32_t>(mode);
+}
+
+VulkanDeviceMemoryAllocator::MemoryPool::MemoryPool(VulkanDeviceMemoryAllocator* owner, uint32_t memory_type, VkDeviceSize block_size) : memory_type(memory_type), block_size(block_size), m_owner(owner) {
+    for(uint32_t tier = 0u; tier < SLAB_TIER_COUNT; ++tier) {
+        slabs[tier].set_sub_block_size(SLAB_SUB_BLOCK_SIZES[tier]);
+        slabs[tier].set_backing_allocator(this);
+    }
+}
+
+bool VulkanDeviceMemoryAllocator::MemoryPool::allocate_backing_heap(uint64_t size, BackingAllocation& backing) {
+    MemoryBlock* block = nullptr;
+    VkDeviceSize offset = 0u;
+    VkDeviceSize range_size = 0u;
+    if(!allocateRange(size, size, block, offset, range_size)) {
+        return false;
+    }
+    backing.offset = offset;
+    backing.size = range_size;
+    backing.owner = block;
+
+    return true;
+}
+
+void VulkanDeviceMemoryAllocator::MemoryPool::free_backing_heap(const BackingAllocation& backing) {
+    freeRange(static_cast<MemoryBlock*>(backing.owner), backing.offset, backing.size);
+}
+
+bool VulkanDeviceMemoryAllocator::MemoryPool::allocateRange(VkDeviceSize size, VkDeviceSize alignment, MemoryBlock*& out_block, VkDeviceSize& out_offset, VkDeviceSize& out_size) {
+    for(std::unique_ptr<MemoryBlock>& block : blocks) {
+        if(block->buddy.allocate(size, alignment, out_offset, out_size)) {
+            out_block = block.get();
+            return true;
+        }
+    }
+
+    std::unique_ptr<MemoryBlock> block = std::make_unique<MemoryBlock>(block_size);
+    block->memory = m_owner->allocateDeviceMemory(memory_type, block->buddy.get_capacity(), &block->mapped);
+    if(block->memory == VK_NULL_HANDLE) {
+        return false;
+    }
+    if(!block->buddy.allocate(size, alignment, out_offset, out_size)) {
+        return false;
+    }
+    out_block = block.get();
+    blocks.push_back(std::move(block));
+
+    return true;
+}
+
+void VulkanDeviceMemoryAllocator::MemoryPool::freeRange(MemoryBlock* block, VkDeviceSize offset, VkDeviceSize size) {
+    block->buddy.free(offset, size);
+    if(!block->buddy.empty() || blocks.size() <= 1u) {
+        return;
+    }
+
+    auto it = std::find_if(blocks.begin(), blocks.end(), [block](const std::unique_ptr<MemoryBlock>& b) { return b.get() == block; });
+    if(it != blocks.end()) {
+        m_owner->m_allocated_bytes -= block->buddy.get_capacity();
+        m_owner->freeDeviceMemory(block->memory, block->mapped != nullptr);
+        blocks.erase(it);
+    }
+}
+
+void VulkanDeviceMemoryAllocator::MemoryPool::destroy() {
+    for(ArenaAllocator& slab : slabs) {
+        slab.set_backing_allocator(nullptr);
+    }
+    for(std::unique_ptr<MemoryBlock>& block : blocks) {
+        m_owner->m_allocated_bytes -= block->buddy.get_capacity();
+        m_owner->freeDeviceMemory(block->memory, block->mapped != nullptr);
+    }
+    blocks.clear();
+}
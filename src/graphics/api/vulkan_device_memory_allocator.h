@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "vulkan_device_memory_allocation.h"
+#include "../../tools/arena_allocator.h"
+#include "../../tools/buddy_allocator.h"
+
+// Suballocates buffers and images out of large per memory type VkDeviceMemory blocks. Small requests go to bitmask
+// slabs whose mini heaps are carved out of the blocks by a buddy allocator, bigger ones get a buddy range and anything
+// larger than half a block gets a dedicated allocation. Linear and optimal resources never share a block when
+// bufferImageGranularity is above 1, so the granularity rule can not be violated.
+class VulkanDeviceMemoryAllocator {
+public:
+    enum class AllocationMode : uint32_t {
+        LINEAR,
+        OPTIMAL,
+        COUNT
+    };
+
+    static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64u * 1024u * 1024u;
+    static constexpr VkDeviceSize MIN_BUDDY_BLOCK_SIZE = 8u * 1024u;
+    static constexpr uint32_t SLAB_TIER_COUNT = 2u;
+    static constexpr std::array<VkDeviceSize, SLAB_TIER_COUNT> SLAB_SUB_BLOCK_SIZES = { 256u, 8u * 1024u };
+
+    bool init(VkDevice device, const VkPhysicalDeviceProperties& props, const VkPhysicalDeviceMemoryProperties& memory_properties);
+    void destroy();
+
+    bool allocate(const VkMemoryRequirements& mem_req, VkMemoryPropertyFlags properties, AllocationMode mode, DeviceAllocation& out_allocation);
+    void free(DeviceAllocation& allocation);
+
+    VkMappedMemoryRange getMappedRange(const DeviceAllocation& allocation) const;
+
+    uint32_t getDeviceAllocationCount() const;
+    VkDeviceSize getAllocatedBytes() const;
+
+private:
+    struct MemoryBlock {
+        MemoryBlock(VkDeviceSize size) : buddy(size, MIN_BUDDY_BLOCK_SIZE) {}
+
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        uint8_t* mapped = nullptr;
+        BuddyAllocator buddy;
+    };
+
+    class MemoryPool : public IBackingAllocator {
+    public:
+        MemoryPool(VulkanDeviceMemoryAllocator* owner, uint32_t memory_type, VkDeviceSize block_size);
+
+        bool allocate_backing_heap(uint64_t size, BackingAllocation& backing) override;
+        void free_backing_heap(const BackingAllocation& backing) override;
+
+        bool allocateRange(VkDeviceSize size, VkDeviceSize alignment, MemoryBlock*& out_block, VkDeviceSize& out_offset, VkDeviceSize& out_size);
+        void freeRange(MemoryBlock* block, VkDeviceSize offset, VkDeviceSize size);
+        void destroy();
+
+        uint32_t memory_type;
+        VkDeviceSize block_size;
+        std::vector<std::unique_ptr<MemoryBlock>> blocks;
+        std::array<ArenaAllocator, SLAB_TIER_COUNT> slabs;
+
+    private:
+        VulkanDeviceMemoryAllocator* m_owner;
+    };
+
+    VkDeviceMemory allocateDeviceMemory(uint32_t memory_type, VkDeviceSize size, uint8_t** out_mapped);
+    void freeDeviceMemory(VkDeviceMemory memory, bool mapped);
+    uint32_t findMemoryType(uint32_t type_filter, VkMemoryPropertyFlags properties) const;
+    bool isHostVisible(uint32_t memory_type) const;
+    bool isHostCoherent(uint32_t memory_type) const;
+    uint32_t getPoolIndex(uint32_t memory_type, AllocationMode mode) const;
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties m_memory_properties{};
+    VkDeviceSize m_buffer_image_granularity = 1u;
+    VkDeviceSize m_non_coherent_atom_size = 1u;
+    std::vector<std::unique_ptr<MemoryPool>> m_pools;
+
+    uint32_t m_device_allocation_count = 0u;
+    VkDeviceSize m_allocated_bytes = 0u;
+    mutable std::mutex m_mutex;
+};
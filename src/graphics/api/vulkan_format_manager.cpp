@@ -32,4 +32,23 @@ bool VulkanFormatManager::init(std::shared_ptr<VulkanDevice> device, const std::
 
 std::shared_ptr<FormatConfig> VulkanFormatManager::getFormat(const std::string& name) {
 	return m_format_map.at(name);
-}
\ No newline at end of file
+}
+
+bool VulkanFormatManager::isTextureFormatSupported(VkFormat format, VkImageUsageFlags usage) {
+    const uint64_t key = (static_cast<uint64_t>(format) << 32u) | usage;
+    if(auto it = m_texture_format_support.find(key); it != m_texture_format_support.end()) {
+        return it->second;
+    }
+
+    VkFormatFeatureFlags features = 0u;
+    if(usage & VK_IMAGE_USAGE_SAMPLED_BIT) features |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    if(usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) features |= VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+    if(usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) features |= VK_FORMAT_FEATURE_TRANSFER_SRC_BIT;
+
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(m_device->getDeviceAbilities().physical_device, format, &props);
+    const bool supported = (props.optimalTilingFeatures & features) == features && m_device->checkFormatSupported(format, VK_IMAGE_TILING_OPTIMAL, usage, {1u, 1u}, 1u, VK_SAMPLE_COUNT_1_BIT);
+
+    m_texture_format_support[key] = supported;
+    return supported;
+}
@@ -19,8 +19,12 @@ public:
     bool init(std::shared_ptr<VulkanDevice> device, const std::shared_ptr<WindowSurface>& window, const std::string& rg_file_path);
     
     std::shared_ptr<FormatConfig> getFormat(const std::string& name);
+    // Whether pre-encoded textures (KTX2 files) of the format can be created with the usage, sampled ones need linear
+    // filtering too. Answers are cached per format and usage.
+    bool isTextureFormatSupported(VkFormat format, VkImageUsageFlags usage);
 
 private:
     std::shared_ptr<VulkanDevice> m_device;
     std::unordered_map<std::string, std::shared_ptr<FormatConfig>> m_format_map;
+    std::unordered_map<uint64_t, bool> m_texture_format_support;
 };
\ No newline at end of file
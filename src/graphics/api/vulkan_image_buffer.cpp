@@ -5,10 +5,14 @@
 #include "../pod/format_config.h"
 #include "../pod/image_buffer_config.h"
 #include "vulkan_resources_manager.h"
+#include "vulkan_upload_manager.h"
 #include "../../application.h"
 #include "../vulkan_renderer.h"
+#include "../../tools/ktx2_file.h"
 
 #include <bit>
+#include <filesystem>
+#include <utility>
 
 // #ifdef STB_IMAGE_IMPLEMENTATION
 // #undef STB_IMAGE_IMPLEMENTATION
@@ -75,6 +79,19 @@ bool VulkanImageBuffer::init(VkImage image, std::shared_ptr<ImageBufferConfig> i
     return true;
 }
 
+VkMemoryPropertyFlags VulkanImageBuffer::getAllocationProperties(const VkMemoryRequirements& mem_req) const {
+    if(!(m_image_config->getImageInfo().usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)) return m_image_config->getMemoryProperties();
+
+    // Transient attachments prefer lazily allocated memory, tile based GPUs then only commit what leaves the tiles.
+    const VkPhysicalDeviceMemoryProperties& memory_properties = m_device->getDeviceAbilities().memory_properties;
+    for(uint32_t i = 0u; i < memory_properties.memoryTypeCount; ++i) {
+        if((mem_req.memoryTypeBits & (1u << i)) && (memory_properties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)) {
+            return VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+        }
+    }
+    return m_image_config->getMemoryProperties();
+}
+
 bool VulkanImageBuffer::init(unsigned char* pixels, std::shared_ptr<ImageBufferConfig> image_buffer_config) {
     using namespace std::literals;
 
@@ -119,19 +136,13 @@ bool VulkanImageBuffer::init(unsigned char* pixels, std::shared_ptr<ImageBufferC
         }
     }
     
-    uint32_t mem_type_idx = m_device->findMemoryType(mem_req.memoryTypeBits, m_image_config->getMemoryProperties());
-    VkMemoryAllocateInfo alloc_info{};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = mem_req.size;
-    alloc_info.memoryTypeIndex = mem_type_idx;
-    
-    result = vkAllocateMemory(m_device->getDevice(), &alloc_info, nullptr, &m_memory);
-    if(result != VK_SUCCESS) {
+    VulkanDeviceMemoryAllocator::AllocationMode allocation_mode = m_image_config->getImageInfo().tiling == VK_IMAGE_TILING_LINEAR ? VulkanDeviceMemoryAllocator::AllocationMode::LINEAR : VulkanDeviceMemoryAllocator::AllocationMode::OPTIMAL;
+    if(!m_device->getMemoryAllocator()->allocate(mem_req, getAllocationProperties(mem_req), allocation_mode, m_allocation)) {
         throw std::runtime_error("failed to allocate image memory!");
     }
+    m_memory = m_allocation.get_memory();
 
-    VkDeviceSize offset = 0u;
-    vkBindImageMemory(m_device->getDevice(), m_image, m_memory, offset);
+    vkBindImageMemory(m_device->getDevice(), m_image, m_memory, m_allocation.get_offset());
 
     for(auto&[view_type_name, view_cfg_ptr] : m_image_config->getViewInfoMap()) {
         view_cfg_ptr->image_view_info.image = m_image;
@@ -157,42 +168,7 @@ bool VulkanImageBuffer::init(unsigned char* pixels, std::shared_ptr<ImageBufferC
         return true;
     }
 
-    std::shared_ptr<VulkanBuffer> staging_buffer = Application::Get().GetRenderer().getResourcesManager()->create_buffer(pixels, m_image_config->getFormat()->getRawFormatBytesCount(), "basic_staging_buffer"s);
-    std::shared_ptr<CommandBatch> command_buffer = m_device->getCommandManager()->allocCommandBufferPtr(PoolTypeEnum::TRANSFER);
-    command_buffer->addResource(staging_buffer);
-
-    if(m_image_config->getImageInfo().initialLayout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        m_device->getCommandManager()->transitionImageLayout(
-            command_buffer->getCommandBufer(),
-            m_image,
-            m_image_config->getImageInfo().format,
-            m_image_config->getImageInfo().initialLayout,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            m_image_config->getImageInfo().mipLevels
-        );
-    }
-    m_device->getCommandManager()->copyBufferToImage(
-        command_buffer->getCommandBufer(),
-        staging_buffer->getBuffer(),
-        m_image,
-        m_image_config->getImageInfo().extent,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-    );
-
-    if(m_image_config->getImageInfo().mipLevels != 1u) {
-        m_device->getCommandManager()->generateMipmaps(
-            command_buffer->getCommandBufer(),
-            m_image,
-            m_image_config->getImageInfo().format,
-            m_image_config->getFormat()->getExtent2D(),
-            m_image_config->getImageInfo().mipLevels,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            m_image_config->getAfterInitLayout()
-        );
-    }
-    m_device->getCommandManager()->submitCommandBuffer(command_buffer);
-    m_device->getCommandManager()->wait(PoolTypeEnum::TRANSFER);
-    command_buffer->destroy();
+    Application::Get().GetRenderer().getUploadManager()->uploadImage(m_image, m_image_config->getImageInfo(), pixels, m_image_config->getFormat()->getRawFormatBytesCount(), m_image_config->getAfterInitLayout());
 
     return true;
 }
@@ -200,6 +176,10 @@ bool VulkanImageBuffer::init(unsigned char* pixels, std::shared_ptr<ImageBufferC
 bool VulkanImageBuffer::init(const std::shared_ptr<ImageBufferConfig>& image_buffer_config_template, const std::string& path_to_file) {
     using namespace std::literals;
 
+    if(std::filesystem::path(path_to_file).extension() == ".ktx2") {
+        return initKtx2(image_buffer_config_template, path_to_file);
+    }
+
     int tex_width;
     int tex_height;
     int tex_channels;
@@ -262,19 +242,13 @@ bool VulkanImageBuffer::init(std::shared_ptr<CommandBatch>& command_buffer, unsi
         }
     }
     
-    uint32_t mem_type_idx = m_device->findMemoryType(mem_req.memoryTypeBits, m_image_config->getMemoryProperties());
-    VkMemoryAllocateInfo alloc_info{};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = mem_req.size;
-    alloc_info.memoryTypeIndex = mem_type_idx;
-    
-    result = vkAllocateMemory(m_device->getDevice(), &alloc_info, nullptr, &m_memory);
-    if(result != VK_SUCCESS) {
+    VulkanDeviceMemoryAllocator::AllocationMode allocation_mode = m_image_config->getImageInfo().tiling == VK_IMAGE_TILING_LINEAR ? VulkanDeviceMemoryAllocator::AllocationMode::LINEAR : VulkanDeviceMemoryAllocator::AllocationMode::OPTIMAL;
+    if(!m_device->getMemoryAllocator()->allocate(mem_req, getAllocationProperties(mem_req), allocation_mode, m_allocation)) {
         throw std::runtime_error("failed to allocate image memory!");
     }
+    m_memory = m_allocation.get_memory();
 
-    VkDeviceSize offset = 0u;
-    vkBindImageMemory(m_device->getDevice(), m_image, m_memory, offset);
+    vkBindImageMemory(m_device->getDevice(), m_image, m_memory, m_allocation.get_offset());
 
     for(const auto&[view_type_name, view_cfg_ptr] : m_image_config->getViewInfoMap()) {
         view_cfg_ptr->image_view_info.image = m_image;
@@ -288,40 +262,7 @@ bool VulkanImageBuffer::init(std::shared_ptr<CommandBatch>& command_buffer, unsi
         return true;
     }
 
-    std::shared_ptr<VulkanBuffer> staging_buffer = Application::Get().GetRenderer().getResourcesManager()->create_buffer(pixels, m_image_size, "basic_staging_buffer"s);
-    command_buffer->addResource(staging_buffer);
-
-    if(m_image_config->getImageInfo().initialLayout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        m_device->getCommandManager()->transitionImageLayout(
-            command_buffer->getCommandBufer(),
-            m_image,
-            m_image_config->getImageInfo().format,
-            m_image_config->getImageInfo().initialLayout,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            m_image_config->getImageInfo().mipLevels
-        );
-    }
-    m_device->getCommandManager()->copyBufferToImage(
-        command_buffer->getCommandBufer(),
-        staging_buffer->getBuffer(),
-        m_image,
-        m_image_config->getImageInfo().extent,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-    );
-
-    if(m_image_config->getImageInfo().mipLevels != 1u) {
-        m_device->getCommandManager()->generateMipmaps(
-            command_buffer->getCommandBufer(),
-            m_image,
-            m_image_config->getImageInfo().format,
-            m_image_config->getFormat()->getExtent2D(),
-            m_image_config->getImageInfo().mipLevels,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            m_image_config->getAfterInitLayout()
-        );
-    }
-    m_device->getCommandManager()->submitCommandBuffer(command_buffer);
-    m_device->getCommandManager()->wait(PoolTypeEnum::TRANSFER);
+    Application::Get().GetRenderer().getUploadManager()->uploadImage(m_image, m_image_config->getImageInfo(), pixels, m_image_config->getFormat()->getRawFormatBytesCount(), m_image_config->getAfterInitLayout());
 
     return true;
 }
@@ -329,6 +270,10 @@ bool VulkanImageBuffer::init(std::shared_ptr<CommandBatch>& command_buffer, unsi
 bool VulkanImageBuffer::init(std::shared_ptr<CommandBatch>& command_buffer, const std::shared_ptr<ImageBufferConfig>& image_buffer_config_template, const std::string& path_to_file) {
     using namespace std::literals;
 
+    if(std::filesystem::path(path_to_file).extension() == ".ktx2") {
+        return initKtx2(image_buffer_config_template, path_to_file);
+    }
+
     int tex_width;
     int tex_height;
     int tex_channels;
@@ -346,6 +291,28 @@ bool VulkanImageBuffer::init(std::shared_ptr<CommandBatch>& command_buffer, cons
     return result;
 }
 
+// Levels are uploaded as stored, nothing is generated.
+bool VulkanImageBuffer::initKtx2(const std::shared_ptr<ImageBufferConfig>& image_buffer_config_template, const std::string& path_to_file) {
+    using namespace std::literals;
+
+    Ktx2File ktx2_file;
+    if(!ktx2_file.load(path_to_file)) {
+        throw std::runtime_error("failed to load ktx2 texture image!");
+    }
+
+    std::shared_ptr<ImageBufferConfig> image_buffer_config = image_buffer_config_template->makeInstance(path_to_file + "_cfg"s, ktx2_file.getExtent());
+    image_buffer_config->setVkFormat(ktx2_file.getFormat());
+    image_buffer_config->setMipLevels(ktx2_file.getLevelCount());
+    if(!init((unsigned char*)nullptr, std::move(image_buffer_config))) {
+        return false;
+    }
+
+    std::vector<unsigned char>& levels = ktx2_file.getLevels();
+    Application::Get().GetRenderer().getUploadManager()->uploadImageMips(m_image, m_image_config->getImageInfo(), 0u, ktx2_file.getLevelCount(), levels.data(), levels.size(), m_image_config->getAfterInitLayout());
+
+    return true;
+}
+
 void VulkanImageBuffer::destroy() {
     //m_image_config->destroy();
     for (auto&[view_name, vk_view] : m_image_view_map) {
@@ -355,12 +322,21 @@ void VulkanImageBuffer::destroy() {
 
     if(!m_image_config->isExternalMemoryControl()) {
         vkDestroyImage(m_device->getDevice(), m_image, nullptr);
-        vkFreeMemory(m_device->getDevice(), m_memory, nullptr);
+        m_device->getMemoryAllocator()->free(m_allocation);
     }
     m_image = VK_NULL_HANDLE;
     m_memory = VK_NULL_HANDLE;
 }
 
+void VulkanImageBuffer::swapContents(VulkanImageBuffer& other) {
+    std::swap(m_image, other.m_image);
+    std::swap(m_memory, other.m_memory);
+    std::swap(m_allocation, other.m_allocation);
+    std::swap(m_image_size, other.m_image_size);
+    std::swap(m_image_view_map, other.m_image_view_map);
+    std::swap(m_image_config, other.m_image_config);
+}
+
 VkImage VulkanImageBuffer::getImageBuffer() const {
     return m_image;
 }
@@ -407,9 +383,7 @@ std::shared_ptr<ImageBufferConfig>& VulkanImageBuffer::getImageConfig() {
 }
 
 void VulkanImageBuffer::changeLayout(VkImageLayout old_layout, VkImageLayout new_layout) {
-    std::shared_ptr<CommandBatch> command_buffer = m_device->getCommandManager()->allocCommandBufferPtr(PoolTypeEnum::TRANSFER);
-    changeLayout(command_buffer, old_layout, new_layout);
-    command_buffer->destroy();
+    Application::Get().GetRenderer().getUploadManager()->transitionImage(m_image, m_image_config->getImageInfo().format, old_layout, new_layout, m_image_config->getImageInfo().mipLevels);
 }
 
 void VulkanImageBuffer::changeLayout(std::shared_ptr<CommandBatch>& command_buffer, VkImageLayout old_layout, VkImageLayout new_layout) {
@@ -422,7 +396,7 @@ void VulkanImageBuffer::changeLayout(std::shared_ptr<CommandBatch>& command_buff
         m_image_config->getImageInfo().mipLevels
     );
     m_device->getCommandManager()->submitCommandBuffer(command_buffer);
-    m_device->getCommandManager()->wait(PoolTypeEnum::TRANSFER);
+    m_device->getCommandManager()->wait(command_buffer->getPoolType());
 }
 
 const RenderResource::ResourceName& VulkanImageBuffer::getName() const {
@@ -1,7 +1,6 @@
  #pragma once
 
-#define GLFW_INCLUDE_VULKAN
-#include <GLFW/glfw3.h>
+#include <vulkan/vulkan.h>
 
 #include <cstdint>
 #include <memory>
@@ -10,6 +9,7 @@
 
 #include "../pod/render_resource.h"
 #include "vulkan_command_buffer.h"
+#include "vulkan_device_memory_allocation.h"
 
 class VulkanDevice;
 class ImageBufferConfig;
@@ -21,12 +21,16 @@ public:
 
     bool init(VkImage image, std::shared_ptr<ImageBufferConfig> image_buffer_config);
     bool init(unsigned char* pixels, std::shared_ptr<ImageBufferConfig> image_buffer_config);
+    // KTX2 files keep their format and levels, other images are decoded to the template's format.
     bool init(const std::shared_ptr<ImageBufferConfig>& image_buffer_config_template, const std::string& path_to_file);
     bool init(std::shared_ptr<ImageBufferConfig> image_buffer_config);
     bool init(std::shared_ptr<CommandBatch>& command_buffer, unsigned char* pixels, std::shared_ptr<ImageBufferConfig> image_buffer_config);
     bool init(std::shared_ptr<CommandBatch>& command_buffer, const std::shared_ptr<ImageBufferConfig>& image_buffer_config_template, const std::string& path_to_file);
 
     void destroy() override;
+    // Exchanges the image, memory, views and config with other, the names stay. Holders of this object see the other
+    // contents from then on, descriptors written with the old views have to be refreshed by their owners.
+    void swapContents(VulkanImageBuffer& other);
 
     VkImage getImageBuffer() const;
     VkImageView getImageBufferView() const;
@@ -47,12 +51,15 @@ public:
     Type getType() const override;
 
 protected:
+    VkMemoryPropertyFlags getAllocationProperties(const VkMemoryRequirements& mem_req) const;
+    bool initKtx2(const std::shared_ptr<ImageBufferConfig>& image_buffer_config_template, const std::string& path_to_file);
 
     std::shared_ptr<VulkanDevice> m_device;
     ResourceName m_name;
 
     VkImage m_image;
     VkDeviceMemory m_memory;
+    DeviceAllocation m_allocation;
     VkDeviceSize m_image_size;
     
     std::unordered_map<std::string, VkImageView> m_image_view_map;
@@ -17,9 +17,9 @@ public:
 
     VkInstance getInstance() const;
     const VulkanInstanceLayersAndExtensions& getLayersAndExtensions() const;
+    static uint32_t getVkApiVersion();
 
 private:
-    static uint32_t getVkApiVersion();
     static void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& messenger_info);
     static VkDebugUtilsMessengerEXT setupDebugMessanger(VkInstance instance);
     static VkResult CreateDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT* p_create_info, const VkAllocationCallbacks* p_allocator, VkDebugUtilsMessengerEXT* p_debug_messenger);
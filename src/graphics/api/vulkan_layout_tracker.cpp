@@ -1,2 +1,530 @@
 #include "vulkan_layout_tracker.h"
 
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    constexpr VkAccessFlags2 WRITE_ACCESS_MASK =
+        VK_ACCESS_2_SHADER_WRITE_BIT |
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+        VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+        VK_ACCESS_2_TRANSFER_WRITE_BIT |
+        VK_ACCESS_2_HOST_WRITE_BIT |
+        VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+    uint32_t resolveCount(uint32_t base, uint32_t count, uint32_t total) {
+        return count == VK_REMAINING_MIP_LEVELS ? total - base : count; // VK_REMAINING_ARRAY_LAYERS has the same value
+    }
+
+    bool sameSync(const VkImageMemoryBarrier2& a, const VkImageMemoryBarrier2& b) {
+        return a.srcStageMask == b.srcStageMask && a.srcAccessMask == b.srcAccessMask &&
+               a.dstStageMask == b.dstStageMask && a.dstAccessMask == b.dstAccessMask &&
+               a.oldLayout == b.oldLayout && a.newLayout == b.newLayout &&
+               a.subresourceRange.baseMipLevel == b.subresourceRange.baseMipLevel &&
+               a.subresourceRange.levelCount == b.subresourceRange.levelCount;
+    }
+}
+
+bool VulkanLayoutTracker::Barriers::empty() const {
+    return image_barriers.empty() && buffer_barriers.empty();
+}
+
+void VulkanLayoutTracker::Barriers::clear() {
+    image_barriers.clear();
+    buffer_barriers.clear();
+}
+
+void VulkanLayoutTracker::registerImage(VkImage image, VkImageAspectFlags aspect, uint32_t mip_levels, uint32_t array_layers, VkImageLayout initial_layout) {
+    ImageTrack& track = m_images[image];
+    track.aspect = aspect;
+    track.mip_levels = std::max(mip_levels, 1u);
+    track.array_layers = std::max(array_layers, 1u);
+
+    State initial_state;
+    initial_state.layout = initial_layout;
+    track.subresources.assign(static_cast<size_t>(track.mip_levels) * track.array_layers, initial_state);
+    track.requested_ranges.clear();
+    track.requested_accesses.clear();
+}
+
+void VulkanLayoutTracker::registerBuffer(VkBuffer buffer, VkDeviceSize size) {
+    BufferTrack& track = m_buffers[buffer];
+    track.size = size;
+    track.segments.assign(1u, BufferSegment{0u, size, State{}});
+    track.requests.clear();
+}
+
+void VulkanLayoutTracker::unregisterImage(VkImage image) {
+    m_images.erase(image);
+    std::erase(m_pending_images, image);
+}
+
+void VulkanLayoutTracker::unregisterBuffer(VkBuffer buffer) {
+    m_buffers.erase(buffer);
+    std::erase(m_pending_buffers, buffer);
+}
+
+bool VulkanLayoutTracker::isImageRegistered(VkImage image) const {
+    return m_images.contains(image);
+}
+
+bool VulkanLayoutTracker::isBufferRegistered(VkBuffer buffer) const {
+    return m_buffers.contains(buffer);
+}
+
+void VulkanLayoutTracker::requestImage(VkImage image, const VkImageSubresourceRange& range, const Access& access) {
+    ImageTrack& track = getImageTrack(image);
+    if(track.requested_ranges.empty()) {
+        m_pending_images.push_back(image);
+    }
+    track.requested_ranges.push_back(range);
+    track.requested_accesses.push_back(access);
+}
+
+void VulkanLayoutTracker::requestBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const Access& access) {
+    BufferTrack& track = getBufferTrack(buffer);
+    if(offset >= track.size) return;
+
+    if(track.requests.empty()) {
+        m_pending_buffers.push_back(buffer);
+    }
+    size = size == VK_WHOLE_SIZE ? track.size - offset : std::min(size, track.size - offset);
+    track.requests.push_back(BufferRequest{offset, size, access});
+}
+
+void VulkanLayoutTracker::resolve(Barriers& barriers) {
+    barriers.clear();
+
+    try {
+        for(VkImage image : m_pending_images) {
+            resolveImage(image, m_images.at(image), barriers);
+        }
+        for(VkBuffer buffer : m_pending_buffers) {
+            resolveBuffer(buffer, m_buffers.at(buffer), barriers);
+        }
+    }
+    catch(...) {
+        dropRequests();
+        throw;
+    }
+    m_pending_images.clear();
+    m_pending_buffers.clear();
+}
+
+void VulkanLayoutTracker::dropRequests() {
+    for(VkImage image : m_pending_images) {
+        ImageTrack& track = m_images.at(image);
+        track.requested_ranges.clear();
+        track.requested_accesses.clear();
+    }
+    m_pending_images.clear();
+
+    for(VkBuffer buffer : m_pending_buffers) {
+        m_buffers.at(buffer).requests.clear();
+    }
+    m_pending_buffers.clear();
+}
+
+void VulkanLayoutTracker::setImageState(VkImage image, const VkImageSubresourceRange& range, const Access& access) {
+    ImageTrack& track = getImageTrack(image);
+
+    State state;
+    state.layout = access.layout;
+    state.write_stage = access.stage;
+    state.write_access = access.access & WRITE_ACCESS_MASK;
+    if(!isWriteAccess(access.access)) {
+        state.read_stages = access.stage;
+        state.visible_stages = access.stage;
+        state.visible_access = access.access;
+    }
+
+    const uint32_t layer_count = resolveCount(range.baseArrayLayer, range.layerCount, track.array_layers);
+    const uint32_t level_count = resolveCount(range.baseMipLevel, range.levelCount, track.mip_levels);
+    for(uint32_t layer = range.baseArrayLayer; layer < range.baseArrayLayer + layer_count; ++layer) {
+        for(uint32_t mip = range.baseMipLevel; mip < range.baseMipLevel + level_count; ++mip) {
+            track.subresources[static_cast<size_t>(layer) * track.mip_levels + mip] = state;
+        }
+    }
+}
+
+VkImageLayout VulkanLayoutTracker::getImageLayout(VkImage image, uint32_t mip_level, uint32_t array_layer) const {
+    const ImageTrack& track = m_images.at(image);
+    return track.subresources.at(static_cast<size_t>(array_layer) * track.mip_levels + mip_level).layout;
+}
+
+VulkanLayoutTracker::Access VulkanLayoutTracker::getLayoutAccess(VkImageLayout layout) {
+    switch (layout) {
+        case VK_IMAGE_LAYOUT_UNDEFINED:
+        case VK_IMAGE_LAYOUT_PREINITIALIZED:
+        case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR: // Presentation is ordered by semaphores
+            return {VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, layout};
+        case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+            return {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, layout};
+        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+        case VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL:
+        case VK_IMAGE_LAYOUT_STENCIL_ATTACHMENT_OPTIMAL:
+        case VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_STENCIL_ATTACHMENT_OPTIMAL:
+        case VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL:
+            return {VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, layout};
+        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+        case VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL:
+        case VK_IMAGE_LAYOUT_STENCIL_READ_ONLY_OPTIMAL:
+            return {VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT, layout};
+        case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+            return {VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT, layout};
+        case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+            return {VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, layout};
+        case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+            return {VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, layout};
+        default:
+            return {VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT, layout};
+    }
+}
+
+VulkanLayoutTracker::Access VulkanLayoutTracker::getAttachmentAccess(VkFormat format, VkImageLayout layout) {
+    Access access = getLayoutAccess(getFormatAspect(format) & VK_IMAGE_ASPECT_COLOR_BIT ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+    access.layout = layout;
+    return access;
+}
+
+VkImageAspectFlags VulkanLayoutTracker::getFormatAspect(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT;
+        case VK_FORMAT_S8_UINT:
+            return VK_IMAGE_ASPECT_STENCIL_BIT;
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        default:
+            return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
+
+bool VulkanLayoutTracker::isWriteAccess(VkAccessFlags2 access) {
+    return (access & WRITE_ACCESS_MASK) != VK_ACCESS_2_NONE;
+}
+
+VkAccessFlags2 VulkanLayoutTracker::getWriteAccess(VkAccessFlags2 access) {
+    return access & WRITE_ACCESS_MASK;
+}
+
+void VulkanLayoutTracker::recordBarriers(VkCommandBuffer command_buffer, const Barriers& barriers, bool synchronization2) {
+    if(barriers.empty()) return;
+
+    if(synchronization2) {
+        VkDependencyInfo dependency_info{};
+        dependency_info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependency_info.bufferMemoryBarrierCount = static_cast<uint32_t>(barriers.buffer_barriers.size());
+        dependency_info.pBufferMemoryBarriers = barriers.buffer_barriers.data();
+        dependency_info.imageMemoryBarrierCount = static_cast<uint32_t>(barriers.image_barriers.size());
+        dependency_info.pImageMemoryBarriers = barriers.image_barriers.data();
+        vkCmdPipelineBarrier2(command_buffer, &dependency_info);
+        return;
+    }
+
+    VkPipelineStageFlags src_stages = 0u;
+    VkPipelineStageFlags dst_stages = 0u;
+
+    std::vector<VkBufferMemoryBarrier> buffer_barriers;
+    buffer_barriers.reserve(barriers.buffer_barriers.size());
+    for(const VkBufferMemoryBarrier2& barrier2 : barriers.buffer_barriers) {
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = static_cast<VkAccessFlags>(barrier2.srcAccessMask);
+        barrier.dstAccessMask = static_cast<VkAccessFlags>(barrier2.dstAccessMask);
+        barrier.srcQueueFamilyIndex = barrier2.srcQueueFamilyIndex;
+        barrier.dstQueueFamilyIndex = barrier2.dstQueueFamilyIndex;
+        barrier.buffer = barrier2.buffer;
+        barrier.offset = barrier2.offset;
+        barrier.size = barrier2.size;
+        buffer_barriers.push_back(barrier);
+
+        src_stages |= static_cast<VkPipelineStageFlags>(barrier2.srcStageMask);
+        dst_stages |= static_cast<VkPipelineStageFlags>(barrier2.dstStageMask);
+    }
+
+    std::vector<VkImageMemoryBarrier> image_barriers;
+    image_barriers.reserve(barriers.image_barriers.size());
+    for(const VkImageMemoryBarrier2& barrier2 : barriers.image_barriers) {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = static_cast<VkAccessFlags>(barrier2.srcAccessMask);
+        barrier.dstAccessMask = static_cast<VkAccessFlags>(barrier2.dstAccessMask);
+        barrier.oldLayout = barrier2.oldLayout;
+        barrier.newLayout = barrier2.newLayout;
+        barrier.srcQueueFamilyIndex = barrier2.srcQueueFamilyIndex;
+        barrier.dstQueueFamilyIndex = barrier2.dstQueueFamilyIndex;
+        barrier.image = barrier2.image;
+        barrier.subresourceRange = barrier2.subresourceRange;
+        image_barriers.push_back(barrier);
+
+        src_stages |= static_cast<VkPipelineStageFlags>(barrier2.srcStageMask);
+        dst_stages |= static_cast<VkPipelineStageFlags>(barrier2.dstStageMask);
+    }
+
+    // Synchronization1 has no NONE stage, waiting on top of pipe or blocking bottom of pipe is the equivalent.
+    if(!src_stages) src_stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    if(!dst_stages) dst_stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+    vkCmdPipelineBarrier(
+        command_buffer,
+        src_stages,
+        dst_stages,
+        0u,
+        0u, nullptr,
+        static_cast<uint32_t>(buffer_barriers.size()), buffer_barriers.data(),
+        static_cast<uint32_t>(image_barriers.size()), image_barriers.data()
+    );
+}
+
+VulkanLayoutTracker::Dependency VulkanLayoutTracker::apply(State& state, const Access& access, bool track_layout) {
+    Dependency dependency;
+    dependency.old_layout = state.layout;
+
+    const bool write = isWriteAccess(access.access);
+    const bool layout_change = track_layout && access.layout != state.layout;
+
+    // Layout transitions behave as writes, they wait for every access since the last write and make it visible.
+    if(write || layout_change) {
+        dependency.required = layout_change || state.write_stage != VK_PIPELINE_STAGE_2_NONE || state.read_stages != VK_PIPELINE_STAGE_2_NONE;
+        dependency.src_stage = state.write_stage | state.read_stages;
+        dependency.src_access = state.write_access;
+
+        if(track_layout) {
+            state.layout = access.layout;
+        }
+        state.write_stage = access.stage;
+        state.write_access = access.access & WRITE_ACCESS_MASK;
+        if(write) {
+            state.read_stages = VK_PIPELINE_STAGE_2_NONE;
+            state.visible_stages = VK_PIPELINE_STAGE_2_NONE;
+            state.visible_access = VK_ACCESS_2_NONE;
+        }
+        else {
+            state.read_stages = access.stage;
+            state.visible_stages = access.stage;
+            state.visible_access = access.access;
+        }
+        return dependency;
+    }
+
+    // Reads only wait when the last write is not yet visible to their stage and access.
+    const bool visible = !(access.stage & ~state.visible_stages) && !(access.access & ~state.visible_access);
+    if(state.write_stage != VK_PIPELINE_STAGE_2_NONE && !visible) {
+        dependency.required = true;
+        dependency.src_stage = state.write_stage;
+        dependency.src_access = state.write_access;
+        state.visible_stages |= access.stage;
+        state.visible_access |= access.access;
+    }
+    state.read_stages |= access.stage;
+
+    return dependency;
+}
+
+void VulkanLayoutTracker::merge(Access& merged, const Access& access) {
+    if(merged.layout != access.layout) {
+        throw std::runtime_error("conflicting layouts requested for one subresource in a barrier batch!");
+    }
+    merged.stage |= access.stage;
+    merged.access |= access.access;
+}
+
+void VulkanLayoutTracker::resolveImage(VkImage image, ImageTrack& track, Barriers& barriers) {
+    const size_t subresources_count = track.subresources.size();
+    m_merged_accesses.assign(subresources_count, Access{});
+    m_merged_mask.assign(subresources_count, 0u);
+
+    for(size_t i = 0u; i < track.requested_ranges.size(); ++i) {
+        const VkImageSubresourceRange& range = track.requested_ranges[i];
+        const uint32_t layer_count = resolveCount(range.baseArrayLayer, range.layerCount, track.array_layers);
+        const uint32_t level_count = resolveCount(range.baseMipLevel, range.levelCount, track.mip_levels);
+        for(uint32_t layer = range.baseArrayLayer; layer < range.baseArrayLayer + layer_count; ++layer) {
+            for(uint32_t mip = range.baseMipLevel; mip < range.baseMipLevel + level_count; ++mip) {
+                const size_t idx = static_cast<size_t>(layer) * track.mip_levels + mip;
+                if(m_merged_mask[idx]) {
+                    merge(m_merged_accesses[idx], track.requested_accesses[i]);
+                }
+                else {
+                    m_merged_accesses[idx] = track.requested_accesses[i];
+                    m_merged_mask[idx] = 1u;
+                }
+            }
+        }
+    }
+    track.requested_ranges.clear();
+    track.requested_accesses.clear();
+
+    m_dependencies.assign(subresources_count, Dependency{});
+    for(size_t idx = 0u; idx < subresources_count; ++idx) {
+        if(m_merged_mask[idx]) {
+            m_dependencies[idx] = apply(track.subresources[idx], m_merged_accesses[idx], true);
+        }
+    }
+
+    // Runs of mips sharing the same transition become one barrier, identical runs of consecutive layers are folded
+    // into the barrier of the previous layer.
+    size_t prev_layer_begin = barriers.image_barriers.size();
+    for(uint32_t layer = 0u; layer < track.array_layers; ++layer) {
+        const size_t layer_begin = barriers.image_barriers.size();
+        const size_t layer_base = static_cast<size_t>(layer) * track.mip_levels;
+
+        uint32_t mip = 0u;
+        while(mip < track.mip_levels) {
+            const size_t first_idx = layer_base + mip;
+            if(!m_merged_mask[first_idx] || !m_dependencies[first_idx].required) {
+                ++mip;
+                continue;
+            }
+
+            uint32_t run_end = mip + 1u;
+            while(run_end < track.mip_levels) {
+                const size_t idx = layer_base + run_end;
+                if(!m_merged_mask[idx] || !(m_dependencies[idx] == m_dependencies[first_idx]) || !(m_merged_accesses[idx] == m_merged_accesses[first_idx])) break;
+                ++run_end;
+            }
+
+            const Dependency& dependency = m_dependencies[first_idx];
+            const Access& access = m_merged_accesses[first_idx];
+
+            VkImageMemoryBarrier2 barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+            barrier.srcStageMask = dependency.src_stage;
+            barrier.srcAccessMask = dependency.src_access;
+            barrier.dstStageMask = access.stage;
+            barrier.dstAccessMask = access.access;
+            barrier.oldLayout = dependency.old_layout;
+            barrier.newLayout = access.layout;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = image;
+            barrier.subresourceRange.aspectMask = track.aspect;
+            barrier.subresourceRange.baseMipLevel = mip;
+            barrier.subresourceRange.levelCount = run_end - mip;
+            barrier.subresourceRange.baseArrayLayer = layer;
+            barrier.subresourceRange.layerCount = 1u;
+
+            bool folded = false;
+            for(size_t i = prev_layer_begin; i < layer_begin; ++i) {
+                VkImageMemoryBarrier2& prev = barriers.image_barriers[i];
+                if(sameSync(prev, barrier) && prev.subresourceRange.baseArrayLayer + prev.subresourceRange.layerCount == layer) {
+                    ++prev.subresourceRange.layerCount;
+                    folded = true;
+                    break;
+                }
+            }
+            if(!folded) {
+                barriers.image_barriers.push_back(barrier);
+            }
+
+            mip = run_end;
+        }
+
+        // Folded barriers stay in the previous layer's range, so keep searching there until a layer adds new ones.
+        if(barriers.image_barriers.size() != layer_begin) {
+            prev_layer_begin = layer_begin;
+        }
+    }
+}
+
+void VulkanLayoutTracker::resolveBuffer(VkBuffer buffer, BufferTrack& track, Barriers& barriers) {
+    for(const BufferRequest& request : track.requests) {
+        splitSegment(track, request.offset);
+        splitSegment(track, request.offset + request.size);
+    }
+
+    const size_t first_barrier = barriers.buffer_barriers.size();
+    for(BufferSegment& segment : track.segments) {
+        Access merged;
+        bool requested = false;
+        for(const BufferRequest& request : track.requests) {
+            if(request.offset >= segment.offset + segment.size || request.offset + request.size <= segment.offset) continue;
+            if(requested) {
+                merge(merged, request.access);
+            }
+            else {
+                merged = request.access;
+                requested = true;
+            }
+        }
+        if(!requested) continue;
+
+        const Dependency dependency = apply(segment.state, merged, false);
+        if(!dependency.required) continue;
+
+        if(barriers.buffer_barriers.size() > first_barrier) {
+            VkBufferMemoryBarrier2& prev = barriers.buffer_barriers.back();
+            if(prev.offset + prev.size == segment.offset &&
+               prev.srcStageMask == dependency.src_stage && prev.srcAccessMask == dependency.src_access &&
+               prev.dstStageMask == merged.stage && prev.dstAccessMask == merged.access) {
+                prev.size += segment.size;
+                continue;
+            }
+        }
+
+        VkBufferMemoryBarrier2 barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+        barrier.srcStageMask = dependency.src_stage;
+        barrier.srcAccessMask = dependency.src_access;
+        barrier.dstStageMask = merged.stage;
+        barrier.dstAccessMask = merged.access;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = buffer;
+        barrier.offset = segment.offset;
+        barrier.size = segment.size;
+        barriers.buffer_barriers.push_back(barrier);
+    }
+    track.requests.clear();
+
+    // Coalesce neighbours that ended up in the same state to keep the segment list short.
+    size_t last = 0u;
+    for(size_t i = 1u; i < track.segments.size(); ++i) {
+        if(track.segments[i].state == track.segments[last].state) {
+            track.segments[last].size += track.segments[i].size;
+        }
+        else {
+            track.segments[++last] = track.segments[i];
+        }
+    }
+    track.segments.resize(last + 1u);
+}
+
+void VulkanLayoutTracker::splitSegment(BufferTrack& track, VkDeviceSize offset) {
+    auto it = std::upper_bound(
+        track.segments.begin(),
+        track.segments.end(),
+        offset,
+        [](VkDeviceSize value, const BufferSegment& segment) { return value < segment.offset; }
+    );
+    if(it == track.segments.begin()) return;
+    --it;
+    if(offset <= it->offset || offset >= it->offset + it->size) return;
+
+    BufferSegment tail = *it;
+    tail.offset = offset;
+    tail.size = it->offset + it->size - offset;
+    it->size = offset - it->offset;
+    track.segments.insert(it + 1, tail);
+}
+
+VulkanLayoutTracker::ImageTrack& VulkanLayoutTracker::getImageTrack(VkImage image) {
+    auto it = m_images.find(image);
+    if(it == m_images.end()) {
+        throw std::runtime_error("image is not registered in the layout tracker!");
+    }
+    return it->second;
+}
+
+VulkanLayoutTracker::BufferTrack& VulkanLayoutTracker::getBufferTrack(VkBuffer buffer) {
+    auto it = m_buffers.find(buffer);
+    if(it == m_buffers.end()) {
+        throw std::runtime_error("buffer is not registered in the layout tracker!");
+    }
+    return it->second;
+}
@@ -1,14 +1,129 @@
-#define GLFW_INCLUDE_VULKAN
-#include <GLFW/glfw3.h>
+#pragma once
 
-#include "vulkan_image_buffer.h"
+#include <vulkan/vulkan.h>
 
-#include <memory>
+#include <cstdint>
 #include <unordered_map>
+#include <vector>
 
+// Owns the layout and the last access of every registered image subresource and buffer range. Accesses of one
+// dependency level are requested first and merged per resource, resolve() then emits only the barriers the tracked
+// state requires, so a whole level is synchronized by a single barrier command. Apart from recordBarriers() nothing
+// here touches the device, the solver works on plain handles and can be driven by synthetic graphs.
 class VulkanLayoutTracker {
 public:
+    struct Access {
+        VkPipelineStageFlags2 stage = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 access = VK_ACCESS_2_NONE;
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED; // Ignored for buffers
+
+        bool operator==(const Access& other) const = default;
+    };
+
+    struct Barriers {
+        std::vector<VkImageMemoryBarrier2> image_barriers;
+        std::vector<VkBufferMemoryBarrier2> buffer_barriers;
+
+        bool empty() const;
+        void clear();
+    };
+
+    void registerImage(VkImage image, VkImageAspectFlags aspect, uint32_t mip_levels, uint32_t array_layers, VkImageLayout initial_layout);
+    void registerBuffer(VkBuffer buffer, VkDeviceSize size);
+    void unregisterImage(VkImage image);
+    void unregisterBuffer(VkBuffer buffer);
+    bool isImageRegistered(VkImage image) const;
+    bool isBufferRegistered(VkBuffer buffer) const;
+
+    // Requests are merged until resolve(), one batch can not ask for two different layouts of a subresource.
+    // Barriers always cover the aspect the image was registered with, range.aspectMask is not used.
+    void requestImage(VkImage image, const VkImageSubresourceRange& range, const Access& access);
+    void requestBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const Access& access);
+    void resolve(Barriers& barriers); // On a conflict the whole batch is dropped before the exception propagates
+
+    // Overwrites the tracked state after work synchronized outside of the tracker, e.g. render pass final layouts.
+    void setImageState(VkImage image, const VkImageSubresourceRange& range, const Access& access);
+    VkImageLayout getImageLayout(VkImage image, uint32_t mip_level = 0u, uint32_t array_layer = 0u) const;
+
+    // Stages and accesses an image in the given layout is normally used with. Only legacy bits are returned, so the
+    // result also fits the synchronization1 fallback.
+    static Access getLayoutAccess(VkImageLayout layout);
+    // Render pass attachment access of an image of the given format, whatever layout the pass keeps it in.
+    static Access getAttachmentAccess(VkFormat format, VkImageLayout layout);
+    static VkImageAspectFlags getFormatAspect(VkFormat format);
+    static bool isWriteAccess(VkAccessFlags2 access);
+    static VkAccessFlags2 getWriteAccess(VkAccessFlags2 access);
+
+    // Single vkCmdPipelineBarrier2, or a vkCmdPipelineBarrier with the low 32 bits of the masks when the device
+    // lacks synchronization2.
+    static void recordBarriers(VkCommandBuffer command_buffer, const Barriers& barriers, bool synchronization2);
 
 private:
-    std::unordered_map<std::shared_ptr<VulkanImageBuffer>, VkImageLayout> m_layout_state;
-};
\ No newline at end of file
+    struct State {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags2 write_stage = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 write_access = VK_ACCESS_2_NONE;
+        VkPipelineStageFlags2 read_stages = VK_PIPELINE_STAGE_2_NONE; // Reads since the last write, a write waits for them
+        VkPipelineStageFlags2 visible_stages = VK_PIPELINE_STAGE_2_NONE; // Where the last write is already visible
+        VkAccessFlags2 visible_access = VK_ACCESS_2_NONE;
+
+        bool operator==(const State& other) const = default;
+    };
+
+    struct Dependency {
+        bool required = false;
+        VkPipelineStageFlags2 src_stage = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 src_access = VK_ACCESS_2_NONE;
+        VkImageLayout old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        bool operator==(const Dependency& other) const = default;
+    };
+
+    struct ImageTrack {
+        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        uint32_t mip_levels = 1u;
+        uint32_t array_layers = 1u;
+        std::vector<State> subresources; // layer * mip_levels + mip
+        std::vector<VkImageSubresourceRange> requested_ranges;
+        std::vector<Access> requested_accesses;
+    };
+
+    struct BufferSegment {
+        VkDeviceSize offset = 0u;
+        VkDeviceSize size = 0u;
+        State state;
+    };
+
+    struct BufferRequest {
+        VkDeviceSize offset = 0u;
+        VkDeviceSize size = 0u;
+        Access access;
+    };
+
+    struct BufferTrack {
+        VkDeviceSize size = 0u;
+        std::vector<BufferSegment> segments; // Sorted, cover the whole buffer
+        std::vector<BufferRequest> requests;
+    };
+
+    static Dependency apply(State& state, const Access& access, bool track_layout);
+    static void merge(Access& merged, const Access& access);
+    void dropRequests();
+
+    void resolveImage(VkImage image, ImageTrack& track, Barriers& barriers);
+    void resolveBuffer(VkBuffer buffer, BufferTrack& track, Barriers& barriers);
+    static void splitSegment(BufferTrack& track, VkDeviceSize offset);
+
+    ImageTrack& getImageTrack(VkImage image);
+    BufferTrack& getBufferTrack(VkBuffer buffer);
+
+    std::unordered_map<VkImage, ImageTrack> m_images;
+    std::unordered_map<VkBuffer, BufferTrack> m_buffers;
+    std::vector<VkImage> m_pending_images;
+    std::vector<VkBuffer> m_pending_buffers;
+
+    // resolve() scratch, kept to avoid per level allocations
+    std::vector<Access> m_merged_accesses;
+    std::vector<uint8_t> m_merged_mask;
+    std::vector<Dependency> m_dependencies;
+};
@@ -13,7 +13,7 @@
 #include "../vulkan_renderer.h"
 
 #include <array>
-#include <filesystem>
+#include <map>
 #include <stdexcept>
 #include <unordered_set>
 
@@ -32,24 +32,6 @@ bool VulkanPipeline::init(std::shared_ptr<VulkanDevice> device, const pugi::xml_
     m_shaders = createShadersMap(m_shader_manager);
     m_desc_slot_to_layout_map = createDescSlotToLayoutMap(desc_manager, m_shader_manager);
 
-    std::filesystem::path pipeline_cache_file_path(m_name);
-    std::vector<char> pipeline_cache_data;
-    bool pipeline_cache_exists = std::filesystem::exists(pipeline_cache_file_path);
-	if(pipeline_cache_exists) {
-        pipeline_cache_data = readFile(pipeline_cache_file_path.string());
-    }
-
-    VkPipelineCacheCreateInfo pipeline_cache_info{};
-    pipeline_cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-    pipeline_cache_info.pNext = nullptr;
-    pipeline_cache_info.initialDataSize = pipeline_cache_data.size();
-    pipeline_cache_info.pInitialData = pipeline_cache_data.data();
-    pipeline_cache_info.flags = 0u;
-    VkResult  result = vkCreatePipelineCache(m_device->getDevice(), &pipeline_cache_info, NULL, &m_pipeline_cache);
-    if(result != VK_SUCCESS) {
-        throw std::runtime_error("failed to create pipeline cache!");
-    }
-    
     m_pipeline_layout_info = VkPipelineLayoutCreateInfo{};
     m_pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 
@@ -69,7 +51,7 @@ bool VulkanPipeline::init(std::shared_ptr<VulkanDevice> device, const pugi::xml_
         m_pipeline_layout_info.pPushConstantRanges = m_push_constants.data();
     }
 
-    result = vkCreatePipelineLayout(m_device->getDevice(), &m_pipeline_layout_info, nullptr, &m_pipeline_layout);
+    VkResult result = vkCreatePipelineLayout(m_device->getDevice(), &m_pipeline_layout_info, nullptr, &m_pipeline_layout);
     if (result != VK_SUCCESS) {
         throw std::runtime_error("failed to create pipeline layout!");
     }
@@ -115,10 +97,16 @@ bool VulkanPipeline::init(std::shared_ptr<VulkanDevice> device, const pugi::xml_
     m_pipeline_info.subpass = subpass;
     m_pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
     m_pipeline_info.basePipelineIndex = -1;
-    
-    result = vkCreateGraphicsPipelines(m_device->getDevice(), VK_NULL_HANDLE, 1, &m_pipeline_info, nullptr, &m_pipeline);
+
+    return true;
+}
+
+void VulkanPipeline::createPipeline(VkPipelineCache pipeline_cache) {
+    using namespace std::literals;
+
+    VkResult result = vkCreateGraphicsPipelines(m_device->getDevice(), pipeline_cache, 1, &m_pipeline_info, nullptr, &m_pipeline);
     if (result != VK_SUCCESS) {
-        throw std::runtime_error("failed to create graphics pipeline!");
+        throw std::runtime_error("failed to create graphics pipeline "s + m_name + "!");
     }
 
 #ifndef NDEBUG
@@ -132,14 +120,9 @@ bool VulkanPipeline::init(std::shared_ptr<VulkanDevice> device, const pugi::xml_
 
     vkSetDebugUtilsObjectNameEXT(m_device->getDevice(), &name_info);
 #endif
-
-    return true;
 }
 
 void VulkanPipeline::destroy() {
-    //saveCacheToFile(m_pipeline_cache, m_name);
-
-    vkDestroyPipelineCache(m_device->getDevice(), m_pipeline_cache, nullptr);
     vkDestroyPipeline(m_device->getDevice(), m_pipeline, nullptr);
     vkDestroyPipelineLayout(m_device->getDevice(), m_pipeline_layout, nullptr);
 }
@@ -244,14 +227,23 @@ void VulkanPipeline::attach_push_constants(VkCommandBuffer command_buffer) {
 }
 
 std::vector<VkDescriptorSetLayout> VulkanPipeline::getVkDescriptorSetLayouts(const std::vector<std::string>& shader_names, const std::shared_ptr<VulkanDescriptorsManager>& desc_manager, const std::shared_ptr<VulkanShadersManager>& shader_manager) const {
-    std::unordered_set<VkDescriptorSetLayout> temp;
+    // pSetLayouts is indexed by set number, shaders may declare different subsets of the slots.
+    std::map<uint32_t, VkDescriptorSetLayout> slot_layouts;
     for(const std::string& shader_name : shader_names) {
         for(const auto&[slot, desc_name] : shader_manager->getShader(shader_name)->getShaderSignature()->getDescSetNames()) {
-            temp.insert(desc_manager->getDescSetLayout(desc_name)->getDescriptorSetLayout());
+            slot_layouts.insert({slot, desc_manager->getDescSetLayout(desc_name)->getDescriptorSetLayout()});
         }
     }
 
-    return {temp.begin(), temp.end()};
+    std::vector<VkDescriptorSetLayout> result;
+    result.reserve(slot_layouts.size());
+    for(const auto&[slot, layout] : slot_layouts) {
+        if(slot != result.size()) {
+            throw std::runtime_error("descriptor set slots of a pipeline must be contiguous!");
+        }
+        result.push_back(layout);
+    }
+    return result;
 }
 
 std::vector<VkPushConstantRange> VulkanPipeline::getPushConstantRanges(const std::shared_ptr<VulkanShadersManager>& shader_manager) {
@@ -343,25 +335,3 @@ std::unordered_map<uint32_t, std::shared_ptr<DescSetLayout>> VulkanPipeline::cre
 
     return result;
 }
-
-void VulkanPipeline::saveCacheToFile(VkPipelineCache cache, const std::string& file_name) {
-    size_t cache_data_size;
-    // Determine the size of the cache data.
-    VkResult result = vkGetPipelineCacheData(m_device->getDevice(), cache, &cache_data_size, nullptr);
-    if (result != VK_SUCCESS) {
-        throw std::runtime_error("failed to read pipeline cache size!");
-    }
-
-    if (cache_data_size == 0u) return;
-
-    // Allocate a temporary store for the cache data.
-    std::vector<char> data(cache_data_size);
-
-    // Retrieve the actual data from the cache.
-    result = vkGetPipelineCacheData(m_device->getDevice(), cache, &cache_data_size, data.data());
-    if (result != VK_SUCCESS) {
-        throw std::runtime_error("failed to write pipeline cache to file!");
-    }
-    // Open the file and write the data to it.
-    writeFile(file_name, data.size(), data.data());
-}
\ No newline at end of file
@@ -26,7 +26,10 @@ public:
         COMPUTE
     };
 
+    // Builds the layout and the create info, the VkPipeline itself is compiled by createPipeline().
     bool init(std::shared_ptr<VulkanDevice> device, const pugi::xml_node& pipeline_data, VkExtent2D viewport_extent, std::shared_ptr<VulkanRenderPass> render_pass, uint32_t subpass, std::shared_ptr<VulkanDescriptorsManager> desc_manager, std::shared_ptr<VulkanShadersManager> shader_manager);
+    // Only touches this pipeline's state and the internally synchronized cache, may run on any thread.
+    void createPipeline(VkPipelineCache pipeline_cache);
     void destroy();
 
     PipelineType getPipelineType() const;
@@ -54,7 +57,6 @@ private:
     std::unordered_map<VkShaderStageFlagBits, std::shared_ptr<VulkanShader>> createShadersMap(const std::shared_ptr<VulkanShadersManager>& shader_manager) const;
     VkPipelineVertexInputStateCreateInfo getVertexInputInfo(const std::vector<std::string>& shader_names, const std::shared_ptr<VulkanShadersManager>& shader_manager);
     std::unordered_map<uint32_t, std::shared_ptr<DescSetLayout>> createDescSlotToLayoutMap(const std::shared_ptr<VulkanDescriptorsManager>& desc_manager, const std::shared_ptr<VulkanShadersManager>& shader_manager) const;
-    void saveCacheToFile(VkPipelineCache cache, const std::string& file_name);
     
     std::shared_ptr<VulkanDevice> m_device;
     std::shared_ptr<VulkanShadersManager> m_shader_manager;
@@ -79,6 +81,5 @@ private:
     VkGraphicsPipelineCreateInfo m_pipeline_info;
     VkPipeline m_pipeline = VK_NULL_HANDLE;
     std::shared_ptr<PipelineConfig> m_pipeline_config;
-    VkPipelineCache m_pipeline_cache = VK_NULL_HANDLE;
     std::shared_ptr<VulkanRenderPass> m_render_pass;
 };
\ No newline at end of file
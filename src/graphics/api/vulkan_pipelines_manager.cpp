@@ -10,8 +10,15 @@
 #include "vulkan_render_pass.h"
 #include "../vulkan_renderer.h"
 #include "../pod/render_pass_config.h"
+#include "../../tools/thread_pool.h"
 
-bool VulkanPipelinesManager::init(std::shared_ptr<VulkanDevice> device, const std::string& rg_file_path) {
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+bool VulkanPipelinesManager::init(std::shared_ptr<VulkanDevice> device, const std::string& rg_file_path, std::shared_ptr<ThreadPool> thread_pool) {
     m_device = std::move(device);
 
     pugi::xml_document xml_doc;
@@ -24,22 +31,77 @@ bool VulkanPipelinesManager::init(std::shared_ptr<VulkanDevice> device, const st
 
     pugi::xml_node pipelines_node = root_node.child("Pipelines");
 	if (pipelines_node) {
+        using clock = std::chrono::steady_clock;
+        const auto start_time = clock::now();
+        createPipelineCache();
+
+        // Parsing and layouts are cheap and touch the other managers, they stay on this thread. Only the driver
+        // compilation fans out to the pool.
+        std::vector<std::shared_ptr<VulkanPipeline>> pipelines;
         VkExtent2D viewport_extent = Application::Get().GetRenderer().getSwapchain()->getSwapchainParams().imageExtent;
 
 		for (pugi::xml_node pipeline_node = pipelines_node.first_child(); pipeline_node; pipeline_node = pipeline_node.next_sibling()) {
+            if(!m_device->isFeatureEnabled(pipeline_node.attribute("device_feature").as_string())) continue;
+
             std::shared_ptr<VulkanRenderPass> render_pass_ptr = Application::GetRenderer().getRenderPassesManager()->getRenderPass(pipeline_node.child("RenderPass").child("RenderPassName").text().as_string());
             std::string subpass_name = pipeline_node.child("RenderPass").child("SubpassName").text().as_string();
             uint32_t subpass = render_pass_ptr->getRenderPassConfig()->getSubpassIdx(subpass_name);
             std::shared_ptr<VulkanPipeline> pipeline = std::make_shared<VulkanPipeline>();
 			pipeline->init(m_device, pipeline_node, viewport_extent, render_pass_ptr, subpass, Application::GetRenderer().getDescriptorsManager(), Application::GetRenderer().getShadersManager());
+            pipelines.push_back(pipeline);
             m_pipeline_name_map.insert({pipeline_node.attribute("name").as_string(), std::move(pipeline)});
 		}
+
+        const auto compile_start_time = clock::now();
+        // Per pipeline compile times, each slot is written by the one worker that compiles it.
+        std::vector<std::chrono::microseconds> compile_times(pipelines.size());
+        auto compile = [this, &pipelines, &compile_times](size_t i) {
+            const auto pipeline_start_time = clock::now();
+            pipelines[i]->createPipeline(m_pipeline_cache);
+            compile_times[i] = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - pipeline_start_time);
+        };
+
+        // A failed compile is rethrown here by ParallelFor once no worker is still using pipelines.
+        if(thread_pool) {
+            thread_pool->ParallelFor(0u, pipelines.size(), 1u, compile);
+        }
+        else {
+            for(size_t i = 0u; i < pipelines.size(); ++i) {
+                compile(i);
+            }
+        }
+
+        const auto end_time = clock::now();
+        m_creation_stats.pipeline_count = pipelines.size();
+        m_creation_stats.setup_time = std::chrono::duration_cast<std::chrono::microseconds>(compile_start_time - start_time);
+        m_creation_stats.compile_time = std::chrono::duration_cast<std::chrono::microseconds>(end_time - compile_start_time);
+        for(const std::chrono::microseconds& compile_time : compile_times) {
+            m_creation_stats.slowest_compile_time = std::max(m_creation_stats.slowest_compile_time, compile_time);
+        }
+
+        const auto to_ms = [](std::chrono::microseconds time) { return time.count() / 1000.0; };
+        const unsigned compile_threads = thread_pool ? thread_pool->getThreadCount() + 1u : 1u;
+        std::cout << m_creation_stats.pipeline_count << " pipelines created in " << to_ms(m_creation_stats.setup_time + m_creation_stats.compile_time) << " ms";
+        if(m_creation_stats.isWarm()) {
+            std::cout << " (warm, " << m_creation_stats.loaded_cache_size << " bytes of cache)";
+        }
+        else {
+            std::cout << " (cold)";
+        }
+        std::cout << ": setup " << to_ms(m_creation_stats.setup_time) << " ms, compile " << to_ms(m_creation_stats.compile_time)
+                  << " ms on " << compile_threads << " threads, slowest pipeline " << to_ms(m_creation_stats.slowest_compile_time) << " ms" << std::endl;
 	}
 
     return true;
 }
 
 void VulkanPipelinesManager::destroy() {
+    if(m_pipeline_cache != VK_NULL_HANDLE) {
+        savePipelineCache();
+        vkDestroyPipelineCache(m_device->getDevice(), m_pipeline_cache, nullptr);
+        m_pipeline_cache = VK_NULL_HANDLE;
+    }
+
     for(auto&[pipeline_name, pipeline] : m_pipeline_name_map) {
         pipeline->destroy();
     }
@@ -47,4 +109,67 @@ void VulkanPipelinesManager::destroy() {
 
 std::shared_ptr<VulkanPipeline> VulkanPipelinesManager::getPipeline(std::string pipeline_name) {
     return m_pipeline_name_map.at(pipeline_name);
-}
\ No newline at end of file
+}
+
+VkPipelineCache VulkanPipelinesManager::getPipelineCache() const {
+    return m_pipeline_cache;
+}
+
+const VulkanPipelinesManager::CreationStats& VulkanPipelinesManager::getCreationStats() const {
+    return m_creation_stats;
+}
+
+void VulkanPipelinesManager::createPipelineCache() {
+    std::vector<char> cache_data;
+    if(std::filesystem::exists(PIPELINE_CACHE_FILE_NAME)) {
+        cache_data = readFile(PIPELINE_CACHE_FILE_NAME);
+        if(!isPipelineCacheCompatible(cache_data)) {
+            cache_data.clear();
+        }
+    }
+    m_creation_stats.loaded_cache_size = cache_data.size();
+
+    VkPipelineCacheCreateInfo pipeline_cache_info{};
+    pipeline_cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    pipeline_cache_info.pNext = nullptr;
+    pipeline_cache_info.initialDataSize = cache_data.size();
+    pipeline_cache_info.pInitialData = cache_data.empty() ? nullptr : cache_data.data();
+    pipeline_cache_info.flags = 0u;
+    VkResult result = vkCreatePipelineCache(m_device->getDevice(), &pipeline_cache_info, nullptr, &m_pipeline_cache);
+    if(result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline cache!");
+    }
+}
+
+void VulkanPipelinesManager::savePipelineCache() const {
+    size_t cache_data_size = 0u;
+    VkResult result = vkGetPipelineCacheData(m_device->getDevice(), m_pipeline_cache, &cache_data_size, nullptr);
+    if(result != VK_SUCCESS) {
+        throw std::runtime_error("failed to read pipeline cache size!");
+    }
+
+    if(cache_data_size == 0u) return;
+
+    std::vector<char> cache_data(cache_data_size);
+    result = vkGetPipelineCacheData(m_device->getDevice(), m_pipeline_cache, &cache_data_size, cache_data.data());
+    if(result != VK_SUCCESS) {
+        throw std::runtime_error("failed to read pipeline cache data!");
+    }
+    writeFile(PIPELINE_CACHE_FILE_NAME, cache_data_size, cache_data.data());
+}
+
+// Drivers should reject foreign data themselves, but not all of them do and a stale file only costs a cold start.
+bool VulkanPipelinesManager::isPipelineCacheCompatible(const std::vector<char>& cache_data) const {
+    VkPipelineCacheHeaderVersionOne header{};
+    if(cache_data.size() < sizeof(header)) return false;
+    memcpy(&header, cache_data.data(), sizeof(header));
+
+    const VkPhysicalDeviceProperties& props = m_device->getDeviceAbilities().props;
+    return
+        header.headerSize >= sizeof(header) &&
+        header.headerSize <= cache_data.size() &&
+        header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+        header.vendorID == props.vendorID &&
+        header.deviceID == props.deviceID &&
+        memcmp(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
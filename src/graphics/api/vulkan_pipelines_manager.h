@@ -5,6 +5,7 @@
 
 #include "vulkan_pipeline.h"
 
+#include <chrono>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -12,16 +13,40 @@
 #include <vector>
 
 class VulkanDevice;
+class ThreadPool;
 struct Managers;
 
+// Owns every pipeline and the one VkPipelineCache they are compiled with. The cache is loaded from and saved to
+// PIPELINE_CACHE_FILE_NAME, a file written by another driver or device is ignored.
 class VulkanPipelinesManager {
 public:
-    bool init(std::shared_ptr<VulkanDevice> device, const std::string& rg_file_path);
+    static constexpr const char* PIPELINE_CACHE_FILE_NAME = "pipeline_cache.bin";
+
+    // Startup cost of init(), a warm start is one that found a compatible PIPELINE_CACHE_FILE_NAME.
+    struct CreationStats {
+        size_t pipeline_count = 0u;
+        size_t loaded_cache_size = 0u;
+        std::chrono::microseconds setup_time{0};
+        std::chrono::microseconds compile_time{0};
+        std::chrono::microseconds slowest_compile_time{0};
+
+        bool isWarm() const { return loaded_cache_size > 0u; }
+    };
+
+    bool init(std::shared_ptr<VulkanDevice> device, const std::string& rg_file_path, std::shared_ptr<ThreadPool> thread_pool = nullptr);
     void destroy();
 
     std::shared_ptr<VulkanPipeline> getPipeline(std::string pipeline_name);
+    VkPipelineCache getPipelineCache() const;
+    const CreationStats& getCreationStats() const;
 
 private:
+    void createPipelineCache();
+    void savePipelineCache() const;
+    bool isPipelineCacheCompatible(const std::vector<char>& cache_data) const;
+
     std::shared_ptr<VulkanDevice> m_device;
     std::unordered_map<std::string, std::shared_ptr<VulkanPipeline>> m_pipeline_name_map;
+    VkPipelineCache m_pipeline_cache = VK_NULL_HANDLE;
+    CreationStats m_creation_stats;
 };
\ No newline at end of file
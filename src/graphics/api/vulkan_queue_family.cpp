@@ -77,8 +77,8 @@ const std::vector<VkQueueFamilyProperties>& QueueFamilyIndices::getQueueFamilies
 }
 
 std::optional<uint32_t> QueueFamilyIndices::getFamilyIdx(PoolTypeEnum pool_type) const {
-    if(m_families.contains(PoolTypeEnum::GRAPICS)) {
-        return m_families.at(PoolTypeEnum::GRAPICS).index;
+    if(m_families.contains(pool_type)) {
+        return m_families.at(pool_type).index;
     }
     return std::nullopt;
 }
@@ -14,9 +14,12 @@
 #include "../../window_surface.h"
 #include "../pod/push_constant_config.h"
 #include "vulkan_push_constant.h"
+#include "vulkan_descriptor.h"
+#include "vulkan_descriptors_manager.h"
 
 #include "../../tools/string_tools.h"
 
+#include <algorithm>
 #include <utility>
 
 VulkanResourcesManager::VulkanResourcesManager(std::shared_ptr<VulkanDevice> device, std::shared_ptr<VulkanFormatManager> format_manager) : m_device(std::move(device)), m_format_manager(std::move(format_manager)) {}
@@ -82,6 +85,7 @@ void VulkanResourcesManager::destroy() {
 	for (auto&[buffer_name, buffer] : m_buffer_map) {
 		buffer->destroy();
 	}
+	m_bindless_descriptor.reset();
 }
 
 std::shared_ptr<VulkanImageBuffer> VulkanResourcesManager::create_image(const std::string& path_to_file) {
@@ -164,6 +168,8 @@ std::shared_ptr<VulkanImageBuffer> VulkanResourcesManager::create_image(std::str
 }
 
 void VulkanResourcesManager::delete_image(const std::string& image_name) {
+	notifyDeletion(m_image_map[image_name]);
+	releaseBindlessImage(m_image_map[image_name]);
 	m_image_map[image_name]->destroy();
 	m_image_map.erase(image_name);
 }
@@ -171,6 +177,8 @@ void VulkanResourcesManager::delete_image(const std::string& image_name) {
 void VulkanResourcesManager::delete_image(std::shared_ptr<VulkanImageBuffer> image_ptr) {
 	for (auto&[image_name, image] : m_image_map) {
 		if(image == image_ptr) {
+			notifyDeletion(image);
+			releaseBindlessImage(image);
 			image->destroy();
 			m_image_map.erase(image_name);
 			return;
@@ -219,6 +227,8 @@ std::shared_ptr<VulkanBuffer> VulkanResourcesManager::create_buffer(const void*
 }
 
 void VulkanResourcesManager::delete_buffer(const std::string& buffer_name) {
+	notifyDeletion(m_buffer_map[buffer_name]);
+	releaseBindlessBuffer(m_buffer_map[buffer_name]);
 	m_buffer_map[buffer_name]->destroy();
 	m_buffer_map.erase(buffer_name);
 }
@@ -226,6 +236,8 @@ void VulkanResourcesManager::delete_buffer(const std::string& buffer_name) {
 void VulkanResourcesManager::delete_buffer(std::shared_ptr<VulkanBuffer> buffer_ptr) {
 	for (auto&[buffer_name, buffer] : m_buffer_map) {
 		if(buffer == buffer_ptr) {
+			notifyDeletion(buffer);
+			releaseBindlessBuffer(buffer);
 			buffer->destroy();
 			m_buffer_map.erase(buffer_name);
 			return;
@@ -274,6 +286,16 @@ void VulkanResourcesManager::delete_push_buffer(std::shared_ptr<VulkanPushConsta
 	}
 }
 
+void VulkanResourcesManager::addDeletionListener(DeletionListener listener) {
+	m_deletion_listeners.push_back(std::move(listener));
+}
+
+void VulkanResourcesManager::notifyDeletion(const std::shared_ptr<RenderResource>& resource) const {
+	for (const DeletionListener& listener : m_deletion_listeners) {
+		listener(resource);
+	}
+}
+
 const std::shared_ptr<VulkanImageBuffer>& VulkanResourcesManager::getImageResource(const std::string& resource_global_name) {
 	return m_image_map.at(resource_global_name);
 }
@@ -310,4 +332,122 @@ const std::shared_ptr<PushConstantConfig> VulkanResourcesManager::getPushConstan
 
 const std::shared_ptr<FramebufferConfig>& VulkanResourcesManager::getFramebufferConfig(const std::string& framebuffer_name) const {
 	return m_framebuffer_config_map.at(framebuffer_name);
-}
\ No newline at end of file
+}
+
+bool VulkanResourcesManager::initBindless(const std::shared_ptr<VulkanDescriptorsManager>& descriptors_manager) {
+	if(!m_device->getDeviceAbilities().descriptor_indexing || !descriptors_manager->hasDescSetLayout(BINDLESS_DESC_SET_NAME)) {
+		return false;
+	}
+
+	const std::shared_ptr<DescSetLayout>& layout = descriptors_manager->getDescSetLayout(BINDLESS_DESC_SET_NAME);
+	VkDescriptorSetLayoutBinding images_binding = layout->getBinding(std::string(BINDLESS_IMAGES_BINDING_NAME));
+	VkDescriptorSetLayoutBinding buffers_binding = layout->getBinding(std::string(BINDLESS_BUFFERS_BINDING_NAME));
+	if(images_binding.descriptorType != VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER || buffers_binding.descriptorType != VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) {
+		throw std::runtime_error("bindless descriptor set layout must have a sampled image and a storage buffer array!");
+	}
+
+	std::lock_guard<std::mutex> lock(m_bindless_mutex);
+	m_bindless_images = BindlessSlots{};
+	m_bindless_images.binding = images_binding.binding;
+	m_bindless_images.capacity = images_binding.descriptorCount;
+	m_bindless_buffers = BindlessSlots{};
+	m_bindless_buffers.binding = buffers_binding.binding;
+	m_bindless_buffers.capacity = buffers_binding.descriptorCount;
+	m_bindless_descriptor = descriptors_manager->allocateDescriptorSet(BINDLESS_DESC_SET_NAME);
+
+	return true;
+}
+
+bool VulkanResourcesManager::isBindlessEnabled() const {
+	return m_bindless_descriptor != nullptr;
+}
+
+const std::shared_ptr<VulkanDescriptor>& VulkanResourcesManager::getBindlessDescriptor() const {
+	return m_bindless_descriptor;
+}
+
+uint32_t VulkanResourcesManager::registerBindlessImage(const std::shared_ptr<VulkanImageBuffer>& image) {
+	std::lock_guard<std::mutex> lock(m_bindless_mutex);
+	if(!m_bindless_descriptor) {
+		throw std::runtime_error("bindless table is not enabled!");
+	}
+	if(auto it = m_bindless_images.resource_slots.find(image.get()); it != m_bindless_images.resource_slots.end()) {
+		return it->second;
+	}
+
+	uint32_t slot = m_bindless_images.acquire();
+	m_bindless_descriptor->updateDescArrayImage(
+		m_bindless_images.binding,
+		slot,
+		image->getImageConfig()->getSampler()->getSampler(),
+		image->getImageBufferView(),
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	);
+	m_bindless_images.resource_slots.insert({image.get(), slot});
+
+	return slot;
+}
+
+uint32_t VulkanResourcesManager::registerBindlessBuffer(const std::shared_ptr<VulkanBuffer>& buffer) {
+	std::lock_guard<std::mutex> lock(m_bindless_mutex);
+	if(!m_bindless_descriptor) {
+		throw std::runtime_error("bindless table is not enabled!");
+	}
+	if(auto it = m_bindless_buffers.resource_slots.find(buffer.get()); it != m_bindless_buffers.resource_slots.end()) {
+		return it->second;
+	}
+
+	uint32_t slot = m_bindless_buffers.acquire();
+	m_bindless_descriptor->updateDescArrayBuffer(m_bindless_buffers.binding, slot, buffer->getBuffer());
+	m_bindless_buffers.resource_slots.insert({buffer.get(), slot});
+
+	return slot;
+}
+
+void VulkanResourcesManager::releaseBindlessImage(const std::shared_ptr<VulkanImageBuffer>& image) {
+	std::lock_guard<std::mutex> lock(m_bindless_mutex);
+	m_bindless_images.release(image.get(), m_bindless_frame);
+}
+
+void VulkanResourcesManager::releaseBindlessBuffer(const std::shared_ptr<VulkanBuffer>& buffer) {
+	std::lock_guard<std::mutex> lock(m_bindless_mutex);
+	m_bindless_buffers.release(buffer.get(), m_bindless_frame);
+}
+
+void VulkanResourcesManager::nextFrame() {
+	std::lock_guard<std::mutex> lock(m_bindless_mutex);
+	++m_bindless_frame;
+	m_bindless_images.reclaim(m_bindless_frame, BINDLESS_RELEASE_DELAY_FRAMES);
+	m_bindless_buffers.reclaim(m_bindless_frame, BINDLESS_RELEASE_DELAY_FRAMES);
+}
+
+uint32_t VulkanResourcesManager::BindlessSlots::acquire() {
+	if(!free_slots.empty()) {
+		uint32_t slot = free_slots.back();
+		free_slots.pop_back();
+		return slot;
+	}
+	if(next_slot < capacity) {
+		return next_slot++;
+	}
+	throw std::runtime_error("bindless table is full!");
+}
+
+// The descriptor is left as it is, partially bound arrays tolerate stale elements nobody indexes.
+void VulkanResourcesManager::BindlessSlots::release(const void* resource, uint64_t frame) {
+	auto it = resource_slots.find(resource);
+	if(it == resource_slots.end()) return;
+
+	released_slots.emplace_back(it->second, frame);
+	resource_slots.erase(it);
+}
+
+void VulkanResourcesManager::BindlessSlots::reclaim(uint64_t frame, uint64_t delay) {
+	auto reusable_end = std::partition(released_slots.begin(), released_slots.end(), [frame, delay](const std::pair<uint32_t, uint64_t>& released) {
+		return frame - released.second > delay;
+	});
+	for(auto it = released_slots.begin(); it != reusable_end; ++it) {
+		free_slots.push_back(it->first);
+	}
+	released_slots.erase(released_slots.begin(), reusable_end);
+}
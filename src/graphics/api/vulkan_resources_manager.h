@@ -4,9 +4,13 @@
 #include <GLFW/glfw3.h>
 
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "../pod/render_resource.h"
 #include "vulkan_command_buffer.h"
@@ -22,6 +26,8 @@ class FramebufferConfig;
 class WindowSurface;
 class VulkanPushConstant;
 class PushConstantConfig;
+class VulkanDescriptor;
+class VulkanDescriptorsManager;
 
 class VulkanResourcesManager {
 public:
@@ -48,6 +54,11 @@ public:
     void detete_push_buffer(const std::string& const_name);
     void delete_push_buffer(std::shared_ptr<VulkanPushConstant> const_ptr);
 
+    // Listeners run when an image or buffer is deleted, before it is destroyed. State keyed on its Vulkan handles has
+    // to be dropped there, the driver may hand the same handles out again.
+    using DeletionListener = std::function<void(const std::shared_ptr<RenderResource>&)>;
+    void addDeletionListener(DeletionListener listener);
+
     const std::shared_ptr<VulkanImageBuffer>& getImageResource(const std::string& resource_global_name);
     const std::shared_ptr<VulkanBuffer>& getBufferResource(const std::string& resource_global_name);
     const std::shared_ptr<VulkanPushConstant>& getPushConstantResource(const std::string& resource_global_name);
@@ -59,7 +70,43 @@ public:
 
     const std::shared_ptr<FramebufferConfig>& getFramebufferConfig(const std::string& framebuffer_name) const;
 
+    // Bindless table: one update after bind set holding every registered texture and storage buffer, shaders index
+    // it with the slots handed out here. Stays disabled when the device lacks descriptor indexing, in that case the
+    // bindless set is not part of the render graph.
+    bool initBindless(const std::shared_ptr<VulkanDescriptorsManager>& descriptors_manager);
+    bool isBindlessEnabled() const;
+    const std::shared_ptr<VulkanDescriptor>& getBindlessDescriptor() const;
+    // Registering a resource twice returns its current slot. Released slots are reused only after
+    // BINDLESS_RELEASE_DELAY_FRAMES calls of nextFrame(), frames in flight may still read them.
+    uint32_t registerBindlessImage(const std::shared_ptr<VulkanImageBuffer>& image);
+    uint32_t registerBindlessBuffer(const std::shared_ptr<VulkanBuffer>& buffer);
+    void releaseBindlessImage(const std::shared_ptr<VulkanImageBuffer>& image);
+    void releaseBindlessBuffer(const std::shared_ptr<VulkanBuffer>& buffer);
+    // Call once per frame after the frame fence.
+    void nextFrame();
+
+    static constexpr const char* BINDLESS_DESC_SET_NAME = "bindless_descriptor_set";
+    static constexpr const char* BINDLESS_IMAGES_BINDING_NAME = "bindless_textures";
+    static constexpr const char* BINDLESS_BUFFERS_BINDING_NAME = "bindless_buffers";
+    static constexpr uint32_t BINDLESS_RELEASE_DELAY_FRAMES = 8u;
+
 protected:
+    void notifyDeletion(const std::shared_ptr<RenderResource>& resource) const;
+
+    // Free-list over the elements of one arrayed binding.
+    struct BindlessSlots {
+        uint32_t binding = 0u;
+        uint32_t capacity = 0u;
+        uint32_t next_slot = 0u; // Slots past it were never handed out
+        std::vector<uint32_t> free_slots;
+        std::vector<std::pair<uint32_t, uint64_t>> released_slots; // Slot, frame of the release
+        std::unordered_map<const void*, uint32_t> resource_slots;
+
+        uint32_t acquire();
+        void release(const void* resource, uint64_t frame);
+        void reclaim(uint64_t frame, uint64_t delay);
+    };
+
     std::shared_ptr<VulkanDevice> m_device;
     std::shared_ptr<VulkanFormatManager> m_format_manager;
 
@@ -73,4 +120,12 @@ protected:
     std::unordered_map<std::string, std::shared_ptr<VulkanPushConstant>> m_push_constant_map;
 
     std::unordered_map<std::string, std::shared_ptr<FramebufferConfig>> m_framebuffer_config_map;
+
+    std::vector<DeletionListener> m_deletion_listeners;
+
+    std::mutex m_bindless_mutex;
+    std::shared_ptr<VulkanDescriptor> m_bindless_descriptor;
+    BindlessSlots m_bindless_images;
+    BindlessSlots m_bindless_buffers;
+    uint64_t m_bindless_frame = 0u;
 };
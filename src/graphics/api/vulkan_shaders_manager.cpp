@@ -1,5 +1,7 @@
 #include "vulkan_shaders_manager.h"
 
+#include "vulkan_device.h"
+
 bool VulkanShadersManager::init(std::shared_ptr<VulkanDevice> device, std::shared_ptr<VulkanResourcesManager>& resources_manager, const std::string& rg_file_name) {
     m_device = device;
 
@@ -14,6 +16,8 @@ bool VulkanShadersManager::init(std::shared_ptr<VulkanDevice> device, std::share
     pugi::xml_node shaders_node = root_node.child("Shaders");
 	if (shaders_node) {
 		for (pugi::xml_node shader_node = shaders_node.first_child(); shader_node; shader_node = shader_node.next_sibling()) {
+            if(!device->isFeatureEnabled(shader_node.attribute("device_feature").as_string())) continue;
+
             size_t shader_pos = m_shaders.size();
             m_shaders.push_back(std::make_shared<VulkanShader>());
             m_shaders[shader_pos]->init(device, resources_manager, shader_node);
@@ -0,0 +1,131 @@
+#include "vulkan_staging_ring.h"
+
+#include "vulkan_device.h"
+#include "vulkan_device_memory_allocator.h"
+
+#include <stdexcept>
+
+bool VulkanStagingRing::init(std::shared_ptr<VulkanDevice> device, VkDeviceSize size) {
+    m_device = std::move(device);
+    m_size = size;
+
+    VkBufferCreateInfo buffer_info{};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = m_size;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkResult result = vkCreateBuffer(m_device->getDevice(), &buffer_info, nullptr, &m_buffer);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create staging ring buffer!");
+    }
+
+    VkMemoryRequirements mem_req;
+    vkGetBufferMemoryRequirements(m_device->getDevice(), m_buffer, &mem_req);
+    if(!m_device->getMemoryAllocator()->allocate(mem_req, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VulkanDeviceMemoryAllocator::AllocationMode::LINEAR, m_allocation)) {
+        throw std::runtime_error("failed to allocate staging ring memory!");
+    }
+    vkBindBufferMemory(m_device->getDevice(), m_buffer, m_allocation.get_memory(), m_allocation.get_offset());
+
+    m_mapped = static_cast<uint8_t*>(m_allocation.get_host_pointer());
+    if(!m_mapped) {
+        throw std::runtime_error("staging ring memory is not host visible!");
+    }
+
+    return true;
+}
+
+void VulkanStagingRing::destroy() {
+    if(m_buffer == VK_NULL_HANDLE) return;
+
+    vkDestroyBuffer(m_device->getDevice(), m_buffer, nullptr);
+    m_device->getMemoryAllocator()->free(m_allocation);
+    m_buffer = VK_NULL_HANDLE;
+    m_mapped = nullptr;
+    m_in_flight.clear();
+    m_head = 0u;
+    m_tail = 0u;
+    m_used = 0u;
+    m_pending = 0u;
+}
+
+bool VulkanStagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment, Allocation& out_allocation) {
+    if(size == 0u || size > m_size) return false;
+
+    if(m_used == 0u) {
+        m_head = 0u;
+        m_tail = 0u;
+    }
+
+    VkDeviceSize offset = (m_head + alignment - 1u) / alignment * alignment;
+    VkDeviceSize consumed = 0u;
+    if(m_head > m_tail || m_used == 0u) {
+        // Free space is [head, size) followed by [0, tail), the gap at the end is wasted when we wrap.
+        if(offset + size <= m_size) {
+            consumed = offset + size - m_head;
+        }
+        else if(size <= m_tail) {
+            consumed = m_size - m_head + size;
+            offset = 0u;
+        }
+        else {
+            return false;
+        }
+    }
+    else if(m_head < m_tail) {
+        if(offset + size > m_tail) return false;
+        consumed = offset + size - m_head;
+    }
+    else {
+        return false;
+    }
+
+    m_head = offset + size;
+    m_used += consumed;
+    m_pending += consumed;
+
+    out_allocation.offset = offset;
+    out_allocation.size = size;
+    out_allocation.mapped = m_mapped + offset;
+
+    return true;
+}
+
+void VulkanStagingRing::fence(uint64_t value) {
+    if(m_pending == 0u) return;
+
+    m_in_flight.push_back({ value, m_head, m_pending });
+    m_pending = 0u;
+}
+
+void VulkanStagingRing::retire(uint64_t completed_value) {
+    while(!m_in_flight.empty() && m_in_flight.front().value <= completed_value) {
+        m_tail = m_in_flight.front().end;
+        m_used -= m_in_flight.front().bytes;
+        m_in_flight.pop_front();
+    }
+}
+
+bool VulkanStagingRing::hasPending() const {
+    return m_pending != 0u;
+}
+
+bool VulkanStagingRing::hasInFlight() const {
+    return !m_in_flight.empty();
+}
+
+uint64_t VulkanStagingRing::getOldestInFlightValue() const {
+    return m_in_flight.empty() ? 0u : m_in_flight.front().value;
+}
+
+VkBuffer VulkanStagingRing::getBuffer() const {
+    return m_buffer;
+}
+
+VkDeviceSize VulkanStagingRing::getSize() const {
+    return m_size;
+}
+
+VkDeviceSize VulkanStagingRing::getUsedSize() const {
+    return m_used;
+}
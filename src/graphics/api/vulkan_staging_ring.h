@@ -0,0 +1,58 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+#include "vulkan_device_memory_allocation.h"
+
+class VulkanDevice;
+
+// Persistently mapped host coherent buffer used as a FIFO of staging ranges. Everything allocated between two fence()
+// calls is owned by the timeline value passed to fence() and comes back in one piece once retire() sees that value
+// completed. Not thread safe, the owner serializes access.
+class VulkanStagingRing {
+public:
+    struct Allocation {
+        VkDeviceSize offset = 0u;
+        VkDeviceSize size = 0u;
+        void* mapped = nullptr;
+    };
+
+    bool init(std::shared_ptr<VulkanDevice> device, VkDeviceSize size);
+    void destroy();
+
+    bool allocate(VkDeviceSize size, VkDeviceSize alignment, Allocation& out_allocation);
+    void fence(uint64_t value);
+    void retire(uint64_t completed_value);
+
+    bool hasPending() const;
+    bool hasInFlight() const;
+    uint64_t getOldestInFlightValue() const;
+
+    VkBuffer getBuffer() const;
+    VkDeviceSize getSize() const;
+    VkDeviceSize getUsedSize() const;
+
+private:
+    struct Region {
+        uint64_t value;
+        VkDeviceSize end;
+        VkDeviceSize bytes;
+    };
+
+    std::shared_ptr<VulkanDevice> m_device;
+    VkBuffer m_buffer = VK_NULL_HANDLE;
+    DeviceAllocation m_allocation;
+    uint8_t* m_mapped = nullptr;
+
+    VkDeviceSize m_size = 0u;
+    VkDeviceSize m_head = 0u;
+    VkDeviceSize m_tail = 0u;
+    VkDeviceSize m_used = 0u;
+    VkDeviceSize m_pending = 0u;
+    std::deque<Region> m_in_flight;
+};
@@ -0,0 +1,218 @@
+#include "vulkan_texture_residency.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+void VulkanTextureResidency::init(VkDeviceSize frame_upload_budget, VkDeviceSize resident_budget) {
+    m_frame_upload_budget = frame_upload_budget;
+    m_resident_budget = resident_budget;
+    clear();
+}
+
+void VulkanTextureResidency::clear() {
+    m_textures.clear();
+    m_tail_queue.clear();
+    m_promotions.clear();
+    m_frame = 0u;
+    m_stats = Stats{};
+}
+
+size_t VulkanTextureResidency::add(VkDeviceSize placeholder_size) {
+    Texture& texture = m_textures.emplace_back();
+    texture.image_size = placeholder_size;
+    texture.last_used_frame = m_frame;
+    m_stats.textures = m_textures.size();
+    return m_textures.size() - 1u;
+}
+
+void VulkanTextureResidency::decoded(size_t texture_idx, std::vector<VkDeviceSize> level_offsets, VkExtent2D extent) {
+    if(texture_idx >= m_textures.size()) throw std::runtime_error("texture residency index out of range !");
+
+    Texture& texture = m_textures[texture_idx];
+    texture.decoding = false;
+    if(level_offsets.size() < 2u) {
+        texture.failed = true;
+        return;
+    }
+    texture.level_offsets = std::move(level_offsets);
+    texture.extent = extent;
+    texture.has_levels = true;
+    // Textures decoded again after a demotion are picked up by startPromotions().
+    if(texture.state == State::PLACEHOLDER) {
+        m_tail_queue.push_back(texture_idx);
+    }
+}
+
+void VulkanTextureResidency::touch(size_t texture_idx) {
+    m_textures[texture_idx].last_used_frame = m_frame;
+}
+
+void VulkanTextureResidency::beginFrame() {
+    ++m_frame;
+    m_stats.uploaded_bytes = 0u;
+}
+
+void VulkanTextureResidency::update(std::vector<Step>& steps) {
+    // Whatever the budget, the tails go first: a texture showing its placeholder looks worse than a blurry one.
+    uploadTails(steps);
+    continuePromotions(steps);
+    startPromotions(steps);
+    demoteUnused(0u, m_frame, steps);
+
+    m_stats.resident_bytes = getResidentSize();
+    m_stats.full_resident = static_cast<size_t>(std::count_if(m_textures.begin(), m_textures.end(), [](const Texture& texture) {
+        return texture.state == State::FULL;
+    }));
+}
+
+VulkanTextureResidency::State VulkanTextureResidency::getState(size_t texture_idx) const {
+    return m_textures[texture_idx].state;
+}
+
+uint64_t VulkanTextureResidency::getFrame() const {
+    return m_frame;
+}
+
+const VulkanTextureResidency::Stats& VulkanTextureResidency::getStats() const {
+    return m_stats;
+}
+
+// Something is uploaded every frame even when it alone is over the budget, otherwise big levels would never go.
+bool VulkanTextureResidency::fitsUploadBudget(VkDeviceSize size) const {
+    return m_stats.uploaded_bytes == 0u || m_stats.uploaded_bytes + size <= m_frame_upload_budget;
+}
+
+// Replaces placeholders with the levels of at most TAIL_EXTENT.
+void VulkanTextureResidency::uploadTails(std::vector<Step>& steps) {
+    while(!m_tail_queue.empty()) {
+        Texture& texture = m_textures[m_tail_queue.front()];
+        const uint32_t chain_levels = static_cast<uint32_t>(texture.level_offsets.size() - 1u);
+        uint32_t tail_first_mip = 0u;
+        while(tail_first_mip + 1u < chain_levels && std::max(texture.extent.width >> tail_first_mip, texture.extent.height >> tail_first_mip) > TAIL_EXTENT) {
+            ++tail_first_mip;
+        }
+
+        const VkDeviceSize tail_size = texture.level_offsets.back() - texture.level_offsets[tail_first_mip];
+        if(!fitsUploadBudget(tail_size)) break;
+
+        steps.push_back({StepType::UPLOAD_TAIL, m_tail_queue.front(), tail_first_mip});
+        m_tail_queue.pop_front();
+        m_stats.uploaded_bytes += tail_size;
+        texture.image_size = tail_size;
+
+        if(tail_first_mip == 0u) {
+            texture.state = State::FULL;
+            texture.promoted = true;
+            texture.has_levels = false;
+        }
+        else {
+            texture.state = State::TAIL;
+        }
+    }
+}
+
+// Fills pending images from the smallest level up, the finished chain replaces the tail which is parked for demotion.
+void VulkanTextureResidency::continuePromotions(std::vector<Step>& steps) {
+    while(!m_promotions.empty()) {
+        const size_t texture_idx = m_promotions.front();
+        Texture& texture = m_textures[texture_idx];
+        while(texture.next_mip > 0u) {
+            const uint32_t mip_level = texture.next_mip - 1u;
+            const VkDeviceSize level_size = texture.level_offsets[mip_level + 1u] - texture.level_offsets[mip_level];
+            if(!fitsUploadBudget(level_size)) return;
+
+            steps.push_back({StepType::UPLOAD_LEVEL, texture_idx, mip_level});
+            m_stats.uploaded_bytes += level_size;
+            --texture.next_mip;
+        }
+
+        steps.push_back({StepType::COMPLETE_PROMOTION, texture_idx, 0u});
+        texture.parked_size = texture.image_size;
+        texture.image_size = texture.pending_size;
+        texture.pending_size = 0u;
+        texture.pending = false;
+        texture.state = State::FULL;
+        texture.promoted = true;
+        texture.has_levels = false;
+        ++m_stats.promotions;
+        m_promotions.erase(m_promotions.begin());
+    }
+}
+
+// Most recently used tails first. Textures that were never complete are promoted whether they are used or not, so a
+// fresh scene fills the budget. Demoted ones come back only once they are used again.
+void VulkanTextureResidency::startPromotions(std::vector<Step>& steps) {
+    if(m_promotions.size() >= MAX_ACTIVE_PROMOTIONS) return;
+
+    m_candidates.clear();
+    for(size_t texture_idx = 0u; texture_idx < m_textures.size(); ++texture_idx) {
+        const Texture& texture = m_textures[texture_idx];
+        if(texture.state != State::TAIL || texture.pending || texture.failed) continue;
+        if(texture.promoted && texture.last_used_frame + 1u < m_frame) continue;
+        m_candidates.push_back(texture_idx);
+    }
+    std::stable_sort(m_candidates.begin(), m_candidates.end(), [this](size_t a, size_t b) {
+        return m_textures[a].last_used_frame > m_textures[b].last_used_frame;
+    });
+
+    for(size_t texture_idx : m_candidates) {
+        if(m_promotions.size() >= MAX_ACTIVE_PROMOTIONS) return;
+
+        Texture& texture = m_textures[texture_idx];
+        if(texture.decoding) continue;
+        if(!texture.has_levels) {
+            steps.push_back({StepType::DECODE, texture_idx, 0u});
+            texture.decoding = true;
+            continue;
+        }
+
+        const VkDeviceSize full_size = texture.level_offsets.back();
+        if(!demoteUnused(full_size, texture.last_used_frame, steps)) continue;
+
+        steps.push_back({StepType::BEGIN_PROMOTION, texture_idx, 0u});
+        texture.pending = true;
+        texture.pending_size = full_size;
+        texture.next_mip = static_cast<uint32_t>(texture.level_offsets.size() - 1u);
+        m_promotions.push_back(texture_idx);
+    }
+}
+
+// Demotes full chains not used for DEMOTE_AFTER_FRAMES frames and not used after used_before, least recently used
+// first, until required more bytes fit into the resident budget. Returns whether they fit.
+bool VulkanTextureResidency::demoteUnused(VkDeviceSize required, uint64_t used_before, std::vector<Step>& steps) {
+    VkDeviceSize resident_size = getResidentSize();
+    if(resident_size + required <= m_resident_budget) return true;
+
+    m_victims.clear();
+    for(size_t texture_idx = 0u; texture_idx < m_textures.size(); ++texture_idx) {
+        const Texture& texture = m_textures[texture_idx];
+        if(texture.state != State::FULL || texture.parked_size == 0u) continue;
+        if(texture.last_used_frame >= used_before || texture.last_used_frame + DEMOTE_AFTER_FRAMES > m_frame) continue;
+        m_victims.push_back(texture_idx);
+    }
+    std::stable_sort(m_victims.begin(), m_victims.end(), [this](size_t a, size_t b) {
+        return m_textures[a].last_used_frame < m_textures[b].last_used_frame;
+    });
+
+    for(size_t texture_idx : m_victims) {
+        Texture& texture = m_textures[texture_idx];
+        steps.push_back({StepType::DEMOTE, texture_idx, 0u});
+        resident_size -= texture.image_size;
+        texture.image_size = texture.parked_size;
+        texture.parked_size = 0u;
+        texture.state = State::TAIL;
+        ++m_stats.demotions;
+        if(resident_size + required <= m_resident_budget) return true;
+    }
+    return false;
+}
+
+// Retired contents are not counted, they are freed a few frames later anyway.
+VkDeviceSize VulkanTextureResidency::getResidentSize() const {
+    VkDeviceSize resident_size = 0u;
+    for(const Texture& texture : m_textures) {
+        resident_size += texture.image_size + texture.pending_size + texture.parked_size;
+    }
+    return resident_size;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Residency decisions of VulkanTextureStreamer, kept apart from the images and uploads so they run without a device.
+// Textures are indices in the order they were added. The streamer reports finished decodes and carries out the steps
+// update() plans, in their order. Sizes are the bytes of the decoded levels, not the allocations holding them.
+//
+// A texture starts as a placeholder and is decoded. Its mip tail (levels up to TAIL_EXTENT) is uploaded first, small
+// textures are complete with that. Larger ones are then promoted: the full chain is created, filled level by level
+// from the smallest one and swapped in, the tail is parked. When the resident textures exceed the budget, full chains
+// unused for DEMOTE_AFTER_FRAMES frames are demoted back to their parked tail, least recently used first.
+class VulkanTextureResidency {
+public:
+    enum class State : uint8_t {
+        PLACEHOLDER,
+        TAIL,
+        FULL
+    };
+
+    enum class StepType : uint8_t {
+        DECODE, // Decode the levels again, report them with decoded()
+        UPLOAD_TAIL, // Create the image of the levels from mip on, upload them all and swap it in
+        BEGIN_PROMOTION, // Create the pending image of the full chain
+        UPLOAD_LEVEL, // Upload level mip of the pending image
+        COMPLETE_PROMOTION, // Swap the pending image in and park the tail
+        DEMOTE // Swap the parked tail back in and retire the full chain
+    };
+
+    struct Step {
+        StepType type;
+        size_t texture;
+        uint32_t mip;
+
+        bool operator==(const Step& other) const = default;
+    };
+
+    struct Stats {
+        size_t textures = 0u;
+        size_t full_resident = 0u;
+        VkDeviceSize resident_bytes = 0u;
+        VkDeviceSize uploaded_bytes = 0u; // Last frame
+        uint64_t promotions = 0u;
+        uint64_t demotions = 0u;
+    };
+
+    static constexpr uint32_t TAIL_EXTENT = 64u;
+    static constexpr uint32_t DEMOTE_AFTER_FRAMES = 120u;
+    static constexpr size_t MAX_ACTIVE_PROMOTIONS = 4u;
+
+    void init(VkDeviceSize frame_upload_budget, VkDeviceSize resident_budget);
+    void clear();
+
+    // The new texture is being decoded.
+    size_t add(VkDeviceSize placeholder_size);
+    // level_offsets are the offsets of the levels in the decoded data and one past the last level, empty when the
+    // decode failed.
+    void decoded(size_t texture, std::vector<VkDeviceSize> level_offsets, VkExtent2D extent);
+    void touch(size_t texture);
+
+    void beginFrame();
+    void update(std::vector<Step>& steps);
+
+    State getState(size_t texture) const;
+    uint64_t getFrame() const;
+    const Stats& getStats() const;
+
+private:
+    struct Texture {
+        std::vector<VkDeviceSize> level_offsets;
+        VkExtent2D extent{};
+        VkDeviceSize image_size = 0u;
+        VkDeviceSize pending_size = 0u;
+        VkDeviceSize parked_size = 0u;
+
+        State state = State::PLACEHOLDER;
+        bool decoding = true;
+        bool has_levels = false; // The decoded levels are still held
+        bool failed = false;
+        bool promoted = false; // Was fully resident once, promoted again only when used
+        bool pending = false;
+        uint32_t next_mip = 0u; // Levels of the pending image from it on are uploaded
+        uint64_t last_used_frame = 0u;
+    };
+
+    bool fitsUploadBudget(VkDeviceSize size) const;
+    void uploadTails(std::vector<Step>& steps);
+    void continuePromotions(std::vector<Step>& steps);
+    void startPromotions(std::vector<Step>& steps);
+    bool demoteUnused(VkDeviceSize required, uint64_t used_before, std::vector<Step>& steps);
+    VkDeviceSize getResidentSize() const;
+
+    VkDeviceSize m_frame_upload_budget = 0u;
+    VkDeviceSize m_resident_budget = 0u;
+
+    std::vector<Texture> m_textures;
+    std::deque<size_t> m_tail_queue;
+    std::vector<size_t> m_promotions;
+    std::vector<size_t> m_candidates; // startPromotions() scratch
+    std::vector<size_t> m_victims; // demoteUnused() scratch
+
+    uint64_t m_frame = 0u;
+    Stats m_stats;
+};
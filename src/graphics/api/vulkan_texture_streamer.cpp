@@ -0,0 +1,286 @@
+#include "vulkan_texture_streamer.h"
+
+#include "vulkan_device.h"
+#include "vulkan_image_buffer.h"
+#include "vulkan_resources_manager.h"
+#include "vulkan_upload_manager.h"
+#include "../pod/image_buffer_config.h"
+#include "../../tools/ktx2_file.h"
+#include "../../tools/texture_tools.h"
+#include "../../tools/thread_pool.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include <utility>
+
+#include <stb_image.h>
+
+namespace {
+    constexpr uint32_t TEXEL_SIZE = 4u; // RGBA8
+}
+
+bool VulkanTextureStreamer::init(std::shared_ptr<VulkanDevice> device, std::shared_ptr<VulkanResourcesManager> resources_manager, std::shared_ptr<VulkanUploadManager> upload_manager, std::shared_ptr<ThreadPool> thread_pool, VkDeviceSize frame_upload_budget, VkDeviceSize resident_budget) {
+    m_device = std::move(device);
+    m_resources_manager = std::move(resources_manager);
+    m_upload_manager = std::move(upload_manager);
+    m_thread_pool = std::move(thread_pool);
+    m_residency.init(frame_upload_budget, resident_budget);
+    m_residency_version = 0u;
+
+    return true;
+}
+
+void VulkanTextureStreamer::destroy() {
+    // Decode tasks write into the textures, wait for the ones still queued on the pool. Their decrement is the last
+    // thing they touch, a notify after it could reach a streamer that is already gone.
+    while(m_decodes_in_flight.load(std::memory_order_acquire) != 0u) {
+        std::this_thread::yield();
+    }
+    size_t texture_idx = 0u;
+    while(m_decoded.TryPop(texture_idx)) {}
+
+    for(std::unique_ptr<Texture>& texture : m_textures) {
+        if(texture->pending) retire(std::move(texture->pending));
+        if(texture->parked) retire(std::move(texture->parked));
+        texture->image->destroy();
+    }
+
+    std::vector<VkImage> retired_images;
+    destroyRetired(retired_images, true);
+
+    m_textures.clear();
+    m_texture_indices.clear();
+    m_image_indices.clear();
+    m_residency.clear();
+}
+
+std::shared_ptr<VulkanImageBuffer> VulkanTextureStreamer::stream(const std::string& name, std::vector<unsigned char> encoded, uint32_t placeholder_rgba) {
+    if(auto it = m_texture_indices.find(name); it != m_texture_indices.end()) {
+        return m_textures[it->second]->image;
+    }
+
+    std::unique_ptr<Texture> texture = std::make_unique<Texture>();
+    texture->name = name;
+    texture->encoded = std::move(encoded);
+    return addTexture(std::move(texture), placeholder_rgba);
+}
+
+std::shared_ptr<VulkanImageBuffer> VulkanTextureStreamer::streamFile(const std::string& name, const std::string& path_to_file, uint32_t placeholder_rgba) {
+    if(auto it = m_texture_indices.find(name); it != m_texture_indices.end()) {
+        return m_textures[it->second]->image;
+    }
+
+    std::unique_ptr<Texture> texture = std::make_unique<Texture>();
+    texture->name = name;
+    texture->source_path = path_to_file;
+    return addTexture(std::move(texture), placeholder_rgba);
+}
+
+void VulkanTextureStreamer::touch(const VulkanImageBuffer* image) {
+    auto it = m_image_indices.find(image);
+    if(it == m_image_indices.end()) return;
+
+    m_residency.touch(it->second);
+}
+
+void VulkanTextureStreamer::update(std::vector<VkImage>& retired_images) {
+    m_residency.beginFrame();
+    destroyRetired(retired_images, false);
+
+    size_t texture_idx = 0u;
+    while(m_decoded.TryPop(texture_idx)) {
+        const Texture& texture = *m_textures[texture_idx];
+        if(texture.mips.empty()) {
+            std::cout << "failed to decode streamed texture " << texture.name << std::endl;
+        }
+        m_residency.decoded(texture_idx, texture.mips.empty() ? std::vector<VkDeviceSize>{} : texture.mip_offsets, texture.extent);
+    }
+
+    m_steps.clear();
+    m_residency.update(m_steps);
+    for(const VulkanTextureResidency::Step& step : m_steps) {
+        runStep(step);
+    }
+}
+
+uint64_t VulkanTextureStreamer::getResidencyVersion() const {
+    return m_residency_version;
+}
+
+const VulkanTextureStreamer::Stats& VulkanTextureStreamer::getStats() const {
+    return m_residency.getStats();
+}
+
+std::shared_ptr<VulkanImageBuffer> VulkanTextureStreamer::addTexture(std::unique_ptr<Texture> texture, uint32_t placeholder_rgba) {
+    unsigned char placeholder[TEXEL_SIZE] = {
+        static_cast<unsigned char>(placeholder_rgba & 0xFFu),
+        static_cast<unsigned char>((placeholder_rgba >> 8u) & 0xFFu),
+        static_cast<unsigned char>((placeholder_rgba >> 16u) & 0xFFu),
+        static_cast<unsigned char>((placeholder_rgba >> 24u) & 0xFFu)
+    };
+    std::shared_ptr<ImageBufferConfig> image_config = m_resources_manager->getImageBufferConfigTemplate(IMAGE_RESOURCE_TYPE_NAME)->makeInstance(texture->name + "_placeholder_cfg", {1u, 1u});
+    texture->image = std::make_shared<VulkanImageBuffer>(m_device, texture->name);
+    texture->image->init(placeholder, std::move(image_config));
+
+    const size_t texture_idx = m_residency.add(texture->image->getSize());
+    std::shared_ptr<VulkanImageBuffer> image = texture->image;
+    m_texture_indices.insert({texture->name, texture_idx});
+    m_image_indices.insert({image.get(), texture_idx});
+    m_textures.push_back(std::move(texture));
+    requestDecode(texture_idx);
+
+    return image;
+}
+
+void VulkanTextureStreamer::requestDecode(size_t texture_idx) {
+    Texture* texture = m_textures[texture_idx].get();
+
+    if(!m_thread_pool) {
+        decode(*texture);
+        m_decoded.Push(texture_idx);
+        return;
+    }
+
+    m_decodes_in_flight.fetch_add(1u, std::memory_order_acq_rel);
+    m_thread_pool->Submit([this, texture, texture_idx]() {
+        decode(*texture);
+        m_decoded.Push(texture_idx);
+        m_decodes_in_flight.fetch_sub(1u, std::memory_order_acq_rel);
+    });
+}
+
+// Leaves mips empty on failure.
+void VulkanTextureStreamer::decode(Texture& texture) {
+    texture.mips.clear();
+    texture.mip_offsets.clear();
+
+    if(texture.encoded.empty() && !texture.source_path.empty()) {
+        std::ifstream file(texture.source_path, std::ios::binary);
+        if(!file.is_open()) return;
+        texture.encoded.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    if(texture.encoded.empty()) return;
+
+    // Cooked textures come with their levels, already in the format the image gets.
+    if(Ktx2File::isKtx2(texture.encoded.data(), texture.encoded.size())) {
+        Ktx2File ktx2_file;
+        if(!ktx2_file.load(texture.encoded.data(), texture.encoded.size())) return;
+
+        texture.format = ktx2_file.getFormat();
+        texture.extent = ktx2_file.getExtent();
+        texture.mip_offsets = ktx2_file.getLevelOffsets();
+        texture.mips = std::move(ktx2_file.getLevels());
+        return;
+    }
+
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    stbi_uc* pixels = stbi_load_from_memory(texture.encoded.data(), static_cast<int>(texture.encoded.size()), &width, &height, &channels, STBI_rgb_alpha);
+    if(!pixels) return;
+
+    MipChain mip_chain = buildMipChain(pixels, { static_cast<uint32_t>(width), static_cast<uint32_t>(height) });
+    stbi_image_free(pixels);
+
+    texture.format = VK_FORMAT_R8G8B8A8_UNORM;
+    texture.extent = mip_chain.extent;
+    texture.mip_offsets = std::move(mip_chain.offsets);
+    texture.mips = std::move(mip_chain.data);
+}
+
+// Image of the chain from first_mip on, in the format of the decoded levels. It and its views have all the levels left,
+// cooked chains may stop before 1x1.
+std::shared_ptr<VulkanImageBuffer> VulkanTextureStreamer::createImage(const Texture& texture, uint32_t first_mip) {
+    using namespace std::literals;
+
+    VkExtent2D extent = getMipExtent(texture.extent, first_mip);
+    std::shared_ptr<ImageBufferConfig> image_config = m_resources_manager->getImageBufferConfigTemplate(IMAGE_RESOURCE_TYPE_NAME)->makeInstance(texture.name + "_mip"s + std::to_string(first_mip) + "_cfg"s, extent);
+
+    image_config->setVkFormat(texture.format);
+    image_config->setMipLevels(static_cast<uint32_t>(texture.mip_offsets.size() - 1u) - first_mip);
+
+    std::shared_ptr<VulkanImageBuffer> image = std::make_shared<VulkanImageBuffer>(m_device, texture.name);
+    image->init((unsigned char*)nullptr, std::move(image_config));
+
+    return image;
+}
+
+void VulkanTextureStreamer::uploadMips(const Texture& texture, const std::shared_ptr<VulkanImageBuffer>& image, uint32_t first_mip, uint32_t image_mip, uint32_t mip_count) {
+    const VkDeviceSize offset = texture.mip_offsets[first_mip];
+    const VkDeviceSize size = texture.mip_offsets[first_mip + mip_count] - offset;
+    m_upload_manager->uploadImageMips(
+        image->getImageBuffer(),
+        image->getImageConfig()->getImageInfo(),
+        image_mip,
+        mip_count,
+        texture.mips.data() + offset,
+        size,
+        image->getImageConfig()->getAfterInitLayout()
+    );
+}
+
+// The graphics side of the uploads is flushed before this frame's submit, so contents can be swapped in right away.
+void VulkanTextureStreamer::swapIn(Texture& texture, const std::shared_ptr<VulkanImageBuffer>& contents) {
+    const std::shared_ptr<VulkanSampler>& sampler = texture.image->getImageConfig()->getSampler();
+    if(contents->getImageConfig()->getSampler() != sampler) {
+        contents->getImageConfig()->setSampler(sampler);
+    }
+    texture.image->swapContents(*contents);
+    ++m_residency_version;
+}
+
+void VulkanTextureStreamer::retire(std::shared_ptr<VulkanImageBuffer> image) {
+    m_retired.push_back({std::move(image), m_residency.getFrame()});
+}
+
+void VulkanTextureStreamer::destroyRetired(std::vector<VkImage>& retired_images, bool all) {
+    auto retired_end = std::partition(m_retired.begin(), m_retired.end(), [this, all](const RetiredImage& retired) {
+        return !all && m_residency.getFrame() - retired.frame <= RETIRE_DELAY_FRAMES;
+    });
+    for(auto it = retired_end; it != m_retired.end(); ++it) {
+        retired_images.push_back(it->image->getImageBuffer());
+        it->image->destroy();
+    }
+    m_retired.erase(retired_end, m_retired.end());
+}
+
+// Decoded levels are dropped once the full chain is resident, a demoted texture is decoded again.
+void VulkanTextureStreamer::runStep(const VulkanTextureResidency::Step& step) {
+    Texture& texture = *m_textures[step.texture];
+    switch(step.type) {
+        case VulkanTextureResidency::StepType::DECODE: {
+            requestDecode(step.texture);
+            break;
+        }
+        case VulkanTextureResidency::StepType::UPLOAD_TAIL: {
+            std::shared_ptr<VulkanImageBuffer> tail = createImage(texture, step.mip);
+            uploadMips(texture, tail, step.mip, 0u, tail->getImageConfig()->getImageInfo().mipLevels);
+            swapIn(texture, tail);
+            retire(std::move(tail));
+            if(step.mip == 0u) texture.mips = {};
+            break;
+        }
+        case VulkanTextureResidency::StepType::BEGIN_PROMOTION: {
+            texture.pending = createImage(texture, 0u);
+            break;
+        }
+        case VulkanTextureResidency::StepType::UPLOAD_LEVEL: {
+            uploadMips(texture, texture.pending, step.mip, step.mip, 1u);
+            break;
+        }
+        case VulkanTextureResidency::StepType::COMPLETE_PROMOTION: {
+            swapIn(texture, texture.pending);
+            texture.parked = std::move(texture.pending);
+            texture.mips = {};
+            break;
+        }
+        case VulkanTextureResidency::StepType::DEMOTE: {
+            swapIn(texture, texture.parked);
+            retire(std::move(texture.parked));
+            break;
+        }
+    }
+}
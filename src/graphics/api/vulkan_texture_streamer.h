@@ -0,0 +1,104 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "vulkan_texture_residency.h"
+#include "../../tools/concurrent_queue.h"
+
+class VulkanDevice;
+class VulkanImageBuffer;
+class VulkanResourcesManager;
+class VulkanUploadManager;
+class ThreadPool;
+
+// Streams textures in the background. stream() returns at once with a 1x1 placeholder, the encoded image is decoded
+// and its RGBA8 mip chain built on the thread pool. update() then uploads through the transfer queue, smallest levels
+// first: the mip tail (levels up to TAIL_EXTENT) replaces the placeholder as soon as it is decoded, the full chain is
+// filled level by level into a second image and swapped in once complete. Uploads are limited to a byte budget per
+// frame. When resident textures exceed the memory budget, full chains unused for DEMOTE_AFTER_FRAMES frames are
+// dropped back to their tail, least recently used first, and decoded again when used.
+// The VulkanImageBuffer handed out stays the same object, only its contents are swapped. Owners of descriptors
+// compare views after getResidencyVersion() changed. Everything but the decode tasks runs on the render thread.
+// VulkanTextureResidency decides what is uploaded, promoted and demoted, the streamer carries its steps out.
+class VulkanTextureStreamer {
+public:
+    using Stats = VulkanTextureResidency::Stats;
+
+    static constexpr const char* IMAGE_RESOURCE_TYPE_NAME = "basic_image_resource";
+    static constexpr uint32_t RETIRE_DELAY_FRAMES = 8u; // Frames in flight may still sample swapped out contents
+
+    bool init(std::shared_ptr<VulkanDevice> device, std::shared_ptr<VulkanResourcesManager> resources_manager, std::shared_ptr<VulkanUploadManager> upload_manager, std::shared_ptr<ThreadPool> thread_pool, VkDeviceSize frame_upload_budget, VkDeviceSize resident_budget);
+    void destroy();
+
+    // Textures are shared by name. placeholder_rgba is the placeholder color, red in the low byte.
+    std::shared_ptr<VulkanImageBuffer> stream(const std::string& name, std::vector<unsigned char> encoded, uint32_t placeholder_rgba);
+    std::shared_ptr<VulkanImageBuffer> streamFile(const std::string& name, const std::string& path_to_file, uint32_t placeholder_rgba);
+
+    // Marks the texture as used by the current frame, keeps its full chain resident and gets it promoted first.
+    void touch(const VulkanImageBuffer* image);
+
+    // Call once per frame after the frame fence. VkImages of destroyed contents are appended to retired_images, so
+    // the caller can forget their tracked state.
+    void update(std::vector<VkImage>& retired_images);
+
+    uint64_t getResidencyVersion() const;
+    const Stats& getStats() const;
+
+private:
+    struct Texture {
+        std::string name;
+        std::string source_path; // Read by the decode task while encoded is empty
+        std::vector<unsigned char> encoded; // Kept to decode again after a demotion
+
+        std::shared_ptr<VulkanImageBuffer> image; // Handed out, contents swapped as the residency changes
+        std::shared_ptr<VulkanImageBuffer> pending; // Full chain being uploaded
+        std::shared_ptr<VulkanImageBuffer> parked; // Mip tail while the full chain is resident
+
+        // Written by the decode task, read once the texture came out of m_decoded
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent{};
+        std::vector<unsigned char> mips; // RGBA8 levels down to 1x1 or the levels of a KTX2 file, tightly packed in level order
+        std::vector<VkDeviceSize> mip_offsets; // One past the last level too
+    };
+
+    struct RetiredImage {
+        std::shared_ptr<VulkanImageBuffer> image;
+        uint64_t frame;
+    };
+
+    std::shared_ptr<VulkanImageBuffer> addTexture(std::unique_ptr<Texture> texture, uint32_t placeholder_rgba);
+    void requestDecode(size_t texture_idx);
+    static void decode(Texture& texture);
+
+    std::shared_ptr<VulkanImageBuffer> createImage(const Texture& texture, uint32_t first_mip);
+    void uploadMips(const Texture& texture, const std::shared_ptr<VulkanImageBuffer>& image, uint32_t first_mip, uint32_t image_mip, uint32_t mip_count);
+    void swapIn(Texture& texture, const std::shared_ptr<VulkanImageBuffer>& contents);
+    void retire(std::shared_ptr<VulkanImageBuffer> image);
+    void destroyRetired(std::vector<VkImage>& retired_images, bool all);
+
+    void runStep(const VulkanTextureResidency::Step& step);
+
+    std::shared_ptr<VulkanDevice> m_device;
+    std::shared_ptr<VulkanResourcesManager> m_resources_manager;
+    std::shared_ptr<VulkanUploadManager> m_upload_manager;
+    std::shared_ptr<ThreadPool> m_thread_pool;
+    std::vector<std::unique_ptr<Texture>> m_textures;
+    std::unordered_map<std::string, size_t> m_texture_indices;
+    std::unordered_map<const VulkanImageBuffer*, size_t> m_image_indices;
+
+    ConcurrentQueue<size_t> m_decoded;
+    std::atomic<size_t> m_decodes_in_flight = 0u;
+    std::vector<RetiredImage> m_retired;
+
+    VulkanTextureResidency m_residency;
+    std::vector<VulkanTextureResidency::Step> m_steps; // update() scratch
+    uint64_t m_residency_version = 0u;
+};
@@ -0,0 +1,548 @@
+#include "vulkan_upload_manager.h"
+
+#include "vulkan_device.h"
+#include "vulkan_command_manager.h"
+#include "vulkan_device_memory_allocator.h"
+#include "../../tools/texture_tools.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+bool VulkanUploadManager::init(std::shared_ptr<VulkanDevice> device, VkDeviceSize staging_size) {
+    m_device = std::move(device);
+    m_timeline_supported = m_device->getDeviceAbilities().timeline_semaphore;
+
+    const QueueFamilyIndices& queue_family_indices = m_device->getCommandManager()->getQueueFamilyIndices();
+    m_transfer_family = queue_family_indices.getFamilyIdx(PoolTypeEnum::TRANSFER).value();
+    m_graphics_family = queue_family_indices.getFamilyIdx(PoolTypeEnum::GRAPICS).value();
+
+    m_staging_ring.init(m_device, staging_size);
+
+    // Own pools, command pools are externally synchronized and the renderer records from its pools on another thread.
+    VkCommandPoolCreateInfo transfer_cmd_pool_info{};
+    transfer_cmd_pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    transfer_cmd_pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    transfer_cmd_pool_info.queueFamilyIndex = m_transfer_family;
+
+    VkResult result = vkCreateCommandPool(m_device->getDevice(), &transfer_cmd_pool_info, nullptr, &m_transfer_pool);
+    if(result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create upload command pool!");
+    }
+
+    VkCommandPoolCreateInfo graphics_cmd_pool_info = transfer_cmd_pool_info;
+    graphics_cmd_pool_info.queueFamilyIndex = m_graphics_family;
+
+    result = vkCreateCommandPool(m_device->getDevice(), &graphics_cmd_pool_info, nullptr, &m_graphics_pool);
+    if(result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create upload command pool!");
+    }
+
+    if(m_timeline_supported) {
+        m_transfer_timeline = createTimelineSemaphore();
+        m_graphics_timeline = createTimelineSemaphore();
+    }
+    else {
+        VkFenceCreateInfo fence_info{};
+        fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        result = vkCreateFence(m_device->getDevice(), &fence_info, nullptr, &m_fallback_fence);
+        if(result != VK_SUCCESS) {
+            throw std::runtime_error("failed to create upload fence!");
+        }
+    }
+
+    return true;
+}
+
+void VulkanUploadManager::destroy() {
+    waitIdle();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    VkDevice device = m_device->getDevice();
+    vkDestroyCommandPool(device, m_transfer_pool, nullptr);
+    vkDestroyCommandPool(device, m_graphics_pool, nullptr);
+    m_transfer_pool = VK_NULL_HANDLE;
+    m_graphics_pool = VK_NULL_HANDLE;
+    m_free_transfer_cmd.clear();
+    m_free_graphics_cmd.clear();
+
+    if(m_transfer_timeline != VK_NULL_HANDLE) vkDestroySemaphore(device, m_transfer_timeline, nullptr);
+    if(m_graphics_timeline != VK_NULL_HANDLE) vkDestroySemaphore(device, m_graphics_timeline, nullptr);
+    if(m_fallback_fence != VK_NULL_HANDLE) vkDestroyFence(device, m_fallback_fence, nullptr);
+    m_transfer_timeline = VK_NULL_HANDLE;
+    m_graphics_timeline = VK_NULL_HANDLE;
+    m_fallback_fence = VK_NULL_HANDLE;
+
+    m_staging_ring.destroy();
+}
+
+void VulkanUploadManager::uploadBuffer(VkBuffer buffer, VkSharingMode sharing_mode, const void* data, VkDeviceSize size, VkDeviceSize dst_offset, VkAccessFlags dst_access, VkPipelineStageFlags dst_stage) {
+    if(!data || !size) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    VkBuffer staging_buffer = VK_NULL_HANDLE;
+    VkDeviceSize staging_offset = 0u;
+    void* staging = allocateStaging(size, 4u, staging_buffer, staging_offset);
+    memcpy(staging, data, size);
+
+    VkBufferCopy copy_region{};
+    copy_region.srcOffset = staging_offset;
+    copy_region.dstOffset = dst_offset;
+    copy_region.size = size;
+    vkCmdCopyBuffer(getTransferCommandBuffer(), staging_buffer, buffer, 1u, &copy_region);
+
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.buffer = buffer;
+    barrier.offset = dst_offset;
+    barrier.size = size;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+    if(isOwnershipTransferNeeded(sharing_mode)) {
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0u;
+        barrier.srcQueueFamilyIndex = m_transfer_family;
+        barrier.dstQueueFamilyIndex = m_graphics_family;
+        vkCmdPipelineBarrier(getTransferCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0u, 0u, nullptr, 1u, &barrier, 0u, nullptr);
+    }
+
+    // Acquire half of the ownership transfer, or with shared ownership only the execution dependency that keeps later
+    // graphics submissions behind the timeline wait. The semaphore wait already made the transfer writes visible.
+    barrier.srcAccessMask = 0u;
+    barrier.dstAccessMask = dst_access;
+    vkCmdPipelineBarrier(getGraphicsCommandBuffer(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, dst_stage, 0u, 0u, nullptr, 1u, &barrier, 0u, nullptr);
+}
+
+void VulkanUploadManager::uploadImage(VkImage image, const VkImageCreateInfo& image_info, const void* pixels, VkDeviceSize size, VkImageLayout final_layout) {
+    if(!pixels || !size) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Buffer offsets of block compressed levels are multiples of the block size.
+    VkDeviceSize block_size = std::max<VkDeviceSize>(getTexelBlock(image_info.format).bytes, 1u);
+    VkDeviceSize copy_alignment = std::max<VkDeviceSize>(m_device->getDeviceAbilities().props.limits.optimalBufferCopyOffsetAlignment, 1u);
+    VkDeviceSize alignment = std::lcm(std::lcm<VkDeviceSize>(block_size, 4u), copy_alignment);
+
+    VkBuffer staging_buffer = VK_NULL_HANDLE;
+    VkDeviceSize staging_offset = 0u;
+    void* staging = allocateStaging(size, alignment, staging_buffer, staging_offset);
+    memcpy(staging, pixels, size);
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.image = image;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0u;
+    barrier.subresourceRange.levelCount = image_info.mipLevels;
+    barrier.subresourceRange.baseArrayLayer = 0u;
+    barrier.subresourceRange.layerCount = 1u;
+    barrier.oldLayout = image_info.initialLayout;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = 0u;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    VkCommandBuffer transfer_cmd = getTransferCommandBuffer();
+    vkCmdPipelineBarrier(transfer_cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0u, 0u, nullptr, 0u, nullptr, 1u, &barrier);
+
+    VkBufferImageCopy region{};
+    region.bufferOffset = staging_offset;
+    region.bufferRowLength = 0u;
+    region.bufferImageHeight = 0u;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0u;
+    region.imageSubresource.baseArrayLayer = 0u;
+    region.imageSubresource.layerCount = 1u;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = image_info.extent;
+    vkCmdCopyBufferToImage(transfer_cmd, staging_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1u, &region);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    if(isOwnershipTransferNeeded(image_info.sharingMode)) {
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0u;
+        barrier.srcQueueFamilyIndex = m_transfer_family;
+        barrier.dstQueueFamilyIndex = m_graphics_family;
+        vkCmdPipelineBarrier(transfer_cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0u, 0u, nullptr, 0u, nullptr, 1u, &barrier);
+    }
+
+    // Blits need a graphics queue, so mips and the final layout are done after the acquire.
+    VkCommandBuffer graphics_cmd = getGraphicsCommandBuffer();
+    barrier.srcAccessMask = 0u;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(graphics_cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0u, 0u, nullptr, 0u, nullptr, 1u, &barrier);
+
+    if(image_info.mipLevels != 1u) {
+        m_device->getCommandManager()->generateMipmaps(graphics_cmd, image, image_info.format, { image_info.extent.width, image_info.extent.height }, image_info.mipLevels, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, final_layout);
+        return;
+    }
+    if(final_layout == VK_IMAGE_LAYOUT_UNDEFINED || final_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) return;
+
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.newLayout = final_layout;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(graphics_cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0u, 0u, nullptr, 0u, nullptr, 1u, &barrier);
+}
+
+void VulkanUploadManager::uploadImageMips(VkImage image, const VkImageCreateInfo& image_info, uint32_t first_mip, uint32_t mip_count, const void* pixels, VkDeviceSize size, VkImageLayout final_layout) {
+    if(!pixels || !size || !mip_count) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Buffer offsets of block compressed levels are multiples of the block size.
+    VkDeviceSize block_size = std::max<VkDeviceSize>(getTexelBlock(image_info.format).bytes, 1u);
+    VkDeviceSize copy_alignment = std::max<VkDeviceSize>(m_device->getDeviceAbilities().props.limits.optimalBufferCopyOffsetAlignment, 1u);
+    VkDeviceSize alignment = std::lcm(std::lcm<VkDeviceSize>(block_size, 4u), copy_alignment);
+
+    VkBuffer staging_buffer = VK_NULL_HANDLE;
+    VkDeviceSize staging_offset = 0u;
+    void* staging = allocateStaging(size, alignment, staging_buffer, staging_offset);
+    memcpy(staging, pixels, size);
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.image = image;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = first_mip;
+    barrier.subresourceRange.levelCount = mip_count;
+    barrier.subresourceRange.baseArrayLayer = 0u;
+    barrier.subresourceRange.layerCount = 1u;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = 0u;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    VkCommandBuffer transfer_cmd = getTransferCommandBuffer();
+    vkCmdPipelineBarrier(transfer_cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0u, 0u, nullptr, 0u, nullptr, 1u, &barrier);
+
+    std::vector<VkBufferImageCopy> regions(mip_count);
+    VkDeviceSize level_offset = staging_offset;
+    for(uint32_t i = 0u; i < mip_count; ++i) {
+        const uint32_t mip_level = first_mip + i;
+        VkBufferImageCopy& region = regions[i];
+        region.bufferOffset = level_offset;
+        region.bufferRowLength = 0u;
+        region.bufferImageHeight = 0u;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = mip_level;
+        region.imageSubresource.baseArrayLayer = 0u;
+        region.imageSubresource.layerCount = 1u;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = { std::max(image_info.extent.width >> mip_level, 1u), std::max(image_info.extent.height >> mip_level, 1u), 1u };
+        level_offset += getLevelSize(image_info.format, { region.imageExtent.width, region.imageExtent.height });
+    }
+    if(level_offset - staging_offset > size) {
+        throw std::runtime_error("not enough pixels for the uploaded mip levels!");
+    }
+    vkCmdCopyBufferToImage(transfer_cmd, staging_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mip_count, regions.data());
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = final_layout;
+    if(isOwnershipTransferNeeded(image_info.sharingMode)) {
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0u;
+        barrier.srcQueueFamilyIndex = m_transfer_family;
+        barrier.dstQueueFamilyIndex = m_graphics_family;
+        vkCmdPipelineBarrier(transfer_cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0u, 0u, nullptr, 0u, nullptr, 1u, &barrier);
+    }
+
+    // Every level is prebuilt, the graphics side only acquires the range and moves it to its final layout.
+    barrier.srcAccessMask = 0u;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(getGraphicsCommandBuffer(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0u, 0u, nullptr, 0u, nullptr, 1u, &barrier);
+}
+
+void VulkanUploadManager::transitionImage(VkImage image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout, uint32_t mip_levels) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_device->getCommandManager()->transitionImageLayout(getGraphicsCommandBuffer(), image, format, old_layout, new_layout, mip_levels);
+}
+
+void VulkanUploadManager::flush() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    submitTransfer();
+    submitGraphics();
+    retireLocked();
+}
+
+void VulkanUploadManager::retire() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    retireLocked();
+}
+
+void VulkanUploadManager::waitIdle() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    submitTransfer();
+    submitGraphics();
+
+    if(m_timeline_supported) {
+        VkSemaphore semaphores[] = { m_transfer_timeline, m_graphics_timeline };
+        uint64_t values[] = { m_transfer_value, m_graphics_value };
+
+        VkSemaphoreWaitInfo wait_info{};
+        wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        wait_info.semaphoreCount = 2u;
+        wait_info.pSemaphores = semaphores;
+        wait_info.pValues = values;
+        vkWaitSemaphores(m_device->getDevice(), &wait_info, UINT64_MAX);
+    }
+
+    retireLocked();
+}
+
+uint64_t VulkanUploadManager::getCompletedTransferValue() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return getSemaphoreValue(m_transfer_timeline, m_transfer_value);
+}
+
+VkDeviceSize VulkanUploadManager::getStagingSize() const {
+    return m_staging_ring.getSize();
+}
+
+VkDeviceSize VulkanUploadManager::getStagingUsedSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_staging_ring.getUsedSize();
+}
+
+bool VulkanUploadManager::isOwnershipTransferNeeded(VkSharingMode sharing_mode) const {
+    return sharing_mode == VK_SHARING_MODE_EXCLUSIVE && m_transfer_family != m_graphics_family;
+}
+
+void* VulkanUploadManager::allocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkBuffer& out_buffer, VkDeviceSize& out_offset) {
+    VulkanStagingRing::Allocation ring_allocation;
+    while(size <= m_staging_ring.getSize()) {
+        if(m_staging_ring.allocate(size, alignment, ring_allocation)) {
+            out_buffer = m_staging_ring.getBuffer();
+            out_offset = ring_allocation.offset;
+            return ring_allocation.mapped;
+        }
+
+        // Ring is full, kick what we have and block on the oldest batch still holding staging space.
+        if(m_staging_ring.hasPending()) {
+            submitTransfer();
+        }
+        if(!m_staging_ring.hasInFlight()) break;
+
+        waitTransferValue(m_staging_ring.getOldestInFlightValue());
+        retireLocked();
+    }
+
+    // Too big for the ring, give it a staging buffer of its own that dies with the batch.
+    VkBufferCreateInfo buffer_info{};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    TemporaryStaging temporary{};
+    temporary.value = m_transfer_value + 1u;
+    VkResult result = vkCreateBuffer(m_device->getDevice(), &buffer_info, nullptr, &temporary.buffer);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create staging buffer!");
+    }
+
+    VkMemoryRequirements mem_req;
+    vkGetBufferMemoryRequirements(m_device->getDevice(), temporary.buffer, &mem_req);
+    if(!m_device->getMemoryAllocator()->allocate(mem_req, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VulkanDeviceMemoryAllocator::AllocationMode::LINEAR, temporary.allocation)) {
+        throw std::runtime_error("failed to allocate staging buffer memory!");
+    }
+    vkBindBufferMemory(m_device->getDevice(), temporary.buffer, temporary.allocation.get_memory(), temporary.allocation.get_offset());
+
+    m_temporary_staging.push_back(temporary);
+    out_buffer = temporary.buffer;
+    out_offset = 0u;
+    return temporary.allocation.get_host_pointer();
+}
+
+VkCommandBuffer VulkanUploadManager::getTransferCommandBuffer() {
+    if(m_transfer_cmd == VK_NULL_HANDLE) {
+        m_transfer_cmd = beginCommandBuffer(m_transfer_pool, m_free_transfer_cmd);
+    }
+    return m_transfer_cmd;
+}
+
+VkCommandBuffer VulkanUploadManager::getGraphicsCommandBuffer() {
+    if(m_graphics_cmd == VK_NULL_HANDLE) {
+        m_graphics_cmd = beginCommandBuffer(m_graphics_pool, m_free_graphics_cmd);
+    }
+    return m_graphics_cmd;
+}
+
+VkCommandBuffer VulkanUploadManager::beginCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& free_list) {
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    if(free_list.empty()) {
+        VkCommandBufferAllocateInfo command_alloc_info{};
+        command_alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        command_alloc_info.commandPool = pool;
+        command_alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        command_alloc_info.commandBufferCount = 1u;
+
+        VkResult result = vkAllocateCommandBuffers(m_device->getDevice(), &command_alloc_info, &command_buffer);
+        if(result != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate command buffers!");
+        }
+    }
+    else {
+        command_buffer = free_list.back();
+        free_list.pop_back();
+    }
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    VkResult result = vkBeginCommandBuffer(command_buffer, &begin_info);
+    if(result != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording commandbuffer!");
+    }
+
+    return command_buffer;
+}
+
+void VulkanUploadManager::submitTransfer() {
+    if(m_transfer_cmd == VK_NULL_HANDLE) return;
+
+    VkResult result = vkEndCommandBuffer(m_transfer_cmd);
+    if(result != VK_SUCCESS) {
+        throw std::runtime_error("failed to record command buffer!");
+    }
+
+    uint64_t value = ++m_transfer_value;
+
+    VkTimelineSemaphoreSubmitInfo timeline_info{};
+    timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timeline_info.signalSemaphoreValueCount = 1u;
+    timeline_info.pSignalSemaphoreValues = &value;
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1u;
+    submit_info.pCommandBuffers = &m_transfer_cmd;
+
+    if(m_timeline_supported) {
+        submit_info.pNext = &timeline_info;
+        submit_info.signalSemaphoreCount = 1u;
+        submit_info.pSignalSemaphores = &m_transfer_timeline;
+        m_device->getCommandManager()->queueSubmit(PoolTypeEnum::TRANSFER, 1u, &submit_info, VK_NULL_HANDLE);
+    }
+    else {
+        m_device->getCommandManager()->queueSubmit(PoolTypeEnum::TRANSFER, 1u, &submit_info, m_fallback_fence);
+        vkWaitForFences(m_device->getDevice(), 1u, &m_fallback_fence, VK_TRUE, UINT64_MAX);
+        vkResetFences(m_device->getDevice(), 1u, &m_fallback_fence);
+    }
+
+    m_staging_ring.fence(value);
+    m_in_flight_transfer_cmd.push_back({ m_transfer_cmd, value });
+    m_transfer_cmd = VK_NULL_HANDLE;
+    m_graphics_wait_value = value;
+}
+
+void VulkanUploadManager::submitGraphics() {
+    if(m_graphics_cmd == VK_NULL_HANDLE) return;
+
+    VkResult result = vkEndCommandBuffer(m_graphics_cmd);
+    if(result != VK_SUCCESS) {
+        throw std::runtime_error("failed to record command buffer!");
+    }
+
+    uint64_t value = ++m_graphics_value;
+    VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+    VkTimelineSemaphoreSubmitInfo timeline_info{};
+    timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timeline_info.waitSemaphoreValueCount = 1u;
+    timeline_info.pWaitSemaphoreValues = &m_graphics_wait_value;
+    timeline_info.signalSemaphoreValueCount = 1u;
+    timeline_info.pSignalSemaphoreValues = &value;
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1u;
+    submit_info.pCommandBuffers = &m_graphics_cmd;
+
+    if(m_timeline_supported) {
+        submit_info.pNext = &timeline_info;
+        submit_info.waitSemaphoreCount = 1u;
+        submit_info.pWaitSemaphores = &m_transfer_timeline;
+        submit_info.pWaitDstStageMask = &wait_stage;
+        submit_info.signalSemaphoreCount = 1u;
+        submit_info.pSignalSemaphores = &m_graphics_timeline;
+        m_device->getCommandManager()->queueSubmit(PoolTypeEnum::GRAPICS, 1u, &submit_info, VK_NULL_HANDLE);
+    }
+    else {
+        m_device->getCommandManager()->queueSubmit(PoolTypeEnum::GRAPICS, 1u, &submit_info, m_fallback_fence);
+        vkWaitForFences(m_device->getDevice(), 1u, &m_fallback_fence, VK_TRUE, UINT64_MAX);
+        vkResetFences(m_device->getDevice(), 1u, &m_fallback_fence);
+    }
+
+    m_in_flight_graphics_cmd.push_back({ m_graphics_cmd, value });
+    m_graphics_cmd = VK_NULL_HANDLE;
+}
+
+void VulkanUploadManager::retireLocked() {
+    uint64_t transfer_completed = getSemaphoreValue(m_transfer_timeline, m_transfer_value);
+    uint64_t graphics_completed = getSemaphoreValue(m_graphics_timeline, m_graphics_value);
+
+    m_staging_ring.retire(transfer_completed);
+
+    while(!m_temporary_staging.empty() && m_temporary_staging.front().value <= transfer_completed) {
+        vkDestroyBuffer(m_device->getDevice(), m_temporary_staging.front().buffer, nullptr);
+        m_device->getMemoryAllocator()->free(m_temporary_staging.front().allocation);
+        m_temporary_staging.pop_front();
+    }
+
+    while(!m_in_flight_transfer_cmd.empty() && m_in_flight_transfer_cmd.front().value <= transfer_completed) {
+        m_free_transfer_cmd.push_back(m_in_flight_transfer_cmd.front().command_buffer);
+        m_in_flight_transfer_cmd.pop_front();
+    }
+
+    while(!m_in_flight_graphics_cmd.empty() && m_in_flight_graphics_cmd.front().value <= graphics_completed) {
+        m_free_graphics_cmd.push_back(m_in_flight_graphics_cmd.front().command_buffer);
+        m_in_flight_graphics_cmd.pop_front();
+    }
+}
+
+void VulkanUploadManager::waitTransferValue(uint64_t value) {
+    if(!m_timeline_supported) return;
+
+    VkSemaphoreWaitInfo wait_info{};
+    wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    wait_info.semaphoreCount = 1u;
+    wait_info.pSemaphores = &m_transfer_timeline;
+    wait_info.pValues = &value;
+    vkWaitSemaphores(m_device->getDevice(), &wait_info, UINT64_MAX);
+}
+
+VkSemaphore VulkanUploadManager::createTimelineSemaphore() {
+    VkSemaphoreTypeCreateInfo type_info{};
+    type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    type_info.initialValue = 0u;
+
+    VkSemaphoreCreateInfo semaphore_info{};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphore_info.pNext = &type_info;
+
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    VkResult result = vkCreateSemaphore(m_device->getDevice(), &semaphore_info, nullptr, &semaphore);
+    if(result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create timeline semaphore!");
+    }
+    return semaphore;
+}
+
+uint64_t VulkanUploadManager::getSemaphoreValue(VkSemaphore semaphore, uint64_t fallback_value) const {
+    // Without timeline semaphores every submit is waited on the spot, so whatever was submitted is complete.
+    if(!m_timeline_supported) return fallback_value;
+
+    uint64_t value = 0u;
+    vkGetSemaphoreCounterValue(m_device->getDevice(), semaphore, &value);
+    return value;
+}
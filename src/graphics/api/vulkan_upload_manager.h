@@ -0,0 +1,96 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "vulkan_device_memory_allocation.h"
+#include "vulkan_staging_ring.h"
+
+class VulkanDevice;
+
+// Streams buffer and image contents to device local memory. Data is copied into a persistently mapped staging ring,
+// the copies are batched into one transfer command buffer and submitted on the transfer queue, which signals a
+// timeline semaphore. Work that has to run on the graphics queue (ownership acquire, mip generation, final layout)
+// is batched into a graphics command buffer that waits on that timeline value and is submitted by flush(), which the
+// renderer calls before its own submit, so the frame sees uploaded data without any CPU wait. Uploads may be issued
+// from any thread, flush() has to come from the thread that owns the graphics queue.
+class VulkanUploadManager {
+public:
+    static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 64u * 1024u * 1024u;
+
+    bool init(std::shared_ptr<VulkanDevice> device, VkDeviceSize staging_size = DEFAULT_STAGING_SIZE);
+    void destroy();
+
+    void uploadBuffer(VkBuffer buffer, VkSharingMode sharing_mode, const void* data, VkDeviceSize size, VkDeviceSize dst_offset, VkAccessFlags dst_access, VkPipelineStageFlags dst_stage);
+    void uploadImage(VkImage image, const VkImageCreateInfo& image_info, const void* pixels, VkDeviceSize size, VkImageLayout final_layout);
+    // Copies prebuilt levels [first_mip, first_mip + mip_count), tightly packed in level order, and leaves only them in
+    // final_layout. Levels outside the range are not touched, an image can be filled a few levels at a time.
+    void uploadImageMips(VkImage image, const VkImageCreateInfo& image_info, uint32_t first_mip, uint32_t mip_count, const void* pixels, VkDeviceSize size, VkImageLayout final_layout);
+    void transitionImage(VkImage image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout, uint32_t mip_levels);
+
+    // Submits pending transfer work and the graphics side batch, then recycles whatever the GPU has finished with.
+    void flush();
+    void retire();
+    void waitIdle();
+
+    uint64_t getCompletedTransferValue() const;
+    VkDeviceSize getStagingSize() const;
+    VkDeviceSize getStagingUsedSize() const;
+
+private:
+    struct InFlightCommandBuffer {
+        VkCommandBuffer command_buffer;
+        uint64_t value;
+    };
+
+    struct TemporaryStaging {
+        VkBuffer buffer;
+        DeviceAllocation allocation;
+        uint64_t value;
+    };
+
+    bool isOwnershipTransferNeeded(VkSharingMode sharing_mode) const;
+    void* allocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkBuffer& out_buffer, VkDeviceSize& out_offset);
+    VkCommandBuffer getTransferCommandBuffer();
+    VkCommandBuffer getGraphicsCommandBuffer();
+    VkCommandBuffer beginCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& free_list);
+    void submitTransfer();
+    void submitGraphics();
+    void retireLocked();
+    void waitTransferValue(uint64_t value);
+
+    VkSemaphore createTimelineSemaphore();
+    uint64_t getSemaphoreValue(VkSemaphore semaphore, uint64_t fallback_value) const;
+
+    std::shared_ptr<VulkanDevice> m_device;
+    bool m_timeline_supported = false;
+    uint32_t m_transfer_family = 0u;
+    uint32_t m_graphics_family = 0u;
+
+    VulkanStagingRing m_staging_ring;
+    std::deque<TemporaryStaging> m_temporary_staging;
+
+    VkCommandPool m_transfer_pool = VK_NULL_HANDLE;
+    VkCommandPool m_graphics_pool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> m_free_transfer_cmd;
+    std::vector<VkCommandBuffer> m_free_graphics_cmd;
+    std::deque<InFlightCommandBuffer> m_in_flight_transfer_cmd;
+    std::deque<InFlightCommandBuffer> m_in_flight_graphics_cmd;
+    VkCommandBuffer m_transfer_cmd = VK_NULL_HANDLE;
+    VkCommandBuffer m_graphics_cmd = VK_NULL_HANDLE;
+
+    VkSemaphore m_transfer_timeline = VK_NULL_HANDLE;
+    VkSemaphore m_graphics_timeline = VK_NULL_HANDLE;
+    VkFence m_fallback_fence = VK_NULL_HANDLE;
+    uint64_t m_transfer_value = 0u;
+    uint64_t m_graphics_value = 0u;
+    uint64_t m_graphics_wait_value = 0u;
+
+    mutable std::mutex m_mutex;
+};
@@ -0,0 +1,84 @@
+#include "draw_batcher.h"
+
+#include "../../tools/simd_math.h"
+
+#include <algorithm>
+
+void DrawBatcher::clear() {
+    m_draws.clear();
+    m_models.clear();
+    m_sorted.clear();
+    m_batches.clear();
+    m_instances.clear();
+    m_commands.clear();
+    m_draw_order.clear();
+}
+
+void DrawBatcher::reserve(size_t count) {
+    m_draws.reserve(count);
+    m_models.reserve(count);
+    m_sorted.reserve(count);
+    m_instances.reserve(count);
+    m_draw_order.reserve(count);
+}
+
+void DrawBatcher::add(const Key& key, uint32_t draw_id, const glm::mat4& model, uint32_t index_count, uint32_t material_index) {
+    m_draws.push_back({ key, draw_id, index_count, material_index });
+    m_models.push_back(model);
+}
+
+void DrawBatcher::build() {
+    m_batches.clear();
+    m_instances.clear();
+    m_commands.clear();
+    m_draw_order.clear();
+
+    // Indices are sorted instead of the draws so the matrices stay where they are, the index breaks ties.
+    m_sorted.resize(m_draws.size());
+    for (uint32_t i = 0u; i < m_sorted.size(); ++i) {
+        m_sorted[i] = i;
+    }
+    std::sort(m_sorted.begin(), m_sorted.end(), [this](uint32_t a, uint32_t b) {
+        const auto order = m_draws[a].key <=> m_draws[b].key;
+        return order != 0 ? order < 0 : a < b;
+    });
+
+    for (uint32_t draw_index : m_sorted) {
+        const Draw& draw = m_draws[draw_index];
+        const uint32_t instance_index = static_cast<uint32_t>(m_instances.size());
+
+        if (m_batches.empty() || m_batches.back().key != draw.key) {
+            m_batches.push_back({ draw.key, draw.draw_id, instance_index, 0u });
+
+            VkDrawIndexedIndirectCommand command{};
+            command.indexCount = draw.index_count;
+            command.instanceCount = 0u;
+            command.firstIndex = 0u;
+            command.vertexOffset = 0;
+            command.firstInstance = instance_index;
+            m_commands.push_back(command);
+        }
+
+        const glm::mat4& model = m_models[draw_index];
+        m_instances.push_back({ model, fastInverse(model), glm::uvec4(draw.material_index, 0u, 0u, 0u) });
+        m_draw_order.push_back(draw.draw_id);
+        ++m_batches.back().instance_count;
+        ++m_commands.back().instanceCount;
+    }
+}
+
+const std::vector<DrawBatcher::Batch>& DrawBatcher::getBatches() const {
+    return m_batches;
+}
+
+const std::vector<DrawBatcher::InstanceData>& DrawBatcher::getInstances() const {
+    return m_instances;
+}
+
+const std::vector<VkDrawIndexedIndirectCommand>& DrawBatcher::getCommands() const {
+    return m_commands;
+}
+
+const std::vector<uint32_t>& DrawBatcher::getDrawOrder() const {
+    return m_draw_order;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#include <glm/glm.hpp>
+#include <glm/mat4x4.hpp>
+
+#include <compare>
+#include <cstdint>
+#include <vector>
+
+// Groups draws that differ only by their world transform. Draws with the same key (pipeline, material, vertex and
+// index buffer) form one batch: their transforms are packed back to back into the instance array and the batch is
+// drawn by a single indexed indirect command whose firstInstance points at its first packed transform.
+class DrawBatcher {
+public:
+    struct Key {
+        const void* pipeline = nullptr;
+        const void* material = nullptr;
+        const void* vertex_buffer = nullptr;
+        const void* index_buffer = nullptr;
+
+        auto operator<=>(const Key&) const = default;
+    };
+
+    // Matches InstanceData in basic_phong_instanced.vert and basic_phong_bindless.vert (std430).
+    struct InstanceData {
+        glm::mat4 model;
+        glm::mat4 inv_model;
+        glm::uvec4 material; // x: index in the material table of the bindless path
+    };
+
+    struct Batch {
+        Key key;
+        uint32_t leader_id;       // draw id of the first member, its render node records the batch
+        uint32_t first_instance;
+        uint32_t instance_count;
+    };
+
+    void clear();
+    void reserve(size_t count);
+    // Bindless draws leave Key::material empty so meshes with different materials still share a batch.
+    void add(const Key& key, uint32_t draw_id, const glm::mat4& model, uint32_t index_count, uint32_t material_index = 0u);
+    // Sorts the draws by key and fills batches, instances and commands. Members of a batch keep their add() order.
+    void build();
+
+    const std::vector<Batch>& getBatches() const;
+    const std::vector<InstanceData>& getInstances() const;
+    const std::vector<VkDrawIndexedIndirectCommand>& getCommands() const;
+    const std::vector<uint32_t>& getDrawOrder() const;
+
+private:
+    struct Draw {
+        Key key;
+        uint32_t draw_id;
+        uint32_t index_count;
+        uint32_t material_index;
+    };
+
+    std::vector<Draw> m_draws;
+    std::vector<glm::mat4> m_models;
+    std::vector<uint32_t> m_sorted;
+
+    std::vector<Batch> m_batches;
+    std::vector<InstanceData> m_instances;
+    std::vector<VkDrawIndexedIndirectCommand> m_commands;
+    std::vector<uint32_t> m_draw_order; // draw ids in packed instance order
+};
@@ -12,6 +12,7 @@
 #include "../api/vulkan_resources_manager.h"
 #include "../api/vulkan_descriptors_manager.h"
 #include "../api/vulkan_push_constant.h"
+#include "../api/vulkan_texture_streamer.h"
 #include "../pod/graphics_render_node.h"
 #include "../pod/graphics_render_node_config.h"
 #include "../pod/descriptor_set_layout.h"
@@ -21,6 +22,8 @@
 #include "../vulkan_renderer.h"
 #include "../../tools/string_tools.h"
 
+#include <algorithm>
+
 struct SceneUniformBufferObject {
     glm::mat4 model;
     glm::mat4 view;
@@ -31,6 +34,13 @@ struct PhongMaterial {
     glm::vec4 fresnelR0_roughness;
 };
 
+struct FrameUniformBufferObject {
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::mat4 inv_view;
+    glm::uvec4 tables;
+};
+
 bool SceneDrawable::init(std::shared_ptr<VulkanDevice> device, int max_frames, std::shared_ptr<LightManager> light_manager) {
     using namespace std::literals;
 
@@ -40,10 +50,23 @@ bool SceneDrawable::init(std::shared_ptr<VulkanDevice> device, int max_frames, s
     m_viewport_extent = Application::GetRenderer().getSwapchain()->getFormatConfig()->getExtent2D();
     m_light_manager = std::move(light_manager);
 
+    m_instancing_supported = m_device->getPhysicalDeviceFeatures().drawIndirectFirstInstance == VK_TRUE;
+    // Bindless draws are batched too, without instancing they fall back with everything else.
+    m_bindless_supported = m_instancing_supported && Application::GetRenderer().getResourcesManager()->isBindlessEnabled();
+
     m_per_frame.resize(max_frames);
     for(int frame = 0; frame < m_max_frames; ++frame) {
         m_per_frame[frame] = std::make_shared<RenderPerFrame>();
         m_per_frame[frame]->light_buffer = Application::GetRenderer().getResourcesManager()->getBufferResource(LightManager::getLightBufferName() + std::to_string(frame));
+        if(m_instancing_supported) {
+            m_per_frame[frame]->instance_buffer = Application::GetRenderer().getResourcesManager()->create_buffer(nullptr, 0, "instance_ssbo"s + std::to_string(frame), "instance_storage_resource"s);
+            m_per_frame[frame]->indirect_buffer = Application::GetRenderer().getResourcesManager()->create_buffer(nullptr, 0, "indirect_draw"s + std::to_string(frame), "indirect_draw_resource"s);
+        }
+        if(m_bindless_supported) {
+            m_per_frame[frame]->frame_buffer = Application::GetRenderer().getResourcesManager()->create_buffer(nullptr, 0, "frame_ubo"s + std::to_string(frame), "frame_uniform_resource"s);
+            m_per_frame[frame]->material_buffer = Application::GetRenderer().getResourcesManager()->create_buffer(nullptr, 0, "material_ssbo"s + std::to_string(frame), "material_storage_resource"s);
+            m_per_frame[frame]->material_buffer_slot = Application::GetRenderer().getResourcesManager()->registerBindlessBuffer(m_per_frame[frame]->material_buffer);
+        }
     }
 
     return true;
@@ -72,9 +95,13 @@ void SceneDrawable::update(const GameTimerDelta& delta, uint32_t image_index) {
     const std::vector<LightNodeProperties>& light_data = m_light_manager->getAllLightsData();
     m_per_frame[image_index]->light_buffer->update(light_data.data(), sizeof(LightNodeProperties) * light_data.size());
 
-    for(size_t render_id = 0u; render_id < sz; ++render_id) {
+    cullRenderables(image_index);
+    refreshStreamedTextures(image_index);
+    batchRenderables(image_index);
+    updateBindlessTables(image_index);
+
+    for(uint32_t render_id : m_per_frame[image_index]->visible_renderables) {
         const std::shared_ptr<Renderable>& renderable = m_per_frame[image_index]->renderables.at(render_id);
-        if(!renderable->mesh_node) continue;
 
         m_light_manager->DecorateValueBag(renderable->mesh_node);
 
@@ -83,6 +110,213 @@ void SceneDrawable::update(const GameTimerDelta& delta, uint32_t image_index) {
     }
 }
 
+// Two phases. The scene's spatial index is queried with the camera frustum first, a renderable whose mesh node has
+// bounds in that tree but was not reported is culled without further tests. The remaining cullable renderables have
+// their world space boxes tested against the frustum in one batch. The sorted ids of the survivors are left in
+// visible_renderables, render nodes of culled renderables are bypassed. Skinned meshes have no reliable bind pose
+// bounds and are always drawn.
+void SceneDrawable::cullRenderables(uint32_t image_index) {
+    std::shared_ptr<RenderPerFrame>& per_frame = m_per_frame[image_index];
+    std::vector<uint32_t>& visible = per_frame->visible_renderables;
+    const size_t sz = per_frame->renderables.size();
+    visible.clear();
+
+    const std::shared_ptr<CameraComponent>& camera_component = Application::Get().GetGameLogic()->GetHumanView()->VGetCamera();
+    std::shared_ptr<BasicCameraNode> camera_node = camera_component ? camera_component->VGetCameraNode() : nullptr;
+
+    std::shared_ptr<Scene> scene;
+    BoundingFrustum world_frustum;
+    if(camera_node) {
+        // The frustum lives in the camera's parent space.
+        scene = camera_node->GetScene();
+        const Scene::NodeIndex parent_index = scene->getNodeHierarchy(camera_node->VGetNodeIndex()).parent;
+        world_frustum = camera_node->GetFrustum();
+        if(parent_index != Scene::NO_INDEX) {
+            camera_node->GetFrustum().Transform(world_frustum, scene->getNodeGlobalTransform(parent_index));
+        }
+
+        const DynamicAABBTree& spatial_index = scene->getSpatialIndex();
+        m_tree_visible.resize(spatial_index.getProxyCount());
+        m_tree_visible.resize(spatial_index.queryFrustum(world_frustum, m_tree_visible.data(), m_tree_visible.size()));
+        m_node_visible.assign(scene->getHierarchy().size(), 0u);
+        for(uint32_t node_index : m_tree_visible) {
+            m_node_visible[node_index] = 1u;
+        }
+    }
+
+    m_culler.clear();
+    m_cull_slots.clear();
+    m_culler.reserve(sz);
+    for(size_t render_id = 0u; render_id < sz; ++render_id) {
+        const std::shared_ptr<Renderable>& renderable = per_frame->renderables[render_id];
+        if(!renderable->mesh_node) continue;
+
+        if(!camera_node || !renderable->cullable) {
+            visible.push_back(static_cast<uint32_t>(render_id));
+            continue;
+        }
+
+        const Scene::NodeIndex node_index = renderable->mesh_node->VGetNodeIndex();
+        const bool in_spatial_index = renderable->mesh_node->GetScene() == scene && scene->getNodeProxy(node_index) != DynamicAABBTree::NULL_NODE;
+        if(in_spatial_index && !m_node_visible[node_index]) continue;
+
+        m_culler.add(renderable->local_aabb, renderable->mesh_node->Get().ToRoot());
+        m_cull_slots.push_back(static_cast<uint32_t>(render_id));
+    }
+
+    if(camera_node && m_culler.size()) {
+        m_culler.setFrustum(world_frustum);
+
+        std::vector<uint32_t> visible_slots;
+        m_culler.cull(visible_slots);
+        for(uint32_t slot : visible_slots) {
+            visible.push_back(m_cull_slots[slot]);
+        }
+    }
+    std::sort(visible.begin(), visible.end());
+
+    for(const std::shared_ptr<Renderable>& renderable : per_frame->renderables) {
+        renderable->render_node->setExecutionBypass(true);
+    }
+    for(uint32_t render_id : visible) {
+        per_frame->renderables[render_id]->render_node->setExecutionBypass(false);
+    }
+}
+
+// Visible instanced renderables are grouped by pipeline, material and mesh buffers. The first member of every group
+// records one indirect draw for the whole group, the others are bypassed. Members share the leader's descriptors and
+// push constants, only the transforms differ and those come from the instance buffer. Bindless renderables read their
+// material from the instance buffer too, so only pipeline and mesh buffers split their groups.
+void SceneDrawable::batchRenderables(uint32_t image_index) {
+    if(!m_instancing_supported) return;
+
+    std::shared_ptr<RenderPerFrame>& per_frame = m_per_frame[image_index];
+    if(per_frame->instanced_count == 0u) return;
+
+    m_batcher.clear();
+    m_batcher.reserve(per_frame->instanced_count);
+    for(uint32_t render_id : per_frame->visible_renderables) {
+        const std::shared_ptr<Renderable>& renderable = per_frame->renderables[render_id];
+        if(!renderable->instanced) continue;
+
+        DrawBatcher::Key key;
+        key.pipeline = renderable->render_node->getPipeline().get();
+        key.material = renderable->bindless ? nullptr : renderable->material.get();
+        key.vertex_buffer = renderable->vertex_buffer.get();
+        key.index_buffer = renderable->index_buffer.get();
+        m_batcher.add(key, render_id, renderable->mesh_node->Get().ToRoot(), renderable->index_count, renderable->material_index);
+    }
+    m_batcher.build();
+
+    const std::vector<DrawBatcher::InstanceData>& instances = m_batcher.getInstances();
+    const std::vector<VkDrawIndexedIndirectCommand>& commands = m_batcher.getCommands();
+    if(instances.empty()) return;
+
+    per_frame->instance_buffer->update(instances.data(), sizeof(DrawBatcher::InstanceData) * instances.size());
+    per_frame->indirect_buffer->update(commands.data(), sizeof(VkDrawIndexedIndirectCommand) * commands.size());
+
+    for(uint32_t render_id : m_batcher.getDrawOrder()) {
+        per_frame->renderables[render_id]->render_node->setExecutionBypass(true);
+    }
+    const std::vector<DrawBatcher::Batch>& batches = m_batcher.getBatches();
+    for(size_t batch_id = 0u; batch_id < batches.size(); ++batch_id) {
+        const std::shared_ptr<GraphicsRenderNode>& leader = per_frame->renderables[batches[batch_id].leader_id]->render_node;
+        leader->setIndirectDraw(per_frame->indirect_buffer, batch_id * sizeof(VkDrawIndexedIndirectCommand), 1u);
+        leader->setExecutionBypass(false);
+    }
+}
+
+// Every bindless draw of the frame binds the same two sets: the frame data and the bindless table. Materials are
+// refreshed each frame like the per node material buffers of the regular path.
+void SceneDrawable::updateBindlessTables(uint32_t image_index) {
+    if(!m_bindless_supported || m_bindless_materials.empty()) return;
+
+    std::shared_ptr<RenderPerFrame>& per_frame = m_per_frame[image_index];
+    for(size_t material_index = 0u; material_index < m_bindless_materials.size(); ++material_index) {
+        const std::shared_ptr<Material>& material = m_bindless_materials[material_index];
+        m_material_table[material_index].fresnelR0_roughness = material->GetReflectance();
+        m_material_table[material_index].fresnelR0_roughness.a = material->GetRoughnessFactor();
+    }
+    per_frame->material_buffer->update(m_material_table.data(), sizeof(BindlessMaterial) * m_material_table.size());
+
+    const std::shared_ptr<CameraComponent>& camera_component = Application::Get().GetGameLogic()->GetHumanView()->VGetCamera();
+    if(!camera_component) return;
+    const std::shared_ptr<BasicCameraNode>& camera_node = camera_component->VGetCameraNode();
+
+    FrameUniformBufferObject frame_ubo{};
+    frame_ubo.view = camera_node->GetView();
+    frame_ubo.proj = camera_node->GetProjection();
+    frame_ubo.inv_view = camera_node->GetInvView();
+    frame_ubo.tables = glm::uvec4(per_frame->material_buffer_slot, 0u, 0u, 0u);
+    per_frame->frame_buffer->update(&frame_ubo, sizeof(FrameUniformBufferObject));
+}
+
+// Streamed textures swap their contents as their mips become resident. Visible ones are marked as used, and after
+// a residency change the descriptors still holding old views are written again: the node sets of this frame, whose
+// command buffer has retired, and the bindless slots. Those get a fresh slot, frames in flight may read the old one.
+void SceneDrawable::refreshStreamedTextures(uint32_t image_index) {
+    const std::shared_ptr<VulkanTextureStreamer>& texture_streamer = Application::GetRenderer().getTextureStreamer();
+    if(!texture_streamer) return;
+
+    std::shared_ptr<RenderPerFrame>& per_frame = m_per_frame[image_index];
+    for(uint32_t render_id : per_frame->visible_renderables) {
+        const std::shared_ptr<Renderable>& renderable = per_frame->renderables[render_id];
+        if(renderable->texture) {
+            texture_streamer->touch(renderable->texture.get());
+        }
+    }
+
+    const uint64_t residency_version = texture_streamer->getResidencyVersion();
+    if(per_frame->texture_residency_version != residency_version) {
+        per_frame->texture_residency_version = residency_version;
+        for(const std::shared_ptr<Renderable>& renderable : per_frame->renderables) {
+            if(renderable->bindless || !renderable->texture) continue;
+
+            VkImageView texture_view = renderable->texture->getImageBufferView();
+            if(renderable->texture_view == texture_view) continue;
+            renderable->texture_view = texture_view;
+            renderable->render_node->updateDescriptors();
+        }
+    }
+
+    if(!m_bindless_supported || m_bindless_residency_version == residency_version) return;
+    m_bindless_residency_version = residency_version;
+
+    // Materials may share a texture, every stale slot is released before the first new one is registered.
+    const std::shared_ptr<VulkanResourcesManager>& resources_manager = Application::GetRenderer().getResourcesManager();
+    std::vector<size_t> stale_materials;
+    for(size_t material_index = 0u; material_index < m_bindless_materials.size(); ++material_index) {
+        const std::shared_ptr<VulkanImageBuffer> texture = m_bindless_materials[material_index]->GetTexture();
+        if(m_material_views[material_index] == texture->getImageBufferView()) continue;
+
+        resources_manager->releaseBindlessImage(texture);
+        stale_materials.push_back(material_index);
+    }
+    for(size_t material_index : stale_materials) {
+        const std::shared_ptr<VulkanImageBuffer> texture = m_bindless_materials[material_index]->GetTexture();
+        m_material_table[material_index].textures.x = resources_manager->registerBindlessImage(texture);
+        m_material_views[material_index] = texture->getImageBufferView();
+    }
+}
+
+uint32_t SceneDrawable::acquireMaterialIndex(const std::shared_ptr<Material>& material) {
+    auto it = m_material_indices.find(material.get());
+    if(it != m_material_indices.end()) {
+        return it->second;
+    }
+
+    BindlessMaterial entry{};
+    entry.textures.x = Application::GetRenderer().getResourcesManager()->registerBindlessImage(material->GetTexture());
+
+    const uint32_t material_index = static_cast<uint32_t>(m_bindless_materials.size());
+    m_bindless_materials.push_back(material);
+    m_material_table.push_back(entry);
+    m_material_views.push_back(material->GetTexture()->getImageBufferView());
+    m_material_indices.insert({material.get(), material_index});
+
+    return material_index;
+}
+
 int SceneDrawable::order() {
     return 0;
 }
@@ -115,14 +349,48 @@ void SceneDrawable::addRendeNode(std::shared_ptr<MeshNode> model) {
             std::shared_ptr<Renderable> renderable = std::make_shared<Renderable>();
             per_frame_data->renderables.push_back(renderable);
             renderable->mesh_node = model;
+            renderable->material = material;
+            renderable->local_aabb = model_data->GetAABB();
+            renderable->cullable = model->GetSkinName().empty();
             
             renderable->texture = material->GetTexture();
+            if(renderable->texture) {
+                renderable->texture_view = renderable->texture->getImageBufferView();
+            }
 
             renderable->vertex_buffer = model_data->GetVertexBuffer();
             renderable->index_buffer = model_data->GetIndexBuffer();
 
+            // Static meshes use the instanced variant of their material render when there is one and the frame's
+            // instance buffer has room left. The bindless variant is preferred, its config only exists on devices
+            // with descriptor indexing, otherwise they fall back to the instanced or regular one.
             std::string render_name = makeRenderNodeName(material);
-            if(!Application::GetRenderer().getFrameData(frame)->render_graph->hasGraphicsRenderNodeConfig(render_name)) {
+            const std::string bindless_render_name = makeRenderName(material->GetName(), "_bindless_render"s);
+            const std::string instanced_render_name = makeRenderName(material->GetName(), "_instanced_render"s);
+            const bool can_instance =
+                m_instancing_supported &&
+                renderable->cullable &&
+                renderable->index_buffer &&
+                per_frame_data->instanced_count < MAX_INSTANCES;
+            renderable->bindless =
+                can_instance &&
+                m_bindless_supported &&
+                renderable->texture &&
+                (m_material_indices.contains(material.get()) || m_bindless_materials.size() < MAX_MATERIALS) &&
+                Application::GetRenderer().getFrameData(frame)->render_graph->hasGraphicsRenderNodeConfig(bindless_render_name);
+            renderable->instanced =
+                renderable->bindless ||
+                (can_instance && Application::GetRenderer().getFrameData(frame)->render_graph->hasGraphicsRenderNodeConfig(instanced_render_name));
+            if(renderable->bindless) {
+                render_name = bindless_render_name;
+                renderable->material_index = acquireMaterialIndex(material);
+                ++per_frame_data->instanced_count;
+            }
+            else if(renderable->instanced) {
+                render_name = instanced_render_name;
+                ++per_frame_data->instanced_count;
+            }
+            else if(!Application::GetRenderer().getFrameData(frame)->render_graph->hasGraphicsRenderNodeConfig(render_name)) {
                 render_name = "mesh_render"s;
             }
 
@@ -132,6 +400,10 @@ void SceneDrawable::addRendeNode(std::shared_ptr<MeshNode> model) {
             const std::shared_ptr<GraphicsRenderNodeConfig>& render_node_cfg = renderable->render_node->getGraphicsRenderNodeConfig();
 
             std::shared_ptr<VulkanShader> vertex_shader = renderable->render_node->getPipeline()->getShader(VK_SHADER_STAGE_VERTEX_BIT);
+            if(renderable->index_buffer) {
+                renderable->render_node->setIndexType(model_data->GetIndexType());
+                renderable->index_count = static_cast<uint32_t>(model_data->GetIndexCount());
+            }
             if(vertex_shader && vertex_shader->getShaderSignature()->getPushConstants()) {
                 renderable->const_params.push_back(vertex_shader->getShaderSignature()->getPushConstants());
             }
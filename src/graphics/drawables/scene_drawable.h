@@ -16,8 +16,10 @@
 
 #include "../../scene/nodes/mesh_node.h"
 #include "../../scene/light_manager.h"
+#include "../../physics/frustum_culler.h"
 #include "../api/vulkan_device.h"
 #include "../drawables/vulkan_drawable.h"
+#include "../drawables/draw_batcher.h"
 #include "../pod/render_resource.h"
 #include "../api/vulkan_pipeline.h"
 #include "../api/vulkan_shader.h"
@@ -47,15 +49,37 @@ public:
         std::shared_ptr<VulkanBuffer> vertex_buffer;
         std::shared_ptr<VulkanBuffer> index_buffer;
         std::shared_ptr<VulkanImageBuffer> texture;
+        VkImageView texture_view = VK_NULL_HANDLE; // The render node's descriptors were written with it
         std::vector<std::shared_ptr<VulkanPushConstant>> const_params;
         std::shared_ptr<GraphicsRenderNode> render_node;
+        std::shared_ptr<Material> material;
+        BoundingBox local_aabb;
+        uint32_t index_count = 0u;
+        bool cullable = true;
+        bool instanced = false;
+        bool bindless = false; // Instanced through the bindless table, implies instanced
+        uint32_t material_index = 0u; // Bindless material table entry
     };
 
     struct RenderPerFrame {
         std::vector<std::shared_ptr<Renderable>> renderables;
         std::shared_ptr<VulkanBuffer> light_buffer;
+        std::vector<uint32_t> visible_renderables;
+        std::shared_ptr<VulkanBuffer> instance_buffer;
+        std::shared_ptr<VulkanBuffer> indirect_buffer;
+        uint32_t instanced_count = 0u;
+        std::shared_ptr<VulkanBuffer> frame_buffer;
+        std::shared_ptr<VulkanBuffer> material_buffer;
+        uint32_t material_buffer_slot = 0u; // Bindless buffer slot of material_buffer
+        uint64_t texture_residency_version = 0u; // Of the texture streamer, when texture views were last checked
     };
 
+    // Capacity of the per frame instance and indirect buffers, see instance_storage_resource and
+    // indirect_draw_resource. Renderables past it fall back to the regular per node draw.
+    static constexpr uint32_t MAX_INSTANCES = 4096u;
+    // Capacity of the bindless material table, see material_storage_resource.
+    static constexpr uint32_t MAX_MATERIALS = 1024u;
+
     bool init(std::shared_ptr<VulkanDevice> device, int max_frames, std::shared_ptr<LightManager> light_manager);
 
     void reset() override;
@@ -67,6 +91,17 @@ public:
     void addRendeNode(std::shared_ptr<MeshNode> model);
 
 private:
+    // Matches Material in basic_phong_bindless.frag (std430).
+    struct BindlessMaterial {
+        glm::vec4 fresnelR0_roughness;
+        glm::uvec4 textures; // x: bindless image slot of the diffuse texture
+    };
+
+    void cullRenderables(uint32_t image_index);
+    void batchRenderables(uint32_t image_index);
+    void updateBindlessTables(uint32_t image_index);
+    void refreshStreamedTextures(uint32_t image_index);
+    uint32_t acquireMaterialIndex(const std::shared_ptr<Material>& material);
     void updatePushConstants(int frame, RenderableId render_id);
     void updateMVPMatrices(const std::shared_ptr<SceneNode>& scene_node, std::shared_ptr<VulkanBuffer>& uniform_buffer);
     void updateInvMVPMatrices(const std::shared_ptr<SceneNode>& scene_node, std::shared_ptr<VulkanBuffer>& uniform_buffer);
@@ -81,4 +116,19 @@ private:
     std::shared_ptr<LightManager> m_light_manager;
 
     std::vector<std::shared_ptr<RenderPerFrame>> m_per_frame;
+
+    FrustumCuller m_culler;
+    std::vector<uint32_t> m_cull_slots;
+    std::vector<uint32_t> m_tree_visible;
+    std::vector<uint8_t> m_node_visible;
+
+    bool m_instancing_supported = false;
+    DrawBatcher m_batcher;
+
+    bool m_bindless_supported = false;
+    std::vector<std::shared_ptr<Material>> m_bindless_materials;
+    std::vector<BindlessMaterial> m_material_table; // Parallel to m_bindless_materials
+    std::vector<VkImageView> m_material_views; // Parallel to m_bindless_materials, view in the bindless slot
+    uint64_t m_bindless_residency_version = 0u;
+    std::unordered_map<const Material*, uint32_t> m_material_indices;
 };
\ No newline at end of file
@@ -51,6 +51,21 @@ const std::vector<std::shared_ptr<GraphicsRenderNode>>& DependencyLevel::getGrap
     return m_pipeline_node_map.at(pipeline_name);
 }
 
+const std::vector<DependencyLevel::ResourceAccess>& DependencyLevel::getResourceAccesses() const {
+    return m_resource_accesses;
+}
+
+void DependencyLevel::addResourceAccess(std::shared_ptr<RenderResource> resource, const VulkanLayoutTracker::Access& access, bool attachment) {
+    for(ResourceAccess& resource_access : m_resource_accesses) {
+        if(resource_access.resource != resource || resource_access.attachment != attachment || resource_access.access.layout != access.layout) continue;
+
+        resource_access.access.stage |= access.stage;
+        resource_access.access.access |= access.access;
+        return;
+    }
+    m_resource_accesses.push_back(ResourceAccess{std::move(resource), access, attachment});
+}
+
 int DependencyLevel::getLevel() const {
     return m_level;
 }
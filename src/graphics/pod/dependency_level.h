@@ -9,7 +9,10 @@
 #include <unordered_set>
 #include <vector>
 
+#include "../api/vulkan_layout_tracker.h"
+
 class RenderNode;
+class RenderResource;
 class GraphicsRenderNode;
 class VulkanFramebuffer;
 class VulkanPipeline;
@@ -20,6 +23,14 @@ public:
     using PipelineName = std::string;
     using RenderPassName = std::string;
 
+    // Access of a resource shared by the level's nodes. Attachment accesses name the render pass initial layout,
+    // the render pass itself synchronizes them once the image is in that layout.
+    struct ResourceAccess {
+        std::shared_ptr<RenderResource> resource;
+        VulkanLayoutTracker::Access access;
+        bool attachment = false;
+    };
+
     DependencyLevel(int level);
 
     const std::vector<std::shared_ptr<RenderNode>>& getNodes() const;
@@ -36,6 +47,9 @@ public:
     const std::unordered_map<PipelineName, std::vector<std::shared_ptr<GraphicsRenderNode>>>& getPipelineNodeMap() const;
     const std::vector<std::shared_ptr<GraphicsRenderNode>>& getGraphicsNodes(const PipelineName& pipeline_name) const;
 
+    const std::vector<ResourceAccess>& getResourceAccesses() const;
+    void addResourceAccess(std::shared_ptr<RenderResource> resource, const VulkanLayoutTracker::Access& access, bool attachment);
+
     int getLevel() const;
     void addNode(std::shared_ptr<RenderNode> node);
 
@@ -49,5 +63,6 @@ private:
     std::unordered_map<FramebufferName, std::vector<RenderPassName>> m_framebuffer_to_renderpass_map;
     std::unordered_map<RenderPassName, std::unordered_set<std::shared_ptr<VulkanPipeline>>> m_renderpass_to_pipeline_map;
     std::unordered_map<PipelineName, std::vector<std::shared_ptr<GraphicsRenderNode>>> m_pipeline_node_map;
+    std::vector<ResourceAccess> m_resource_accesses;
     int m_level;
 };
\ No newline at end of file
@@ -41,6 +41,18 @@ bool DescSetLayout::init(std::shared_ptr<VulkanDevice> device, const pugi::xml_n
             layout_binding.pImmutableSamplers = m_immutable_samplers_ptr.data();
         }
         
+        VkDescriptorBindingFlags binding_flags = 0u;
+        pugi::xml_node binding_flags_node = layout_binding_node.child("BindingFlags");
+        for (pugi::xml_node binding_flag = binding_flags_node.first_child(); binding_flag; binding_flag = binding_flag.next_sibling()) {
+            binding_flags |= getDescriptorBindingFlag(binding_flag.text().as_string());
+        }
+        if(binding_flags && m_binding_flags.empty()) {
+            m_binding_flags.resize(m_bindings.size(), 0u);
+        }
+        if(!m_binding_flags.empty()) {
+            m_binding_flags.push_back(binding_flags);
+        }
+
         m_binding_num_to_idx_map[layout_binding.binding] = m_bindings.size();
         m_bindings.push_back(layout_binding);
         m_binding_name_map[layout_binding_name] = layout_binding.binding;
@@ -57,11 +69,21 @@ bool DescSetLayout::init(std::shared_ptr<VulkanDevice> device, const pugi::xml_n
     
     m_desc_layout_info.bindingCount = static_cast<uint32_t>(m_bindings.size());
     m_desc_layout_info.pBindings = m_bindings.data();
+
+    // Update after bind and partially bound arrays, only chained when some binding asks for them.
+    VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info{};
+    if(!m_binding_flags.empty()) {
+        binding_flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        binding_flags_info.bindingCount = static_cast<uint32_t>(m_binding_flags.size());
+        binding_flags_info.pBindingFlags = m_binding_flags.data();
+        m_desc_layout_info.pNext = &binding_flags_info;
+    }
     
     VkResult result = vkCreateDescriptorSetLayout(m_device->getDevice(), &m_desc_layout_info, nullptr, &m_desc_layout);
     if(result != VK_SUCCESS) {
         throw std::runtime_error("failed to create descriptor set layout!");
     }
+    m_desc_layout_info.pNext = nullptr;
 
 #ifndef NDEBUG
     std::string descset_layout_name = "descset_layout_"s + m_name;
@@ -163,6 +185,13 @@ const std::vector<VkSampler>& DescSetLayout::getImmutableSamplersPtr() const {
     return m_immutable_samplers_ptr;
 }
 
+VkDescriptorBindingFlags DescSetLayout::getBindingFlags(DescSetLayout::BindingNum binding_num) const {
+    if(m_binding_flags.empty() || !m_binding_num_to_idx_map.contains(binding_num)) {
+        return 0u;
+    }
+    return m_binding_flags.at(m_binding_num_to_idx_map.at(binding_num));
+}
+
 VkDescriptorSetLayoutCreateInfo DescSetLayout::getDescriptorSetLayoutInfo() const {
     return m_desc_layout_info;
 }
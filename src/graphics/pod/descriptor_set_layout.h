@@ -43,6 +43,7 @@ public:
     const std::unordered_map<std::string, BindingNum>& getBindingMap() const;
     const std::vector<std::shared_ptr<VulkanSampler>>& getImmutableSamplers() const;
     const std::vector<VkSampler>& getImmutableSamplersPtr() const;
+    VkDescriptorBindingFlags getBindingFlags(BindingNum binding_num) const;
     VkDescriptorSetLayoutCreateInfo getDescriptorSetLayoutInfo() const;
     VkDescriptorSetLayout getDescriptorSetLayout() const;
 
@@ -60,6 +61,7 @@ private:
     
     std::vector<std::shared_ptr<VulkanSampler>> m_immutable_samplers;
     std::vector<VkSampler> m_immutable_samplers_ptr;
+    std::vector<VkDescriptorBindingFlags> m_binding_flags; // Parallel to m_bindings, empty when no binding has flags
     VkDescriptorSetLayoutCreateInfo m_desc_layout_info;
     VkDescriptorSetLayout m_desc_layout;
 };
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "image_buffer_config.h"
 #include "format_config.h"
 #include "render_pass_config.h"
+#include "vertex_format.h"
 #include "../../application.h"
 #include "../vulkan_renderer.h"
 #include "../api/vulkan_pipelines_manager.h"
@@ -34,6 +35,14 @@ void GraphicsRenderNode::destroy() {
 void GraphicsRenderNode::render(CommandBatch& command_buffer, unsigned image_index) {
     if(getExecutionBypass()) return;
 
+    prepare(command_buffer, image_index);
+    m_pipeline->build_push_constants();
+    record(command_buffer.getCommandBufer());
+}
+
+void GraphicsRenderNode::prepare(CommandBatch& command_buffer, unsigned image_index) {
+    if(getExecutionBypass()) return;
+
     for(const auto&[desc_layout_binding_name, metadata] : m_node_config->getBindingsMetadata()) {
         if(metadata->creation_point == GraphicsRenderNodeConfig::CreationPoint::EXTERNAL) continue;
         
@@ -41,23 +50,22 @@ void GraphicsRenderNode::render(CommandBatch& command_buffer, unsigned image_ind
         std::shared_ptr<VulkanBuffer> uniform_buffer = getAttachedBufferResource(desc_layout_binding_name);
         getUpdateFunction(update_fn_name)(uniform_buffer);
     }
-    
-    TransitionResourcesToProperState(command_buffer);
+}
 
-    vkCmdBindPipeline(command_buffer.getCommandBufer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline->getPipeline());
+void GraphicsRenderNode::record(VkCommandBuffer command_buffer) const {
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline->getPipeline());
 
-    m_pipeline->build_push_constants();
-    m_pipeline->attach_push_constants(command_buffer.getCommandBufer());
+    m_pipeline->attach_push_constants(command_buffer);
 
     VkViewport view_port = m_node_config->getViewport();
     VkRect2D scissor = m_node_config->getScissor();
         
-    vkCmdSetViewport(command_buffer.getCommandBufer(), 0u, 1u, &view_port);
-    vkCmdSetScissor(command_buffer.getCommandBufer(), 0u, 1u, &scissor);
+    vkCmdSetViewport(command_buffer, 0u, 1u, &view_port);
+    vkCmdSetScissor(command_buffer, 0u, 1u, &scissor);
         
     for(const auto&[slot, desc] : getDescriptors()) {
         vkCmdBindDescriptorSets(
-            command_buffer.getCommandBufer(), // commandBuffer
+            command_buffer, // commandBuffer
             VK_PIPELINE_BIND_POINT_GRAPHICS, // pipelineBindPoint
             m_pipeline->getPipelineLayout(), // pipeline layout
             slot, // first set
@@ -73,7 +81,7 @@ void GraphicsRenderNode::render(CommandBatch& command_buffer, unsigned image_ind
         std::shared_ptr<VulkanBuffer> vertex_buffer = getReadAttachedBufferResource(vertex_buffer_name);
         VkDeviceSize offsets[] = {0};
         vkCmdBindVertexBuffers(
-            command_buffer.getCommandBufer(), // commandBuffer
+            command_buffer, // commandBuffer
             vf.getBindingNum(), // firstBinding
             1, // bindingCount
             vertex_buffer->getBufferPtr(), // buffers pointer
@@ -82,17 +90,27 @@ void GraphicsRenderNode::render(CommandBatch& command_buffer, unsigned image_ind
     }
     const std::string& index_buffer_name = m_pipeline->getShader(VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT)->getShaderSignature()->getVertexFormat().getIndexBufferBindingName();
     std::shared_ptr<VulkanBuffer> index_buffer = getReadAttachedBufferResource(index_buffer_name);
+    const VkIndexType index_type = getIndexType();
     vkCmdBindIndexBuffer(
-        command_buffer.getCommandBufer(), // commandBuffer
+        command_buffer, // commandBuffer
         index_buffer->getBuffer(), // buffer
         0u, // offset
-        m_pipeline->getShader(VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT)->getShaderSignature()->getVertexFormat().getIndexType() // indexType
+        index_type // indexType
     );
         
-    if(m_node_config->getIndexCountType() == GraphicsRenderNodeConfig::IndexCountType::ALL) {
-        uint32_t index_count = index_buffer->getNotAlignedSize() / m_pipeline->getShader(VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT)->getShaderSignature()->getVertexFormat().getIndexTypeBytesCount();
+    if(m_indirect_buffer) {
+        vkCmdDrawIndexedIndirect(
+            command_buffer, // commandBuffer
+            m_indirect_buffer->getBuffer(), // buffer
+            m_indirect_offset, // offset
+            m_indirect_draw_count, // drawCount
+            sizeof(VkDrawIndexedIndirectCommand) // stride
+        );
+    }
+    else if(m_node_config->getIndexCountType() == GraphicsRenderNodeConfig::IndexCountType::ALL) {
+        uint32_t index_count = index_buffer->getNotAlignedSize() / VertexFormat::getIndexTypeBytesCount(index_type);
         vkCmdDrawIndexed(
-            command_buffer.getCommandBufer(), // commandBuffer
+            command_buffer, // commandBuffer
             index_count, // indexCount
             1u, // instanceCount
             0u, // firstIndex
@@ -103,7 +121,7 @@ void GraphicsRenderNode::render(CommandBatch& command_buffer, unsigned image_ind
     else {
         uint32_t index_count = m_node_config->getIndexCount();
         vkCmdDrawIndexed(
-            command_buffer.getCommandBufer(), // commandBuffer
+            command_buffer, // commandBuffer
             index_count, // indexCount
             1u, // instanceCount
             m_node_config->getFirstIndex(), // firstIndex
@@ -114,8 +132,6 @@ void GraphicsRenderNode::render(CommandBatch& command_buffer, unsigned image_ind
 }
 
 void GraphicsRenderNode::finishRenderNode() {
-    VulkanRenderer& renderer = Application::GetRenderer();
-
     VkExtent2D extent = getWrittenAttachedImageResource(m_node_config->getAttachmentsConfig().front()->attachment_name)->getImageConfig()->getFormat()->getExtent2D();
     if(m_node_config->getViewportSource() == GraphicsRenderNodeConfig::ExtentSource::AUTO) {
         VkViewport viewport = m_node_config->getViewport();
@@ -137,27 +153,45 @@ void GraphicsRenderNode::finishRenderNode() {
     };
     m_frame_buffer->init(m_device, m_node_config->getFramebufferConfig(), render_pass_ptr, map_fn);
 
+    updateDescriptors();
+}
+
+void GraphicsRenderNode::updateDescriptors() {
+    VulkanRenderer& renderer = Application::GetRenderer();
+
+    VulkanDescriptorCache::Bindings desc_bindings;
     for (const auto&[slot, desc_set_layout] : m_pipeline->getDescLayouts()) {
-        setDescriptor(slot, renderer.getDescriptorsManager()->allocateDescriptorSet(desc_set_layout->getName()));
+        // The bindless table is global, its contents are not described by the node config.
+        if(desc_set_layout->getName() == VulkanResourcesManager::BINDLESS_DESC_SET_NAME) {
+            setDescriptor(slot, renderer.getResourcesManager()->getBindlessDescriptor());
+            continue;
+        }
+
+        desc_bindings.clear();
         for(const VkDescriptorSetLayoutBinding& binding : desc_set_layout->getBindings()) {
             const std::string& binding_name = desc_set_layout->getBindingName(binding.binding);
             const std::shared_ptr<GraphicsRenderNodeConfig::UpdateMetadata>& binding_metadata = m_node_config->getUpdateMetadata(binding_name);
+
+            VulkanDescriptorCache::Binding desc_binding;
+            desc_binding.binding = binding.binding;
+            desc_binding.type = binding.descriptorType;
             if(binding_metadata->resource_type == RenderResource::Type::IMAGE) {
                 std::shared_ptr<VulkanImageBuffer> image_to_bind = getReadAttachedImageResource(binding_name);
-                getDescriptor(slot)->updateDescImageInfo(
-                    binding.binding,
-                    image_to_bind->getImageConfig()->getSampler()->getSampler(),
-                    image_to_bind->getImageBufferView(binding_metadata->image_view_type_name),
-                    binding_metadata->read_image_layout
-                );
+                desc_binding.sampler = image_to_bind->getImageConfig()->getSampler()->getSampler();
+                desc_binding.image_view = image_to_bind->getImageBufferView(binding_metadata->image_view_type_name);
+                desc_binding.image_layout = binding_metadata->read_image_layout;
             }
             else if(binding_metadata->resource_type == RenderResource::Type::BUFFER) {
-                std::shared_ptr<VulkanBuffer> buffer_to_bind = getReadAttachedBufferResource(binding_name);
-                getDescriptor(slot)->updateDescBuffer(binding.binding, buffer_to_bind->getBuffer());
+                desc_binding.buffer = getReadAttachedBufferResource(binding_name)->getBuffer();
+            }
+            else {
+                continue;
             }
+            desc_bindings.push_back(desc_binding);
         }
+
+        setDescriptor(slot, renderer.getDescriptorsManager()->acquireDescriptorSet(desc_set_layout->getName(), desc_bindings));
     }
-    
 }
 
 const std::shared_ptr<VulkanPipeline>& GraphicsRenderNode::getPipeline() {
@@ -176,42 +210,28 @@ std::shared_ptr<GraphicsRenderNodeConfig>& GraphicsRenderNode::getGraphicsRender
     return m_node_config;
 }
 
-void GraphicsRenderNode::TransitionResourcesToProperState(CommandBatch& command_buffer) {
-    std::shared_ptr<RenderGraph> render_graph = m_render_graph.lock();
-    const std::shared_ptr<VulkanRenderPass>& render_pass_ptr = m_pipeline->getRenderPass();
+void GraphicsRenderNode::setIndirectDraw(std::shared_ptr<VulkanBuffer> indirect_buffer, VkDeviceSize offset, uint32_t draw_count) {
+    m_indirect_buffer = std::move(indirect_buffer);
+    m_indirect_offset = offset;
+    m_indirect_draw_count = draw_count;
+}
 
-    for(const auto&[gloabal_name, att_slot] : getWrittenResourcesMap()){
-        RenderResource::Type att_slot_res_type = att_slot.resource->getType();
-        if(att_slot_res_type == RenderResource::Type::BUFFER) continue;
-
-        bool resource_only_init = render_graph->isWrittenInGraph(gloabal_name);
-        if(resource_only_init) {
-            std::shared_ptr<VulkanImageBuffer> attached_write_resource = getAttachedImageResource(att_slot.attached_as);
-            VkImageLayout current_image_layout = attached_write_resource->getImageConfig()->getAfterInitLayout();
-            
-            const VkAttachmentDescription& attach_desc = m_pipeline->getRenderPass()->getRenderPassConfig()->getAttachmentDescription(att_slot.attached_as);
-            VkImageLayout write_image_layout = attach_desc.initialLayout;
-            if(current_image_layout != write_image_layout) {
-                attached_write_resource->changeLayout(current_image_layout, write_image_layout);
-                attached_write_resource->getImageConfig()->setAfterInitLayout(write_image_layout);
-            }
-            continue;
-        }
+void GraphicsRenderNode::resetIndirectDraw() {
+    m_indirect_buffer.reset();
+    m_indirect_offset = 0u;
+    m_indirect_draw_count = 0u;
+}
 
-        // size_t my_pos = render_graph->getTopologicalIdentity(shared_from_this());
-        // size_t last_written_by_node_id = render_graph->getLastWrittenIdentity(shared_from_this(), gloabal_name);
-        // size_t last_read_by_node_id = render_graph->getLastReadIdentity(shared_from_this(), gloabal_name);
-
-        // if(last_read_by_node_id == RenderGraph::NO_ID && last_written_by_node_id == RenderGraph::NO_ID) {
-        //     std::shared_ptr<VulkanImageBuffer> attached_write_resource = getAttachedImageResource(att_slot.attached_as);
-        //     VkImageLayout current_image_layout = attached_write_resource->getImageConfig()->getAfterInitLayout();
-            
-        //     const VkAttachmentDescription& attach_desc = m_pipeline->getRenderPass()->getRenderPassConfig()->getAttachmentDescription(att_slot.attached_as);
-        //     VkImageLayout write_image_layout = attach_desc.initialLayout;
-        //     if(current_image_layout != write_image_layout) {
-        //         attached_write_resource->changeLayout(current_image_layout, write_image_layout);
-        //         attached_write_resource->getImageConfig()->setAfterInitLayout(write_image_layout);
-        //     }
-        // }
-    }
+void GraphicsRenderNode::setIndexType(VkIndexType index_type) {
+    m_index_type = index_type;
+}
+
+VkIndexType GraphicsRenderNode::getIndexType() const {
+    if(m_index_type) return *m_index_type;
+
+    return m_pipeline->getShader(VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT)->getShaderSignature()->getVertexFormat().getIndexType();
+}
+
+void GraphicsRenderNode::TransitionResourcesToProperState(CommandBatch& command_buffer) {
+    // Layouts and hazards of graph resources are resolved per dependency level by the renderer's VulkanLayoutTracker.
 }
\ No newline at end of file
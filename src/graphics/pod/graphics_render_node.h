@@ -3,6 +3,7 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -13,6 +14,7 @@
 #include "render_node.h"
 
 class VulkanFramebuffer;
+class VulkanBuffer;
 
 class GraphicsRenderNode : public RenderNode {
 public:
@@ -20,7 +22,15 @@ public:
     virtual void destroy() override;
 
     virtual void render(CommandBatch& command_buffer, unsigned image_index) override;
+    // render() split in two for parallel recording: prepare() runs the update functions and must stay on the
+    // recording thread, record() only writes into command_buffer and may run on any worker.
+    // The pipeline push constants have to be built before record(), once per pipeline.
+    void prepare(CommandBatch& command_buffer, unsigned image_index);
+    void record(VkCommandBuffer command_buffer) const;
     virtual void finishRenderNode() override;
+    // Acquires the descriptor sets again from what is attached now, e.g. after a streamed texture swapped its views.
+    // Only for nodes whose frame has retired, sets of frames in flight stay alive in the descriptor cache.
+    void updateDescriptors();
 
     const std::shared_ptr<VulkanPipeline>& getPipeline();
     VkFramebuffer getVkFramebuffer() const;
@@ -28,6 +38,15 @@ public:
 
     std::shared_ptr<GraphicsRenderNodeConfig>& getGraphicsRenderNodeConfig();
 
+    // Replaces the config driven vkCmdDrawIndexed with draw_count VkDrawIndexedIndirectCommand records read from
+    // indirect_buffer at offset, used by batched instanced drawing.
+    void setIndirectDraw(std::shared_ptr<VulkanBuffer> indirect_buffer, VkDeviceSize offset, uint32_t draw_count);
+    void resetIndirectDraw();
+    // Index type of the attached index buffer when it is not the one of the vertex shader's vertex format, e.g. for
+    // meshes loaded with 16 or 8 bit indices.
+    void setIndexType(VkIndexType index_type);
+    VkIndexType getIndexType() const;
+
     virtual void TransitionResourcesToProperState(CommandBatch& command_buffer) override;
 
 private:
@@ -35,4 +54,10 @@ private:
 
     std::shared_ptr<GraphicsRenderNodeConfig> m_node_config;
     std::shared_ptr<VulkanFramebuffer> m_frame_buffer;
+
+    std::shared_ptr<VulkanBuffer> m_indirect_buffer;
+    VkDeviceSize m_indirect_offset = 0u;
+    uint32_t m_indirect_draw_count = 0u;
+
+    std::optional<VkIndexType> m_index_type;
 };
\ No newline at end of file
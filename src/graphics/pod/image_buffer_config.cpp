@@ -154,6 +154,25 @@ const std::shared_ptr<FormatConfig>& ImageBufferConfig::getFormat() const {
     return m_format;
 }
 
+void ImageBufferConfig::setVkFormat(VkFormat format) {
+    m_image_info.format = format;
+    m_format->setVkFormat(format);
+    for(const auto&[view_type_name, view_cfg_ptr] : m_image_view_info_map) {
+        view_cfg_ptr->format->setVkFormat(format);
+        view_cfg_ptr->image_view_info.format = format;
+    }
+}
+
+void ImageBufferConfig::setMipLevels(uint32_t mip_levels) {
+    m_image_info.mipLevels = mip_levels;
+    m_format->setMipLevels(mip_levels);
+    for(const auto&[view_type_name, view_cfg_ptr] : m_image_view_info_map) {
+        view_cfg_ptr->format->setMipLevels(mip_levels);
+        view_cfg_ptr->image_view_info.subresourceRange.baseMipLevel = 0u;
+        view_cfg_ptr->image_view_info.subresourceRange.levelCount = mip_levels;
+    }
+}
+
 const std::unordered_map<std::string, std::shared_ptr<ImageBufferViewConfig>>& ImageBufferConfig::getViewInfoMap() const {
     return m_image_view_info_map;
 }
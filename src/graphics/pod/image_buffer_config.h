@@ -33,6 +33,8 @@ public:
     void setSampler(std::shared_ptr<VulkanSampler> sampler);
     const std::shared_ptr<VulkanSampler>& getSampler() const;
     const std::shared_ptr<FormatConfig>& getFormat() const;
+    void setVkFormat(VkFormat format); // Image and views, for instances of pre-encoded textures
+    void setMipLevels(uint32_t mip_levels); // Image and views, all views then start from level 0
     const std::unordered_map<std::string, std::shared_ptr<ImageBufferViewConfig>>& getViewInfoMap() const;
     VkMemoryPropertyFlags getMemoryProperties() const;
     void setMemoryProperties(VkMemoryPropertyFlags props);
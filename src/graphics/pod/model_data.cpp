@@ -5,7 +5,7 @@
 
 #include "../api/vulkan_buffer.h"
 
-ModelData::ModelData() : m_primitive_topology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST) {}
+ModelData::ModelData() : m_index_type(VK_INDEX_TYPE_UINT32), m_primitive_topology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST) {}
 
 const std::shared_ptr<VulkanBuffer>& ModelData::GetVertexBuffer() const {
     return m_vertex_buffer;
@@ -31,10 +31,18 @@ const std::shared_ptr<VulkanBuffer>& ModelData::GetIndexBuffer() const {
     return m_index_buffer;
 }
 
+void ModelData::SetIndexType(VkIndexType index_type) {
+    m_index_type = index_type;
+}
+
+VkIndexType ModelData::GetIndexType() const {
+    return m_index_type;
+}
+
 size_t ModelData::GetIndexCount() const {
     size_t index_count = 0u;
     if (m_index_buffer) {
-        index_count = m_index_buffer->getNotAlignedSize() / m_vertex_format.getIndexTypeBytesCount();;
+        index_count = m_index_buffer->getNotAlignedSize() / VertexFormat::getIndexTypeBytesCount(m_index_type);
     }
 
     return index_count;
@@ -66,6 +74,10 @@ const BoundingBox& ModelData::GetAABB() const {
     return m_AABB;
 }
 
+void ModelData::SetSphere(const BoundingSphere& sphere) {
+    m_sphere = sphere;
+}
+
 const BoundingSphere& ModelData::GetSphere() const {
     return m_sphere;
 }
@@ -84,4 +96,5 @@ const VertexFormat& ModelData::GetVertexFormat() {
 
 void ModelData::SetVertexFormat(const VertexFormat& format) {
     m_vertex_format = format;
+    m_index_type = format.getIndexType();
 }
\ No newline at end of file
@@ -39,6 +39,10 @@ public:
 	void SetIndexBuffer(std::shared_ptr<VulkanBuffer> index_buffer);
 	const std::shared_ptr<VulkanBuffer>& GetIndexBuffer() const;
 
+	// Defaults to the index type of the vertex format, loaders narrow it to what the vertex count allows.
+	void SetIndexType(VkIndexType index_type);
+	VkIndexType GetIndexType() const;
+
 	size_t GetIndexCount() const;
 	size_t GetVertexCount() const;
 
@@ -47,7 +51,7 @@ public:
 
 	void SetAABB(const BoundingBox& aabb);
 	const BoundingBox& GetAABB() const;
-    void SetSphere(const BoundingSphere& sphere) const;
+	void SetSphere(const BoundingSphere& sphere);
 	const BoundingSphere& GetSphere() const;
 
 	const std::string& GetName() const;
@@ -60,6 +64,7 @@ private:
 	std::shared_ptr<VulkanBuffer> m_vertex_buffer;
 	std::shared_ptr<VulkanBuffer> m_index_buffer;
 	VertexFormat m_vertex_format;
+	VkIndexType m_index_type;
 	std::shared_ptr<Material> m_material;
 
 	VkPrimitiveTopology m_primitive_topology;
@@ -32,7 +32,7 @@ void PresentRenderNode::render(CommandBatch& command_buffer, unsigned image_inde
     m_present_info.pWaitSemaphores = m_present_wait_sem.data();
     m_present_info.swapchainCount = 1u;
     m_present_info.pImageIndices = &image_index;
-    VkResult result = vkQueuePresentKHR(Application::GetRenderer().getCommandManager()->getQueue(), &m_present_info);
+    VkResult result = Application::GetRenderer().getCommandManager()->queuePresent(m_present_info);
     if (result != VK_SUCCESS) {
         throw std::runtime_error("failed to present swap chain image!");
     }
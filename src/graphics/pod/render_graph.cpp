@@ -1,53 +1,30 @@
 #include "render_graph.h"
 
 #include "../api/vulkan_device.h"
+#include "../api/vulkan_image_buffer.h"
 #include "../api/vulkan_pipeline.h"
 #include "../api/vulkan_render_pass.h"
 #include "../api/vulkan_resources_manager.h"
-#include "../api/vulkan_swapchain.h"
 #include "render_node.h"
 #include "graphics_render_node_config.h"
 #include "graphics_render_node.h"
-#include "../../application.h"
-#include "../../window_surface.h"
+#include "image_buffer_config.h"
+#include "render_pass_config.h"
 
-#include <pugixml.hpp>
-
-#include <filesystem>
-
-bool RenderGraph::init(std::shared_ptr<VulkanDevice> device, const std::shared_ptr<WindowSurface>& window) {
-    using namespace std::literals;
+#include <algorithm>
+#include <stdexcept>
 
+bool RenderGraph::init(std::shared_ptr<VulkanDevice> device, std::shared_ptr<const RenderGraphTemplate> graph_template) {
     m_device = std::move(device);
+    m_template = std::move(graph_template);
     m_sorted = false;
 
-    pugi::xml_document xml_doc;
-	pugi::xml_parse_result parse_res = xml_doc.load_file("graphics_pipelines.xml");
-	if (!parse_res) { return false;	}
-
-	pugi::xml_node root_node = xml_doc.root();
-	if (!root_node) { return false; }
-	root_node = root_node.child("RenderGraph");
-
-    pugi::xml_node render_nodes_node = root_node.child("RenderNodes");
-	if (!render_nodes_node) return false;
-
-    for (pugi::xml_node render_node = render_nodes_node.first_child(); render_node; render_node = render_node.next_sibling()) {
-        std::string render_node_type = render_node.name();
-        std::string node_name = render_node.attribute("name").as_string();
-        
-        if(render_node_type == "GraphicsRenderNode"s) {
-            std::shared_ptr<GraphicsRenderNodeConfig> render_node_config = std::make_shared<GraphicsRenderNodeConfig>();
-            render_node_config->init(
-                device,
-                0u,
-                window,
-                VulkanSwapChain::querySwapChainSupport(m_device->getDeviceAbilities().physical_device, m_device->getSurface()),
-                Application::GetRenderer().getResourcesManager(), Application::GetRenderer().getPipelinesManager(),
-                render_node
-            );
-            m_graphics_cfg_name_map[node_name] = std::move(render_node_config);
-        }
+    // Per frame copies, nodes created without an instance config write their viewport and scissor into these.
+    size_t configs_count = m_template->getConfigsCount();
+    m_graphics_cfgs.reserve(configs_count);
+    for(size_t i = 0u; i < configs_count; ++i) {
+        const std::shared_ptr<GraphicsRenderNodeConfig>& config = m_template->getConfig(static_cast<RenderGraphTemplate::ConfigHandle>(i));
+        m_graphics_cfgs.push_back(config->makeInstance(config->getName()));
     }
 
     return true;
@@ -60,25 +37,29 @@ void RenderGraph::destroy() {
         render_node->destroy();
     }
     m_render_nodes.clear();
+    m_render_node_idx.clear();
     m_read_map.clear();
     m_written_map.clear();
-    m_adjency_list.clear();
-    m_rev_adjency_list.clear();
+    m_schedule.reset();
     m_topologically_sorted_nodes.clear();
     m_render_node_sort_idx.clear();
     m_dependency_levels.clear();
 }
 
 bool RenderGraph::hasGraphicsRenderNodeConfig(const std::string& config_name) const {
-    return m_graphics_cfg_name_map.contains(config_name);
+    return m_template->findConfig(config_name) != RenderGraphTemplate::NO_CONFIG;
 }
 
 const std::shared_ptr<GraphicsRenderNodeConfig>& RenderGraph::getGraphicsRenderNodeConfig(const std::string& config_name) const {
-    return m_graphics_cfg_name_map.at(config_name);
+    RenderGraphTemplate::ConfigHandle handle = m_template->findConfig(config_name);
+    if(handle == RenderGraphTemplate::NO_CONFIG) {
+        throw std::runtime_error("unknown graphics render node config " + config_name + " !");
+    }
+    return m_graphics_cfgs[handle];
 }
 
 std::shared_ptr<GraphicsRenderNodeConfig> RenderGraph::makeGraphicsRenderNodeCfgInstance(const std::string& config_name, const std::string& config_extension) {
-    return m_graphics_cfg_name_map.at(config_name)->makeInstance(config_name + config_extension);
+    return getGraphicsRenderNodeConfig(config_name)->makeInstance(config_name + config_extension);
 }
 
 void RenderGraph::add_pass(std::shared_ptr<RenderNode> render_node) {
@@ -90,114 +71,37 @@ void RenderGraph::add_pass(std::shared_ptr<RenderNode> render_node) {
         m_read_map[read_resource_name].insert(render_node);
     }
 
+    m_render_node_idx[render_node] = static_cast<RenderGraphTemplate::NodeIndex>(m_render_nodes.size());
     m_render_nodes.push_back(std::move(render_node));
     m_sorted = false;
 }
 
 void RenderGraph::topological_sort() {
-    if(m_render_nodes.size() == 1u) {
-        m_topologically_sorted_nodes.clear();
-        m_topologically_sorted_nodes.push_back(m_render_nodes.front());
-        m_render_node_sort_idx.clear();
-        m_render_node_sort_idx[m_topologically_sorted_nodes.front()] = 0u;
-        m_sorted = true;
-        return;
-    }
-
-    std::unordered_map<RenderNodePtr, int> count_edges_to_node;
-    std::unordered_map<RenderNodePtr, int> count_edges_from_node;
-
-    for(const RenderNodePtr& render_node : m_render_nodes) {
-        if(!count_edges_to_node.contains(render_node)) {
-            count_edges_to_node[render_node] = 0;
-        }
-        if(!count_edges_from_node.contains(render_node)) {
-            count_edges_from_node[render_node] = 0;
-        }
-        for(const auto&[written_resource_name, written_resource_ptr] : render_node->getWrittenResourcesMap()) {
-            if(!m_read_map.contains(written_resource_name)) continue;
-            for(const RenderNodePtr& reader_node : m_read_map.at(written_resource_name)) {
-                m_adjency_list[render_node].insert(reader_node);
-                m_rev_adjency_list[reader_node].insert(render_node);
-                count_edges_to_node[reader_node]++;
-                count_edges_from_node[render_node]++;
+    // Only the graph shape in add_pass index space goes to the template, frames with the same passes get the
+    // schedule compiled for the first of them.
+    std::vector<RenderGraphTemplate::Edge> edges;
+    for(size_t i = 0u; i < m_render_nodes.size(); ++i) {
+        for(const auto&[written_resource_name, written_resource_ptr] : m_render_nodes[i]->getWrittenResourcesMap()) {
+            auto read_it = m_read_map.find(written_resource_name);
+            if(read_it == m_read_map.end()) continue;
+            for(const RenderNodePtr& reader_node : read_it->second) {
+                RenderGraphTemplate::NodeIndex reader_idx = m_render_node_idx.at(reader_node);
+                if(reader_idx == i) continue;
+                edges.emplace_back(static_cast<RenderGraphTemplate::NodeIndex>(i), reader_idx);
             }
         }
-        // for(const auto&[written_resource_name, written_resource_ptr] : render_node->getWrittenResourcesMap()) {
-        //     if(!m_read_map.contains(written_resource_name)) continue;
-        //     for(const RenderNodePtr& reader_node : m_read_map.at(written_resource_name)) {
-        //         m_adjency_list[render_node].insert(reader_node);
-        //         m_rev_adjency_list[reader_node].insert(render_node);
-        //         count_edges_to_node[reader_node]++;
-        //         count_edges_from_node[render_node]++;
-        //     }
-        // }
-        // for(const auto&[read_resource_name, read_resource_ptr] : render_node->getReadResourcesMap()) {
-        //     if(!m_written_map.contains(read_resource_name)) continue;
-        //     for(const RenderNodePtr& write_node : m_written_map.at(read_resource_name)) {
-        //         m_adjency_list[write_node].insert(render_node);
-        //         m_rev_adjency_list[render_node].insert(write_node);
-        //     }
-        // }
     }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
 
-    if(m_adjency_list.size() == 0u) {
-        m_topologically_sorted_nodes.clear();
-        m_topologically_sorted_nodes.insert(m_topologically_sorted_nodes.end(), m_render_nodes.begin(), m_render_nodes.end());
-        m_render_node_sort_idx.clear();
-        for(size_t i = 0; i < m_topologically_sorted_nodes.size(); ++i) {
-            const RenderNodePtr& render_node = m_topologically_sorted_nodes.at(i);
-            m_render_node_sort_idx[render_node] = i;
-        }
-        m_sorted = true;
-        return;
-    }
+    m_schedule = m_template->getSchedule(m_render_nodes.size(), edges);
 
     m_topologically_sorted_nodes.clear();
     m_render_node_sort_idx.clear();
-    m_topologically_sorted_nodes.reserve(m_render_nodes.size());
-
-    std::stack<std::pair<RenderNodePtr, bool>> stack;
-    for (const auto&[node_ptr, ct] : count_edges_from_node) {
-        if (!ct) {
-            stack.push({ node_ptr, false });
-        }
-    }
-
-    std::unordered_set<RenderNodePtr> visited_set;
-    visited_set.reserve(m_render_nodes.size());
-
-    while (stack.size()) {
-        auto [node_ptr, is_processed] = stack.top();
-        stack.pop();
-
-        if (is_processed) {
-            m_topologically_sorted_nodes.push_back(node_ptr);
-            continue;
-        }
-
-        if (!visited_set.count(node_ptr)) {
-            visited_set.insert(node_ptr);
-            stack.push({node_ptr, true});
-
-            if(m_rev_adjency_list.contains(node_ptr)){
-                std::for_each(
-                    m_rev_adjency_list.at(node_ptr).begin(),
-                    m_rev_adjency_list.at(node_ptr).end(),
-                    [&stack, &visited_set](const RenderNodePtr& new_node_ptr) {
-                        if (!visited_set.count(new_node_ptr)) {
-                            stack.push({ new_node_ptr, false });
-                        }
-                    }
-                );
-            }
-        }
-    }
-
-    std::reverse(m_topologically_sorted_nodes.begin(), m_topologically_sorted_nodes.end());
-    for(size_t i = 0; i < m_topologically_sorted_nodes.size(); ++i) {
-        const RenderNodePtr& render_node = m_topologically_sorted_nodes.at(i);
-        m_render_node_sort_idx[render_node] = i;
+    m_topologically_sorted_nodes.reserve(m_schedule->sorted_nodes.size());
+    for(RenderGraphTemplate::NodeIndex node_idx : m_schedule->sorted_nodes) {
+        m_render_node_sort_idx[m_render_nodes[node_idx]] = m_topologically_sorted_nodes.size();
+        m_topologically_sorted_nodes.push_back(m_render_nodes[node_idx]);
     }
 
     m_sorted = true;
@@ -205,41 +109,96 @@ void RenderGraph::topological_sort() {
 
 void RenderGraph::build_dependency_levels() {
     m_dependency_levels.clear();
-
-    std::unordered_map<RenderNodePtr, int> node_dist_to_start;
-    for (const RenderNodePtr& node_ptr : m_topologically_sorted_nodes) {
-        node_dist_to_start[node_ptr] = 0;
+    m_dependency_levels.resize(m_schedule->levels_count);
+    for (int level = 0; level < m_schedule->levels_count; ++level) {
+        m_dependency_levels[level] = std::make_shared<DependencyLevel>(level);
     }
 
-    int dependency_level_count = 1;
+    for (RenderGraphTemplate::NodeIndex node_idx : m_schedule->sorted_nodes) {
+        m_dependency_levels[m_schedule->node_levels[node_idx]]->addNode(m_render_nodes[node_idx]);
+    }
 
-    for (RenderNodeList::iterator it = m_topologically_sorted_nodes.begin(); it != m_topologically_sorted_nodes.end(); ++it) {
-        const RenderNodePtr& node_ptr = *it;
-        int max_neighbor_dist = -1;
+    for (const std::shared_ptr<DependencyLevel>& dependency_level : m_dependency_levels) {
+        dependency_level->sortPipelineNodes();
+    }
 
-        if(!m_rev_adjency_list.contains(node_ptr)) continue;
-        for (const RenderNodePtr& adj_node_ptr : m_rev_adjency_list.at(node_ptr)) {
-            max_neighbor_dist = std::max(max_neighbor_dist, node_dist_to_start[adj_node_ptr]);
-        }
+    check_transient_attachments();
+    build_level_accesses();
+}
 
-        if (max_neighbor_dist != -1) {
-            node_dist_to_start[node_ptr] = 1 + max_neighbor_dist;
-            dependency_level_count = std::max(1 + max_neighbor_dist, dependency_level_count);
+// Transient attachments may live in lazily allocated memory, their contents do not survive the render pass.
+void RenderGraph::check_transient_attachments() const {
+    auto is_transient = [](const std::shared_ptr<RenderResource>& resource) {
+        if(resource->getType() != RenderResource::Type::IMAGE) return false;
+        return (std::static_pointer_cast<VulkanImageBuffer>(resource)->getImageConfig()->getImageInfo().usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) != 0u;
+    };
+
+    for (const std::shared_ptr<DependencyLevel>& dependency_level : m_dependency_levels) {
+        for (const auto&[pipeline_name, graphics_nodes] : dependency_level->getPipelineNodeMap()) {
+            for (const std::shared_ptr<GraphicsRenderNode>& graphics_node : graphics_nodes) {
+                const std::shared_ptr<RenderPassConfig>& render_pass_config = graphics_node->getPipeline()->getRenderPass()->getRenderPassConfig();
+                for(const auto&[written_resource_name, written_slot] : graphics_node->getWrittenResourcesMap()) {
+                    if(!is_transient(written_slot.resource)) continue;
+                    const VkAttachmentDescription& attachment = render_pass_config->getAttachmentDescription(written_slot.attached_as);
+                    if(attachment.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD || attachment.stencilLoadOp == VK_ATTACHMENT_LOAD_OP_LOAD) {
+                        throw std::runtime_error("transient attachment " + written_resource_name + " can not be loaded by a render pass!");
+                    }
+                }
+                for(const auto&[read_resource_name, read_slot] : graphics_node->getReadResourcesMap()) {
+                    if(is_transient(read_slot.resource)) {
+                        throw std::runtime_error("transient attachment " + read_resource_name + " can not be read through a descriptor!");
+                    }
+                }
+            }
         }
     }
+}
 
-    m_dependency_levels.resize(dependency_level_count + 1);
-    for (int level = 0; level < (dependency_level_count + 1); ++level) {
-        std::shared_ptr<DependencyLevel> dependency_level = std::make_shared<DependencyLevel>(level);
-        m_dependency_levels[level] = std::move(dependency_level);
-    }
+void RenderGraph::build_level_accesses() {
+    for (const std::shared_ptr<DependencyLevel>& dependency_level : m_dependency_levels) {
+        for (const auto&[pipeline_name, graphics_nodes] : dependency_level->getPipelineNodeMap()) {
+            for (const std::shared_ptr<GraphicsRenderNode>& graphics_node : graphics_nodes) {
+                const std::shared_ptr<RenderPassConfig>& render_pass_config = graphics_node->getPipeline()->getRenderPass()->getRenderPassConfig();
+                for(const auto&[written_resource_name, written_slot] : graphics_node->getWrittenResourcesMap()) {
+                    if(written_slot.resource->getType() == RenderResource::Type::BUFFER) {
+                        dependency_level->addResourceAccess(written_slot.resource, {VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_WRITE_BIT}, false);
+                        continue;
+                    }
 
-    for (const auto&[node_ptr, level] : node_dist_to_start) {
-        m_dependency_levels[level]->addNode(node_ptr);
-    }
+                    // Undefined initial layouts discard the contents, there is nothing to transition from.
+                    const VkImageLayout initial_layout = render_pass_config->getAttachmentDescription(written_slot.attached_as).initialLayout;
+                    if(initial_layout == VK_IMAGE_LAYOUT_UNDEFINED) continue;
+                    const VkFormat format = std::static_pointer_cast<VulkanImageBuffer>(written_slot.resource)->getImageConfig()->getImageInfo().format;
+                    dependency_level->addResourceAccess(written_slot.resource, VulkanLayoutTracker::getAttachmentAccess(format, initial_layout), true);
+                }
+
+                // Resources nobody in the graph writes keep the state the upload manager left them in.
+                const auto& bindings_metadata = graphics_node->getGraphicsRenderNodeConfig()->getBindingsMetadata();
+                for(const auto&[read_resource_name, read_slot] : graphics_node->getReadResourcesMap()) {
+                    if(!isWrittenInGraph(read_resource_name)) continue;
+
+                    if(read_slot.resource->getType() == RenderResource::Type::BUFFER) {
+                        dependency_level->addResourceAccess(
+                            read_slot.resource,
+                            {
+                                VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                                VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_2_INDEX_READ_BIT | VK_ACCESS_2_UNIFORM_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT
+                            },
+                            false
+                        );
+                        continue;
+                    }
 
-    for (int level = 0; level < (dependency_level_count + 1); ++level) {
-        m_dependency_levels[level]->sortPipelineNodes();
+                    auto metadata_it = bindings_metadata.find(read_slot.attached_as);
+                    if(metadata_it == bindings_metadata.end()) continue;
+                    dependency_level->addResourceAccess(
+                        read_slot.resource,
+                        {VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT, metadata_it->second->read_image_layout},
+                        false
+                    );
+                }
+            }
+        }
     }
 }
 
@@ -13,6 +13,7 @@
 
 #include "render_resource.h"
 #include "dependency_level.h"
+#include "render_graph_template.h"
 
 class VulkanDevice;
 class RenderNode;
@@ -26,7 +27,7 @@ public:
 	using RenderNodeSet = std::unordered_set<RenderNodePtr>;
 	static const size_t NO_ID = -1;
 
-	bool init(std::shared_ptr<VulkanDevice> device, const std::shared_ptr<WindowSurface>& window);
+	bool init(std::shared_ptr<VulkanDevice> device, std::shared_ptr<const RenderGraphTemplate> graph_template);
     void destroy();
 
 	bool hasGraphicsRenderNodeConfig(const std::string& config_name) const;
@@ -53,17 +54,20 @@ public:
 	const RenderNodeSet& getReadBy(const std::string& global_resource_name) const;
 
 private:
+	void check_transient_attachments() const;
+	void build_level_accesses();
 
 	std::shared_ptr<VulkanDevice> m_device;
 
-	std::unordered_map<std::string, std::shared_ptr<GraphicsRenderNodeConfig>> m_graphics_cfg_name_map;
+	std::shared_ptr<const RenderGraphTemplate> m_template;
+	std::vector<std::shared_ptr<GraphicsRenderNodeConfig>> m_graphics_cfgs; // Indexed by RenderGraphTemplate::ConfigHandle
 
 	RenderNodeList m_render_nodes;
+	std::unordered_map<RenderNodePtr, RenderGraphTemplate::NodeIndex> m_render_node_idx;
 	std::unordered_map<std::string, RenderNodeSet> m_read_map;
 	std::unordered_map<std::string, RenderNodeSet> m_written_map;
 
-	std::unordered_map<RenderNodePtr, RenderNodeSet> m_adjency_list; // Write To Read
-	std::unordered_map<RenderNodePtr, RenderNodeSet> m_rev_adjency_list; // Read To Write
+	std::shared_ptr<const RenderGraphTemplate::Schedule> m_schedule;
 	RenderNodeList m_topologically_sorted_nodes;
 	std::unordered_map<RenderNodePtr, size_t> m_render_node_sort_idx;
 	std::vector<std::shared_ptr<DependencyLevel>> m_dependency_levels;
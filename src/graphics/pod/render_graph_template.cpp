@@ -0,0 +1,155 @@
+#include "render_graph_template.h"
+
+#include "../api/vulkan_device.h"
+#include "../api/vulkan_swapchain.h"
+#include "graphics_render_node_config.h"
+#include "../../application.h"
+#include "../../window_surface.h"
+
+#include <pugixml.hpp>
+
+#include <algorithm>
+#include <stack>
+#include <stdexcept>
+
+bool RenderGraphTemplate::init(std::shared_ptr<VulkanDevice> device, const std::shared_ptr<WindowSurface>& window, const std::string& file_name) {
+    using namespace std::literals;
+
+    pugi::xml_document xml_doc;
+    pugi::xml_parse_result parse_res = xml_doc.load_file(file_name.c_str());
+    if (!parse_res) { return false; }
+
+    pugi::xml_node root_node = xml_doc.root();
+    if (!root_node) { return false; }
+    root_node = root_node.child("RenderGraph");
+
+    pugi::xml_node render_nodes_node = root_node.child("RenderNodes");
+    if (!render_nodes_node) return false;
+
+    const SwapchainSupportDetails swapchain_support = VulkanSwapChain::querySwapChainSupport(device->getDeviceAbilities().physical_device, device->getSurface());
+    for (pugi::xml_node render_node = render_nodes_node.first_child(); render_node; render_node = render_node.next_sibling()) {
+        std::string render_node_type = render_node.name();
+        std::string node_name = render_node.attribute("name").as_string();
+        if(!device->isFeatureEnabled(render_node.attribute("device_feature").as_string())) continue;
+
+        if(render_node_type == "GraphicsRenderNode"s) {
+            std::shared_ptr<GraphicsRenderNodeConfig> render_node_config = std::make_shared<GraphicsRenderNodeConfig>();
+            render_node_config->init(
+                device,
+                0u,
+                window,
+                swapchain_support,
+                Application::GetRenderer().getResourcesManager(), Application::GetRenderer().getPipelinesManager(),
+                render_node
+            );
+
+            auto [it, inserted] = m_config_handles.try_emplace(std::move(node_name), static_cast<ConfigHandle>(m_configs.size()));
+            if(inserted) {
+                m_configs.push_back(std::move(render_node_config));
+            }
+            else {
+                m_configs[it->second] = std::move(render_node_config);
+            }
+        }
+    }
+
+    return true;
+}
+
+RenderGraphTemplate::ConfigHandle RenderGraphTemplate::findConfig(const std::string& config_name) const {
+    auto it = m_config_handles.find(config_name);
+    return it == m_config_handles.end() ? NO_CONFIG : it->second;
+}
+
+const std::shared_ptr<GraphicsRenderNodeConfig>& RenderGraphTemplate::getConfig(ConfigHandle handle) const {
+    return m_configs.at(handle);
+}
+
+size_t RenderGraphTemplate::getConfigsCount() const {
+    return m_configs.size();
+}
+
+std::shared_ptr<const RenderGraphTemplate::Schedule> RenderGraphTemplate::getSchedule(size_t nodes_count, const std::vector<Edge>& edges) const {
+    {
+        std::lock_guard<std::mutex> lock(m_schedules_mutex);
+        for(const std::shared_ptr<const Schedule>& schedule : m_schedules) {
+            if(schedule->nodes_count == nodes_count && schedule->edges == edges) {
+                return schedule;
+            }
+        }
+    }
+
+    std::shared_ptr<const Schedule> schedule = compileSchedule(nodes_count, edges);
+
+    std::lock_guard<std::mutex> lock(m_schedules_mutex);
+    m_schedules.push_back(schedule);
+    return schedule;
+}
+
+std::shared_ptr<const RenderGraphTemplate::Schedule> RenderGraphTemplate::compileSchedule(size_t nodes_count, const std::vector<Edge>& edges) {
+    std::shared_ptr<Schedule> schedule = std::make_shared<Schedule>();
+    schedule->nodes_count = nodes_count;
+    schedule->edges = edges;
+    schedule->sorted_nodes.reserve(nodes_count);
+
+    std::vector<std::vector<NodeIndex>> rev_adjency_list(nodes_count); // Read To Write
+    std::vector<int> count_edges_from_node(nodes_count, 0);
+    for(const auto&[writer, reader] : edges) {
+        rev_adjency_list[reader].push_back(writer);
+        count_edges_from_node[writer]++;
+    }
+
+    if(edges.empty()) {
+        for(size_t i = 0u; i < nodes_count; ++i) {
+            schedule->sorted_nodes.push_back(static_cast<NodeIndex>(i));
+        }
+    }
+    else {
+        std::stack<std::pair<NodeIndex, bool>> stack;
+        for(size_t i = 0u; i < nodes_count; ++i) {
+            if(!count_edges_from_node[i]) {
+                stack.push({static_cast<NodeIndex>(i), false});
+            }
+        }
+
+        std::vector<bool> visited(nodes_count, false);
+        while (stack.size()) {
+            auto [node_idx, is_processed] = stack.top();
+            stack.pop();
+
+            if (is_processed) {
+                schedule->sorted_nodes.push_back(node_idx);
+                continue;
+            }
+
+            if (!visited[node_idx]) {
+                visited[node_idx] = true;
+                stack.push({node_idx, true});
+                for(NodeIndex writer_idx : rev_adjency_list[node_idx]) {
+                    if(!visited[writer_idx]) {
+                        stack.push({writer_idx, false});
+                    }
+                }
+            }
+        }
+
+        std::reverse(schedule->sorted_nodes.begin(), schedule->sorted_nodes.end());
+    }
+
+    schedule->node_levels.assign(nodes_count, 0);
+    int dependency_level_count = 1;
+    for(NodeIndex node_idx : schedule->sorted_nodes) {
+        int max_neighbor_dist = -1;
+        for(NodeIndex writer_idx : rev_adjency_list[node_idx]) {
+            max_neighbor_dist = std::max(max_neighbor_dist, schedule->node_levels[writer_idx]);
+        }
+
+        if (max_neighbor_dist != -1) {
+            schedule->node_levels[node_idx] = 1 + max_neighbor_dist;
+            dependency_level_count = std::max(1 + max_neighbor_dist, dependency_level_count);
+        }
+    }
+    schedule->levels_count = dependency_level_count + 1;
+
+    return schedule;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class VulkanDevice;
+class GraphicsRenderNodeConfig;
+class WindowSurface;
+
+// Compiled form of the RenderGraph section of graphics_pipelines.xml. Parsed once by the renderer and shared by the
+// per frame RenderGraph instances, which only copy the node configs and swap their own resources in.
+class RenderGraphTemplate {
+public:
+    using ConfigHandle = uint32_t;
+    using NodeIndex = uint32_t;
+    using Edge = std::pair<NodeIndex, NodeIndex>; // Writer to reader, indices are in RenderGraph::add_pass order
+    static constexpr ConfigHandle NO_CONFIG = static_cast<ConfigHandle>(-1);
+
+    // Topological order and dependency levels of a graph shape, frames that add the same passes in the same order
+    // share one schedule.
+    struct Schedule {
+        size_t nodes_count = 0u;
+        std::vector<Edge> edges;
+        std::vector<NodeIndex> sorted_nodes;
+        std::vector<int> node_levels;
+        int levels_count = 0;
+    };
+
+    bool init(std::shared_ptr<VulkanDevice> device, const std::shared_ptr<WindowSurface>& window, const std::string& file_name);
+
+    ConfigHandle findConfig(const std::string& config_name) const;
+    const std::shared_ptr<GraphicsRenderNodeConfig>& getConfig(ConfigHandle handle) const;
+    size_t getConfigsCount() const;
+
+    // edges must be sorted and unique.
+    std::shared_ptr<const Schedule> getSchedule(size_t nodes_count, const std::vector<Edge>& edges) const;
+
+private:
+    static std::shared_ptr<const Schedule> compileSchedule(size_t nodes_count, const std::vector<Edge>& edges);
+
+    std::vector<std::shared_ptr<GraphicsRenderNodeConfig>> m_configs;
+    std::unordered_map<std::string, ConfigHandle> m_config_handles;
+
+    mutable std::mutex m_schedules_mutex;
+    mutable std::vector<std::shared_ptr<const Schedule>> m_schedules;
+};
@@ -201,7 +201,11 @@ VkIndexType VertexFormat::getIndexType() const {
 }
 
 uint32_t VertexFormat::getIndexTypeBytesCount() const {
-    switch (m_index_type) {
+    return getIndexTypeBytesCount(m_index_type);
+}
+
+uint32_t VertexFormat::getIndexTypeBytesCount(VkIndexType index_type) {
+    switch (index_type) {
         case VK_INDEX_TYPE_UINT16 : return 2u;
         case VK_INDEX_TYPE_UINT32 : return 4u;
         case VK_INDEX_TYPE_NONE_KHR : return 0u;
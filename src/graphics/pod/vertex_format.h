@@ -108,6 +108,7 @@ public:
 
     VkIndexType getIndexType() const;
     uint32_t getIndexTypeBytesCount() const;
+    static uint32_t getIndexTypeBytesCount(VkIndexType index_type);
     void setIndexType(VkIndexType idx_type);
 
     VkVertexInputRate getInputRate() const;
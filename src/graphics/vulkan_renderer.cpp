@@ -7,6 +7,7 @@
 #include "api/vulkan_framebuffer.h"
 #include "api/vulkan_fence_manager.h"
 #include "api/vulkan_format_manager.h"
+#include "api/vulkan_buffer.h"
 #include "api/vulkan_image_buffer.h"
 #include "api/vulkan_pipelines_manager.h"
 #include "api/vulkan_pipeline.h"
@@ -17,19 +18,68 @@
 #include "api/vulkan_shader.h"
 #include "api/vulkan_shaders_manager.h"
 #include "api/vulkan_semaphores_manager.h"
+#include "api/vulkan_texture_streamer.h"
+#include "api/vulkan_upload_manager.h"
 #include "pod/render_node.h"
 #include "pod/present_render_node.h"
 #include "pod/graphics_render_node.h"
 #include "pod/render_graph.h"
+#include "pod/render_graph_template.h"
+#include "pod/dependency_level.h"
 #include "pod/framebuffer_config.h"
 #include "pod/graphics_render_node_config.h"
 #include "pod/image_buffer_config.h"
 #include "pod/render_pass_config.h"
 #include "pod/pipeline_config.h"
 #include "../scene/light_manager.h"
+#include "../application.h"
 
 #include <algorithm>
 
+bool SecondaryCommandPool::init(VkDevice device, uint32_t family_index) {
+    VkCommandPoolCreateInfo cmd_pool_info{};
+    cmd_pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    cmd_pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    cmd_pool_info.queueFamilyIndex = family_index;
+
+    VkResult result = vkCreateCommandPool(device, &cmd_pool_info, nullptr, &pool);
+    if(result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create secondary command pool!");
+    }
+    return true;
+}
+
+void SecondaryCommandPool::destroy(VkDevice device) {
+    vkDestroyCommandPool(device, pool, nullptr);
+    pool = VK_NULL_HANDLE;
+    buffers.clear();
+    used = 0u;
+}
+
+void SecondaryCommandPool::reset(VkDevice device) {
+    if(used == 0u) return;
+    vkResetCommandPool(device, pool, 0u);
+    used = 0u;
+}
+
+VkCommandBuffer SecondaryCommandPool::acquire(VkDevice device) {
+    if(used == buffers.size()) {
+        VkCommandBufferAllocateInfo command_alloc_info{};
+        command_alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        command_alloc_info.commandPool = pool;
+        command_alloc_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        command_alloc_info.commandBufferCount = 1u;
+
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+        VkResult result = vkAllocateCommandBuffers(device, &command_alloc_info, &command_buffer);
+        if(result != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate secondary command buffer!");
+        }
+        buffers.push_back(command_buffer);
+    }
+    return buffers[used++];
+}
+
 bool PerFrame::init(std::shared_ptr<VulkanDevice> device, unsigned index) {
     frame_index = index;
     return true;
@@ -41,9 +91,10 @@ void PerFrame::destroy(VulkanRenderer& renderer) {
     for(VkSemaphore sem : cmd_submit_wait_sem) {
         renderer.getSemaphoreManager()->returnSemaphore(sem);
     }
-    renderer.getResourcesManager()->delete_image(out_color_image);
-    renderer.getResourcesManager()->delete_image(out_depth_image);
     command_buffer->destroy();
+    for(SecondaryCommandPool& secondary_pool : secondary_pools) {
+        secondary_pool.destroy(renderer.GetDevice()->getDevice());
+    }
     present_render_node->destroy();
     render_graph->destroy();
 }
@@ -77,8 +128,14 @@ bool VulkanRenderer::init(std::shared_ptr<VulkanDevice> device, std::shared_ptr<
     m_semaphore_manager = std::make_shared<VulkanSemaphoresManager>();
     m_semaphore_manager->init(m_device);
 
+    m_upload_manager = std::make_shared<VulkanUploadManager>();
+    m_upload_manager->init(m_device, static_cast<VkDeviceSize>(Application::Get().GetApplicationOptions().StagingBufferSizeMB) * 1024u * 1024u);
+
     m_resources_manager = std::make_shared<VulkanResourcesManager>(m_device, m_format_manager);
     m_resources_manager->init(window, "graphics_pipelines.xml"s);
+    m_resources_manager->addDeletionListener([this](const std::shared_ptr<RenderResource>& resource) {
+        unregisterTrackedResource(resource);
+    });
 
     m_swapchain = std::make_shared<VulkanSwapChain>();
     m_swapchain->init(m_device, window, "graphics_pipelines.xml"s);
@@ -87,6 +144,23 @@ bool VulkanRenderer::init(std::shared_ptr<VulkanDevice> device, std::shared_ptr<
 
     m_descriptors_manager = std::make_shared<VulkanDescriptorsManager>();
     m_descriptors_manager->init(m_device, "graphics_pipelines.xml"s);
+    m_resources_manager->initBindless(m_descriptors_manager);
+    m_resources_manager->addDeletionListener([this](const std::shared_ptr<RenderResource>& resource) {
+        m_descriptors_manager->invalidateResource(resource);
+    });
+
+    const ApplicationOptions& options = Application::Get().GetApplicationOptions();
+    if(options.TextureStreaming) {
+        m_texture_streamer = std::make_shared<VulkanTextureStreamer>();
+        m_texture_streamer->init(
+            m_device,
+            m_resources_manager,
+            m_upload_manager,
+            m_thread_pool,
+            static_cast<VkDeviceSize>(options.TextureUploadBudgetKB) * 1024u,
+            static_cast<VkDeviceSize>(options.TextureResidentBudgetMB) * 1024u * 1024u
+        );
+    }
 
     m_render_passes_manager = std::make_shared<VulkanRenderPassesManager>();
     m_render_passes_manager->init(m_device, "graphics_pipelines.xml"s, m_swapchain);
@@ -95,7 +169,12 @@ bool VulkanRenderer::init(std::shared_ptr<VulkanDevice> device, std::shared_ptr<
     m_shaders_manager->init(m_device, m_resources_manager, "graphics_pipelines.xml"s);
 
     m_pipelines_manager = std::make_shared<VulkanPipelinesManager>();
-    m_pipelines_manager->init(m_device, "graphics_pipelines.xml"s);
+    m_pipelines_manager->init(m_device, "graphics_pipelines.xml"s, m_thread_pool);
+
+    m_render_graph_template = std::make_shared<RenderGraphTemplate>();
+    if(!m_render_graph_template->init(m_device, window, "graphics_pipelines.xml"s)) {
+        throw std::runtime_error("failed to load render graph template!");
+    }
 
     m_frame = 0u;
     //m_prev_frame.push_back(m_swapchain->getMaxFrames() - 1u);
@@ -103,12 +182,18 @@ bool VulkanRenderer::init(std::shared_ptr<VulkanDevice> device, std::shared_ptr<
 
     const std::vector<std::shared_ptr<VulkanImageBuffer>>& swapchain_images = m_swapchain->getSwapchainImages();
     int max_frames = m_swapchain->getMaxFrames();
+
+    // The multisampled targets never outlive a frame: every graph clears them in its first render pass and resolves
+    // into its own swapchain image, and the external dependency of each pass orders its attachment writes after the
+    // previous submission's. Frames in flight therefore alias one color and one depth image instead of owning them.
+    m_out_color_image = m_resources_manager->create_image("render_target_color"s, "render_target_color_resource");
+    m_out_depth_image = m_resources_manager->create_image("render_target_depth"s, "render_target_depth_resource");
     m_per_frame.reserve(max_frames);
     for(int i = 0; i < max_frames; ++i) {
         std::shared_ptr<PerFrame> per_frame = std::make_shared<PerFrame>();
 
-        per_frame->out_color_image = m_resources_manager->create_image("render_target_color"s + std::to_string(i), "render_target_color_resource");
-        per_frame->out_depth_image = m_resources_manager->create_image("render_target_depth"s + std::to_string(i), "render_target_depth_resource");
+        per_frame->out_color_image = m_out_color_image;
+        per_frame->out_depth_image = m_out_depth_image;
         per_frame->light_buffer = m_resources_manager->create_buffer(nullptr, 0, LightManager::getLightBufferName() + std::to_string(i), LightManager::getLightResourceCfgName());
 
         per_frame->swapchain_available_sem = m_semaphore_manager->getSemaphore("swapchain_available_sem");
@@ -116,11 +201,18 @@ bool VulkanRenderer::init(std::shared_ptr<VulkanDevice> device, std::shared_ptr<
         vkResetFences(m_device->getDevice(), 1u, &per_frame->swapchain_available_fen);
 
         per_frame->render_graph = std::make_shared<RenderGraph>();
-        per_frame->render_graph->init(m_device, window);
+        per_frame->render_graph->init(m_device, m_render_graph_template);
 
         per_frame->init(m_device, i);
         per_frame->command_buffer = m_command_manager->allocCommandBufferPtr(PoolTypeEnum::GRAPICS);
         per_frame->cmd_submit_finish_fence = per_frame->command_buffer->getRenderFence();
+
+        // One slot per worker plus the recording thread, ParallelForRange never runs more blocks than that.
+        const size_t secondary_pools_count = m_thread_pool ? m_thread_pool->getThreadCount() + 1u : 0u;
+        per_frame->secondary_pools.resize(secondary_pools_count);
+        for(SecondaryCommandPool& secondary_pool : per_frame->secondary_pools) {
+            secondary_pool.init(m_device->getDevice(), m_command_manager->getQueueFamilyIndices().getFamilyIdx(PoolTypeEnum::GRAPICS).value());
+        }
         
         per_frame->present_render_node = std::make_shared<PresentRenderNode>();
         per_frame->present_render_node->init(m_device, "presenter"s, false, per_frame->render_graph);
@@ -143,6 +235,12 @@ void VulkanRenderer::destroy() {
     for(size_t i = 0u; i < sz; ++i) {
         m_per_frame[i]->destroy(*this);
     }
+    m_resources_manager->delete_image(m_out_color_image);
+    m_resources_manager->delete_image(m_out_depth_image);
+    if(m_texture_streamer) {
+        m_texture_streamer->destroy();
+    }
+    m_upload_manager->destroy();
     m_command_manager->destroy();
     m_fence_manager->destroy();
     m_semaphore_manager->destroy();
@@ -196,6 +294,14 @@ std::shared_ptr<VulkanResourcesManager>& VulkanRenderer::getResourcesManager() {
     return m_resources_manager;
 }
 
+std::shared_ptr<VulkanUploadManager>& VulkanRenderer::getUploadManager() {
+    return m_upload_manager;
+}
+
+std::shared_ptr<VulkanTextureStreamer>& VulkanRenderer::getTextureStreamer() {
+    return m_texture_streamer;
+}
+
 std::shared_ptr<VulkanImageBuffer>& VulkanRenderer::getOutColorImage(uint32_t image_index) {
     return m_per_frame[image_index]->out_color_image;
 }
@@ -210,7 +316,19 @@ void VulkanRenderer::beginFrame(unsigned image_index) {
     vkWaitForFences(m_device->getDevice(), 1u, &(m_per_frame[image_index]->cmd_submit_finish_fence), VK_TRUE, UINT64_MAX);
     vkResetFences(m_device->getDevice(), 1u, &(m_per_frame[image_index]->cmd_submit_finish_fence));
 
+    m_descriptors_manager->nextFrame();
+    m_resources_manager->nextFrame();
+    if(m_texture_streamer) {
+        m_retired_images.clear();
+        m_texture_streamer->update(m_retired_images);
+        for(VkImage image : m_retired_images) {
+            m_layout_tracker.unregisterImage(image);
+        }
+    }
     m_per_frame[image_index]->command_buffer->reset();
+    for(SecondaryCommandPool& secondary_pool : m_per_frame[image_index]->secondary_pools) {
+        secondary_pool.reset(m_device->getDevice());
+    }
     m_per_frame[image_index]->cmd_submit_finish_signal_sem = m_per_frame[image_index]->command_buffer->getInProgressSemaphore();
     m_per_frame[image_index]->cmd_submit_finish_fence = m_per_frame[image_index]->command_buffer->getRenderFence();
 
@@ -224,6 +342,8 @@ void VulkanRenderer::recordCommandBuffer(CommandBatch& command_buffer, unsigned
     for (auto dependency_it = dependency_levels.begin(); dependency_it != dependency_levels.end(); ++dependency_it) {
         const std::shared_ptr<DependencyLevel>& dependency_lvl = *dependency_it;
 
+        recordLevelBarriers(command_buffer, *dependency_lvl);
+
         for (const auto& framebuffer_name : dependency_lvl->getFramebuffers()) {
             for(const auto& renderpass_name : dependency_lvl->getRenderpasses(framebuffer_name)) {
 
@@ -240,15 +360,18 @@ void VulkanRenderer::recordCommandBuffer(CommandBatch& command_buffer, unsigned
                 renderpass_info.clearValueCount = framebuffer_ptr->getRenderpass()->getRenderPassConfig()->getClearValues().size();
                 renderpass_info.pClearValues = framebuffer_ptr->getRenderpass()->getRenderPassConfig()->getClearValues().data();
 
-                vkCmdBeginRenderPass(command_buffer.getCommandBufer(), &renderpass_info, VK_SUBPASS_CONTENTS_INLINE);
-
+                m_pass_nodes.clear();
                 for(const auto& pipeline : dependency_lvl->getPipelines(renderpass_name)) {
+                    pipeline->build_push_constants();
                     for(const std::shared_ptr<GraphicsRenderNode>& graphics_node : dependency_lvl->getGraphicsNodes(pipeline->getPipelineConfig()->getName())) {
-                        graphics_node->render(command_buffer, image_index);
+                        if(graphics_node->getExecutionBypass()) continue;
+                        graphics_node->prepare(command_buffer, image_index);
+                        m_pass_nodes.push_back(graphics_node);
                     }
                 }
-                
-                vkCmdEndRenderPass(command_buffer.getCommandBufer());
+
+                recordRenderPass(command_buffer, image_index, renderpass_info);
+                trackRenderPassFinalLayouts(node_params);
             }
         }
     }
@@ -256,6 +379,127 @@ void VulkanRenderer::recordCommandBuffer(CommandBatch& command_buffer, unsigned
     VulkanCommandManager::endCommandBuffer(command_buffer);
 }
 
+void VulkanRenderer::recordLevelBarriers(CommandBatch& command_buffer, const DependencyLevel& dependency_level) {
+    const VkImageSubresourceRange whole_image{VK_IMAGE_ASPECT_NONE, 0u, VK_REMAINING_MIP_LEVELS, 0u, VK_REMAINING_ARRAY_LAYERS};
+
+    for(const DependencyLevel::ResourceAccess& resource_access : dependency_level.getResourceAccesses()) {
+        registerTrackedResource(resource_access.resource);
+
+        if(resource_access.resource->getType() == RenderResource::Type::BUFFER) {
+            VkBuffer buffer = std::static_pointer_cast<VulkanBuffer>(resource_access.resource)->getBuffer();
+            m_layout_tracker.requestBuffer(buffer, 0u, VK_WHOLE_SIZE, resource_access.access);
+            continue;
+        }
+
+        // Attachments already in the initial layout are left to the render pass external dependencies.
+        VkImage image = std::static_pointer_cast<VulkanImageBuffer>(resource_access.resource)->getImageBuffer();
+        if(resource_access.attachment && m_layout_tracker.getImageLayout(image) == resource_access.access.layout) continue;
+        m_layout_tracker.requestImage(image, whole_image, resource_access.access);
+    }
+
+    m_layout_tracker.resolve(m_level_barriers);
+    VulkanLayoutTracker::recordBarriers(command_buffer.getCommandBufer(), m_level_barriers, m_device->getDeviceAbilities().synchronization2);
+}
+
+void VulkanRenderer::trackRenderPassFinalLayouts(const std::shared_ptr<GraphicsRenderNode>& graphics_node) {
+    const VkImageSubresourceRange whole_image{VK_IMAGE_ASPECT_NONE, 0u, VK_REMAINING_MIP_LEVELS, 0u, VK_REMAINING_ARRAY_LAYERS};
+    const std::shared_ptr<RenderPassConfig>& render_pass_config = graphics_node->getPipeline()->getRenderPass()->getRenderPassConfig();
+
+    for(const auto&[written_resource_name, written_slot] : graphics_node->getWrittenResourcesMap()) {
+        if(written_slot.resource->getType() != RenderResource::Type::IMAGE) continue;
+        registerTrackedResource(written_slot.resource);
+
+        const std::shared_ptr<VulkanImageBuffer> image = std::static_pointer_cast<VulkanImageBuffer>(written_slot.resource);
+        const VkImageLayout final_layout = render_pass_config->getAttachmentDescription(written_slot.attached_as).finalLayout;
+        VulkanLayoutTracker::Access pass_access = VulkanLayoutTracker::getAttachmentAccess(image->getImageConfig()->getImageInfo().format, final_layout);
+        pass_access.access = VulkanLayoutTracker::getWriteAccess(pass_access.access);
+        m_layout_tracker.setImageState(image->getImageBuffer(), whole_image, pass_access);
+    }
+}
+
+void VulkanRenderer::registerTrackedResource(const std::shared_ptr<RenderResource>& resource) {
+    if(resource->getType() == RenderResource::Type::BUFFER) {
+        const std::shared_ptr<VulkanBuffer> buffer = std::static_pointer_cast<VulkanBuffer>(resource);
+        if(!m_layout_tracker.isBufferRegistered(buffer->getBuffer())) {
+            m_layout_tracker.registerBuffer(buffer->getBuffer(), buffer->getAlignedSize());
+        }
+        return;
+    }
+
+    const std::shared_ptr<VulkanImageBuffer> image = std::static_pointer_cast<VulkanImageBuffer>(resource);
+    if(m_layout_tracker.isImageRegistered(image->getImageBuffer())) return;
+
+    const VkImageCreateInfo& image_info = image->getImageConfig()->getImageInfo();
+    m_layout_tracker.registerImage(
+        image->getImageBuffer(),
+        VulkanLayoutTracker::getFormatAspect(image_info.format),
+        image_info.mipLevels,
+        image_info.arrayLayers,
+        image->getImageConfig()->getAfterInitLayout()
+    );
+}
+
+void VulkanRenderer::unregisterTrackedResource(const std::shared_ptr<RenderResource>& resource) {
+    if(resource->getType() == RenderResource::Type::BUFFER) {
+        m_layout_tracker.unregisterBuffer(std::static_pointer_cast<VulkanBuffer>(resource)->getBuffer());
+        return;
+    }
+    m_layout_tracker.unregisterImage(std::static_pointer_cast<VulkanImageBuffer>(resource)->getImageBuffer());
+}
+
+void VulkanRenderer::recordRenderPass(CommandBatch& command_buffer, unsigned image_index, const VkRenderPassBeginInfo& renderpass_info) {
+    std::vector<SecondaryCommandPool>& secondary_pools = m_per_frame[image_index]->secondary_pools;
+    const size_t nodes_count = m_pass_nodes.size();
+    const size_t chunks_count = std::min(secondary_pools.size(), nodes_count / SECONDARY_RECORD_GRAIN);
+
+    if(chunks_count <= 1u) {
+        vkCmdBeginRenderPass(command_buffer.getCommandBufer(), &renderpass_info, VK_SUBPASS_CONTENTS_INLINE);
+        for(const std::shared_ptr<GraphicsRenderNode>& graphics_node : m_pass_nodes) {
+            graphics_node->record(command_buffer.getCommandBufer());
+        }
+        vkCmdEndRenderPass(command_buffer.getCommandBufer());
+        return;
+    }
+
+    VkCommandBufferInheritanceInfo inherit_info{};
+    inherit_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inherit_info.renderPass = renderpass_info.renderPass;
+    inherit_info.subpass = 0u;
+    inherit_info.framebuffer = renderpass_info.framebuffer;
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    begin_info.pInheritanceInfo = &inherit_info;
+
+    // Chunk i always records the i-th contiguous node range into a buffer of pool i, so executing the buffers in chunk
+    // order replays the nodes in the graph order regardless of which worker picked up which chunk.
+    m_pass_secondaries.assign(chunks_count, VK_NULL_HANDLE);
+    m_thread_pool->ParallelFor(0u, chunks_count, 1u, [&](size_t chunk) {
+        VkCommandBuffer secondary = secondary_pools[chunk].acquire(m_device->getDevice());
+        VkResult result = vkBeginCommandBuffer(secondary, &begin_info);
+        if(result != VK_SUCCESS) {
+            throw std::runtime_error("failed to begin recording secondary command buffer!");
+        }
+
+        const size_t first = chunk * nodes_count / chunks_count;
+        const size_t last = (chunk + 1u) * nodes_count / chunks_count;
+        for(size_t i = first; i < last; ++i) {
+            m_pass_nodes[i]->record(secondary);
+        }
+
+        result = vkEndCommandBuffer(secondary);
+        if(result != VK_SUCCESS) {
+            throw std::runtime_error("failed to record secondary command buffer!");
+        }
+        m_pass_secondaries[chunk] = secondary;
+    });
+
+    vkCmdBeginRenderPass(command_buffer.getCommandBufer(), &renderpass_info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    vkCmdExecuteCommands(command_buffer.getCommandBufer(), static_cast<uint32_t>(m_pass_secondaries.size()), m_pass_secondaries.data());
+    vkCmdEndRenderPass(command_buffer.getCommandBufer());
+}
+
 void VulkanRenderer::drawFrame(unsigned image_index) {
     uint32_t prev_frame = getPrevFrame();
 
@@ -269,6 +513,8 @@ void VulkanRenderer::drawFrame(unsigned image_index) {
     wait_info.wait_for_stages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
     VkSubmitInfo submit_info = m_per_frame[image_index]->command_buffer->getSubmitInfo(&wait_info);
 
+    // Uploads recorded since the last frame go first, their graphics side barriers order this frame behind them.
+    m_upload_manager->flush();
     m_command_manager->submitCommandBuffer(m_per_frame[image_index]->command_buffer, VulkanCommandManager::SELECT_ALL_BUFFERS, &submit_info);
 
     m_per_frame[image_index]->present_render_node->render(*m_per_frame[image_index]->command_buffer, image_index);
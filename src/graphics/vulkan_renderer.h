@@ -17,6 +17,7 @@
 #include "../window_surface.h"
 
 #include "api/vulkan_command_pool_type.h"
+#include "api/vulkan_layout_tracker.h"
 #include "../engine/views/iengine_view.h"
 
 class VulkanDevice;
@@ -33,10 +34,29 @@ class VulkanCommandManager;
 class VulkanRenderPassesManager;
 class VulkanFormatManager;
 class VulkanResourcesManager;
+class VulkanUploadManager;
+class VulkanTextureStreamer;
 class RenderNode;
 class RenderGraph;
+class RenderGraphTemplate;
+class DependencyLevel;
+class RenderResource;
 class VulkanRenderer;
 class PresentRenderNode;
+class GraphicsRenderNode;
+
+// Secondary command buffers of one recording slot, reset as a whole once the frame that used them has retired.
+// A pool is only ever touched by the worker recording its slot, so no locking is needed.
+struct SecondaryCommandPool {
+    bool init(VkDevice device, uint32_t family_index);
+    void destroy(VkDevice device);
+    void reset(VkDevice device);
+    VkCommandBuffer acquire(VkDevice device);
+
+    VkCommandPool pool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> buffers;
+    size_t used = 0u;
+};
 
 struct PerFrame {
     bool init(std::shared_ptr<VulkanDevice> device, unsigned index);
@@ -58,12 +78,16 @@ struct PerFrame {
     VkFence cmd_submit_finish_fence;
 
 	std::shared_ptr<CommandBatch> command_buffer;
+    std::vector<SecondaryCommandPool> secondary_pools;
     std::shared_ptr<PresentRenderNode> present_render_node;
     std::shared_ptr<RenderGraph> render_graph;
 };
 
 class VulkanRenderer {
 public:
+    // Render passes with fewer nodes than this are recorded inline, each secondary command buffer gets at least this many.
+    static constexpr size_t SECONDARY_RECORD_GRAIN = 32u;
+
     bool init(std::shared_ptr<VulkanDevice> device, std::shared_ptr<WindowSurface> window, std::shared_ptr<ThreadPool> thread_pool);
     void destroy();
 
@@ -79,6 +103,8 @@ public:
     std::shared_ptr<VulkanRenderPassesManager>& getRenderPassesManager();
     std::shared_ptr<VulkanFormatManager>& getFormatManager();
     std::shared_ptr<VulkanResourcesManager>& getResourcesManager();
+    std::shared_ptr<VulkanUploadManager>& getUploadManager();
+    std::shared_ptr<VulkanTextureStreamer>& getTextureStreamer(); // nullptr when texture streaming is disabled
 
     std::shared_ptr<VulkanImageBuffer>& getOutColorImage(uint32_t image_index);
     std::shared_ptr<VulkanImageBuffer>& getOutDepthImage(uint32_t image_index);
@@ -94,6 +120,11 @@ public:
 
 private:
     uint32_t getPrevFrame() const;
+    void recordRenderPass(CommandBatch& command_buffer, unsigned image_index, const VkRenderPassBeginInfo& renderpass_info);
+    void recordLevelBarriers(CommandBatch& command_buffer, const DependencyLevel& dependency_level);
+    void trackRenderPassFinalLayouts(const std::shared_ptr<GraphicsRenderNode>& graphics_node);
+    void registerTrackedResource(const std::shared_ptr<RenderResource>& resource);
+    void unregisterTrackedResource(const std::shared_ptr<RenderResource>& resource);
 
     std::shared_ptr<VulkanDevice> m_device;
     
@@ -110,8 +141,18 @@ private:
     std::shared_ptr<VulkanRenderPassesManager> m_render_passes_manager;
     std::shared_ptr<VulkanFormatManager> m_format_manager;
     std::shared_ptr<VulkanResourcesManager> m_resources_manager;
+    std::shared_ptr<VulkanUploadManager> m_upload_manager;
+    std::shared_ptr<VulkanTextureStreamer> m_texture_streamer;
+    std::vector<VkImage> m_retired_images;
 
+    std::shared_ptr<RenderGraphTemplate> m_render_graph_template;
+    std::shared_ptr<VulkanImageBuffer> m_out_color_image;
+    std::shared_ptr<VulkanImageBuffer> m_out_depth_image;
     std::shared_ptr<ThreadPool> m_thread_pool;
+    std::vector<std::shared_ptr<GraphicsRenderNode>> m_pass_nodes;
+    std::vector<VkCommandBuffer> m_pass_secondaries;
+    VulkanLayoutTracker m_layout_tracker; // Persists across frames, the frames' command buffers are submitted in recording order
+    VulkanLayoutTracker::Barriers m_level_barriers;
     uint32_t m_frame;
     std::vector<uint32_t> m_prev_frame;
 };
\ No newline at end of file
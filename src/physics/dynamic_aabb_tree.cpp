@@ -0,0 +1,509 @@
+#include "dynamic_aabb_tree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+void DynamicAABBTree::NodeStack::push(ProxyId id) {
+    if (m_size < m_inline.size()) {
+        m_inline[m_size] = id;
+    }
+    else {
+        m_spill.push_back(id);
+    }
+    ++m_size;
+}
+
+DynamicAABBTree::ProxyId DynamicAABBTree::NodeStack::pop() {
+    --m_size;
+    if (m_size < m_inline.size()) {
+        return m_inline[m_size];
+    }
+    const ProxyId id = m_spill.back();
+    m_spill.pop_back();
+    return id;
+}
+
+bool DynamicAABBTree::NodeStack::empty() const {
+    return m_size == 0u;
+}
+
+DynamicAABBTree::DynamicAABBTree(float margin) : m_margin(margin) {}
+
+DynamicAABBTree::ProxyId DynamicAABBTree::createProxy(const BoundingBox& box, uint32_t user_data) {
+    const ProxyId proxy_id = allocateNode();
+    TreeNode& node = m_nodes[proxy_id];
+    node.tight_lower = box.Center - box.Extents;
+    node.tight_upper = box.Center + box.Extents;
+    node.lower = node.tight_lower - glm::vec3(m_margin);
+    node.upper = node.tight_upper + glm::vec3(m_margin);
+    node.height = 0;
+    node.user_data = user_data;
+
+    insertLeaf(proxy_id);
+    ++m_proxy_count;
+    return proxy_id;
+}
+
+void DynamicAABBTree::destroyProxy(ProxyId proxy_id) {
+    if (proxy_id < 0 || static_cast<size_t>(proxy_id) >= m_nodes.size() || !m_nodes[proxy_id].isLeaf() || m_nodes[proxy_id].height != 0) {
+        throw std::runtime_error("invalid proxy passed to DynamicAABBTree::destroyProxy!");
+    }
+
+    removeLeaf(proxy_id);
+    freeNode(proxy_id);
+    --m_proxy_count;
+}
+
+bool DynamicAABBTree::moveProxy(ProxyId proxy_id, const BoundingBox& box) {
+    TreeNode& node = m_nodes[proxy_id];
+    node.tight_lower = box.Center - box.Extents;
+    node.tight_upper = box.Center + box.Extents;
+
+    const bool inside_fat =
+        glm::all(glm::greaterThanEqual(node.tight_lower, node.lower)) &&
+        glm::all(glm::lessThanEqual(node.tight_upper, node.upper));
+    if (inside_fat) return false;
+
+    removeLeaf(proxy_id);
+    TreeNode& moved = m_nodes[proxy_id];
+    moved.lower = moved.tight_lower - glm::vec3(m_margin);
+    moved.upper = moved.tight_upper + glm::vec3(m_margin);
+    insertLeaf(proxy_id);
+    return true;
+}
+
+void DynamicAABBTree::clear() {
+    m_nodes.clear();
+    m_root = NULL_NODE;
+    m_free_list = NULL_NODE;
+    m_proxy_count = 0u;
+}
+
+uint32_t DynamicAABBTree::getUserData(ProxyId proxy_id) const {
+    return m_nodes[proxy_id].user_data;
+}
+
+BoundingBox DynamicAABBTree::getFatBox(ProxyId proxy_id) const {
+    const TreeNode& node = m_nodes[proxy_id];
+    return BoundingBox((node.lower + node.upper) * 0.5f, (node.upper - node.lower) * 0.5f);
+}
+
+int DynamicAABBTree::getHeight() const {
+    return m_root == NULL_NODE ? 0 : m_nodes[m_root].height;
+}
+
+size_t DynamicAABBTree::getProxyCount() const {
+    return m_proxy_count;
+}
+
+// Sum of the internal node areas over the root area, the cost a query pays relative to a perfect single box.
+float DynamicAABBTree::getAreaRatio() const {
+    if (m_root == NULL_NODE) return 0.0f;
+
+    const float root_area = area(m_nodes[m_root].lower, m_nodes[m_root].upper);
+    if (root_area <= 0.0f) return 0.0f;
+
+    float total_area = 0.0f;
+    for (const TreeNode& node : m_nodes) {
+        if (node.height > 0) {
+            total_area += area(node.lower, node.upper);
+        }
+    }
+    return total_area / root_area;
+}
+
+// Planes point out of the frustum. A node entirely behind every plane has all of its leaves visible, so those are
+// collected without further plane tests, leaves that straddle a plane are tested with their tight box.
+size_t DynamicAABBTree::queryFrustum(const BoundingFrustum& frustum, uint32_t* out_user_data, size_t capacity) const {
+    if (m_root == NULL_NODE || capacity == 0u) return 0u;
+
+    std::array<glm::vec4, 6u> planes;
+    frustum.GetPlanes(&planes[0], &planes[1], &planes[2], &planes[3], &planes[4], &planes[5]);
+
+    // 0 outside, 1 intersecting, 2 inside
+    auto classify = [&planes](const glm::vec3& lower, const glm::vec3& upper) {
+        const glm::vec3 center = (lower + upper) * 0.5f;
+        const glm::vec3 extents = (upper - lower) * 0.5f;
+        int result = 2;
+        for (const glm::vec4& plane : planes) {
+            const float dist = glm::dot(glm::vec3(plane), center) + plane.w;
+            const float radius = glm::dot(glm::abs(glm::vec3(plane)), extents);
+            if (dist > radius) return 0;
+            if (dist > -radius) result = 1;
+        }
+        return result;
+    };
+
+    size_t count = 0u;
+    NodeStack stack;
+    NodeStack inside_stack;
+    stack.push(m_root);
+    while (!stack.empty() && count < capacity) {
+        const TreeNode& node = m_nodes[stack.pop()];
+        if (node.isLeaf()) {
+            if (classify(node.tight_lower, node.tight_upper) != 0) {
+                out_user_data[count++] = node.user_data;
+            }
+            continue;
+        }
+
+        const int containment = classify(node.lower, node.upper);
+        if (containment == 1) {
+            stack.push(node.child1);
+            stack.push(node.child2);
+        }
+        else if (containment == 2) {
+            inside_stack.push(node.child1);
+            inside_stack.push(node.child2);
+            while (!inside_stack.empty() && count < capacity) {
+                const TreeNode& inner = m_nodes[inside_stack.pop()];
+                if (inner.isLeaf()) {
+                    out_user_data[count++] = inner.user_data;
+                }
+                else {
+                    inside_stack.push(inner.child1);
+                    inside_stack.push(inner.child2);
+                }
+            }
+        }
+    }
+    return count;
+}
+
+size_t DynamicAABBTree::queryOverlap(const BoundingBox& box, uint32_t* out_user_data, size_t capacity) const {
+    if (m_root == NULL_NODE || capacity == 0u) return 0u;
+
+    const glm::vec3 lower = box.Center - box.Extents;
+    const glm::vec3 upper = box.Center + box.Extents;
+
+    size_t count = 0u;
+    NodeStack stack;
+    stack.push(m_root);
+    while (!stack.empty() && count < capacity) {
+        const TreeNode& node = m_nodes[stack.pop()];
+        if (!overlaps(node.lower, node.upper, lower, upper)) continue;
+
+        if (node.isLeaf()) {
+            if (overlaps(node.tight_lower, node.tight_upper, lower, upper)) {
+                out_user_data[count++] = node.user_data;
+            }
+        }
+        else {
+            stack.push(node.child1);
+            stack.push(node.child2);
+        }
+    }
+    return count;
+}
+
+// Hits are sorted by distance along the ray, the direction does not have to be normalized and distances are in
+// units of its length.
+size_t DynamicAABBTree::rayCast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, RayHit* out_hits, size_t capacity) const {
+    if (m_root == NULL_NODE || capacity == 0u) return 0u;
+
+    const glm::vec3 inv_direction = 1.0f / direction;
+
+    size_t count = 0u;
+    NodeStack stack;
+    stack.push(m_root);
+    while (!stack.empty() && count < capacity) {
+        const TreeNode& node = m_nodes[stack.pop()];
+        float distance;
+        if (!rayBox(origin, direction, inv_direction, node.lower, node.upper, max_distance, distance)) continue;
+
+        if (node.isLeaf()) {
+            if (rayBox(origin, direction, inv_direction, node.tight_lower, node.tight_upper, max_distance, distance)) {
+                out_hits[count++] = { node.user_data, distance };
+            }
+        }
+        else {
+            stack.push(node.child1);
+            stack.push(node.child2);
+        }
+    }
+
+    std::sort(out_hits, out_hits + count, [](const RayHit& a, const RayHit& b) { return a.distance < b.distance; });
+    return count;
+}
+
+bool DynamicAABBTree::rayCastClosest(const glm::vec3& origin, const glm::vec3& direction, float max_distance, RayHit& out_hit) const {
+    if (m_root == NULL_NODE) return false;
+
+    const glm::vec3 inv_direction = 1.0f / direction;
+
+    bool found = false;
+    float closest = max_distance;
+    NodeStack stack;
+    stack.push(m_root);
+    while (!stack.empty()) {
+        const TreeNode& node = m_nodes[stack.pop()];
+        float distance;
+        if (!rayBox(origin, direction, inv_direction, node.lower, node.upper, closest, distance)) continue;
+
+        if (node.isLeaf()) {
+            if (rayBox(origin, direction, inv_direction, node.tight_lower, node.tight_upper, closest, distance)) {
+                out_hit = { node.user_data, distance };
+                closest = distance;
+                found = true;
+            }
+            continue;
+        }
+
+        // Visit the nearer child first so the closest hit shrinks the ray early.
+        float distance1, distance2;
+        const TreeNode& child1 = m_nodes[node.child1];
+        const TreeNode& child2 = m_nodes[node.child2];
+        const bool hit1 = rayBox(origin, direction, inv_direction, child1.lower, child1.upper, closest, distance1);
+        const bool hit2 = rayBox(origin, direction, inv_direction, child2.lower, child2.upper, closest, distance2);
+        if (hit1 && hit2) {
+            if (distance1 < distance2) {
+                stack.push(node.child2);
+                stack.push(node.child1);
+            }
+            else {
+                stack.push(node.child1);
+                stack.push(node.child2);
+            }
+        }
+        else if (hit1) {
+            stack.push(node.child1);
+        }
+        else if (hit2) {
+            stack.push(node.child2);
+        }
+    }
+    return found;
+}
+
+DynamicAABBTree::ProxyId DynamicAABBTree::allocateNode() {
+    if (m_free_list == NULL_NODE) {
+        m_nodes.emplace_back();
+        return static_cast<ProxyId>(m_nodes.size() - 1u);
+    }
+
+    const ProxyId node_id = m_free_list;
+    m_free_list = m_nodes[node_id].parent;
+    m_nodes[node_id] = TreeNode{};
+    return node_id;
+}
+
+void DynamicAABBTree::freeNode(ProxyId node_id) {
+    TreeNode& node = m_nodes[node_id];
+    node.parent = m_free_list;
+    node.child1 = NULL_NODE;
+    node.child2 = NULL_NODE;
+    node.height = -1;
+    m_free_list = node_id;
+}
+
+// Branch and bound descent from Box2D: the cost of pairing the leaf with a node is the area of their union plus the
+// growth that union forces on every ancestor, the descent stops once no child can beat pairing with the current node.
+void DynamicAABBTree::insertLeaf(ProxyId leaf) {
+    if (m_root == NULL_NODE) {
+        m_root = leaf;
+        m_nodes[leaf].parent = NULL_NODE;
+        return;
+    }
+
+    const glm::vec3 leaf_lower = m_nodes[leaf].lower;
+    const glm::vec3 leaf_upper = m_nodes[leaf].upper;
+
+    ProxyId index = m_root;
+    while (!m_nodes[index].isLeaf()) {
+        const TreeNode& node = m_nodes[index];
+        const float node_area = area(node.lower, node.upper);
+        const float combined_area = area(glm::min(node.lower, leaf_lower), glm::max(node.upper, leaf_upper));
+
+        const float cost = 2.0f * combined_area;
+        const float inheritance_cost = 2.0f * (combined_area - node_area);
+
+        auto descend_cost = [&](ProxyId child_id) {
+            const TreeNode& child = m_nodes[child_id];
+            const float merged_area = area(glm::min(child.lower, leaf_lower), glm::max(child.upper, leaf_upper));
+            return child.isLeaf() ? merged_area + inheritance_cost : merged_area - area(child.lower, child.upper) + inheritance_cost;
+        };
+
+        const float cost1 = descend_cost(node.child1);
+        const float cost2 = descend_cost(node.child2);
+        if (cost < cost1 && cost < cost2) break;
+
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    const ProxyId sibling = index;
+    const ProxyId old_parent = m_nodes[sibling].parent;
+    const ProxyId new_parent = allocateNode();
+
+    TreeNode& parent = m_nodes[new_parent];
+    parent.parent = old_parent;
+    parent.child1 = sibling;
+    parent.child2 = leaf;
+    parent.lower = glm::min(m_nodes[sibling].lower, leaf_lower);
+    parent.upper = glm::max(m_nodes[sibling].upper, leaf_upper);
+    parent.height = m_nodes[sibling].height + 1;
+
+    if (old_parent != NULL_NODE) {
+        TreeNode& grand_parent = m_nodes[old_parent];
+        if (grand_parent.child1 == sibling) {
+            grand_parent.child1 = new_parent;
+        }
+        else {
+            grand_parent.child2 = new_parent;
+        }
+    }
+    else {
+        m_root = new_parent;
+    }
+    m_nodes[sibling].parent = new_parent;
+    m_nodes[leaf].parent = new_parent;
+
+    refitAncestors(old_parent);
+}
+
+void DynamicAABBTree::removeLeaf(ProxyId leaf) {
+    if (leaf == m_root) {
+        m_root = NULL_NODE;
+        return;
+    }
+
+    const ProxyId parent = m_nodes[leaf].parent;
+    const ProxyId grand_parent = m_nodes[parent].parent;
+    const ProxyId sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+    if (grand_parent != NULL_NODE) {
+        TreeNode& grand = m_nodes[grand_parent];
+        if (grand.child1 == parent) {
+            grand.child1 = sibling;
+        }
+        else {
+            grand.child2 = sibling;
+        }
+        m_nodes[sibling].parent = grand_parent;
+        freeNode(parent);
+        refitAncestors(grand_parent);
+    }
+    else {
+        m_root = sibling;
+        m_nodes[sibling].parent = NULL_NODE;
+        freeNode(parent);
+    }
+}
+
+void DynamicAABBTree::refitAncestors(ProxyId node_id) {
+    while (node_id != NULL_NODE) {
+        refit(node_id);
+        rotate(node_id);
+        node_id = m_nodes[node_id].parent;
+    }
+}
+
+void DynamicAABBTree::refit(ProxyId node_id) {
+    TreeNode& node = m_nodes[node_id];
+    const TreeNode& child1 = m_nodes[node.child1];
+    const TreeNode& child2 = m_nodes[node.child2];
+    node.lower = glm::min(child1.lower, child2.lower);
+    node.upper = glm::max(child1.upper, child2.upper);
+    node.height = 1 + std::max(child1.height, child2.height);
+}
+
+// Tree rotation from Box2D v3. With A's children B and C and their children D, E and F, G, swapping a child of A
+// with a grandchild under the other child only changes the box of that other child, so the rotation that shrinks
+// it the most is applied, if any does.
+void DynamicAABBTree::rotate(ProxyId node_id) {
+    const TreeNode& a = m_nodes[node_id];
+    const ProxyId b_id = a.child1;
+    const ProxyId c_id = a.child2;
+    const TreeNode& b = m_nodes[b_id];
+    const TreeNode& c = m_nodes[c_id];
+    if (b.isLeaf() && c.isLeaf()) return;
+
+    float best_delta = 0.0f;
+    ProxyId best_child = NULL_NODE;
+    ProxyId best_sibling = NULL_NODE;
+    ProxyId best_grandchild = NULL_NODE;
+
+    auto consider = [&](ProxyId child_id, ProxyId sibling_id) {
+        const TreeNode& child = m_nodes[child_id];
+        const TreeNode& sibling = m_nodes[sibling_id];
+        if (sibling.isLeaf()) return;
+
+        const float sibling_area = area(sibling.lower, sibling.upper);
+        const ProxyId grandchildren[2] = { sibling.child1, sibling.child2 };
+        for (size_t i = 0u; i < 2u; ++i) {
+            // child takes the place of grandchildren[i], so the sibling ends up around child and the other grandchild.
+            const TreeNode& kept = m_nodes[grandchildren[1u - i]];
+            const float delta = area(glm::min(child.lower, kept.lower), glm::max(child.upper, kept.upper)) - sibling_area;
+            if (delta < best_delta) {
+                best_delta = delta;
+                best_child = child_id;
+                best_sibling = sibling_id;
+                best_grandchild = grandchildren[i];
+            }
+        }
+    };
+
+    consider(b_id, c_id);
+    consider(c_id, b_id);
+
+    if (best_child != NULL_NODE) {
+        swapWithGrandchild(node_id, best_child, best_sibling, best_grandchild);
+    }
+}
+
+void DynamicAABBTree::swapWithGrandchild(ProxyId node_id, ProxyId child, ProxyId sibling, ProxyId grandchild) {
+    TreeNode& sibling_node = m_nodes[sibling];
+    if (sibling_node.child1 == grandchild) {
+        sibling_node.child1 = child;
+    }
+    else {
+        sibling_node.child2 = child;
+    }
+    m_nodes[child].parent = sibling;
+
+    TreeNode& node = m_nodes[node_id];
+    if (node.child1 == child) {
+        node.child1 = grandchild;
+    }
+    else {
+        node.child2 = grandchild;
+    }
+    m_nodes[grandchild].parent = node_id;
+
+    refit(sibling);
+    refit(node_id);
+}
+
+float DynamicAABBTree::area(const glm::vec3& lower, const glm::vec3& upper) {
+    const glm::vec3 d = upper - lower;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+bool DynamicAABBTree::overlaps(const glm::vec3& lower_a, const glm::vec3& upper_a, const glm::vec3& lower_b, const glm::vec3& upper_b) {
+    return
+        lower_a.x <= upper_b.x && upper_a.x >= lower_b.x &&
+        lower_a.y <= upper_b.y && upper_a.y >= lower_b.y &&
+        lower_a.z <= upper_b.z && upper_a.z >= lower_b.z;
+}
+
+// Slab test, axes the ray runs parallel to only check that the origin lies within the slab.
+bool DynamicAABBTree::rayBox(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& inv_direction, const glm::vec3& lower, const glm::vec3& upper, float max_distance, float& out_distance) {
+    float t_min = 0.0f;
+    float t_max = max_distance;
+    for (glm::length_t axis = 0; axis < 3; ++axis) {
+        if (std::fabs(direction[axis]) < std::numeric_limits<float>::epsilon()) {
+            if (origin[axis] < lower[axis] || origin[axis] > upper[axis]) return false;
+            continue;
+        }
+
+        float t1 = (lower[axis] - origin[axis]) * inv_direction[axis];
+        float t2 = (upper[axis] - origin[axis]) * inv_direction[axis];
+        if (t1 > t2) std::swap(t1, t2);
+        t_min = std::max(t_min, t1);
+        t_max = std::min(t_max, t2);
+        if (t_min > t_max) return false;
+    }
+    out_distance = t_min;
+    return true;
+}
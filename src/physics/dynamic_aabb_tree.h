@@ -0,0 +1,99 @@
+#pragma once
+
+#define GLM_ENABLE_EXPERIMENTAL
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#include <glm/glm.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "bounding_box.h"
+#include "bounding_frustum.h"
+
+// Incrementally maintained bounding volume hierarchy over axis aligned boxes (Catto, "Dynamic Bounding Volume
+// Hierarchies", GDC 2019). Leaves keep the tight box they were given and a fattened copy used by the tree, so small
+// motions only touch the leaf. Insertion descends by surface area cost and every refit on the way up tries the
+// rotation that lowers the area of the children the most. Queries write user data into caller provided buffers and
+// stop when the buffer is full, the returned count tells how much was written.
+class DynamicAABBTree {
+public:
+    using ProxyId = int32_t;
+    static constexpr ProxyId NULL_NODE = -1;
+    static constexpr float DEFAULT_MARGIN = 0.1f;
+
+    struct RayHit {
+        uint32_t user_data;
+        float distance;
+    };
+
+    DynamicAABBTree(float margin = DEFAULT_MARGIN);
+
+    ProxyId createProxy(const BoundingBox& box, uint32_t user_data);
+    void destroyProxy(ProxyId proxy_id);
+    // Returns true when the proxy left its fat box and was reinserted.
+    bool moveProxy(ProxyId proxy_id, const BoundingBox& box);
+    void clear();
+
+    uint32_t getUserData(ProxyId proxy_id) const;
+    BoundingBox getFatBox(ProxyId proxy_id) const;
+    int getHeight() const;
+    size_t getProxyCount() const;
+    float getAreaRatio() const;
+
+    size_t queryFrustum(const BoundingFrustum& frustum, uint32_t* out_user_data, size_t capacity) const;
+    size_t queryOverlap(const BoundingBox& box, uint32_t* out_user_data, size_t capacity) const;
+    size_t rayCast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, RayHit* out_hits, size_t capacity) const;
+    bool rayCastClosest(const glm::vec3& origin, const glm::vec3& direction, float max_distance, RayHit& out_hit) const;
+
+private:
+    struct TreeNode {
+        glm::vec3 lower;
+        glm::vec3 upper;
+        glm::vec3 tight_lower;
+        glm::vec3 tight_upper;
+        ProxyId parent = NULL_NODE; // next free node while on the free list
+        ProxyId child1 = NULL_NODE;
+        ProxyId child2 = NULL_NODE;
+        int32_t height = -1; // 0 for leaves, -1 for free nodes
+        uint32_t user_data = 0u;
+
+        bool isLeaf() const { return child1 == NULL_NODE; }
+    };
+
+    // Traversal stack that lives on the stack for any sane tree height and spills to the heap otherwise.
+    class NodeStack {
+    public:
+        void push(ProxyId id);
+        ProxyId pop();
+        bool empty() const;
+
+    private:
+        std::array<ProxyId, 128u> m_inline;
+        std::vector<ProxyId> m_spill;
+        size_t m_size = 0u;
+    };
+
+    ProxyId allocateNode();
+    void freeNode(ProxyId node_id);
+    void insertLeaf(ProxyId leaf);
+    void removeLeaf(ProxyId leaf);
+    void refitAncestors(ProxyId node_id);
+    void refit(ProxyId node_id);
+    void rotate(ProxyId node_id);
+    void swapWithGrandchild(ProxyId node_id, ProxyId child, ProxyId sibling, ProxyId grandchild);
+
+    static float area(const glm::vec3& lower, const glm::vec3& upper);
+    static bool overlaps(const glm::vec3& lower_a, const glm::vec3& upper_a, const glm::vec3& lower_b, const glm::vec3& upper_b);
+    static bool rayBox(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& inv_direction, const glm::vec3& lower, const glm::vec3& upper, float max_distance, float& out_distance);
+
+    std::vector<TreeNode> m_nodes;
+    ProxyId m_root = NULL_NODE;
+    ProxyId m_free_list = NULL_NODE;
+    size_t m_proxy_count = 0u;
+    float m_margin;
+};
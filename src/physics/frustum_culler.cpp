@@ -0,0 +1,143 @@
+#include "frustum_culler.h"
+
+#include <bit>
+#include <cmath>
+
+#include "../tools/simd_math.h"
+
+#if defined(MASIC_SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(MASIC_SIMD_SSE)
+#include <emmintrin.h>
+#endif
+
+void FrustumCuller::clear() {
+    m_center_x.clear();
+    m_center_y.clear();
+    m_center_z.clear();
+    m_extent_x.clear();
+    m_extent_y.clear();
+    m_extent_z.clear();
+}
+
+void FrustumCuller::reserve(size_t count) {
+    m_center_x.reserve(count);
+    m_center_y.reserve(count);
+    m_center_z.reserve(count);
+    m_extent_x.reserve(count);
+    m_extent_y.reserve(count);
+    m_extent_z.reserve(count);
+}
+
+uint32_t FrustumCuller::add(const BoundingBox& world_box) {
+    const uint32_t slot = static_cast<uint32_t>(m_center_x.size());
+    m_center_x.push_back(world_box.Center.x);
+    m_center_y.push_back(world_box.Center.y);
+    m_center_z.push_back(world_box.Center.z);
+    m_extent_x.push_back(world_box.Extents.x);
+    m_extent_y.push_back(world_box.Extents.y);
+    m_extent_z.push_back(world_box.Extents.z);
+    return slot;
+}
+
+// Arvo's method, the world extents are the local extents projected through the absolute 3x3 part.
+uint32_t FrustumCuller::add(const BoundingBox& local_box, const glm::mat4& to_world) {
+    const glm::vec3 center = glm::vec3(to_world * glm::vec4(local_box.Center, 1.0f));
+    const glm::vec3 extents =
+        glm::abs(glm::vec3(to_world[0])) * local_box.Extents.x +
+        glm::abs(glm::vec3(to_world[1])) * local_box.Extents.y +
+        glm::abs(glm::vec3(to_world[2])) * local_box.Extents.z;
+    return add(BoundingBox(center, extents));
+}
+
+uint32_t FrustumCuller::add(const BoundingSphere& world_sphere) {
+    return add(BoundingBox(world_sphere.Center, glm::vec3(world_sphere.Radius)));
+}
+
+void FrustumCuller::setFrustum(const BoundingFrustum& world_frustum) {
+    world_frustum.GetPlanes(&m_planes[0], &m_planes[1], &m_planes[2], &m_planes[3], &m_planes[4], &m_planes[5]);
+}
+
+size_t FrustumCuller::size() const {
+    return m_center_x.size();
+}
+
+// Planes point out of the frustum, a box is outside a plane when its center distance exceeds its projected radius.
+bool FrustumCuller::isVisible(size_t slot) const {
+    for (const glm::vec4& plane : m_planes) {
+        const float dist = m_center_x[slot] * plane.x + m_center_y[slot] * plane.y + m_center_z[slot] * plane.z + plane.w;
+        const float radius = m_extent_x[slot] * std::fabs(plane.x) + m_extent_y[slot] * std::fabs(plane.y) + m_extent_z[slot] * std::fabs(plane.z);
+        if (dist > radius) return false;
+    }
+    return true;
+}
+
+void FrustumCuller::cull(std::vector<uint32_t>& out_visible) const {
+    out_visible.clear();
+    const size_t count = size();
+    size_t slot = 0u;
+
+#if defined(MASIC_SIMD_AVX2)
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    for (; slot + 8u <= count; slot += 8u) {
+        const __m256 cx = _mm256_loadu_ps(m_center_x.data() + slot);
+        const __m256 cy = _mm256_loadu_ps(m_center_y.data() + slot);
+        const __m256 cz = _mm256_loadu_ps(m_center_z.data() + slot);
+        const __m256 ex = _mm256_loadu_ps(m_extent_x.data() + slot);
+        const __m256 ey = _mm256_loadu_ps(m_extent_y.data() + slot);
+        const __m256 ez = _mm256_loadu_ps(m_extent_z.data() + slot);
+
+        __m256 outside = _mm256_setzero_ps();
+        for (const glm::vec4& plane : m_planes) {
+            const __m256 px = _mm256_set1_ps(plane.x);
+            const __m256 py = _mm256_set1_ps(plane.y);
+            const __m256 pz = _mm256_set1_ps(plane.z);
+            __m256 dist = _mm256_add_ps(_mm256_mul_ps(cx, px), _mm256_set1_ps(plane.w));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(cy, py));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(cz, pz));
+            __m256 radius = _mm256_mul_ps(ex, _mm256_andnot_ps(sign_mask, px));
+            radius = _mm256_add_ps(radius, _mm256_mul_ps(ey, _mm256_andnot_ps(sign_mask, py)));
+            radius = _mm256_add_ps(radius, _mm256_mul_ps(ez, _mm256_andnot_ps(sign_mask, pz)));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(dist, radius, _CMP_GT_OQ));
+        }
+
+        for (uint32_t visible = ~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & 0xFFu; visible; visible &= visible - 1u) {
+            out_visible.push_back(static_cast<uint32_t>(slot) + std::countr_zero(visible));
+        }
+    }
+#elif defined(MASIC_SIMD_SSE)
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    for (; slot + 4u <= count; slot += 4u) {
+        const __m128 cx = _mm_loadu_ps(m_center_x.data() + slot);
+        const __m128 cy = _mm_loadu_ps(m_center_y.data() + slot);
+        const __m128 cz = _mm_loadu_ps(m_center_z.data() + slot);
+        const __m128 ex = _mm_loadu_ps(m_extent_x.data() + slot);
+        const __m128 ey = _mm_loadu_ps(m_extent_y.data() + slot);
+        const __m128 ez = _mm_loadu_ps(m_extent_z.data() + slot);
+
+        __m128 outside = _mm_setzero_ps();
+        for (const glm::vec4& plane : m_planes) {
+            const __m128 px = _mm_set1_ps(plane.x);
+            const __m128 py = _mm_set1_ps(plane.y);
+            const __m128 pz = _mm_set1_ps(plane.z);
+            __m128 dist = _mm_add_ps(_mm_mul_ps(cx, px), _mm_set1_ps(plane.w));
+            dist = _mm_add_ps(dist, _mm_mul_ps(cy, py));
+            dist = _mm_add_ps(dist, _mm_mul_ps(cz, pz));
+            __m128 radius = _mm_mul_ps(ex, _mm_andnot_ps(sign_mask, px));
+            radius = _mm_add_ps(radius, _mm_mul_ps(ey, _mm_andnot_ps(sign_mask, py)));
+            radius = _mm_add_ps(radius, _mm_mul_ps(ez, _mm_andnot_ps(sign_mask, pz)));
+            outside = _mm_or_ps(outside, _mm_cmpgt_ps(dist, radius));
+        }
+
+        for (uint32_t visible = ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xFu; visible; visible &= visible - 1u) {
+            out_visible.push_back(static_cast<uint32_t>(slot) + std::countr_zero(visible));
+        }
+    }
+#endif
+
+    for (; slot < count; ++slot) {
+        if (isVisible(slot)) {
+            out_visible.push_back(static_cast<uint32_t>(slot));
+        }
+    }
+}
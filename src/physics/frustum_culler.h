@@ -0,0 +1,49 @@
+#pragma once
+
+#define GLM_ENABLE_EXPERIMENTAL
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#include <glm/glm.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "bounding_box.h"
+#include "bounding_sphere.h"
+#include "bounding_frustum.h"
+
+// Batch frustum test for world space volumes. Volumes are gathered as axis aligned boxes into SoA arrays and tested
+// 8 (AVX2) or 4 (SSE) at a time against the six frustum planes. A volume is rejected only when it lies completely
+// outside one plane, the same rule BoundingBox::ContainedBy() uses for DISJOINT, so the test is conservative.
+class FrustumCuller {
+public:
+    void clear();
+    void reserve(size_t count);
+
+    // Returns the slot of the added volume, cull() reports visible volumes by that slot.
+    uint32_t add(const BoundingBox& world_box);
+    uint32_t add(const BoundingBox& local_box, const glm::mat4& to_world);
+    uint32_t add(const BoundingSphere& world_sphere);
+
+    void setFrustum(const BoundingFrustum& world_frustum);
+    void cull(std::vector<uint32_t>& out_visible) const;
+
+    size_t size() const;
+
+private:
+    bool isVisible(size_t slot) const;
+
+    std::vector<float> m_center_x;
+    std::vector<float> m_center_y;
+    std::vector<float> m_center_z;
+    std::vector<float> m_extent_x;
+    std::vector<float> m_extent_y;
+    std::vector<float> m_extent_z;
+
+    std::array<glm::vec4, 6u> m_planes;
+};
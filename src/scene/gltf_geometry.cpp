@@ -0,0 +1,182 @@
+#include "gltf_geometry.h"
+
+#include "../tools/thread_pool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+namespace {
+    constexpr float OVERDRAW_THRESHOLD = 1.05f; // ACMR given up for overdraw, at most 5%
+
+    const GltfVertexAttribute* findAttribute(const GltfVertexLayout& layout, const std::string& semantic) {
+        auto it = std::find_if(layout.attributes.begin(), layout.attributes.end(), [&semantic](const GltfVertexAttribute& attribute) {
+            return attribute.semantic == semantic;
+        });
+        return it != layout.attributes.end() ? &*it : nullptr;
+    }
+}
+
+VertexComponentType getVertexComponentType(int gltf_component_type) {
+    switch (gltf_component_type) {
+        case TINYGLTF_COMPONENT_TYPE_BYTE: return VertexComponentType::INT8;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: return VertexComponentType::UINT8;
+        case TINYGLTF_COMPONENT_TYPE_SHORT: return VertexComponentType::INT16;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: return VertexComponentType::UINT16;
+        case TINYGLTF_COMPONENT_TYPE_INT: return VertexComponentType::INT32;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: return VertexComponentType::UINT32;
+        case TINYGLTF_COMPONENT_TYPE_FLOAT: return VertexComponentType::FLOAT32;
+        default: return VertexComponentType::UNSUPPORTED;
+    }
+}
+
+size_t getGltfVertexCount(const tinygltf::Model& model, const tinygltf::Primitive& primitive) {
+    return model.accessors.at(primitive.attributes.at("POSITION")).count;
+}
+
+std::vector<uint32_t> convertGltfIndices(const tinygltf::Model& model, const tinygltf::Accessor& accessor) {
+    if (accessor.type != TINYGLTF_TYPE_SCALAR) return std::vector<uint32_t>();
+    if (accessor.componentType != TINYGLTF_COMPONENT_TYPE_BYTE &&
+        accessor.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE &&
+        accessor.componentType != TINYGLTF_COMPONENT_TYPE_SHORT &&
+        accessor.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT &&
+        accessor.componentType != TINYGLTF_COMPONENT_TYPE_INT &&
+        accessor.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT
+    ) return std::vector<uint32_t>();
+
+    const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
+    const tinygltf::Buffer& buffer = model.buffers[view.buffer];
+    const size_t component_size = static_cast<size_t>(tinygltf::GetComponentSizeInBytes(accessor.componentType));
+    const size_t stride = view.byteStride ? view.byteStride : component_size;
+    const unsigned char* src = buffer.data.data() + view.byteOffset + accessor.byteOffset;
+
+    std::vector<uint32_t> indices(accessor.count);
+    for (size_t i = 0u; i < accessor.count; ++i) {
+        switch (component_size) {
+            case 1u: indices[i] = *src; break;
+            case 2u: { uint16_t index; std::memcpy(&index, src, sizeof(index)); indices[i] = index; } break;
+            default: std::memcpy(&indices[i], src, sizeof(uint32_t)); break;
+        }
+        src += stride;
+    }
+    return indices;
+}
+
+// The conversion plan holds one stream per attribute the shader reads, each stream is then converted in a single pass.
+std::vector<char> convertGltfVertices(const tinygltf::Model& model, const tinygltf::Primitive& primitive, const GltfVertexLayout& layout) {
+    const size_t vertex_count = getGltfVertexCount(model, primitive);
+    std::vector<char> vertices(layout.vertex_size * vertex_count);
+
+    for (const GltfVertexAttribute& attribute : layout.attributes) {
+        auto accessor_it = primitive.attributes.find(attribute.semantic);
+        if (accessor_it == primitive.attributes.end()) continue;
+
+        const tinygltf::Accessor& accessor = model.accessors[accessor_it->second];
+        if (accessor.bufferView == -1) continue;
+
+        const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
+        const tinygltf::Buffer& buffer = model.buffers[view.buffer];
+        const size_t element_size = static_cast<size_t>(tinygltf::GetComponentSizeInBytes(accessor.componentType));
+        const size_t element_components = static_cast<size_t>(tinygltf::GetNumComponentsInType(accessor.type));
+
+        VertexAttributeStream stream;
+        stream.src = buffer.data.data() + accessor.byteOffset + view.byteOffset;
+        stream.src_stride = view.byteStride ? view.byteStride : element_size * element_components;
+        stream.src_type = getVertexComponentType(accessor.componentType);
+        stream.normalized = accessor.normalized;
+        stream.dst_offset = attribute.offset;
+        stream.dst_type = attribute.type;
+        stream.components = static_cast<uint32_t>(std::min<size_t>(element_components, attribute.components));
+        stream.count = std::min<size_t>(accessor.count, vertex_count);
+        convertVertexStream(stream, reinterpret_cast<unsigned char*>(vertices.data()), layout.vertex_size);
+    }
+    return vertices;
+}
+
+BoundingBox calculateGltfBoundingBox(const tinygltf::Model& model, const tinygltf::Primitive& primitive) {
+    const tinygltf::Accessor& pos_accessor = model.accessors.at(primitive.attributes.at("POSITION"));
+
+    glm::vec3 min_pos(std::numeric_limits<float>::max());
+    glm::vec3 max_pos(std::numeric_limits<float>::lowest());
+    if (pos_accessor.minValues.size() >= 3u && pos_accessor.maxValues.size() >= 3u) {
+        min_pos = glm::vec3(pos_accessor.minValues[0], pos_accessor.minValues[1], pos_accessor.minValues[2]);
+        max_pos = glm::vec3(pos_accessor.maxValues[0], pos_accessor.maxValues[1], pos_accessor.maxValues[2]);
+    }
+    else if (pos_accessor.bufferView != -1 && pos_accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT && pos_accessor.count > 0u) {
+        const tinygltf::BufferView& pos_view = model.bufferViews[pos_accessor.bufferView];
+        const tinygltf::Buffer& pos_buffer = model.buffers[pos_view.buffer];
+        const unsigned char* begin_ptr = pos_buffer.data.data() + pos_view.byteOffset + pos_accessor.byteOffset;
+        const size_t stride = pos_view.byteStride ? pos_view.byteStride : 3u * sizeof(float);
+
+        for (size_t i = 0u; i < pos_accessor.count; ++i) {
+            float pos[3];
+            std::memcpy(pos, begin_ptr + i * stride, sizeof(pos));
+            min_pos = glm::min(min_pos, glm::vec3(pos[0], pos[1], pos[2]));
+            max_pos = glm::max(max_pos, glm::vec3(pos[0], pos[1], pos[2]));
+        }
+    }
+    else {
+        return BoundingBox(glm::vec3(0.0f), glm::vec3(0.0f));
+    }
+
+    return BoundingBox((min_pos + max_pos) * 0.5f, (max_pos - min_pos) * 0.5f);
+}
+
+void optimizeGltfGeometry(GltfPrimitiveGeometry& geometry) {
+    const size_t vertex_size = geometry.layout.vertex_size;
+    const size_t vertex_count = vertex_size ? geometry.vertices.size() / vertex_size : 0u;
+    if (!vertex_count || geometry.indices.size() < 3u || geometry.indices.size() % 3u != 0u) return;
+    if (*std::max_element(geometry.indices.begin(), geometry.indices.end()) >= vertex_count) return;
+
+    geometry.cache_before = analyzeVertexCache(geometry.indices.data(), geometry.indices.size(), vertex_count);
+
+    std::vector<uint32_t> cache_order(geometry.indices.size());
+    optimizeVertexCache(cache_order.data(), geometry.indices.data(), geometry.indices.size(), vertex_count);
+
+    // Overdraw clusters are ranked by their positions, which have to be plain floats.
+    const GltfVertexAttribute* position = findAttribute(geometry.layout, "POSITION");
+    if (position && position->type == VertexComponentType::FLOAT32 && (position->components == 3u || position->components == 4u)) {
+        const unsigned char* positions = reinterpret_cast<const unsigned char*>(geometry.vertices.data()) + position->offset;
+        optimizeOverdraw(geometry.indices.data(), cache_order.data(), cache_order.size(), positions, vertex_size, vertex_count, OVERDRAW_THRESHOLD);
+    }
+    else {
+        geometry.indices.swap(cache_order);
+    }
+
+    std::vector<char> fetch_order(geometry.vertices.size());
+    const size_t used_vertices = optimizeVertexFetch(reinterpret_cast<unsigned char*>(fetch_order.data()), geometry.indices.data(), geometry.indices.size(), reinterpret_cast<const unsigned char*>(geometry.vertices.data()), vertex_count, vertex_size);
+    fetch_order.resize(used_vertices * vertex_size);
+    geometry.vertices.swap(fetch_order);
+
+    geometry.cache_after = analyzeVertexCache(geometry.indices.data(), geometry.indices.size(), used_vertices);
+    geometry.optimized = true;
+}
+
+void convertGltfPrimitives(const tinygltf::Model& model, std::vector<GltfPrimitiveGeometry>& geometries, ThreadPool* thread_pool) {
+    auto convert_primitive = [&model, &geometries](size_t geometry_idx) {
+        GltfPrimitiveGeometry& geometry = geometries[geometry_idx];
+        const tinygltf::Primitive& primitive = model.meshes[geometry.mesh_idx].primitives[geometry.primitive_idx];
+        if (primitive.indices != -1) {
+            geometry.indices = convertGltfIndices(model, model.accessors[primitive.indices]);
+        }
+        else {
+            geometry.indices = std::vector<uint32_t>(getGltfVertexCount(model, primitive));
+            std::iota(geometry.indices.begin(), geometry.indices.end(), 0u);
+        }
+        geometry.vertices = convertGltfVertices(model, primitive, geometry.layout);
+        geometry.aabb = calculateGltfBoundingBox(model, primitive);
+        if (geometry.optimize && primitive.mode == TINYGLTF_MODE_TRIANGLES) {
+            optimizeGltfGeometry(geometry);
+        }
+    };
+
+    if (thread_pool) {
+        thread_pool->ParallelFor(0u, geometries.size(), 1u, convert_primitive);
+    }
+    else {
+        for (size_t geometry_idx = 0u; geometry_idx < geometries.size(); ++geometry_idx) {
+            convert_primitive(geometry_idx);
+        }
+    }
+}
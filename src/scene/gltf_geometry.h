@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tiny_gltf.h"
+
+#include "mesh_optimizer.h"
+#include "vertex_stream_converter.h"
+#include "../physics/bounding_box.h"
+
+class ThreadPool;
+
+// Conversion of glTF primitives to the interleaved vertices and 32 bit indices the draws use. Only the parsed model is
+// read, so any number of primitives convert at once and the result does not depend on the thread doing the work.
+
+// An attribute of the shader vertex layout, resolved from its VertexFormat by MeshNodeLoader.
+struct GltfVertexAttribute {
+    std::string semantic; // glTF attribute name, TEXCOORD_0
+    size_t offset = 0u;
+    VertexComponentType type = VertexComponentType::UNSUPPORTED;
+    uint32_t components = 0u;
+};
+
+// Attributes of the layout the primitive has, the others are left zeroed.
+struct GltfVertexLayout {
+    size_t vertex_size = 0u;
+    std::vector<GltfVertexAttribute> attributes;
+};
+
+struct GltfPrimitiveGeometry {
+    int mesh_idx = -1;
+    int primitive_idx = -1;
+    GltfVertexLayout layout;
+    bool optimize = false; // Triangle lists only, see optimizeGltfGeometry()
+
+    std::vector<char> vertices;
+    std::vector<uint32_t> indices;
+    BoundingBox aabb;
+    bool optimized = false;
+    VertexCacheStats cache_before;
+    VertexCacheStats cache_after;
+};
+
+VertexComponentType getVertexComponentType(int gltf_component_type);
+size_t getGltfVertexCount(const tinygltf::Model& model, const tinygltf::Primitive& primitive);
+
+// Empty for index accessors that are not integer scalars.
+std::vector<uint32_t> convertGltfIndices(const tinygltf::Model& model, const tinygltf::Accessor& accessor);
+std::vector<char> convertGltfVertices(const tinygltf::Model& model, const tinygltf::Primitive& primitive, const GltfVertexLayout& layout);
+// POSITION accessors are required to carry min and max, the vertex scan is only a fallback for files that omit them.
+BoundingBox calculateGltfBoundingBox(const tinygltf::Model& model, const tinygltf::Primitive& primitive);
+
+// Triangles for the post-transform cache, then clusters of them against overdraw, then vertices in fetch order.
+// Vertices no index refers to are dropped. Primitives with out of range indices are left as they are.
+void optimizeGltfGeometry(GltfPrimitiveGeometry& geometry);
+
+// Fills in the geometry of mesh_idx and primitive_idx of each entry, every entry is its own task on thread_pool when
+// there is one.
+void convertGltfPrimitives(const tinygltf::Model& model, std::vector<GltfPrimitiveGeometry>& geometries, ThreadPool* thread_pool);
@@ -0,0 +1,337 @@
+#include "gltf_model_snapshot.h"
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <type_traits>
+
+namespace {
+    constexpr uint32_t SNAPSHOT_MAGIC = 0x464C5447u; // "GTLF"
+    constexpr uint32_t SNAPSHOT_VERSION = 1u; // Bumped whenever a field is added
+
+    // One field list per type serves both directions, the writer only reads the values it is given.
+    template<typename Archive>
+    void transferFields(Archive& archive, tinygltf::Buffer& buffer) {
+        archive.transfer(buffer.name);
+        archive.transfer(buffer.uri);
+        archive.transfer(buffer.data);
+    }
+
+    template<typename Archive>
+    void transferFields(Archive& archive, tinygltf::BufferView& view) {
+        archive.transfer(view.name);
+        archive.transfer(view.buffer);
+        archive.transfer(view.byteOffset);
+        archive.transfer(view.byteLength);
+        archive.transfer(view.byteStride);
+        archive.transfer(view.target);
+    }
+
+    template<typename Archive>
+    void transferFields(Archive& archive, tinygltf::Accessor& accessor) {
+        archive.transfer(accessor.name);
+        archive.transfer(accessor.bufferView);
+        archive.transfer(accessor.byteOffset);
+        archive.transfer(accessor.normalized);
+        archive.transfer(accessor.componentType);
+        archive.transfer(accessor.count);
+        archive.transfer(accessor.type);
+        archive.transfer(accessor.minValues);
+        archive.transfer(accessor.maxValues);
+    }
+
+    template<typename Archive>
+    void transferFields(Archive& archive, tinygltf::Primitive& primitive) {
+        archive.transfer(primitive.attributes);
+        archive.transfer(primitive.material);
+        archive.transfer(primitive.indices);
+        archive.transfer(primitive.mode);
+    }
+
+    template<typename Archive>
+    void transferFields(Archive& archive, tinygltf::Mesh& mesh) {
+        archive.transfer(mesh.name);
+        archive.transfer(mesh.primitives);
+    }
+
+    template<typename Archive>
+    void transferFields(Archive& archive, tinygltf::Node& node) {
+        archive.transfer(node.name);
+        archive.transfer(node.camera);
+        archive.transfer(node.skin);
+        archive.transfer(node.mesh);
+        archive.transfer(node.children);
+        archive.transfer(node.rotation);
+        archive.transfer(node.scale);
+        archive.transfer(node.translation);
+        archive.transfer(node.matrix);
+        archive.transfer(node.extensions_json_string);
+    }
+
+    template<typename Archive>
+    void transferFields(Archive& archive, tinygltf::Skin& skin) {
+        archive.transfer(skin.name);
+        archive.transfer(skin.inverseBindMatrices);
+        archive.transfer(skin.skeleton);
+        archive.transfer(skin.joints);
+    }
+
+    template<typename Archive>
+    void transferFields(Archive& archive, tinygltf::Scene& scene) {
+        archive.transfer(scene.name);
+        archive.transfer(scene.nodes);
+    }
+
+    template<typename Archive>
+    void transferFields(Archive& archive, tinygltf::AnimationChannel& channel) {
+        archive.transfer(channel.sampler);
+        archive.transfer(channel.target_node);
+        archive.transfer(channel.target_path);
+    }
+
+    template<typename Archive>
+    void transferFields(Archive& archive, tinygltf::AnimationSampler& sampler) {
+        archive.transfer(sampler.input);
+        archive.transfer(sampler.output);
+        archive.transfer(sampler.interpolation);
+    }
+
+    template<typename Archive>
+    void transferFields(Archive& archive, tinygltf::Animation& animation) {
+        archive.transfer(animation.name);
+        archive.transfer(animation.channels);
+        archive.transfer(animation.samplers);
+    }
+
+    template<typename Archive>
+    void transferFields(Archive& archive, tinygltf::Material& material) {
+        archive.transfer(material.name);
+        archive.transfer(material.pbrMetallicRoughness.baseColorFactor);
+        archive.transfer(material.pbrMetallicRoughness.baseColorTexture.index);
+        archive.transfer(material.pbrMetallicRoughness.baseColorTexture.texCoord);
+        archive.transfer(material.pbrMetallicRoughness.metallicFactor);
+        archive.transfer(material.pbrMetallicRoughness.roughnessFactor);
+        archive.transfer(material.pbrMetallicRoughness.metallicRoughnessTexture.index);
+        archive.transfer(material.pbrMetallicRoughness.metallicRoughnessTexture.texCoord);
+        archive.transfer(material.normalTexture.index);
+        archive.transfer(material.normalTexture.texCoord);
+        archive.transfer(material.normalTexture.scale);
+        archive.transfer(material.occlusionTexture.index);
+        archive.transfer(material.occlusionTexture.texCoord);
+        archive.transfer(material.occlusionTexture.strength);
+        archive.transfer(material.emissiveTexture.index);
+        archive.transfer(material.emissiveTexture.texCoord);
+        archive.transfer(material.emissiveFactor);
+        archive.transfer(material.alphaMode);
+        archive.transfer(material.alphaCutoff);
+        archive.transfer(material.doubleSided);
+        archive.transfer(material.extensions_json_string);
+    }
+
+    template<typename Archive>
+    void transferFields(Archive& archive, tinygltf::Texture& texture) {
+        archive.transfer(texture.name);
+        archive.transfer(texture.source);
+        archive.transfer(texture.sampler);
+    }
+
+    template<typename Archive>
+    void transferFields(Archive& archive, tinygltf::Image& image) {
+        archive.transfer(image.name);
+        archive.transfer(image.width);
+        archive.transfer(image.height);
+        archive.transfer(image.component);
+        archive.transfer(image.bits);
+        archive.transfer(image.pixel_type);
+        archive.transfer(image.image);
+        archive.transfer(image.bufferView);
+        archive.transfer(image.mimeType);
+        archive.transfer(image.uri);
+    }
+
+    template<typename Archive>
+    void transferFields(Archive& archive, tinygltf::Sampler& sampler) {
+        archive.transfer(sampler.name);
+        archive.transfer(sampler.minFilter);
+        archive.transfer(sampler.magFilter);
+        archive.transfer(sampler.wrapS);
+        archive.transfer(sampler.wrapT);
+    }
+
+    // The loader parses extensions from the original JSON, the map only tells which ones the model has.
+    template<typename Archive>
+    void transferFields(Archive& archive, tinygltf::Model& model) {
+        archive.transfer(model.buffers);
+        archive.transfer(model.bufferViews);
+        archive.transfer(model.accessors);
+        archive.transfer(model.meshes);
+        archive.transfer(model.nodes);
+        archive.transfer(model.skins);
+        archive.transfer(model.scenes);
+        archive.transfer(model.animations);
+        archive.transfer(model.materials);
+        archive.transfer(model.textures);
+        archive.transfer(model.images);
+        archive.transfer(model.samplers);
+        archive.transfer(model.defaultScene);
+        archive.transfer(model.extensions);
+        archive.transfer(model.extensions_json_string);
+    }
+
+    class SnapshotWriter {
+    public:
+        template<typename T> requires std::is_arithmetic_v<T>
+        void transfer(const T& value) {
+            append(&value, sizeof(T));
+        }
+
+        void transfer(const std::string& value) {
+            transfer(static_cast<uint64_t>(value.size()));
+            append(value.data(), value.size());
+        }
+
+        template<typename T> requires std::is_arithmetic_v<T>
+        void transfer(std::vector<T>& values) {
+            transfer(static_cast<uint64_t>(values.size()));
+            append(values.data(), values.size() * sizeof(T));
+        }
+
+        template<typename T>
+        void transfer(std::vector<T>& values) {
+            transfer(static_cast<uint64_t>(values.size()));
+            for (T& value : values) {
+                transferFields(*this, value);
+            }
+        }
+
+        template<typename T>
+        void transfer(std::map<std::string, T>& values) {
+            transfer(static_cast<uint64_t>(values.size()));
+            for (auto&[key, value] : values) {
+                transfer(key);
+                if constexpr (std::is_arithmetic_v<T>) {
+                    transfer(value);
+                }
+            }
+        }
+
+        std::vector<char>& getData() {
+            return m_data;
+        }
+
+    private:
+        void append(const void* data, size_t size) {
+            const char* bytes = static_cast<const char*>(data);
+            m_data.insert(m_data.end(), bytes, bytes + size);
+        }
+
+        std::vector<char> m_data;
+    };
+
+    // Every read is checked against the end of the data, the first one past it fails the rest.
+    class SnapshotReader {
+    public:
+        SnapshotReader(const unsigned char* data, size_t size) : m_data(data), m_size(size) {}
+
+        template<typename T> requires std::is_arithmetic_v<T>
+        void transfer(T& value) {
+            take(&value, sizeof(T));
+        }
+
+        void transfer(std::string& value) {
+            const size_t size = takeCount(1u);
+            value.resize(size);
+            take(value.data(), size);
+        }
+
+        template<typename T> requires std::is_arithmetic_v<T>
+        void transfer(std::vector<T>& values) {
+            const size_t count = takeCount(sizeof(T));
+            values.resize(count);
+            take(values.data(), count * sizeof(T));
+        }
+
+        // Every element takes at least a byte, a count larger than the rest of the data is damage.
+        template<typename T>
+        void transfer(std::vector<T>& values) {
+            const size_t count = takeCount(1u);
+            values.clear();
+            values.resize(count);
+            for (T& value : values) {
+                transferFields(*this, value);
+            }
+        }
+
+        template<typename T>
+        void transfer(std::map<std::string, T>& values) {
+            const size_t count = takeCount(1u);
+            values.clear();
+            for (size_t i = 0u; i < count && m_ok; ++i) {
+                std::string key;
+                transfer(key);
+                T& value = values[key];
+                if constexpr (std::is_arithmetic_v<T>) {
+                    transfer(value);
+                }
+            }
+        }
+
+        bool isOk() const {
+            return m_ok;
+        }
+
+        bool isAtEnd() const {
+            return m_offset == m_size;
+        }
+
+    private:
+        size_t takeCount(size_t element_size) {
+            uint64_t count = 0u;
+            transfer(count);
+            if (count > (m_size - m_offset) / element_size) {
+                m_ok = false;
+                return 0u;
+            }
+            return static_cast<size_t>(count);
+        }
+
+        void take(void* data, size_t size) {
+            if (!m_ok || size > m_size - m_offset) {
+                m_ok = false;
+                return;
+            }
+            if (size) {
+                memcpy(data, m_data + m_offset, size);
+            }
+            m_offset += size;
+        }
+
+        const unsigned char* m_data;
+        size_t m_size;
+        size_t m_offset = 0u;
+        bool m_ok = true;
+    };
+}
+
+std::vector<char> writeGltfModelSnapshot(const tinygltf::Model& model) {
+    SnapshotWriter writer;
+    writer.transfer(SNAPSHOT_MAGIC);
+    writer.transfer(SNAPSHOT_VERSION);
+    // The field lists take the model by reference for the reader, the writer does not change it.
+    transferFields(writer, const_cast<tinygltf::Model&>(model));
+    return std::move(writer.getData());
+}
+
+bool readGltfModelSnapshot(const unsigned char* data, size_t size, tinygltf::Model& model) {
+    SnapshotReader reader(data, size);
+    uint32_t magic = 0u;
+    uint32_t version = 0u;
+    reader.transfer(magic);
+    reader.transfer(version);
+    if (!reader.isOk() || magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION) return false;
+
+    model = tinygltf::Model{};
+    transferFields(reader, model);
+    return reader.isOk() && reader.isAtEnd();
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "tiny_gltf.h"
+
+// Binary copy of the parts of a parsed glTF model that MeshNodeLoader reads: hierarchy, meshes, materials, textures,
+// skins, animations and the buffers their accessors point into. Reading it back is a few copies where tinygltf parses
+// JSON and decodes base64, MeshCache keeps it next to the converted geometry.
+// Images are stored as they are when the snapshot is written, the loader writes it before decoding them.
+
+std::vector<char> writeGltfModelSnapshot(const tinygltf::Model& model);
+// Truncated or damaged data fails and leaves the model in an unspecified state.
+bool readGltfModelSnapshot(const unsigned char* data, size_t size, tinygltf::Model& model);
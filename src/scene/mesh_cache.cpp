@@ -0,0 +1,281 @@
+#include "mesh_cache.h"
+
+#include "gltf_geometry.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+    constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+    constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+    uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for(size_t i = 0u; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    template<typename T>
+    uint64_t fnv1a(uint64_t hash, const T& value) {
+        return fnv1a(hash, &value, sizeof(T));
+    }
+}
+
+std::filesystem::path MeshCache::makeCachePath(const std::filesystem::path& model_path) {
+    std::filesystem::path cache_path = model_path;
+    cache_path.replace_extension(".meshcache");
+    return cache_path;
+}
+
+uint64_t MeshCache::makeSourceStamp(const std::filesystem::path& model_path, const std::vector<std::string>& external_uris) {
+    // Missing files stamp as the error values, the cache is then stale until they are back.
+    auto stamp_file = [](uint64_t hash, const std::filesystem::path& path) {
+        std::error_code error;
+        const uint64_t file_size = std::filesystem::file_size(path, error);
+        const int64_t write_time = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+        hash = fnv1a(hash, file_size);
+        return fnv1a(hash, write_time);
+    };
+
+    uint64_t hash = stamp_file(FNV_OFFSET_BASIS, model_path);
+    for(const std::string& uri : external_uris) {
+        if(uri.empty() || uri.starts_with("data:")) continue;
+
+        hash = fnv1a(hash, uri.data(), uri.size());
+        hash = stamp_file(hash, model_path.parent_path() / uri);
+    }
+    return hash;
+}
+
+uint64_t MeshCache::makeKey(int mesh_idx, size_t primitive_idx, const GltfVertexLayout& vertex_layout, bool optimized) {
+    uint64_t hash = fnv1a(FNV_OFFSET_BASIS, mesh_idx);
+    hash = fnv1a(hash, static_cast<uint64_t>(primitive_idx));
+    hash = fnv1a(hash, static_cast<uint64_t>(optimized));
+    hash = fnv1a(hash, static_cast<uint64_t>(vertex_layout.vertex_size));
+    // The attributes the primitive has are all the conversion writes, the rest of the vertex stays zeroed.
+    for(const GltfVertexAttribute& attribute : vertex_layout.attributes) {
+        hash = fnv1a(hash, attribute.semantic.data(), attribute.semantic.size());
+        hash = fnv1a(hash, static_cast<uint64_t>(attribute.offset));
+        hash = fnv1a(hash, attribute.type);
+        hash = fnv1a(hash, attribute.components);
+    }
+    return hash;
+}
+
+bool MeshCache::open(const std::filesystem::path& cache_path, const std::filesystem::path& model_path) {
+    m_cache_path = cache_path;
+    m_model_path = model_path;
+    m_source_stamp = 0u;
+    m_external_uris.clear();
+    m_model = nullptr;
+    m_model_size = 0u;
+    m_pending_model.clear();
+    m_model_changed = false;
+    m_entries.clear();
+    m_pending.clear();
+
+    if(!m_file.open(cache_path.string())) return false;
+
+    FileHeader header{};
+    if(m_file.size() < sizeof(FileHeader)) {
+        m_file.close();
+        return false;
+    }
+    memcpy(&header, m_file.data(), sizeof(FileHeader));
+    if(header.magic != MAGIC || header.version != VERSION || header.entry_count > m_file.size() / sizeof(Entry) ||
+       !isInFile(header.entries_offset, header.entry_count * sizeof(Entry)) || !isInFile(header.uris_offset, header.uris_size) ||
+       !isInFile(header.model_offset, header.model_size)) {
+        m_file.close();
+        return false;
+    }
+
+    // The uris are stored null terminated, one after another.
+    std::vector<std::string> external_uris;
+    const char* uris = reinterpret_cast<const char*>(m_file.data() + header.uris_offset);
+    for(uint64_t uri_offset = 0u; uri_offset < header.uris_size;) {
+        const void* uri_end = memchr(uris + uri_offset, '\0', header.uris_size - uri_offset);
+        if(!uri_end) {
+            m_file.close();
+            return false;
+        }
+        const size_t uri_size = static_cast<const char*>(uri_end) - (uris + uri_offset);
+        external_uris.emplace_back(uris + uri_offset, uri_size);
+        uri_offset += uri_size + 1u;
+    }
+    if(header.source_stamp != makeSourceStamp(model_path, external_uris)) {
+        m_file.close();
+        return false;
+    }
+
+    const Entry* entries = reinterpret_cast<const Entry*>(m_file.data() + header.entries_offset);
+    for(uint64_t i = 0u; i < header.entry_count; ++i) {
+        const Entry& entry = entries[i];
+        const bool indices_fit = entry.index_count <= m_file.size() / sizeof(uint32_t);
+        if(!isInFile(entry.vertex_offset, entry.vertex_size) || !indices_fit || !isInFile(entry.index_offset, entry.index_count * sizeof(uint32_t))) {
+            m_entries.clear();
+            m_file.close();
+            return false;
+        }
+        m_entries.insert({entry.key, entry});
+    }
+
+    m_source_stamp = header.source_stamp;
+    m_external_uris = std::move(external_uris);
+    m_model = m_file.data() + header.model_offset;
+    m_model_size = header.model_size;
+    return true;
+}
+
+bool MeshCache::findModel(const unsigned char*& snapshot, size_t& snapshot_size) const {
+    if(!m_model_size) return false;
+
+    snapshot = m_model;
+    snapshot_size = m_model_size;
+    return true;
+}
+
+void MeshCache::setModel(std::vector<char> snapshot, std::vector<std::string> external_uris) {
+    m_pending_model = std::move(snapshot);
+    m_model = reinterpret_cast<const unsigned char*>(m_pending_model.data());
+    m_model_size = m_pending_model.size();
+    m_external_uris = std::move(external_uris);
+    m_source_stamp = makeSourceStamp(m_model_path, m_external_uris);
+    m_model_changed = true;
+}
+
+bool MeshCache::find(uint64_t key, Primitive& primitive) const {
+    auto it = m_entries.find(key);
+    if(it == m_entries.end()) return false;
+
+    const Entry& entry = it->second;
+    primitive.vertices = m_file.data() + entry.vertex_offset;
+    primitive.vertices_size = entry.vertex_size;
+    primitive.indices = reinterpret_cast<const uint32_t*>(m_file.data() + entry.index_offset);
+    primitive.index_count = entry.index_count;
+    primitive.aabb = BoundingBox(
+        glm::vec3(entry.aabb_center[0], entry.aabb_center[1], entry.aabb_center[2]),
+        glm::vec3(entry.aabb_extents[0], entry.aabb_extents[1], entry.aabb_extents[2])
+    );
+    return true;
+}
+
+MeshCache::Primitive MeshCache::add(uint64_t key, std::vector<char> vertices, std::vector<uint32_t> indices, const BoundingBox& aabb) {
+    // Moving the pending entries around keeps the blobs where they are, so the view survives later additions.
+    PendingPrimitive& pending = m_pending.emplace_back(PendingPrimitive{key, std::move(vertices), std::move(indices), aabb});
+
+    Primitive primitive;
+    primitive.vertices = pending.vertices.data();
+    primitive.vertices_size = pending.vertices.size();
+    primitive.indices = pending.indices.data();
+    primitive.index_count = pending.indices.size();
+    primitive.aabb = aabb;
+    return primitive;
+}
+
+bool MeshCache::hasPendingChanges() const {
+    return m_model_changed || !m_pending.empty();
+}
+
+void MeshCache::save() {
+    std::unordered_map<uint64_t, const PendingPrimitive*> pending_keys;
+    for(const PendingPrimitive& pending : m_pending) {
+        pending_keys.insert({pending.key, &pending});
+    }
+
+    std::vector<Entry> entries;
+    entries.reserve(m_entries.size() + pending_keys.size());
+    for(const auto&[key, entry] : m_entries) {
+        if(!pending_keys.contains(key)) {
+            entries.push_back(entry);
+        }
+    }
+    const size_t mapped_count = entries.size();
+    for(const auto&[key, pending] : pending_keys) {
+        Entry entry{};
+        entry.key = key;
+        entry.vertex_size = pending->vertices.size();
+        entry.index_count = pending->indices.size();
+        entry.aabb_center[0] = pending->aabb.Center.x;
+        entry.aabb_center[1] = pending->aabb.Center.y;
+        entry.aabb_center[2] = pending->aabb.Center.z;
+        entry.aabb_extents[0] = pending->aabb.Extents.x;
+        entry.aabb_extents[1] = pending->aabb.Extents.y;
+        entry.aabb_extents[2] = pending->aabb.Extents.z;
+        entries.push_back(entry);
+    }
+
+    std::string uris;
+    for(const std::string& uri : m_external_uris) {
+        uris.append(uri.c_str(), uri.size() + 1u);
+    }
+
+    FileHeader header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.source_stamp = m_source_stamp;
+    header.entry_count = entries.size();
+    header.entries_offset = alignOffset(sizeof(FileHeader));
+    header.uris_offset = alignOffset(header.entries_offset + entries.size() * sizeof(Entry));
+    header.uris_size = uris.size();
+    header.model_offset = alignOffset(header.uris_offset + header.uris_size);
+    header.model_size = m_model_size;
+
+    uint64_t file_size = alignOffset(header.model_offset + header.model_size);
+    std::vector<const void*> vertex_sources(entries.size());
+    std::vector<const void*> index_sources(entries.size());
+    for(size_t i = 0u; i < entries.size(); ++i) {
+        Entry& entry = entries[i];
+        if(i < mapped_count) {
+            vertex_sources[i] = m_file.data() + entry.vertex_offset;
+            index_sources[i] = m_file.data() + entry.index_offset;
+        }
+        else {
+            const PendingPrimitive* pending = pending_keys.at(entry.key);
+            vertex_sources[i] = pending->vertices.data();
+            index_sources[i] = pending->indices.data();
+        }
+
+        entry.vertex_offset = file_size;
+        file_size = alignOffset(file_size + entry.vertex_size);
+        entry.index_offset = file_size;
+        file_size = alignOffset(file_size + entry.index_count * sizeof(uint32_t));
+    }
+
+    std::vector<char> file_data(file_size, 0);
+    memcpy(file_data.data(), &header, sizeof(FileHeader));
+    memcpy(file_data.data() + header.entries_offset, entries.data(), entries.size() * sizeof(Entry));
+    memcpy(file_data.data() + header.uris_offset, uris.data(), uris.size());
+    if(m_model_size) {
+        memcpy(file_data.data() + header.model_offset, m_model, m_model_size);
+    }
+    for(size_t i = 0u; i < entries.size(); ++i) {
+        memcpy(file_data.data() + entries[i].vertex_offset, vertex_sources[i], entries[i].vertex_size);
+        memcpy(file_data.data() + entries[i].index_offset, index_sources[i], entries[i].index_count * sizeof(uint32_t));
+    }
+
+    // The old file may still be mapped, it has to be released before it can be replaced.
+    m_entries.clear();
+    m_pending.clear();
+    m_model = nullptr;
+    m_model_size = 0u;
+    m_pending_model.clear();
+    m_model_changed = false;
+    m_file.close();
+    std::ofstream file(m_cache_path, std::ios::out | std::ios::trunc | std::ios::binary);
+    if(!file.is_open()) {
+        throw std::runtime_error("failed to open file: " + m_cache_path.string() + " !");
+    }
+    file.write(file_data.data(), static_cast<std::streamsize>(file_data.size()));
+}
+
+uint64_t MeshCache::alignOffset(uint64_t offset) {
+    return (offset + SECTION_ALIGNMENT - 1u) & ~(SECTION_ALIGNMENT - 1u);
+}
+
+bool MeshCache::isInFile(uint64_t offset, uint64_t size) const {
+    return offset <= m_file.size() && size <= m_file.size() - offset;
+}
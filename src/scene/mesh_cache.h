@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../physics/bounding_box.h"
+#include "../tools/mapped_file.h"
+
+struct GltfVertexLayout;
+
+// Everything MeshNodeLoader takes from one model that does not depend on the device: a snapshot of the parsed glTF
+// model, see gltf_model_snapshot.h, and the primitive geometry already converted to the vertex layout of the shader
+// that draws it. A hit skips the tinygltf parse as well as the conversion. The file sits next to the model and is
+// memory mapped, hits hand out pointers into the mapping that go straight to staging.
+// The file is checked against the size and write time of the model and of the external buffers and images it lists,
+// nothing of the sources is read to open it.
+// Layout: FileHeader | Entry[entry_count] | external uris | model snapshot | vertex and index blobs, every section
+// aligned to SECTION_ALIGNMENT.
+class MeshCache {
+public:
+    static constexpr uint32_t MAGIC = 0x4853454Du; // "MESH"
+    static constexpr uint32_t VERSION = 5u; // Bumped whenever the layout or the vertex conversion changes
+    static constexpr uint64_t SECTION_ALIGNMENT = 64u;
+
+    struct Primitive {
+        const void* vertices = nullptr;
+        size_t vertices_size = 0u;
+        const uint32_t* indices = nullptr;
+        size_t index_count = 0u;
+        BoundingBox aabb;
+    };
+
+    static std::filesystem::path makeCachePath(const std::filesystem::path& model_path);
+    // Size and write time of the model file and of the external files it references, relative to the model.
+    static uint64_t makeSourceStamp(const std::filesystem::path& model_path, const std::vector<std::string>& external_uris);
+    // Optimized primitives have their own entries, see MeshNodeLoader::SetOptimizeMeshes.
+    static uint64_t makeKey(int mesh_idx, size_t primitive_idx, const GltfVertexLayout& vertex_layout, bool optimized);
+
+    // A missing, stale or damaged file leaves the cache empty, everything then goes through setModel(), add() and save().
+    bool open(const std::filesystem::path& cache_path, const std::filesystem::path& model_path);
+    // The returned snapshot stays valid until save().
+    bool findModel(const unsigned char*& snapshot, size_t& snapshot_size) const;
+    // external_uris are the buffers and images the model was parsed from besides its own file, data uris are skipped.
+    void setModel(std::vector<char> snapshot, std::vector<std::string> external_uris);
+    bool find(uint64_t key, Primitive& primitive) const;
+    // The returned view stays valid until save().
+    Primitive add(uint64_t key, std::vector<char> vertices, std::vector<uint32_t> indices, const BoundingBox& aabb);
+
+    bool hasPendingChanges() const;
+    // Writes the model and the mapped and added primitives to a new file, the mapping is released.
+    void save();
+
+private:
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t source_stamp;
+        uint64_t entry_count;
+        uint64_t entries_offset;
+        uint64_t uris_offset;
+        uint64_t uris_size;
+        uint64_t model_offset;
+        uint64_t model_size;
+    };
+
+    struct Entry {
+        uint64_t key;
+        uint64_t vertex_offset;
+        uint64_t vertex_size;
+        uint64_t index_offset;
+        uint64_t index_count;
+        float aabb_center[3];
+        float aabb_extents[3];
+    };
+    static_assert(sizeof(Entry) == 64u);
+
+    struct PendingPrimitive {
+        uint64_t key;
+        std::vector<char> vertices;
+        std::vector<uint32_t> indices;
+        BoundingBox aabb;
+    };
+
+    static uint64_t alignOffset(uint64_t offset);
+    bool isInFile(uint64_t offset, uint64_t size) const;
+
+    MappedFile m_file;
+    std::filesystem::path m_cache_path;
+    std::filesystem::path m_model_path;
+    uint64_t m_source_stamp = 0u;
+    std::vector<std::string> m_external_uris;
+    const unsigned char* m_model = nullptr; // In the mapping or in m_pending_model
+    size_t m_model_size = 0u;
+    std::vector<char> m_pending_model;
+    bool m_model_changed = false;
+    std::unordered_map<uint64_t, Entry> m_entries;
+    std::vector<PendingPrimitive> m_pending;
+};
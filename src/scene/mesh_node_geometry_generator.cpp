@@ -1,5 +1,6 @@
 #include "mesh_node_geometry_generator.h"
 
+#include <limits>
 #include <numeric>
 
 #include "../application.h"
@@ -74,6 +75,8 @@ std::shared_ptr<SceneNode> MeshNodeGeometryGenerator::GenerateSceneNodeSpline(co
 
     float offset = 1.0f / static_cast<float>(points_per_spline);
     float value = 0.0f;
+    glm::vec3 min_pos(std::numeric_limits<float>::max());
+    glm::vec3 max_pos(std::numeric_limits<float>::lowest());
     
     size_t sz = keyframes.size();
     for(size_t i0 = 0u, i1 = i0 + 1u; i1 < sz; ++i0, ++i1) {
@@ -86,6 +89,8 @@ std::shared_ptr<SceneNode> MeshNodeGeometryGenerator::GenerateSceneNodeSpline(co
             value += offset;
             glm::vec3 pos1 = glm::hermite(t0.Translation, t1.inTangent, t1.Translation, t1.outTangent, value);
             glm::vec4 color1 = glm::vec4(1.0f, 0.0f, 0.0f, 0.5f);
+            min_pos = glm::min(min_pos, glm::min(pos0, pos1));
+            max_pos = glm::max(max_pos, glm::max(pos0, pos1));
 
             size_t line_start = j * vertex_stride * vertices_per_line;
             size_t keyframe_start = i0 * vertices_per_line * points_per_spline * vertex_stride;
@@ -130,6 +135,8 @@ std::shared_ptr<SceneNode> MeshNodeGeometryGenerator::GenerateSceneNodeSpline(co
         value = 0.0f;
     }
 
+    model_data->SetAABB(BoundingBox((min_pos + max_pos) * 0.5f, (max_pos - min_pos) * 0.5f));
+
     const void* vertex_data_ptr = vertex_data.data();
 
     std::shared_ptr<VulkanBuffer> vertex_buffer = Application::GetRenderer().getResourcesManager()->create_buffer(vertex_data_ptr, num_vertices * model_data->GetVertexFormat().getVertexSize(), mesh_name + "_line_vertex_buffer_"s, "basic_vertex_resource");
@@ -7,6 +7,7 @@
 
 #include "../application.h"
 #include "../graphics/api/vulkan_device.h"
+#include "../graphics/api/vulkan_format_manager.h"
 #include "../graphics/pod/image_buffer_config.h"
 #include "../graphics/pod/buffer_config.h"
 #include "../graphics/pod/graphics_render_node_config.h"
@@ -14,9 +15,18 @@
 #include "../graphics/api/vulkan_buffer.h"
 #include "../graphics/vulkan_renderer.h"
 #include "../graphics/api/vulkan_resources_manager.h"
+#include "../graphics/api/vulkan_texture_streamer.h"
 #include "light_manager.h"
 #include "skeleton_manager.h"
 #include "animation_manager.h"
+#include "gltf_model_snapshot.h"
+#include "../tools/ktx2_file.h"
+#include "../tools/texture_tools.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
 
 struct TextureMatInfo {
 	int index = -1; // required.
@@ -37,6 +47,16 @@ struct SpecularGlossinessMat {
 	bool operator==(const SpecularGlossinessMat&) const;
 };
 
+// tinygltf decodes images while it parses, one after another. The encoded bytes are kept instead and decoded on the
+// thread pool by MeshNodeLoader::DecodeImages(), width stays -1 until then.
+bool DeferImageDecode(tinygltf::Image* image, const int image_idx, std::string* err, std::string* warn, int req_width, int req_height, const unsigned char* bytes, int size, void* user_data) {
+	image->image.assign(bytes, bytes + size);
+	image->width = -1;
+	image->height = -1;
+	image->component = -1;
+	return true;
+}
+
 std::unordered_map<MeshNodeLoader::NodeIdx, MeshNodeLoader::NodeIdx> MeshNodeLoader::make_parent_map() {
     std::unordered_map<NodeIdx, NodeIdx> node_parent_map;
     size_t num_nodes = m_gltf_model.nodes.size();
@@ -50,10 +70,24 @@ std::unordered_map<MeshNodeLoader::NodeIdx, MeshNodeLoader::NodeIdx> MeshNodeLoa
     return node_parent_map;
 }
 
+void MeshNodeLoader::SetOptimizeMeshes(bool optimize) {
+	m_optimize_meshes = optimize;
+}
+
+const MeshNodeLoader::IndexMemoryStats& MeshNodeLoader::GetIndexMemoryStats() const {
+	return m_index_memory;
+}
+
+const MeshNodeLoader::MeshOptimizationStats& MeshNodeLoader::GetMeshOptimizationStats() const {
+	return m_mesh_optimization;
+}
+
 std::shared_ptr<SceneNode> MeshNodeLoader::ImportSceneNode(const std::filesystem::path& model_path, std::shared_ptr<VulkanShadersManager> shader_manager, std::shared_ptr<SceneNode> root_transform) {
 	using namespace std::literals;
 
 	m_model_path = model_path;
+	m_index_memory = IndexMemoryStats{};
+	m_mesh_optimization = MeshOptimizationStats{};
 
     Application& app = Application::Get();
     VulkanRenderer& renderer = app.GetRenderer();
@@ -62,21 +96,41 @@ std::shared_ptr<SceneNode> MeshNodeLoader::ImportSceneNode(const std::filesystem
 	m_shader_manager = std::move(shader_manager);
 	m_default_vertex_shader_name = "basic_diffuse_vertex_shader"s;
 
-    bool store_original_json_for_extras_and_extensions = true;
-    m_gltf_ctx.SetStoreOriginalJSONForExtrasAndExtensions(store_original_json_for_extras_and_extensions);
+	// A cache written from the same sources has the parsed model as well, tinygltf is skipped then. The snapshot is
+	// taken before the images are decoded, see MeshCache.
+	bool load_result = false;
+	if (m_mesh_cache.open(MeshCache::makeCachePath(model_path), model_path)) {
+		const unsigned char* model_snapshot = nullptr;
+		size_t model_snapshot_size = 0u;
+		load_result = m_mesh_cache.findModel(model_snapshot, model_snapshot_size) && readGltfModelSnapshot(model_snapshot, model_snapshot_size, m_gltf_model);
+	}
 
-    bool load_result = false;
-    std::string ext = model_path.extension().string().c_str();
-    std::string load_error;
-    std::string load_warning;
-    if (ext.compare(".glb") == 0) {
-    	load_result = m_gltf_ctx.LoadBinaryFromFile(&m_gltf_model, &load_error, &load_warning, model_path.string().c_str());
-    }
-    else {
-    	load_result = m_gltf_ctx.LoadASCIIFromFile(&m_gltf_model, &load_error, &load_warning, model_path.string().c_str());
-    }
+	if (!load_result) {
+		m_gltf_ctx.SetStoreOriginalJSONForExtrasAndExtensions(true);
+		m_gltf_ctx.SetImageLoader(DeferImageDecode, nullptr);
+
+		std::string ext = model_path.extension().string().c_str();
+		std::string load_error;
+		std::string load_warning;
+		if (ext.compare(".glb") == 0) {
+			load_result = m_gltf_ctx.LoadBinaryFromFile(&m_gltf_model, &load_error, &load_warning, model_path.string().c_str());
+		}
+		else {
+			load_result = m_gltf_ctx.LoadASCIIFromFile(&m_gltf_model, &load_error, &load_warning, model_path.string().c_str());
+		}
+		if (!load_result) return nullptr;
 
-    if (!load_result || m_gltf_model.scenes.empty()) return nullptr;
+		std::vector<std::string> external_uris;
+		for (const tinygltf::Buffer& gltf_buffer : m_gltf_model.buffers) {
+			external_uris.push_back(gltf_buffer.uri);
+		}
+		for (const tinygltf::Image& gltf_image : m_gltf_model.images) {
+			external_uris.push_back(gltf_image.uri);
+		}
+		m_mesh_cache.setModel(writeGltfModelSnapshot(m_gltf_model), std::move(external_uris));
+	}
+
+    if (m_gltf_model.scenes.empty()) return nullptr;
     
     m_root_node = root_transform;
 
@@ -86,6 +140,16 @@ std::shared_ptr<SceneNode> MeshNodeLoader::ImportSceneNode(const std::filesystem
 
     m_node_parent = make_parent_map();
 
+	// Images, primitive geometry and animation tracks only read the model, they are prepared on the thread pool.
+	// Scene nodes are created afterwards by the serial walk below, so node indices do not depend on scheduling.
+	// With texture streaming the images stay encoded, the streamer decodes them after the load. Images cooked by
+	// texture_cooker are not decoded at all.
+	FindCookedImages();
+	if (!renderer.getTextureStreamer()) {
+		DecodeImages();
+	}
+	PrepareGeometry();
+
 	if(m_gltf_model.extensions.count("KHR_lights_punctual")) {
 		nlohmann::json light_ext = m_extensions["KHR_lights_punctual"];
 		for(auto light_el : light_ext["lights"]) {
@@ -133,6 +197,10 @@ std::shared_ptr<SceneNode> MeshNodeLoader::ImportSceneNode(const std::filesystem
 		m_scene->getAnimationManager()->CalcAnimRoots(gltf_current_animation.name);
 	}
 
+	if (m_mesh_cache.hasPendingChanges()) {
+		m_mesh_cache.save();
+	}
+
 	return m_root_node;
 }
 
@@ -436,6 +504,35 @@ VkFormat getAttribVkFormat(const tinygltf::Accessor& gltf_accessor) {
 }
 
 
+// Normalized and scaled shader formats keep the integer bits, the fetch unit does their conversion.
+VertexComponentType getVertexComponentType(VkFormat vk_format) {
+	const size_t component_size = VulkanDevice::getBytesCount(vk_format) / VulkanDevice::getNumComponents(vk_format);
+	switch (VulkanDevice::getComponentType(vk_format)) {
+		case VulkanDevice::VulkanFormatComponentType::SIGNED_FLOAT:
+			return component_size == 4u ? VertexComponentType::FLOAT32 : VertexComponentType::UNSUPPORTED;
+		case VulkanDevice::VulkanFormatComponentType::UNSIGNED_INT:
+		case VulkanDevice::VulkanFormatComponentType::UNSIGNED_NORMALIZED:
+		case VulkanDevice::VulkanFormatComponentType::UNSIGNED_SCALED:
+		case VulkanDevice::VulkanFormatComponentType::SRGB:
+			switch (component_size) {
+				case 1u: return VertexComponentType::UINT8;
+				case 2u: return VertexComponentType::UINT16;
+				case 4u: return VertexComponentType::UINT32;
+				default: return VertexComponentType::UNSUPPORTED;
+			}
+		case VulkanDevice::VulkanFormatComponentType::SIGNED_INT:
+		case VulkanDevice::VulkanFormatComponentType::SIGNED_NORMALIZED:
+		case VulkanDevice::VulkanFormatComponentType::SIGNED_SCALED:
+			switch (component_size) {
+				case 1u: return VertexComponentType::INT8;
+				case 2u: return VertexComponentType::INT16;
+				case 4u: return VertexComponentType::INT32;
+				default: return VertexComponentType::UNSUPPORTED;
+			}
+		default: return VertexComponentType::UNSUPPORTED;
+	}
+}
+
 VertexFormat MeshNodeLoader::GetVertexFormatFromMesh(std::map<std::string, int> attributes) const {
 	VertexFormat format{};
 	std::vector<std::string> attributes_seq(attributes.size());
@@ -464,6 +561,58 @@ VkIndexType MeshNodeLoader::getIndexType(int accessor_component_type) {
     }
 }
 
+// The narrowest type that can address vertex_count vertices. The all ones index of each type stays unused, it restarts
+// strips when primitive restart is enabled. 8 bit indices need VK_EXT_index_type_uint8.
+VkIndexType MeshNodeLoader::GetCompactIndexType(size_t vertex_count) const {
+	if (vertex_count <= std::numeric_limits<uint8_t>::max() && m_device->getDeviceAbilities().index_type_uint8) {
+		return VK_INDEX_TYPE_UINT8_EXT;
+	}
+	if (vertex_count <= std::numeric_limits<uint16_t>::max()) {
+		return VK_INDEX_TYPE_UINT16;
+	}
+	return VK_INDEX_TYPE_UINT32;
+}
+
+// The mesh cache keeps 32 bit indices, they are narrowed to index_type on upload.
+std::shared_ptr<VulkanBuffer> MeshNodeLoader::MakeIndexBuffer(const MeshCache::Primitive& geometry, VkIndexType index_type, const std::string& name) {
+	const std::shared_ptr<VulkanResourcesManager>& resources_manager = Application::GetRenderer().getResourcesManager();
+	const size_t index_bytes = geometry.index_count * VertexFormat::getIndexTypeBytesCount(index_type);
+
+	std::shared_ptr<VulkanBuffer> index_buffer;
+	switch (index_type) {
+		case VK_INDEX_TYPE_UINT8_EXT: {
+			std::vector<uint8_t> indices(geometry.indices, geometry.indices + geometry.index_count);
+			index_buffer = resources_manager->create_buffer(indices.data(), index_bytes, name, "basic_index_resource");
+			++m_index_memory.uint8_buffers;
+			break;
+		}
+		case VK_INDEX_TYPE_UINT16: {
+			std::vector<uint16_t> indices(geometry.indices, geometry.indices + geometry.index_count);
+			index_buffer = resources_manager->create_buffer(indices.data(), index_bytes, name, "basic_index_resource");
+			++m_index_memory.uint16_buffers;
+			break;
+		}
+		case VK_INDEX_TYPE_UINT32:
+			index_buffer = resources_manager->create_buffer(geometry.indices, index_bytes, name, "basic_index_resource");
+			++m_index_memory.uint32_buffers;
+			break;
+		default: throw std::runtime_error("unsupported index type!");
+	}
+	m_index_memory.uint32_bytes += geometry.index_count * sizeof(uint32_t);
+	m_index_memory.compact_bytes += index_bytes;
+
+	return index_buffer;
+}
+
+MeshNodeLoader::IndexMemoryStats& MeshNodeLoader::IndexMemoryStats::operator+=(const IndexMemoryStats& other) {
+	uint32_bytes += other.uint32_bytes;
+	compact_bytes += other.compact_bytes;
+	uint8_buffers += other.uint8_buffers;
+	uint16_buffers += other.uint16_buffers;
+	uint32_buffers += other.uint32_buffers;
+	return *this;
+}
+
 std::shared_ptr<MeshNode> MeshNodeLoader::MakeRenderNode(const tinygltf::Node& gltf_node, Scene::NodeIndex node) {
 	using namespace std::literals;
 
@@ -486,58 +635,28 @@ std::shared_ptr<MeshNode> MeshNodeLoader::MakeRenderNode(const tinygltf::Node& g
 		std::shared_ptr<ModelData> model_data = std::make_shared<ModelData>();
 		model_data->SetPrimitiveTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
 
-    	size_t num_vertices = GetNumVertices(primitive);
-    	//int32_t num_primitives = GetNumPrimitives(primitive);
-
-    	std::vector<uint32_t> indices;
-    	int indices_accessor_idx = primitive.indices;
-		int indices_component_type = TINYGLTF_COMPONENT_TYPE_INT;
-    	if (indices_accessor_idx != -1) {
-    		const tinygltf::Accessor& indices_accessor = m_gltf_model.accessors[indices_accessor_idx];
-			//indices_component_type = indices_accessor.componentType;
-    		indices = GetIndices(indices_accessor);
-    	}
-    	else {
-    		indices = std::vector<uint32_t>(num_vertices);
-    		std::iota(indices.begin(), indices.end(), 0u);
-    	}
-		
-		const void* indices_data = indices.data();
-		size_t index_count = indices.size();
-
-		int gltf_material_idx = primitive.material;
-		const tinygltf::Material& gltf_material = m_gltf_model.materials[gltf_material_idx];
-		std::string gltf_material_name = gltf_material.name.c_str();
-		std::string render_name = makeRenderName(gltf_material_name, "_render"s);
-		if(!Application::GetRenderer().getFrameData(0)->render_graph->hasGraphicsRenderNodeConfig(render_name)) {
-        	render_name = "mesh_render"s;
-        }
-		const std::shared_ptr<GraphicsRenderNodeConfig>& render_node_cfg = Application::GetRenderer().getFrameData(0)->render_graph->getGraphicsRenderNodeConfig(render_name);
-		std::shared_ptr<VulkanPipeline> pipeline = render_node_cfg->getPipeline();
-		//std::string material_vertex_shader_name = pipeline->getPipelineConfig()->;
-		std::shared_ptr<ShaderSignature> shader_signature = pipeline->getShader(VK_SHADER_STAGE_VERTEX_BIT)->getShaderSignature();
-		//if(m_shader_manager->hasShader(material_vertex_shader_name)) {	
-		//	shader_signature = m_shader_manager->getShader(material_vertex_shader_name)->getShaderSignature();	
-		//}	
-		//else {	
-		//	shader_signature = m_shader_manager->getShader(m_default_vertex_shader_name)->getShaderSignature();	
-		//}	
-
+		std::shared_ptr<ShaderSignature> shader_signature = GetPrimitiveShaderSignature(primitive);
 		model_data->SetVertexFormat(shader_signature->getVertexFormat());
     	std::shared_ptr<Material> prop_set = MakePropertySet(primitive);
     	//VertexFormat vertex_format = GetVertexFormat(primitive.attributes);
 		model_data->SetMaterial(prop_set);
 
-    	std::vector<char> vertices = GetVertices(primitive, shader_signature->getVertexFormat());
-		const void* vertices_data = vertices.data();
-		std::shared_ptr<VulkanBuffer> vertex_buffer = Application::GetRenderer().getResourcesManager()->create_buffer(vertices_data, num_vertices * model_data->GetVertexFormat().getVertexSize(), m_model_path.string() + "/node"s + std::to_string(node) + "/"s + mesh_name + "_vertex_buffer_primitive_"s + std::to_string(prim_idx), "basic_vertex_resource");
-		std::shared_ptr<VulkanBuffer> index_buffer = Application::GetRenderer().getResourcesManager()->create_buffer(indices.data(), indices.size() * sizeof(uint32_t), m_model_path.string() + "/node"s + std::to_string(node) + "/"s + mesh_name + "_index_buffer_primitive_"s + std::to_string(prim_idx), "basic_index_resource");
+		const MeshCache::Primitive& geometry = m_primitive_geometry.at({gltf_node.mesh, static_cast<int>(prim_idx)});
+
+		std::shared_ptr<VulkanBuffer> vertex_buffer = Application::GetRenderer().getResourcesManager()->create_buffer(geometry.vertices, geometry.vertices_size, m_model_path.string() + "/node"s + std::to_string(node) + "/"s + mesh_name + "_vertex_buffer_primitive_"s + std::to_string(prim_idx), "basic_vertex_resource");
+		const VkIndexType index_type = GetCompactIndexType(geometry.vertices_size / shader_signature->getVertexFormat().getVertexSize());
+		std::shared_ptr<VulkanBuffer> index_buffer = MakeIndexBuffer(geometry, index_type, m_model_path.string() + "/node"s + std::to_string(node) + "/"s + mesh_name + "_index_buffer_primitive_"s + std::to_string(prim_idx));
+		model_data->SetIndexType(index_type);
 
 		model_data->SetVertexBuffer(std::move(vertex_buffer));
 		model_data->SetIndexBuffer(std::move(index_buffer));
 		
     	model_data->SetName(m_model_path.string() + "/node"s + std::to_string(node) + "/"s + mesh_name);
-    	//model_data->calculateBoundingBox();
+		BoundingBox aabb = geometry.aabb;
+		BoundingSphere sphere;
+		BoundingSphere::CreateFromBoundingBox(sphere, aabb);
+		model_data->SetAABB(aabb);
+		model_data->SetSphere(sphere);
 
     	mesh_node->AddMesh(model_data);
     }
@@ -891,15 +1010,34 @@ std::unordered_map<MeshNodeLoader::NodeIdx, std::unordered_map<MeshNodeLoader::A
 	return node_to_anim_map;
 }
 
+// Every node and animation pair is extracted as its own task, the map is filled afterwards on the calling thread.
 std::unordered_map<MeshNodeLoader::NodeIdx, std::unordered_map<MeshNodeLoader::AnimationIdx, std::shared_ptr<MatrixAnimation>>> MeshNodeLoader::make_node_to_matrix_map() {
-	std::unordered_map<NodeIdx, std::unordered_map<AnimationIdx, std::shared_ptr<MatrixAnimation>>> node_to_matrix_map;
+	std::vector<std::pair<NodeIdx, AnimationIdx>> tracks;
 	for (const auto&[node_idx, node_to_anim_map] : m_node_to_anim_map) {
 		for(const auto&[anim_idx, channels_vec] : node_to_anim_map) {
-			std::shared_ptr<MatrixAnimation> anim_matrix = make_anim_matrix(anim_idx, node_idx);
-			node_to_matrix_map[node_idx][anim_idx] = std::move(anim_matrix);
+			tracks.push_back({node_idx, anim_idx});
 		}
 	}
 
+	std::vector<std::shared_ptr<MatrixAnimation>> anim_matrices(tracks.size());
+	auto extract_track = [this, &tracks, &anim_matrices](size_t track_idx) {
+		anim_matrices[track_idx] = make_anim_matrix(tracks[track_idx].second, tracks[track_idx].first);
+	};
+	const std::shared_ptr<ThreadPool>& thread_pool = Application::Get().GetThreadPool();
+	if (thread_pool) {
+		thread_pool->ParallelFor(0u, tracks.size(), 1u, extract_track);
+	}
+	else {
+		for (size_t track_idx = 0u; track_idx < tracks.size(); ++track_idx) {
+			extract_track(track_idx);
+		}
+	}
+
+	std::unordered_map<NodeIdx, std::unordered_map<AnimationIdx, std::shared_ptr<MatrixAnimation>>> node_to_matrix_map;
+	for (size_t track_idx = 0u; track_idx < tracks.size(); ++track_idx) {
+		node_to_matrix_map[tracks[track_idx].first][tracks[track_idx].second] = std::move(anim_matrices[track_idx]);
+	}
+
 	return node_to_matrix_map;
 }
 
@@ -909,7 +1047,7 @@ std::shared_ptr<MatrixAnimation> MeshNodeLoader::make_anim_matrix(AnimationIdx a
 	
 	const tinygltf::Animation& gltf_animation = m_gltf_model.animations[animation_idx];
 	std::shared_ptr<MatrixAnimation> matrix_anim = std::make_shared<MatrixAnimation>();
-	for (AnimationChannelIdx channel_idx : m_node_to_anim_map[node_idx][animation_idx]) {
+	for (AnimationChannelIdx channel_idx : m_node_to_anim_map.at(node_idx).at(animation_idx)) {
 		const tinygltf::AnimationChannel& gltf_anim_channel = gltf_animation.channels[channel_idx];
 		if(gltf_anim_channel.target_node != node_idx) continue;
 
@@ -1044,56 +1182,6 @@ MeshNodeLoader::NodeIdx MeshNodeLoader::getParent(MeshNodeLoader::NodeIdx node_i
     }
 }
 
-std::vector<uint32_t> MeshNodeLoader::GetIndices(const tinygltf::Accessor& gltf_accessor) {
-	int indices_view_idx = gltf_accessor.bufferView;
-	const tinygltf::BufferView& indices_view = m_gltf_model.bufferViews[indices_view_idx];
-
-	int indices_buffer_idx = indices_view.buffer;
-	const tinygltf::Buffer& gltf_buffer = m_gltf_model.buffers[indices_buffer_idx];
-	return GetIndices(gltf_buffer, indices_view, gltf_accessor);
-}
-
-std::vector<uint32_t> MeshNodeLoader::GetIndices(const tinygltf::Buffer& gltf_buffer, const tinygltf::BufferView& gltf_view, const tinygltf::Accessor& gltf_accessor) {
-	if (gltf_accessor.type != TINYGLTF_TYPE_SCALAR) return std::vector<uint32_t>();
-	if (gltf_accessor.componentType != TINYGLTF_COMPONENT_TYPE_BYTE &&
-		gltf_accessor.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE &&
-		gltf_accessor.componentType != TINYGLTF_COMPONENT_TYPE_SHORT &&
-		gltf_accessor.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT &&
-		gltf_accessor.componentType != TINYGLTF_COMPONENT_TYPE_INT &&
-		gltf_accessor.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT
-	) return std::vector<uint32_t>();
-
-	size_t elements_count = gltf_accessor.count;
-	std::vector<uint32_t> indices;
-	indices.reserve(elements_count);
-
-	int32_t component_size = tinygltf::GetComponentSizeInBytes(gltf_accessor.componentType);
-	size_t buffer_offset_bytes = gltf_accessor.byteOffset + gltf_view.byteOffset;
-	size_t buffer_stride_bytes = gltf_view.byteStride ? gltf_view.byteStride : component_size;
-
-	for (size_t current_element_num = 0u; current_element_num < elements_count; ++current_element_num) {
-		int32_t indice = GetIndice(gltf_buffer, buffer_offset_bytes, current_element_num, component_size, buffer_stride_bytes);
-		indices.push_back(indice);
-	}
-	return indices;
-}
-
-uint32_t MeshNodeLoader::GetIndice(const tinygltf::Buffer& gltf_buffer, size_t buffer_offset, size_t element_number, size_t element_size_in_bytes, size_t stride) {
-	if (element_size_in_bytes == 0u) return -1;
-	if (element_size_in_bytes > sizeof(uint32_t)) return -1;
-
-	uint32_t result = -1;
-	const unsigned char* begin_ptr = gltf_buffer.data.data();
-	switch (element_size_in_bytes) {
-		case 1: result = *((const uint8_t*)(begin_ptr + buffer_offset + element_number * stride)); break;
-		case 2: result = *((const uint16_t*)(begin_ptr + buffer_offset + element_number * stride)); break;
-		case 4: result = *((const uint32_t*)(begin_ptr + buffer_offset + element_number * stride)); break;
-		default: break;
-	}
-
-	return result;
-}
-
 std::shared_ptr<Material> MeshNodeLoader::MakePropertySet(const tinygltf::Primitive& primitive) {
 	int gltf_material_idx = primitive.material;
 	if(gltf_material_idx == -1) {
@@ -1193,18 +1281,57 @@ std::shared_ptr<VulkanSampler> MeshNodeLoader::createTextureSampler(uint32_t mip
     return texture_sampler;
 }
 
+// Streamed and cooked images are not decoded yet, their width and height are -1 and log2 of them is NaN.
+// The sampler levels of those are left unclamped, the image view limits them once the levels are known.
+uint32_t SamplerMipLevels(const tinygltf::Image& texture_image) {
+	if (texture_image.width <= 0 || texture_image.height <= 0) {
+		return static_cast<uint32_t>(VK_LOD_CLAMP_NONE);
+	}
+	return static_cast<uint32_t>(std::floor(std::log2(std::max(texture_image.width, texture_image.height))));
+}
+
 void MeshNodeLoader::SetTextureProperty(const tinygltf::Texture& gltf_texture, Material::TextureType texture_type_enum, std::shared_ptr<Material> material) {
 	int texture_image_idx = gltf_texture.source;
-	const tinygltf::Image& texture_image = m_gltf_model.images[texture_image_idx];
+	tinygltf::Image& texture_image = m_gltf_model.images[texture_image_idx];
 	bool mime_is_file = IsImageFileMime(texture_image.mimeType.c_str());
 
 	int texture_sampler_idx = gltf_texture.sampler;
 	const tinygltf::Sampler& texture_sampler = m_gltf_model.samplers[texture_sampler_idx];
-	uint32_t mip_levels = static_cast<uint32_t>(std::floor(std::log2(std::max(texture_image.width, texture_image.height))));
-	std::shared_ptr<VulkanSampler> sampler = createTextureSampler(mip_levels, texture_sampler, material->GetName());
+	std::shared_ptr<VulkanSampler> sampler = createTextureSampler(SamplerMipLevels(texture_image), texture_sampler, material->GetName());
+
+	// Images from files keep the path as their name, other models share them by it.
+	std::string texture_image_name = m_model_path.string() + "/image"s + std::to_string(texture_image_idx);
+	if (!texture_image.uri.empty()) {
+		texture_image_name = std::filesystem::exists(texture_image.uri) ? texture_image.uri : "textures/"s + texture_image.uri;
+	}
+	// Until the streamer has decoded them normal maps are flat, other textures grey.
+	const uint32_t placeholder_rgba = texture_type_enum == Material::TextureType::Normal ? 0xFFFF8080u : 0xFF808080u;
+	const std::shared_ptr<VulkanTextureStreamer>& texture_streamer = Application::GetRenderer().getTextureStreamer();
 
 	std::shared_ptr<VulkanImageBuffer> texture;
-	if (mime_is_file) {
+	const std::string& cooked_image = m_cooked_images[texture_image_idx];
+	if (!cooked_image.empty()) {
+		if (texture_streamer) {
+			texture = texture_streamer->streamFile(texture_image_name, cooked_image, placeholder_rgba);
+		}
+		else {
+			texture = Application::GetRenderer().getResourcesManager()->create_image(cooked_image);
+		}
+		texture->getImageConfig()->setSampler(std::move(sampler));
+		material->SetTexture(texture_type_enum, std::move(texture));
+	}
+	else if (texture_streamer && texture_image.width == -1 && !texture_image.image.empty()) {
+		texture = texture_streamer->stream(texture_image_name, texture_image.image, placeholder_rgba);
+		texture->getImageConfig()->setSampler(std::move(sampler));
+		material->SetTexture(texture_type_enum, std::move(texture));
+	}
+	else if (texture_image.width != -1 && !texture_image.image.empty()) {
+		// Decoded by DecodeImages().
+		texture = Application::GetRenderer().getResourcesManager()->create_image(texture_image.image.data(), {(uint32_t)texture_image.width, (uint32_t)texture_image.height}, texture_image_name, "basic_image_resource");
+		texture->getImageConfig()->setSampler(std::move(sampler));
+		material->SetTexture(texture_type_enum, std::move(texture));
+	}
+	else if (mime_is_file) {
 		std::string texture_image_file_name = texture_image.uri;
 		bool file_exists = std::filesystem::exists(texture_image_file_name);
 		if(!file_exists) {
@@ -1212,7 +1339,12 @@ void MeshNodeLoader::SetTextureProperty(const tinygltf::Texture& gltf_texture, M
 			file_exists = std::filesystem::exists(texture_image_file_name);
 		}
 
-		texture = Application::GetRenderer().getResourcesManager()->create_image(texture_image_file_name);
+		if (texture_streamer) {
+			texture = texture_streamer->streamFile(texture_image_file_name, texture_image_file_name, placeholder_rgba);
+		}
+		else {
+			texture = Application::GetRenderer().getResourcesManager()->create_image(texture_image_file_name);
+		}
 		texture->getImageConfig()->setSampler(std::move(sampler));
 		material->SetTexture(texture_type_enum, std::move(texture));
 	}
@@ -1671,53 +1803,157 @@ bool ValidateVertexAttribute(const std::string& semantic_name) {
 // 	return result;
 // }
 
-std::vector<char> MeshNodeLoader::GetVertices(const tinygltf::Primitive& primitive, const VertexFormat& pbr_shader_vertex_format) {
-	const VertexFormat& uni_vertex_format = pbr_shader_vertex_format;
-	int32_t num_vertices = GetNumVertices(primitive);
-	int32_t uni_stride = uni_vertex_format.getVertexSize();
-	size_t uni_total_vertex_size_bytes = uni_stride * num_vertices;
+// Attributes of the shader vertex the primitive has, in the order tinygltf lists them.
+GltfVertexLayout MeshNodeLoader::GetVertexLayout(const tinygltf::Primitive& primitive, const VertexFormat& vertex_format) const {
+	GltfVertexLayout layout;
+	layout.vertex_size = vertex_format.getVertexSize();
 
-	std::vector<char> result(uni_total_vertex_size_bytes);
+	// VertexFormat::getOffset walks all previous attributes, the offsets are gathered once instead.
+	std::vector<size_t> offsets(vertex_format.getVertexAttribCount());
+	for (size_t pos = 0u, offset = 0u; pos < offsets.size(); ++pos) {
+		offsets[pos] = offset;
+		offset += VulkanDevice::getBytesCount(vertex_format.getAttribInternalFormat(pos));
+	}
 
 	for (const auto& [semantic_name_str, semantic_accessor_idx] : primitive.attributes) {
 		SemanticName semantic_name;
 		semantic_name.init(semantic_name_str);
 		if(!ValidateVertexAttribute(semantic_name_str)) continue;
-		if(!uni_vertex_format.checkVertexAttribExist(semantic_name)) continue;
-
-		size_t uni_current_offset = uni_vertex_format.getOffset<char>(semantic_name);
-
-		const tinygltf::Accessor& vertex_attrib_accessor = m_gltf_model.accessors[semantic_accessor_idx];
-		int32_t gltf_element_size = tinygltf::GetComponentSizeInBytes(vertex_attrib_accessor.componentType);
-		int32_t num_of_elements_in_type = tinygltf::GetNumComponentsInType(vertex_attrib_accessor.type);
-		//int32_t num_of_elements_to_copy = num_of_elements_in_type;
-		int32_t num_of_elements_to_copy = uni_vertex_format.GetNumComponentsInVkType(semantic_name);
-		int32_t my_element_size = uni_vertex_format.GetComponentSizeInVkType(semantic_name);
-		//int32_t num_of_elements_to_copy = VulkanDevice::getNumComponents(semantic_name);
-
-		size_t vertex_attrib_view_idx = vertex_attrib_accessor.bufferView;
-		const tinygltf::BufferView& vertex_attrib_view = m_gltf_model.bufferViews[vertex_attrib_view_idx];
-		size_t vertex_attrib_buffer_idx = vertex_attrib_view.buffer;
-		const tinygltf::Buffer& vertex_attrib_buffer = m_gltf_model.buffers[vertex_attrib_buffer_idx];
-
-		const unsigned char* begin_ptr = vertex_attrib_buffer.data.data();
-		size_t buffer_offset_bytes = vertex_attrib_accessor.byteOffset + vertex_attrib_view.byteOffset;
-		size_t buffer_stride_bytes = vertex_attrib_view.byteStride ? vertex_attrib_view.byteStride : gltf_element_size * num_of_elements_in_type;
-		size_t elements_count = vertex_attrib_accessor.count;
-
-		for (size_t current_element = 0u; current_element < elements_count; ++current_element) {
-			for (int32_t current_component_num = 0; current_component_num < num_of_elements_to_copy; ++current_component_num) {
-				const unsigned char* raw_data_ptr = begin_ptr + buffer_offset_bytes + current_element * buffer_stride_bytes + current_component_num * gltf_element_size;
-				for(int32_t c = 0; c < gltf_element_size; ++c) {
-					char one_data = *((int8_t*)(raw_data_ptr + c));
-					result[current_element * uni_stride + uni_current_offset + current_component_num * my_element_size + c] = one_data;
-				}
-				//float vertex_attrib_element = GetAttribute(raw_data_ptr, vertex_attrib_accessor.componentType);
-				//result[current_element * uni_stride_el + uni_current_offset + current_component_num] = vertex_attrib_element;
+		if(!vertex_format.checkVertexAttribExist(semantic_name)) continue;
+
+		const size_t pos = vertex_format.getVertexAttribPos(semantic_name);
+		const VkFormat format = vertex_format.getAttribInternalFormat(pos);
+		layout.attributes.push_back({semantic_name_str, offsets[pos], getVertexComponentType(format), static_cast<uint32_t>(VulkanDevice::getNumComponents(format))});
+	}
+	return layout;
+}
+
+std::shared_ptr<ShaderSignature> MeshNodeLoader::GetPrimitiveShaderSignature(const tinygltf::Primitive& primitive) const {
+	using namespace std::literals;
+
+	const tinygltf::Material& gltf_material = m_gltf_model.materials[primitive.material];
+	std::string render_name = makeRenderName(gltf_material.name, "_render"s);
+	if(!Application::GetRenderer().getFrameData(0)->render_graph->hasGraphicsRenderNodeConfig(render_name)) {
+		render_name = "mesh_render"s;
+	}
+	const std::shared_ptr<GraphicsRenderNodeConfig>& render_node_cfg = Application::GetRenderer().getFrameData(0)->render_graph->getGraphicsRenderNodeConfig(render_name);
+	return render_node_cfg->getPipeline()->getShader(VK_SHADER_STAGE_VERTEX_BIT)->getShaderSignature();
+}
+
+// Every primitive a node draws is converted as its own task by convertGltfPrimitives(). The results go into the mesh
+// cache in mesh and primitive order, which keeps the cache file independent of how the tasks were scheduled.
+void MeshNodeLoader::PrepareGeometry() {
+	std::vector<bool> mesh_used(m_gltf_model.meshes.size(), false);
+	for (const tinygltf::Node& gltf_node : m_gltf_model.nodes) {
+		if (gltf_node.mesh != -1) {
+			mesh_used[gltf_node.mesh] = true;
+		}
+	}
+
+	std::vector<GltfPrimitiveGeometry> geometries;
+	std::vector<uint64_t> keys;
+	for (int mesh_idx = 0; mesh_idx < static_cast<int>(m_gltf_model.meshes.size()); ++mesh_idx) {
+		if (!mesh_used[mesh_idx]) continue;
+
+		const tinygltf::Mesh& gltf_mesh = m_gltf_model.meshes[mesh_idx];
+		for (size_t prim_idx = 0u; prim_idx < gltf_mesh.primitives.size(); ++prim_idx) {
+			const tinygltf::Primitive& primitive = gltf_mesh.primitives[prim_idx];
+			if (!PrimitiveSupported(primitive.mode)) continue;
+
+			const std::shared_ptr<ShaderSignature> shader_signature = GetPrimitiveShaderSignature(primitive);
+			GltfVertexLayout layout = GetVertexLayout(primitive, shader_signature->getVertexFormat());
+			const uint64_t key = MeshCache::makeKey(mesh_idx, prim_idx, layout, m_optimize_meshes);
+
+			MeshCache::Primitive cached;
+			if (m_mesh_cache.find(key, cached)) {
+				m_primitive_geometry.insert({{mesh_idx, static_cast<int>(prim_idx)}, cached});
+				continue;
 			}
+
+			GltfPrimitiveGeometry& geometry = geometries.emplace_back();
+			geometry.mesh_idx = mesh_idx;
+			geometry.primitive_idx = static_cast<int>(prim_idx);
+			geometry.layout = std::move(layout);
+			geometry.optimize = m_optimize_meshes;
+			keys.push_back(key);
+		}
+	}
+
+	convertGltfPrimitives(m_gltf_model, geometries, Application::Get().GetThreadPool().get());
+
+	// Cached primitives were optimized when they were added, only freshly converted ones are counted.
+	for (size_t geometry_idx = 0u; geometry_idx < geometries.size(); ++geometry_idx) {
+		GltfPrimitiveGeometry& geometry = geometries[geometry_idx];
+		if (geometry.optimized) {
+			m_mesh_optimization.before += geometry.cache_before;
+			m_mesh_optimization.after += geometry.cache_after;
+		}
+		MeshCache::Primitive cached = m_mesh_cache.add(keys[geometry_idx], std::move(geometry.vertices), std::move(geometry.indices), geometry.aabb);
+		m_primitive_geometry.insert({{geometry.mesh_idx, geometry.primitive_idx}, cached});
+	}
+}
+
+// KTX2 files written by texture_cooker are used in place of the images, as long as the device samples their format.
+// Others keep the source image, decoded to RGBA8: there is no transcoder from the compressed formats.
+void MeshNodeLoader::FindCookedImages() {
+	using namespace std::literals;
+
+	VulkanRenderer& renderer = Application::GetRenderer();
+	const VkImageUsageFlags usage = renderer.getResourcesManager()->getImageBufferConfigTemplate("basic_image_resource"s)->getImageInfo().usage;
+
+	m_cooked_images.assign(m_gltf_model.images.size(), std::string());
+	for (size_t image_idx = 0u; image_idx < m_gltf_model.images.size(); ++image_idx) {
+		const tinygltf::Image& image = m_gltf_model.images[image_idx];
+		std::filesystem::path cooked_path;
+		if (image.uri.empty() || image.uri.starts_with("data:"s)) {
+			cooked_path = getCookedTexturePath(m_model_path, static_cast<int>(image_idx));
+		}
+		else {
+			cooked_path = getCookedTexturePath(std::filesystem::exists(image.uri) ? image.uri : "textures/"s + image.uri);
+		}
+		if (!std::filesystem::exists(cooked_path)) continue;
+
+		const VkFormat format = Ktx2File::readFormat(cooked_path.string());
+		if (format == VK_FORMAT_UNDEFINED || !renderer.getFormatManager()->isTextureFormatSupported(format, usage)) {
+			std::cout << "texture " << cooked_path.string() << " is not supported by the device, using its source image" << std::endl;
+			continue;
+		}
+		m_cooked_images[image_idx] = cooked_path.string();
+	}
+}
+
+// Decodes what DeferImageDecode kept, to the RGBA8 layout the default tinygltf loader produces.
+void MeshNodeLoader::DecodeImages() {
+	auto decode_image = [this](size_t image_idx) {
+		tinygltf::Image& image = m_gltf_model.images[image_idx];
+		if (image.width != -1 || image.image.empty() || !m_cooked_images[image_idx].empty()) return;
+
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+		stbi_uc* pixels = stbi_load_from_memory(image.image.data(), static_cast<int>(image.image.size()), &width, &height, &channels, STBI_rgb_alpha);
+		if (!pixels) {
+			image.image.clear();
+			return;
+		}
+
+		image.width = width;
+		image.height = height;
+		image.component = STBI_rgb_alpha;
+		image.bits = 8;
+		image.pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+		image.image.assign(pixels, pixels + static_cast<size_t>(width) * height * STBI_rgb_alpha);
+		stbi_image_free(pixels);
+	};
+	const std::shared_ptr<ThreadPool>& thread_pool = Application::Get().GetThreadPool();
+	if (thread_pool) {
+		thread_pool->ParallelFor(0u, m_gltf_model.images.size(), 1u, decode_image);
+	}
+	else {
+		for (size_t image_idx = 0u; image_idx < m_gltf_model.images.size(); ++image_idx) {
+			decode_image(image_idx);
 		}
 	}
-	return result;
 }
 
 bool MeshNodeLoader::HaveLightExt(const tinygltf::Node& gltf_node) {
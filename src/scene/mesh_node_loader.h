@@ -24,6 +24,9 @@
 #include <pugixml.hpp>
 
 #include "scene.h"
+#include "gltf_geometry.h"
+#include "mesh_cache.h"
+#include "mesh_optimizer.h"
 #include "nodes/scene_node.h"
 #include "nodes/mesh_node.h"
 #include "nodes/light_node.h"
@@ -62,9 +65,33 @@ struct LightPunctual {
 
 class MeshNodeLoader {
 public:
+	// Index buffer memory of the primitives a model draws, next to what they took with 32 bit indices.
+	struct IndexMemoryStats {
+		size_t uint32_bytes = 0u;
+		size_t compact_bytes = 0u;
+		size_t uint8_buffers = 0u;
+		size_t uint16_buffers = 0u;
+		size_t uint32_buffers = 0u;
+
+		IndexMemoryStats& operator+=(const IndexMemoryStats& other);
+	};
+
+	// Post-transform vertex cache of the primitives converted and optimized by an import, before and after the
+	// reordering. Primitives read from the mesh cache were counted when they were added to it.
+	struct MeshOptimizationStats {
+		VertexCacheStats before;
+		VertexCacheStats after;
+	};
+
 	MeshNodeLoader() = default;
 
 	std::shared_ptr<SceneNode> ImportSceneNode(const std::filesystem::path& model_path, std::shared_ptr<VulkanShadersManager> shader_manager, std::shared_ptr<SceneNode> root_transform);
+	// Vertex cache, overdraw and vertex fetch reordering of triangle list primitives, on by default.
+	void SetOptimizeMeshes(bool optimize);
+	// Of the model imported last, callers that want a total over models add them up.
+	const IndexMemoryStats& GetIndexMemoryStats() const;
+	// Of the model imported last, empty when every primitive came from the mesh cache.
+	const MeshOptimizationStats& GetMeshOptimizationStats() const;
 
 private:
     using NodeIdx = int;
@@ -74,6 +101,8 @@ private:
     using SkinIdx = int;
     using AnimationIdx = int;
     using AnimationChannelIdx = int;
+    using MeshIdx = int;
+    using PrimitiveIdx = int;
 
     struct BoneIdentity {
         BoneNode::JointIndex joint;
@@ -114,6 +143,10 @@ private:
     std::vector<CubicSplineVec3> GetCubicTranslationAnimData(const tinygltf::Accessor& translation_accessor);
 
     void MakeNodesHierarchy(NodeIdx current_node_idx, std::shared_ptr<SceneNode> parent);
+    void PrepareGeometry();
+    void FindCookedImages();
+    void DecodeImages();
+    std::shared_ptr<ShaderSignature> GetPrimitiveShaderSignature(const tinygltf::Primitive& primitive) const;
     //float GetAttribute(const unsigned char* raw_data_ptr, uint32_t component_type);
     template<typename ElementType>
     ElementType GetAttribute(const unsigned char* raw_data_ptr, uint32_t component_type) {
@@ -166,17 +199,16 @@ private:
     std::vector<float> GetTimeline(const tinygltf::Accessor& time_accessor);
     int32_t GetNumVertices(const tinygltf::Primitive& primitive) const;
     int32_t GetNumPrimitives(const tinygltf::Primitive& primitive) const;
-    std::vector<uint32_t> GetIndices(const tinygltf::Accessor& gltf_accessor);
-    std::vector<uint32_t> GetIndices(const tinygltf::Buffer& gltf_buffer, const tinygltf::BufferView& gltf_view, const tinygltf::Accessor& gltf_accessor);
-    uint32_t GetIndice(const tinygltf::Buffer& gltf_buffer, size_t buffer_offset, size_t element_number, size_t element_size_in_bytes, size_t stride);
     std::shared_ptr<Material> MakePropertySet(const tinygltf::Primitive& primitive);
     void MakeTextureProperties(const tinygltf::Material& gltf_material, std::shared_ptr<Material> material);
     void SetTextureProperty(const tinygltf::Texture& texture, Material::TextureType texture_type_enum, std::shared_ptr<Material> material);
     std::shared_ptr<VulkanSampler> createTextureSampler(uint32_t mip_levels, const tinygltf::Sampler& texture_sampler, const std::string& sampler_subname);
     void MakeMaterialProperties(const tinygltf::Material& gltf_material, std::shared_ptr<Material> material);
     VertexFormat GetVertexFormatFromMesh(std::map<std::string, int> attributes) const;
-    std::vector<char> GetVertices(const tinygltf::Primitive& primitive, const VertexFormat& pbr_shader_vertex_format);
+    GltfVertexLayout GetVertexLayout(const tinygltf::Primitive& primitive, const VertexFormat& vertex_format) const;
     VkIndexType getIndexType(int accessor_component_type);
+    VkIndexType GetCompactIndexType(size_t vertex_count) const;
+    std::shared_ptr<VulkanBuffer> MakeIndexBuffer(const MeshCache::Primitive& geometry, VkIndexType index_type, const std::string& name);
     bool HaveLightExt(const tinygltf::Node& gltf_node);
     bool HaveLightExt(const nlohmann::json& json_node_ext);
     LightPunctual GetLightPunctual(const nlohmann::json& json_light);
@@ -195,6 +227,12 @@ private:
     std::shared_ptr<VulkanShadersManager> m_shader_manager;
     std::string m_default_vertex_shader_name;
     std::vector<LightPunctual> m_lights;
+    MeshCache m_mesh_cache;
+    bool m_optimize_meshes = true;
+    std::unordered_map<std::pair<MeshIdx, PrimitiveIdx>, MeshCache::Primitive, SimpleHash> m_primitive_geometry;
+    IndexMemoryStats m_index_memory;
+    MeshOptimizationStats m_mesh_optimization;
+    std::vector<std::string> m_cooked_images; // KTX2 file of each image, empty when there is none the device takes
 
     nlohmann::json m_extensions;
 };
\ No newline at end of file
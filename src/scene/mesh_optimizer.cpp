@@ -0,0 +1,336 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace {
+    // Forsyth's scoring, with the constants of the original article.
+    constexpr uint32_t SCORING_CACHE_SIZE = 32u;
+    constexpr float CACHE_DECAY_POWER = 1.5f;
+    constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+    constexpr float VALENCE_BOOST_SCALE = 2.0f;
+    constexpr float VALENCE_BOOST_POWER = 0.5f;
+    constexpr uint32_t VALENCE_TABLE_SIZE = 32u;
+
+    struct ScoreTables {
+        float cache[SCORING_CACHE_SIZE];
+        float valence[VALENCE_TABLE_SIZE];
+
+        ScoreTables() {
+            for(uint32_t position = 0u; position < SCORING_CACHE_SIZE; ++position) {
+                // The three vertices of the last triangle get a fixed score, so its neighbours are not always preferred.
+                cache[position] = position < 3u ? LAST_TRIANGLE_SCORE : std::pow(1.0f - static_cast<float>(position - 3u) / static_cast<float>(SCORING_CACHE_SIZE - 3u), CACHE_DECAY_POWER);
+            }
+            for(uint32_t remaining = 0u; remaining < VALENCE_TABLE_SIZE; ++remaining) {
+                valence[remaining] = remaining ? VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining), -VALENCE_BOOST_POWER) : 0.0f;
+            }
+        }
+
+        float getScore(int32_t cache_position, uint32_t remaining) const {
+            if(!remaining) return -1.0f;
+
+            const float cache_score = cache_position >= 0 ? cache[cache_position] : 0.0f;
+            const float valence_score = remaining < VALENCE_TABLE_SIZE ? valence[remaining] : VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining), -VALENCE_BOOST_POWER);
+            return cache_score + valence_score;
+        }
+    };
+
+    // FIFO cache on timestamps: a vertex is cached while fewer than FIFO_SIZE misses happened since its own. Adding
+    // FIFO_SIZE + 1 to the time empties the cache.
+    class FifoCache {
+    public:
+        explicit FifoCache(size_t vertex_count) : m_timestamps(vertex_count, 0u) {}
+
+        uint32_t addTriangle(const uint32_t* triangle) {
+            uint32_t misses = 0u;
+            for(uint32_t corner = 0u; corner < 3u; ++corner) {
+                uint32_t& timestamp = m_timestamps[triangle[corner]];
+                if(m_time - timestamp > VertexCacheStats::FIFO_SIZE) {
+                    timestamp = m_time++;
+                    ++misses;
+                }
+            }
+            return misses;
+        }
+
+        void flush() {
+            m_time += VertexCacheStats::FIFO_SIZE + 1u;
+        }
+
+    private:
+        std::vector<uint32_t> m_timestamps;
+        uint32_t m_time = VertexCacheStats::FIFO_SIZE + 1u;
+    };
+
+    struct Vec3 {
+        float x = 0.0f;
+        float y = 0.0f;
+        float z = 0.0f;
+    };
+
+    Vec3 readPosition(const unsigned char* positions, size_t position_stride, uint32_t vertex) {
+        Vec3 position;
+        memcpy(&position, positions + vertex * position_stride, sizeof(Vec3));
+        return position;
+    }
+}
+
+float VertexCacheStats::getAcmr() const {
+    return triangles ? static_cast<float>(transformed) / static_cast<float>(triangles) : 0.0f;
+}
+
+float VertexCacheStats::getAtvr() const {
+    return vertices ? static_cast<float>(transformed) / static_cast<float>(vertices) : 0.0f;
+}
+
+VertexCacheStats& VertexCacheStats::operator+=(const VertexCacheStats& other) {
+    transformed += other.transformed;
+    triangles += other.triangles;
+    vertices += other.vertices;
+    return *this;
+}
+
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t index_count, size_t vertex_count) {
+    VertexCacheStats stats;
+    stats.triangles = index_count / 3u;
+
+    FifoCache cache(vertex_count);
+    std::vector<bool> referenced(vertex_count, false);
+    for(size_t triangle = 0u; triangle < stats.triangles; ++triangle) {
+        stats.transformed += cache.addTriangle(indices + triangle * 3u);
+        for(uint32_t corner = 0u; corner < 3u; ++corner) {
+            const uint32_t vertex = indices[triangle * 3u + corner];
+            if(!referenced[vertex]) {
+                referenced[vertex] = true;
+                ++stats.vertices;
+            }
+        }
+    }
+
+    return stats;
+}
+
+void optimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t index_count, size_t vertex_count) {
+    static const ScoreTables score_tables;
+    const size_t triangle_count = index_count / 3u;
+    if(!triangle_count) return;
+
+    // Triangles of every vertex, the ones still to emit are kept at the front of each range.
+    std::vector<uint32_t> remaining(vertex_count, 0u);
+    for(size_t i = 0u; i < triangle_count * 3u; ++i) {
+        ++remaining[indices[i]];
+    }
+    std::vector<uint32_t> adjacency_offsets(vertex_count + 1u, 0u);
+    std::inclusive_scan(remaining.begin(), remaining.end(), adjacency_offsets.begin() + 1u);
+    std::vector<uint32_t> adjacency(triangle_count * 3u);
+    std::vector<uint32_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1u);
+    for(size_t i = 0u; i < triangle_count * 3u; ++i) {
+        adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3u);
+    }
+
+    std::vector<int32_t> cache_positions(vertex_count, -1);
+    std::vector<float> vertex_scores(vertex_count);
+    for(size_t vertex = 0u; vertex < vertex_count; ++vertex) {
+        vertex_scores[vertex] = score_tables.getScore(-1, remaining[vertex]);
+    }
+    auto getTriangleScore = [&](size_t triangle) {
+        const uint32_t* corners = indices + triangle * 3u;
+        return vertex_scores[corners[0]] + vertex_scores[corners[1]] + vertex_scores[corners[2]];
+    };
+
+    std::vector<bool> emitted(triangle_count, false);
+    size_t best_triangle = 0u;
+    float best_score = -std::numeric_limits<float>::max();
+    for(size_t triangle = 0u; triangle < triangle_count; ++triangle) {
+        const float score = getTriangleScore(triangle);
+        if(score > best_score) {
+            best_score = score;
+            best_triangle = triangle;
+        }
+    }
+
+    uint32_t cache[SCORING_CACHE_SIZE + 3u];
+    uint32_t new_cache[SCORING_CACHE_SIZE + 3u];
+    size_t cache_count = 0u;
+    size_t input_cursor = 0u; // Dead ends continue with the first triangle left in input order
+    for(size_t output_triangle = 0u; output_triangle < triangle_count; ++output_triangle) {
+        if(best_score < 0.0f) {
+            while(emitted[input_cursor]) ++input_cursor;
+            best_triangle = input_cursor;
+        }
+
+        const uint32_t* corners = indices + best_triangle * 3u;
+        std::copy(corners, corners + 3u, destination + output_triangle * 3u);
+        emitted[best_triangle] = true;
+
+        // The triangle's vertices move to the front of the LRU cache, degenerate ones only once.
+        size_t new_cache_count = 0u;
+        for(uint32_t corner = 0u; corner < 3u; ++corner) {
+            const uint32_t vertex = corners[corner];
+            if(std::find(new_cache, new_cache + new_cache_count, vertex) == new_cache + new_cache_count) {
+                new_cache[new_cache_count++] = vertex;
+            }
+
+            uint32_t* adjacent_begin = adjacency.data() + adjacency_offsets[vertex];
+            uint32_t* adjacent_end = adjacent_begin + remaining[vertex];
+            uint32_t* emitted_triangle = std::find(adjacent_begin, adjacent_end, static_cast<uint32_t>(best_triangle));
+            std::swap(*emitted_triangle, *(adjacent_end - 1));
+            --remaining[vertex];
+        }
+        for(size_t i = 0u; i < cache_count; ++i) {
+            const uint32_t vertex = cache[i];
+            if(std::find(new_cache, new_cache + new_cache_count, vertex) == new_cache + new_cache_count) {
+                new_cache[new_cache_count++] = vertex;
+            }
+        }
+
+        // Vertices pushed out of the cache are rescored too, then every triangle around the touched vertices.
+        for(size_t i = 0u; i < new_cache_count; ++i) {
+            const uint32_t vertex = new_cache[i];
+            cache_positions[vertex] = i < SCORING_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+            vertex_scores[vertex] = score_tables.getScore(cache_positions[vertex], remaining[vertex]);
+        }
+        best_score = -1.0f;
+        for(size_t i = 0u; i < new_cache_count; ++i) {
+            const uint32_t vertex = new_cache[i];
+            const uint32_t* adjacent = adjacency.data() + adjacency_offsets[vertex];
+            for(uint32_t j = 0u; j < remaining[vertex]; ++j) {
+                const float score = getTriangleScore(adjacent[j]);
+                if(score > best_score) {
+                    best_score = score;
+                    best_triangle = adjacent[j];
+                }
+            }
+        }
+
+        cache_count = std::min<size_t>(new_cache_count, SCORING_CACHE_SIZE);
+        std::copy(new_cache, new_cache + cache_count, cache);
+    }
+}
+
+void optimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t index_count, const unsigned char* positions, size_t position_stride, size_t vertex_count, float threshold) {
+    const size_t triangle_count = index_count / 3u;
+    if(!triangle_count) return;
+
+    // Hard boundaries: triangles sharing nothing with the cache, the order restarts there anyway.
+    FifoCache cache(vertex_count);
+    std::vector<size_t> hard_boundaries = {0u};
+    cache.addTriangle(indices);
+    for(size_t triangle = 1u; triangle < triangle_count; ++triangle) {
+        if(cache.addTriangle(indices + triangle * 3u) == 3u) {
+            hard_boundaries.push_back(triangle);
+        }
+    }
+    hard_boundaries.push_back(triangle_count);
+
+    // Soft boundaries: a cluster ends as soon as its own ACMR, on a cache flushed at its start, is within threshold of
+    // the ACMR of the whole run it belongs to.
+    std::vector<size_t> clusters;
+    for(size_t run = 0u; run + 1u < hard_boundaries.size(); ++run) {
+        const size_t run_begin = hard_boundaries[run];
+        const size_t run_end = hard_boundaries[run + 1u];
+
+        cache.flush();
+        size_t run_misses = 0u;
+        for(size_t triangle = run_begin; triangle < run_end; ++triangle) {
+            run_misses += cache.addTriangle(indices + triangle * 3u);
+        }
+        const float target_acmr = threshold * static_cast<float>(run_misses) / static_cast<float>(run_end - run_begin);
+
+        cache.flush();
+        clusters.push_back(run_begin);
+        size_t cluster_begin = run_begin;
+        size_t cluster_misses = 0u;
+        for(size_t triangle = run_begin; triangle < run_end; ++triangle) {
+            cluster_misses += cache.addTriangle(indices + triangle * 3u);
+            if(triangle + 1u < run_end && static_cast<float>(cluster_misses) <= target_acmr * static_cast<float>(triangle + 1u - cluster_begin)) {
+                cluster_begin = triangle + 1u;
+                cluster_misses = 0u;
+                clusters.push_back(cluster_begin);
+                cache.flush();
+            }
+        }
+    }
+    clusters.push_back(triangle_count);
+
+    // Clusters are ranked by how much they face away from the area weighted centre of the mesh: those on the outside
+    // are drawn first and occlude the rest from most directions.
+    const size_t cluster_count = clusters.size() - 1u;
+    std::vector<Vec3> cluster_centroids(cluster_count);
+    std::vector<Vec3> cluster_normals(cluster_count);
+    Vec3 mesh_centroid;
+    float mesh_area = 0.0f;
+    for(size_t cluster = 0u; cluster < cluster_count; ++cluster) {
+        Vec3 centroid;
+        Vec3 normal;
+        float cluster_area = 0.0f;
+        for(size_t triangle = clusters[cluster]; triangle < clusters[cluster + 1u]; ++triangle) {
+            const Vec3 p0 = readPosition(positions, position_stride, indices[triangle * 3u]);
+            const Vec3 p1 = readPosition(positions, position_stride, indices[triangle * 3u + 1u]);
+            const Vec3 p2 = readPosition(positions, position_stride, indices[triangle * 3u + 2u]);
+            const Vec3 e1 = {p1.x - p0.x, p1.y - p0.y, p1.z - p0.z};
+            const Vec3 e2 = {p2.x - p0.x, p2.y - p0.y, p2.z - p0.z};
+            const Vec3 cross = {e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x};
+            const float area = std::sqrt(cross.x * cross.x + cross.y * cross.y + cross.z * cross.z);
+
+            centroid.x += (p0.x + p1.x + p2.x) * area;
+            centroid.y += (p0.y + p1.y + p2.y) * area;
+            centroid.z += (p0.z + p1.z + p2.z) * area;
+            normal.x += cross.x;
+            normal.y += cross.y;
+            normal.z += cross.z;
+            cluster_area += area;
+        }
+
+        mesh_centroid.x += centroid.x;
+        mesh_centroid.y += centroid.y;
+        mesh_centroid.z += centroid.z;
+        mesh_area += cluster_area;
+
+        const float inv_area = cluster_area > 0.0f ? 1.0f / (3.0f * cluster_area) : 0.0f;
+        cluster_centroids[cluster] = {centroid.x * inv_area, centroid.y * inv_area, centroid.z * inv_area};
+        const float normal_length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        const float inv_length = normal_length > 0.0f ? 1.0f / normal_length : 0.0f;
+        cluster_normals[cluster] = {normal.x * inv_length, normal.y * inv_length, normal.z * inv_length};
+    }
+    const float inv_mesh_area = mesh_area > 0.0f ? 1.0f / (3.0f * mesh_area) : 0.0f;
+    mesh_centroid = {mesh_centroid.x * inv_mesh_area, mesh_centroid.y * inv_mesh_area, mesh_centroid.z * inv_mesh_area};
+
+    std::vector<float> sort_keys(cluster_count);
+    for(size_t cluster = 0u; cluster < cluster_count; ++cluster) {
+        const Vec3& centroid = cluster_centroids[cluster];
+        const Vec3& normal = cluster_normals[cluster];
+        sort_keys[cluster] = (centroid.x - mesh_centroid.x) * normal.x + (centroid.y - mesh_centroid.y) * normal.y + (centroid.z - mesh_centroid.z) * normal.z;
+    }
+    std::vector<size_t> cluster_order(cluster_count);
+    std::iota(cluster_order.begin(), cluster_order.end(), size_t{0u});
+    std::stable_sort(cluster_order.begin(), cluster_order.end(), [&sort_keys](size_t a, size_t b) {
+        return sort_keys[a] > sort_keys[b];
+    });
+
+    uint32_t* output = destination;
+    for(size_t cluster : cluster_order) {
+        output = std::copy(indices + clusters[cluster] * 3u, indices + clusters[cluster + 1u] * 3u, output);
+    }
+}
+
+size_t optimizeVertexFetch(unsigned char* destination, uint32_t* indices, size_t index_count, const unsigned char* vertices, size_t vertex_count, size_t vertex_size) {
+    constexpr uint32_t UNUSED = std::numeric_limits<uint32_t>::max();
+
+    std::vector<uint32_t> remap(vertex_count, UNUSED);
+    uint32_t next_vertex = 0u;
+    for(size_t i = 0u; i < index_count; ++i) {
+        uint32_t& new_index = remap[indices[i]];
+        if(new_index == UNUSED) {
+            new_index = next_vertex++;
+            memcpy(destination + static_cast<size_t>(new_index) * vertex_size, vertices + static_cast<size_t>(indices[i]) * vertex_size, vertex_size);
+        }
+        indices[i] = new_index;
+    }
+
+    return next_vertex;
+}
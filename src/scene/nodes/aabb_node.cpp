@@ -34,6 +34,7 @@ bool AABBNode::VOnUpdate() {
 
 void AABBNode::setAABB(const BoundingBox& aabb) {
     m_aabb = aabb;
+    GetScene()->setNodeBounds(VGetNodeIndex(), m_aabb);
 }
 
 const BoundingBox& AABBNode::getAABB() const {
@@ -1,5 +1,7 @@
 #include "value_bag_node.h"
 
+#include <cstring>
+
 ValueBagNode::ValueBagNode(std::shared_ptr<Scene> scene, Scene::NodeIndex node_index) : SceneNode(std::move(scene), node_index) {
     SetNodeType(Scene::NODE_TYPE_FLAG_VALUE_BAG);
 }
@@ -1,11 +1,15 @@
 #define _ENABLE_EXTENDED_ALIGNED_STORAGE
 #include "scene.h"
 #include "nodes/scene_node.h"
+#include "nodes/aabb_node.h"
 #include "light_manager.h"
 #include "animation_manager.h"
 #include "skeleton_manager.h"
+#include "../tools/simd_math.h"
+#include "../tools/thread_pool.h"
 
 #include <algorithm>
+#include <bit>
 #include <numeric>
 
 //const std::string Scene::NO_NAME = "NO NAME";
@@ -13,12 +17,47 @@ const Material NO_MATERIAL = Material("NO MATERIAL");
 const std::shared_ptr<SceneNode> NULL_PTR_NODE;
 const std::shared_ptr<Scene::Properties> NULL_PTR_PROP;
 
+static void setStaleBit(std::vector<uint64_t>& bits, size_t index) {
+    const size_t word = index >> 6u;
+    if (word >= bits.size()) {
+        bits.resize(word + 1u, 0u);
+    }
+    bits[word] |= 1ull << (index & 63u);
+}
+
+static void setAllStaleBits(std::vector<uint64_t>& bits, size_t count) {
+    bits.assign((count + 63u) >> 6u, ~0ull);
+}
+
+static void insertSortedIdx(std::vector<Scene::NodeIndex>& v, Scene::NodeIndex index) {
+    auto it = std::lower_bound(v.begin(), v.end(), index);
+    if (it == v.end() || *it != index) {
+        v.insert(it, index);
+    }
+}
+
+static void eraseSortedIdx(std::vector<Scene::NodeIndex>& v, Scene::NodeIndex index) {
+    auto it = std::lower_bound(v.begin(), v.end(), index);
+    if (it != v.end() && *it == index) {
+        v.erase(it);
+    }
+}
+
+static const Scene::NodeIndexArray EMPTY_NODE_LIST;
+
 Scene::Scene(std::string name) {
     m_local_transform.push_back(glm::mat4(1.0f));
     m_global_transform.push_back(glm::mat4(1.0f));
     m_inv_local_transform.push_back(glm::mat4(1.0f));
     m_inv_global_transform.push_back(glm::mat4(1.0f));
     m_hierarchy.push_back({});
+    m_dirty_generation.push_back(0u);
+    m_node_type_flags.push_back(NODE_TYPE_FLAG_NONE);
+    m_node_property_index.push_back(NO_INDEX);
+    m_node_name_id.push_back(StringInternTable::NO_ID);
+    m_node_bounds.push_back(BoundingBox());
+    m_node_proxy.push_back(DynamicAABBTree::NULL_NODE);
+    linkNodeName(0u, name);
     m_node_names.push_back(std::move(name));
     m_node_name_map[0] = 0;
     m_dirty_at_level = std::vector<NodeIndexArray>(MAX_NODE_LEVEL);
@@ -39,6 +78,12 @@ int Scene::addNode(NodeIndex parent_index) {
     m_inv_local_transform.push_back(glm::mat4(1.0f));
     m_inv_global_transform.push_back(glm::mat4(1.0f));
     m_hierarchy.push_back(hierarchy);
+    m_dirty_generation.push_back(0u);
+    m_node_type_flags.push_back(NODE_TYPE_FLAG_NONE);
+    m_node_property_index.push_back(NO_INDEX);
+    m_node_name_id.push_back(StringInternTable::NO_ID);
+    m_node_bounds.push_back(BoundingBox());
+    m_node_proxy.push_back(DynamicAABBTree::NULL_NODE);
 
     const NodeIndex old_child_index = m_hierarchy[parent_index].first_child;
     m_hierarchy[parent_index].first_child = new_node_index;
@@ -69,37 +114,70 @@ int Scene::addNode(const glm::mat4& local_transform, std::string name, NodeIndex
     return new_node_index;
 }
 
+// A node that already carries the current generation stamp has been queued together with its whole subtree during
+// this frame, so both the node and its children can be skipped.
 void Scene::markAsChanged(NodeIndex node_index) {
-    const NodeLevel level = m_hierarchy[node_index].level;
-    m_dirty_at_level[level].push_back(node_index);
+    if (m_dirty_generation[node_index] == m_current_generation) return;
+
+    m_mark_stack.push_back(node_index);
+    while (!m_mark_stack.empty()) {
+        const NodeIndex n = m_mark_stack.back();
+        m_mark_stack.pop_back();
+        if (m_dirty_generation[n] == m_current_generation) continue;
+
+        m_dirty_generation[n] = m_current_generation;
+        const NodeLevel level = m_hierarchy[n].level;
+        if (level >= m_dirty_at_level.size()) {
+            m_dirty_at_level.resize(level + 1u);
+        }
+        m_dirty_at_level[level].push_back(n);
 
-    if(m_skeleton_manager && (getNodeTypeFlags(node_index) & NODE_TYPE_FLAG_BONE)) {
-        std::shared_ptr<BoneNode> bone = std::dynamic_pointer_cast<BoneNode>(getProperty(node_index, NODE_TYPE_FLAG_BONE));
-        m_skeleton_manager->markAsChanged(bone);
+        if(m_skeleton_manager && (getNodeTypeFlags(n) & NODE_TYPE_FLAG_BONE)) {
+            std::shared_ptr<BoneNode> bone = std::dynamic_pointer_cast<BoneNode>(getProperty(n, NODE_TYPE_FLAG_BONE));
+            m_skeleton_manager->markAsChanged(bone);
+        }
+
+        for (NodeIndex child = m_hierarchy[n].first_child; child != NO_INDEX; child = m_hierarchy[child].next_sibling) {
+            m_mark_stack.push_back(child);
+        }
     }
+}
+
+const Scene::NodeIndexArray& Scene::getDirtyNodes(NodeLevel level) const {
+    if (level >= m_dirty_at_level.size()) return EMPTY_NODE_LIST;
+    return m_dirty_at_level[level];
+}
 
-    for (int n = m_hierarchy[node_index].first_child; n != -1; n = m_hierarchy[n].next_sibling) {
-        markAsChanged(n);
+// markAsChanged() queues every node once per generation, sorting keeps the batches walking the arrays forward.
+void Scene::sortDirtyNodes() {
+    for (NodeIndexArray& dirty_nodes : m_dirty_at_level) {
+        std::sort(dirty_nodes.begin(), dirty_nodes.end());
     }
 }
 
-int Scene::findNodeByName(const std::string& name) const {
-    // Extremely simple linear search without any hierarchy reference
-    // To support DFS/BFS searches separate traversal routines are needed
-
-    size_t sz = m_hierarchy.size();
-    for (size_t n = 0; n < sz; ++n) {
-        if (m_node_name_map.contains(n)) {
-            int name_index = m_node_name_map.at(n);
-            if (name_index != NO_INDEX) {
-                if (m_node_names[name_index] == name) {
-                    return (int)n;
-                }
-            }
-        }
+void Scene::nextDirtyGeneration() {
+    if (++m_current_generation == 0u) {
+        std::fill(m_dirty_generation.begin(), m_dirty_generation.end(), 0u);
+        m_current_generation = 1u;
     }
+}
+
+int Scene::findNodeByName(const std::string& name) const {
+    const NodeIndexArray& nodes = findNodesByName(name);
+    return nodes.empty() ? NO_INDEX : (int)nodes.front();
+}
 
-    return NO_INDEX;
+const Scene::NodeIndexArray& Scene::findNodesByName(const std::string& name) const {
+    const StringInternTable::StringId name_id = m_name_table.find(name);
+    if (name_id == StringInternTable::NO_ID) return EMPTY_NODE_LIST;
+    return m_nodes_by_name[name_id];
+}
+
+const Scene::NodeIndexArray& Scene::getNodesOfType(NodeType node_type) const {
+    if (node_type == NODE_TYPE_FLAG_NONE || !std::has_single_bit(node_type)) return EMPTY_NODE_LIST;
+    const uint32_t type_slot = std::countr_zero(node_type);
+    if (type_slot >= NODE_TYPE_COUNT) return EMPTY_NODE_LIST;
+    return m_nodes_by_type[type_slot];
 }
 
 const std::string Scene::getSceneName() const {
@@ -122,16 +200,22 @@ const glm::mat4& Scene::getNodeLocalTransform(Scene::NodeIndex node_index) const
 
 void Scene::setNodeLocalTransform(Scene::NodeIndex node_index, const glm::mat4& local_transform) {
     m_local_transform[node_index] = local_transform;
-    m_inv_local_transform[node_index] = glm::inverse(local_transform);
+    setStaleBit(m_stale_inv_local, node_index);
+    ++m_inverse_counters.invalidated;
     markAsChanged(node_index);
 }
 
+void Scene::setThreadPool(std::shared_ptr<ThreadPool> thread_pool) {
+    m_thread_pool = std::move(thread_pool);
+}
+
 const std::vector<glm::mat4>& Scene::getNodeInvLocalTransforms() const {
+    resolveAllInverses(m_stale_inv_local, m_local_transform, m_inv_local_transform);
     return m_inv_local_transform;
 }
 
 const glm::mat4& Scene::getNodeInvLocalTransform(NodeIndex node_index) const {
-    return m_inv_local_transform[node_index];
+    return resolveInverse(m_stale_inv_local, m_local_transform, m_inv_local_transform, node_index);
 }
 
 const std::vector<glm::mat4>& Scene::getNodeGlobalTransforms() const {
@@ -143,11 +227,51 @@ const glm::mat4& Scene::getNodeGlobalTransform(Scene::NodeIndex node_index) cons
 }
 
 const std::vector<glm::mat4>& Scene::getNodeInvGlobalTransforms() const {
+    resolveAllInverses(m_stale_inv_global, m_global_transform, m_inv_global_transform);
     return m_inv_global_transform;
 }
 
 const glm::mat4& Scene::getNodeInvGlobalTransform(NodeIndex node_index) const {
-    return m_inv_global_transform[node_index];
+    return resolveInverse(m_stale_inv_global, m_global_transform, m_inv_global_transform, node_index);
+}
+
+const Scene::InverseCounters& Scene::getInverseCounters() const {
+    return m_inverse_counters;
+}
+
+void Scene::resetInverseCounters() {
+    m_inverse_counters = {};
+}
+
+const glm::mat4& Scene::resolveInverse(std::vector<uint64_t>& stale_bits, const std::vector<glm::mat4>& transforms, std::vector<glm::mat4>& inv_transforms, NodeIndex node_index) const {
+    const size_t word = node_index >> 6u;
+    const uint64_t mask = 1ull << (node_index & 63u);
+    if (word < stale_bits.size() && (stale_bits[word] & mask)) {
+        InversePath path;
+        inv_transforms[node_index] = fastInverse(transforms[node_index], path);
+        stale_bits[word] &= ~mask;
+
+        switch (path) {
+            case InversePath::UNIFORM_SCALE: ++m_inverse_counters.computed_uniform_scale; break;
+            case InversePath::AFFINE: ++m_inverse_counters.computed_affine; break;
+            case InversePath::GENERAL: ++m_inverse_counters.computed_general; break;
+        }
+    }
+    return inv_transforms[node_index];
+}
+
+void Scene::resolveAllInverses(std::vector<uint64_t>& stale_bits, const std::vector<glm::mat4>& transforms, std::vector<glm::mat4>& inv_transforms) const {
+    const size_t count = transforms.size();
+    for (size_t word = 0u; word < stale_bits.size(); ++word) {
+        uint64_t bits = stale_bits[word];
+        while (bits) {
+            const size_t node_index = (word << 6u) + std::countr_zero(bits);
+            bits &= bits - 1u;
+            if (node_index >= count) break;
+            resolveInverse(stale_bits, transforms, inv_transforms, static_cast<NodeIndex>(node_index));
+        }
+        stale_bits[word] = 0u;
+    }
 }
 
 const Scene::Hierarchy& Scene::getNodeHierarchy(Scene::NodeIndex node_index) const {
@@ -159,15 +283,36 @@ const std::vector<Scene::Hierarchy>& Scene::getHierarchy() const {
 }
 
 Scene::NodeTypeFlags Scene::getNodeTypeFlags(Scene::NodeIndex node_index) const {
-    if(m_node_type_flags_map.contains(node_index)) {
-        return m_node_type_flags_map.at(node_index);
+    if(node_index >= m_node_type_flags.size()) return NODE_TYPE_FLAG_NONE;
+    return m_node_type_flags[node_index];
+}
+
+void Scene::setNodeBounds(NodeIndex node_index, const BoundingBox& local_bounds) {
+    m_node_bounds[node_index] = local_bounds;
+
+    BoundingBox world_bounds;
+    local_bounds.Transform(world_bounds, m_global_transform[node_index]);
+    if (m_node_proxy[node_index] == DynamicAABBTree::NULL_NODE) {
+        m_node_proxy[node_index] = m_spatial_index.createProxy(world_bounds, node_index);
     }
-    else return NODE_TYPE_FLAG_NONE;
+    else {
+        m_spatial_index.moveProxy(m_node_proxy[node_index], world_bounds);
+    }
+}
+
+const DynamicAABBTree& Scene::getSpatialIndex() const {
+    return m_spatial_index;
+}
+
+DynamicAABBTree::ProxyId Scene::getNodeProxy(NodeIndex node_index) const {
+    if (node_index >= m_node_proxy.size()) return DynamicAABBTree::NULL_NODE;
+    return m_node_proxy[node_index];
 }
 
 const std::shared_ptr<Scene::Properties>& Scene::getProperties(Scene::NodeIndex node_index) {
-    if(!m_node_property_map.contains(node_index)) return NULL_PTR_PROP;
-    const Scene::PropertyIndex property_index = m_node_property_map.at(node_index);
+    if(node_index >= m_node_property_index.size()) return NULL_PTR_PROP;
+    const Scene::PropertyIndex property_index = m_node_property_index[node_index];
+    if(property_index == NO_INDEX) return NULL_PTR_PROP;
     return m_properties[property_index];
 }
 
@@ -195,19 +340,29 @@ void Scene::addProperty(std::shared_ptr<SceneNode> property, NodeIndex node_inde
         m_animation_manager->AddNodeAnimation(std::dynamic_pointer_cast<AnimationNode>(property));
     }
 
+    if(node_type != NODE_TYPE_FLAG_NONE) {
+        insertSortedIdx(m_nodes_by_type[std::countr_zero(node_type)], node_index);
+    }
+    if(node_type == NODE_TYPE_FLAG_AABB) {
+        setNodeBounds(node_index, std::dynamic_pointer_cast<AABBNode>(property)->getAABB());
+    }
+
     if(!m_node_property_map.contains(node_index)) {
         Scene::PropertyIndex property_index = m_properties.size();
         m_node_property_map[node_index] = property_index;
+        m_node_property_index[node_index] = property_index;
         Properties new_props;
         new_props[node_type] = property;
         m_properties.push_back(std::make_shared<Properties>(std::move(new_props)));
 
-        m_node_type_flags_map[node_index] = property->Get().GetNodeType();
+        m_node_type_flags_map[node_index] = node_type;
+        m_node_type_flags[node_index] = node_type;
         
         return;
     }
 
     m_node_type_flags_map[node_index] |= node_type;
+    m_node_type_flags[node_index] |= node_type;
 
     Scene::PropertyIndex property_index = m_node_property_map[node_index];
     m_properties[property_index]->operator[](node_type) = std::move(property);
@@ -226,6 +381,7 @@ const std::vector<std::shared_ptr<Scene::Properties>>& Scene::getProperties() co
 }
 
 void Scene::setNodeName(NodeIndex node_index, std::string name) {
+    linkNodeName(node_index, name);
     if(m_node_name_map.count(node_index)) {
         NameIndex name_index = m_node_name_map[node_index];
         m_node_names[name_index] = name;
@@ -244,28 +400,119 @@ const std::unordered_map<Scene::NodeIndex, Scene::NameIndex>& Scene::getNodeName
     return m_node_name_map;
 }
 
+void Scene::linkNodeName(NodeIndex node_index, const std::string& name) {
+    const StringInternTable::StringId old_name_id = m_node_name_id[node_index];
+    if (old_name_id != StringInternTable::NO_ID) {
+        eraseSortedIdx(m_nodes_by_name[old_name_id], node_index);
+    }
+
+    const StringInternTable::StringId name_id = m_name_table.intern(name);
+    if (name_id >= m_nodes_by_name.size()) {
+        m_nodes_by_name.resize(name_id + 1u);
+    }
+    insertSortedIdx(m_nodes_by_name[name_id], node_index);
+    m_node_name_id[node_index] = name_id;
+}
+
+// Rebuilds the flat per node arrays and the name and type indices from the maps, used after the node indices move.
+void Scene::rebuildLookupIndices() {
+    const size_t node_count = m_hierarchy.size();
+    m_node_type_flags.assign(node_count, NODE_TYPE_FLAG_NONE);
+    m_node_property_index.assign(node_count, NO_INDEX);
+    m_node_name_id.assign(node_count, StringInternTable::NO_ID);
+    m_name_table.clear();
+    m_nodes_by_name.clear();
+    for (NodeIndexArray& nodes : m_nodes_by_type) {
+        nodes.clear();
+    }
+
+    for (const auto& [node_index, node_type_flags] : m_node_type_flags_map) {
+        if (node_index < node_count) m_node_type_flags[node_index] = node_type_flags;
+    }
+    for (const auto& [node_index, property_index] : m_node_property_map) {
+        if (node_index < node_count) m_node_property_index[node_index] = property_index;
+    }
+    for (const auto& [node_index, name_index] : m_node_name_map) {
+        if (node_index < node_count && name_index < m_node_names.size()) m_node_name_id[node_index] = m_name_table.intern(m_node_names[name_index]);
+    }
+
+    // Walking the nodes in order keeps every list sorted.
+    m_nodes_by_name.resize(m_name_table.size());
+    for (NodeIndex n = 0u; n < node_count; ++n) {
+        for (NodeTypeFlags flags = m_node_type_flags[n]; flags != 0u; flags &= flags - 1u) {
+            const uint32_t type_slot = std::countr_zero(flags);
+            if (type_slot < NODE_TYPE_COUNT) m_nodes_by_type[type_slot].push_back(n);
+        }
+        if (m_node_name_id[n] != StringInternTable::NO_ID) {
+            m_nodes_by_name[m_node_name_id[n]].push_back(n);
+        }
+    }
+}
+
+// Node indices are the user data of the proxies, so the tree is rebuilt whenever they move.
+void Scene::rebuildSpatialIndex() {
+    m_spatial_index.clear();
+    for (NodeIndex n = 0u; n < m_node_proxy.size(); ++n) {
+        if (m_node_proxy[n] == DynamicAABBTree::NULL_NODE) continue;
+
+        BoundingBox world_bounds;
+        m_node_bounds[n].Transform(world_bounds, m_global_transform[n]);
+        m_node_proxy[n] = m_spatial_index.createProxy(world_bounds, n);
+    }
+}
+
 int Scene::getNodeLevel(Scene::NodeIndex node_index) const {
     return m_hierarchy[node_index].level;
 }
 
-// CPU version of global transform update []
+// CPU version of global transform update. Levels are processed top down, every node of a level only reads its
+// parent from the previous level, so a level is an independent batch and large ones are split across the pool.
 bool Scene::recalculateGlobalTransforms() {
     bool was_updated = false;
 
-    for (int lvl = 1; lvl < MAX_NODE_LEVEL; ++lvl) {
-        for (int dirty_node_index : m_dirty_at_level[lvl]) {
-            const int parent_node_index = m_hierarchy[dirty_node_index].parent;
-            glm::mat4 new_global_transform = m_global_transform[parent_node_index] * m_local_transform[dirty_node_index];
-            m_global_transform[dirty_node_index] = new_global_transform;
-            m_inv_global_transform[dirty_node_index] = glm::inverse(new_global_transform);
+    sortDirtyNodes();
+    for (size_t lvl = 1u; lvl < m_dirty_at_level.size(); ++lvl) {
+        NodeIndexArray& dirty_nodes = m_dirty_at_level[lvl];
+        if (dirty_nodes.empty()) continue;
+
+        const size_t count = dirty_nodes.size();
+        if (m_thread_pool && count >= PARALLEL_LEVEL_THRESHOLD) {
+            m_thread_pool->ParallelForRange(0u, count, PARALLEL_LEVEL_GRAIN, [this, &dirty_nodes](size_t first, size_t last) {
+                recalculateGlobalTransforms(dirty_nodes, first, last);
+            });
+        }
+        else {
+            recalculateGlobalTransforms(dirty_nodes, 0u, count);
+        }
+
+        // The tree is not thread safe, proxies of the level are refitted here after the batch is done.
+        for (NodeIndex dirty_node_index : dirty_nodes) {
+            setStaleBit(m_stale_inv_global, dirty_node_index);
+            if (m_node_proxy[dirty_node_index] != DynamicAABBTree::NULL_NODE) {
+                BoundingBox world_bounds;
+                m_node_bounds[dirty_node_index].Transform(world_bounds, m_global_transform[dirty_node_index]);
+                m_spatial_index.moveProxy(m_node_proxy[dirty_node_index], world_bounds);
+            }
         }
-        was_updated |= !m_dirty_at_level[lvl].empty();
-        m_dirty_at_level[lvl].clear();
+        m_inverse_counters.invalidated += static_cast<uint32_t>(count);
+
+        was_updated = true;
+        dirty_nodes.clear();
     }
 
+    nextDirtyGeneration();
+
     return was_updated;
 }
 
+void Scene::recalculateGlobalTransforms(const NodeIndexArray& dirty_nodes, size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+        const NodeIndex dirty_node_index = dirty_nodes[i];
+        const NodeIndex parent_node_index = m_hierarchy[dirty_node_index].parent;
+        mat4Mul(m_global_transform[parent_node_index], m_local_transform[dirty_node_index], m_global_transform[dirty_node_index]);
+    }
+}
+
 static void addUniqueIdx(std::vector<Scene::NodeIndex>& v, Scene::NodeIndex index) {
     if (!std::binary_search(v.begin(), v.end(), index)) {
         v.push_back(index);
@@ -359,6 +606,7 @@ void Scene::deleteSceneNodes(const std::vector<NodeIndex>& nodes_indices_to_dele
 
     // 3) Finally throw away the hierarchy items
     eraseSelected(m_hierarchy, copy_of_indices_to_delete);
+    eraseSelected(m_dirty_generation, copy_of_indices_to_delete);
 
     // 4) As in mergeScenes() routine we also have to adjust all the "components" (i.e., meshes, materials, names and transformations)
 
@@ -367,11 +615,19 @@ void Scene::deleteSceneNodes(const std::vector<NodeIndex>& nodes_indices_to_dele
     eraseSelected(m_global_transform, copy_of_indices_to_delete);
     eraseSelected(m_inv_local_transform, copy_of_indices_to_delete);
     eraseSelected(m_inv_global_transform, copy_of_indices_to_delete);
+    setAllStaleBits(m_stale_inv_local, m_local_transform.size());
+    setAllStaleBits(m_stale_inv_global, m_global_transform.size());
 
     // 4b) All the maps should change the key values with the newIndices[] array
     shiftMapIndices(m_node_type_flags_map, new_indices);
     shiftMapIndices(m_node_property_map, new_indices);
     shiftMapIndices(m_node_name_map, new_indices);
+    rebuildLookupIndices();
+
+    // 4c) Bounds are per node arrays as well, the tree is keyed by node index and has to be rebuilt
+    eraseSelected(m_node_bounds, copy_of_indices_to_delete);
+    eraseSelected(m_node_proxy, copy_of_indices_to_delete);
+    rebuildSpatialIndex();
 
     // 5) scene node names list is not modified, but in principle it can be (remove all non-used items and adjust the nameForNode_ map)
     // 6) Material names list is not modified also, but if some materials fell out of use
@@ -429,6 +685,8 @@ void Scene::mergeScenes(const std::vector<Scene*>& scenes, const std::vector<glm
     m_global_transform.push_back(glm::mat4(1.0f));
     m_inv_local_transform.push_back(glm::mat4(1.0f));
     m_inv_global_transform.push_back(glm::mat4(1.0f));
+    m_node_bounds.push_back(BoundingBox());
+    m_node_proxy.push_back(DynamicAABBTree::NULL_NODE);
 
     if (scenes.empty()) return;
 
@@ -448,6 +706,8 @@ void Scene::mergeScenes(const std::vector<Scene*>& scenes, const std::vector<glm
         mergeVectors(m_global_transform, s->m_global_transform);
         mergeVectors(m_inv_local_transform, s->m_inv_local_transform);
         mergeVectors(m_inv_global_transform, s->m_inv_global_transform);
+        mergeVectors(m_node_bounds, s->m_node_bounds);
+        mergeVectors(m_node_proxy, s->m_node_proxy);
 
         mergeVectors(m_hierarchy, s->m_hierarchy);
 
@@ -491,7 +751,6 @@ void Scene::mergeScenes(const std::vector<Scene*>& scenes, const std::vector<glm
         // transform old root nodes, if the transforms are given
         if (!root_transforms.empty()) {
             m_local_transform[offs] = root_transforms[idx] * m_local_transform[offs];
-            m_inv_local_transform[offs] = glm::inverse(m_local_transform[offs]);
         }
 
         offs += node_count;
@@ -502,6 +761,12 @@ void Scene::mergeScenes(const std::vector<Scene*>& scenes, const std::vector<glm
     for (auto i = m_hierarchy.begin() + 1; i != m_hierarchy.end(); ++i) {
         i->level++;
     }
+
+    setAllStaleBits(m_stale_inv_local, m_local_transform.size());
+    setAllStaleBits(m_stale_inv_global, m_global_transform.size());
+    m_dirty_generation.assign(m_hierarchy.size(), 0u);
+    rebuildLookupIndices();
+    rebuildSpatialIndex();
 }
 
 const std::shared_ptr<LightManager>& Scene::getLightManager() const {
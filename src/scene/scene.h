@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <cassert>
 #include <iostream>
 #include <memory>
@@ -18,26 +19,31 @@
 #include <glm/ext.hpp>
 
 #include "../graphics/pod/material.h"
+#include "../physics/bounding_box.h"
+#include "../physics/dynamic_aabb_tree.h"
+#include "../tools/string_intern_table.h"
 
-constexpr const int MAX_NODE_LEVEL = 32;
+constexpr const int MAX_NODE_LEVEL = 32; // Levels queued up front, deeper hierarchies add theirs on demand
 
 class SceneNode;
 class LightManager;
 class AnimationManager;
 class SkeletonManager;
+class ThreadPool;
 
 class Scene : public std::enable_shared_from_this<Scene> {
 public:
-    static const uint32_t NODE_TYPE_FLAG_NONE = 0u;
-    static const uint32_t NODE_TYPE_FLAG_MESH = 1u;
-	static const uint32_t NODE_TYPE_FLAG_LIGHT = 2u;
-	static const uint32_t NODE_TYPE_FLAG_CAMERA = 4u;
-	static const uint32_t NODE_TYPE_FLAG_SHADOW_CAMERA = 8u;
-	static const uint32_t NODE_TYPE_FLAG_AABB = 16u;
-	static const uint32_t NODE_TYPE_FLAG_SPHERE = 32u;
-	static const uint32_t NODE_TYPE_FLAG_BONE = 64u;
-	static const uint32_t NODE_TYPE_FLAG_VALUE_BAG = 128u;
-	static const uint32_t NODE_TYPE_FLAG_ANIMATION = 256u;
+    static constexpr uint32_t NODE_TYPE_FLAG_NONE = 0u;
+    static constexpr uint32_t NODE_TYPE_FLAG_MESH = 1u;
+	static constexpr uint32_t NODE_TYPE_FLAG_LIGHT = 2u;
+	static constexpr uint32_t NODE_TYPE_FLAG_CAMERA = 4u;
+	static constexpr uint32_t NODE_TYPE_FLAG_SHADOW_CAMERA = 8u;
+	static constexpr uint32_t NODE_TYPE_FLAG_AABB = 16u;
+	static constexpr uint32_t NODE_TYPE_FLAG_SPHERE = 32u;
+	static constexpr uint32_t NODE_TYPE_FLAG_BONE = 64u;
+	static constexpr uint32_t NODE_TYPE_FLAG_VALUE_BAG = 128u;
+	static constexpr uint32_t NODE_TYPE_FLAG_ANIMATION = 256u;
+	static constexpr uint32_t NODE_TYPE_COUNT = 9u;
 
 	using NodeIndex = uint32_t;
     using NodeLevel = uint32_t;
@@ -58,6 +64,14 @@ public:
 		NodeLevel level = 0;
 	};
 
+	// How many inverses were invalidated and how many were actually computed on access, split by the path taken.
+	struct InverseCounters {
+		uint32_t invalidated = 0u;
+		uint32_t computed_uniform_scale = 0u;
+		uint32_t computed_affine = 0u;
+		uint32_t computed_general = 0u;
+	};
+
     Scene(std::string name);
 
 	int addNode(NodeIndex parent_index = 0u);
@@ -66,7 +80,12 @@ public:
 	int addNode(const glm::mat4& local_transform, std::string name, NodeIndex parent_index = 0);
 
     void markAsChanged(NodeIndex node_index);
+    // Nodes queued for the next recalculateGlobalTransforms() at a level, which sorts them before propagating.
+    const NodeIndexArray& getDirtyNodes(NodeLevel level) const;
+    void sortDirtyNodes();
     int findNodeByName(const std::string& name) const;
+    const NodeIndexArray& findNodesByName(const std::string& name) const;
+    const NodeIndexArray& getNodesOfType(NodeType node_type) const;
 
 	const std::string getSceneName() const;
 
@@ -85,11 +104,18 @@ public:
 	const glm::mat4& getNodeGlobalTransform(NodeIndex node_index) const;
 	const std::vector<glm::mat4>& getNodeInvGlobalTransforms() const;
 	const glm::mat4& getNodeInvGlobalTransform(NodeIndex node_index) const;
+	const InverseCounters& getInverseCounters() const;
+	void resetInverseCounters();
 
 	const Hierarchy& getNodeHierarchy(NodeIndex node_index) const;
 	const std::vector<Hierarchy>& getHierarchy() const;
 	NodeTypeFlags getNodeTypeFlags(NodeIndex node_index) const;
 
+	// Local space bounds of a node, its world box is kept in the spatial index and follows the global transform.
+	void setNodeBounds(NodeIndex node_index, const BoundingBox& local_bounds);
+	const DynamicAABBTree& getSpatialIndex() const;
+	DynamicAABBTree::ProxyId getNodeProxy(NodeIndex node_index) const;
+
 	const std::shared_ptr<Properties>& getProperties(NodeIndex node_index);
 	const std::shared_ptr<SceneNode>& getProperty(NodeIndex node_index, NodeType node_type = NODE_TYPE_FLAG_NONE);
 	std::shared_ptr<SceneNode> getRootNode();
@@ -100,6 +126,7 @@ public:
 
     int getNodeLevel(NodeIndex node_index) const;
     bool recalculateGlobalTransforms();
+    void setThreadPool(std::shared_ptr<ThreadPool> thread_pool);
     void deleteSceneNodes(const std::vector<NodeIndex>& nodes_indices_to_delete);
 	void mergeScenes(const std::vector<Scene*>& scenes, const std::vector<glm::mat4>& root_transforms, const std::vector<uint32_t>& mesh_counts, bool merge_meshes, bool merge_materials);
 
@@ -110,21 +137,51 @@ public:
 private:
 	NodeIndex findLastNonDeletedItem(const std::vector<NodeIndex>& new_indices, NodeIndex node);
 	void shiftNodes(int startOffset, int nodeCount, int shiftAmount);
+	void nextDirtyGeneration();
+	void linkNodeName(NodeIndex node_index, const std::string& name);
+	void rebuildLookupIndices();
+	void rebuildSpatialIndex();
+	void recalculateGlobalTransforms(const NodeIndexArray& dirty_nodes, size_t first, size_t last);
+	const glm::mat4& resolveInverse(std::vector<uint64_t>& stale_bits, const std::vector<glm::mat4>& transforms, std::vector<glm::mat4>& inv_transforms, NodeIndex node_index) const;
+	void resolveAllInverses(std::vector<uint64_t>& stale_bits, const std::vector<glm::mat4>& transforms, std::vector<glm::mat4>& inv_transforms) const;
+
+	static constexpr size_t PARALLEL_LEVEL_THRESHOLD = 1024u;
+	static constexpr size_t PARALLEL_LEVEL_GRAIN = 256u;
 
 	std::vector<glm::mat4> m_local_transform; // convert from local space to parent space
 	std::vector<glm::mat4> m_global_transform; // accumulated convert from local space directly to root space(world space)
-	std::vector<glm::mat4> m_inv_local_transform;
-	std::vector<glm::mat4> m_inv_global_transform;
+	// Inverses are computed on first access, a set bit in the stale masks means the cached inverse is out of date.
+	// The const getters fill them in, so readers have to be on the thread that updates the scene.
+	mutable std::vector<glm::mat4> m_inv_local_transform;
+	mutable std::vector<glm::mat4> m_inv_global_transform;
+	mutable std::vector<uint64_t> m_stale_inv_local;
+	mutable std::vector<uint64_t> m_stale_inv_global;
+	mutable InverseCounters m_inverse_counters;
 	std::vector<Hierarchy> m_hierarchy;
 	std::vector<NodeIndexArray> m_dirty_at_level;
+	std::vector<uint32_t> m_dirty_generation; // generation in which the node was last queued for propagation
+	uint32_t m_current_generation = 1u;
+	NodeIndexArray m_mark_stack;
 
     std::unordered_map<NodeIndex, NodeTypeFlags> m_node_type_flags_map;
 	std::unordered_map<NodeIndex, PropertyIndex> m_node_property_map;
 	std::unordered_map<NodeIndex, NameIndex> m_node_name_map;
 
 	std::vector<std::string> m_node_names;
+
+	// Flat per node mirrors of the maps above and reverse indices, all node lists are kept sorted.
+	std::vector<NodeTypeFlags> m_node_type_flags;
+	std::vector<PropertyIndex> m_node_property_index;
+	std::vector<StringInternTable::StringId> m_node_name_id;
+	StringInternTable m_name_table;
+	std::vector<NodeIndexArray> m_nodes_by_name;
+	std::array<NodeIndexArray, NODE_TYPE_COUNT> m_nodes_by_type;
 	std::vector<std::shared_ptr<Properties>> m_properties;
+	std::vector<BoundingBox> m_node_bounds;
+	std::vector<DynamicAABBTree::ProxyId> m_node_proxy; // NULL_NODE for nodes without bounds
+	DynamicAABBTree m_spatial_index;
 	std::shared_ptr<LightManager> m_light_manager;
 	std::shared_ptr<AnimationManager> m_animation_manager;
 	std::shared_ptr<SkeletonManager> m_skeleton_manager;
+	std::shared_ptr<ThreadPool> m_thread_pool;
 };
\ No newline at end of file
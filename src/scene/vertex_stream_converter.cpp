@@ -0,0 +1,140 @@
+#include "vertex_stream_converter.h"
+
+#include "../tools/simd_math.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined(MASIC_SIMD_SSE)
+#include <emmintrin.h>
+#endif
+
+namespace {
+    template<typename Src, typename Dst, bool Normalized>
+    void convertComponents(const VertexAttributeStream& stream, unsigned char* dst, size_t dst_stride) {
+        constexpr bool normalize = Normalized && std::is_same_v<Dst, float> && std::is_integral_v<Src>;
+        constexpr float scale = std::is_integral_v<Src> ? 1.0f / static_cast<float>(std::numeric_limits<Src>::max()) : 1.0f;
+
+        for (size_t element = 0u; element < stream.count; ++element) {
+            const unsigned char* src_element = stream.src + element * stream.src_stride;
+            unsigned char* dst_element = dst + element * dst_stride + stream.dst_offset;
+            for (uint32_t component = 0u; component < stream.components; ++component) {
+                Src value;
+                memcpy(&value, src_element + component * sizeof(Src), sizeof(Src));
+                Dst result;
+                if constexpr (normalize && std::is_signed_v<Src>) {
+                    result = std::max(static_cast<float>(value) * scale, -1.0f);
+                }
+                else if constexpr (normalize) {
+                    result = static_cast<float>(value) * scale;
+                }
+                else {
+                    result = static_cast<Dst>(value);
+                }
+                memcpy(dst_element + component * sizeof(Dst), &result, sizeof(Dst));
+            }
+        }
+    }
+
+#if defined(MASIC_SIMD_SSE)
+    // Up to four components are gathered into the low lane, zero extended to 32 bit and scaled in one go.
+    template<typename Src>
+    void convertUnormToFloat(const VertexAttributeStream& stream, unsigned char* dst, size_t dst_stride) {
+        const __m128 scale = _mm_set1_ps(1.0f / static_cast<float>(std::numeric_limits<Src>::max()));
+        const __m128i zero = _mm_setzero_si128();
+        const size_t src_bytes = stream.components * sizeof(Src);
+        const size_t dst_bytes = stream.components * sizeof(float);
+
+        alignas(16) float result[4];
+        for (size_t element = 0u; element < stream.count; ++element) {
+            uint64_t raw = 0u;
+            memcpy(&raw, stream.src + element * stream.src_stride, src_bytes);
+            __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&raw));
+            if constexpr (sizeof(Src) == 1u) {
+                packed = _mm_unpacklo_epi8(packed, zero);
+            }
+            const __m128i widened = _mm_unpacklo_epi16(packed, zero);
+            _mm_store_ps(result, _mm_mul_ps(_mm_cvtepi32_ps(widened), scale));
+            memcpy(dst + element * dst_stride + stream.dst_offset, result, dst_bytes);
+        }
+    }
+#endif
+
+    template<typename Src, typename Dst>
+    void convertTyped(const VertexAttributeStream& stream, unsigned char* dst, size_t dst_stride) {
+        if (!stream.normalized) {
+            convertComponents<Src, Dst, false>(stream, dst, dst_stride);
+            return;
+        }
+#if defined(MASIC_SIMD_SSE)
+        if constexpr (std::is_same_v<Dst, float> && (std::is_same_v<Src, uint8_t> || std::is_same_v<Src, uint16_t>)) {
+            if (stream.components <= 4u) {
+                convertUnormToFloat<Src>(stream, dst, dst_stride);
+                return;
+            }
+        }
+#endif
+        convertComponents<Src, Dst, true>(stream, dst, dst_stride);
+    }
+
+    template<typename Dst>
+    void convertFrom(const VertexAttributeStream& stream, unsigned char* dst, size_t dst_stride) {
+        switch (stream.src_type) {
+            case VertexComponentType::INT8: convertTyped<int8_t, Dst>(stream, dst, dst_stride); break;
+            case VertexComponentType::UINT8: convertTyped<uint8_t, Dst>(stream, dst, dst_stride); break;
+            case VertexComponentType::INT16: convertTyped<int16_t, Dst>(stream, dst, dst_stride); break;
+            case VertexComponentType::UINT16: convertTyped<uint16_t, Dst>(stream, dst, dst_stride); break;
+            case VertexComponentType::INT32: convertTyped<int32_t, Dst>(stream, dst, dst_stride); break;
+            case VertexComponentType::UINT32: convertTyped<uint32_t, Dst>(stream, dst, dst_stride); break;
+            case VertexComponentType::FLOAT32: convertTyped<float, Dst>(stream, dst, dst_stride); break;
+            default: break;
+        }
+    }
+
+    void copyElements(const VertexAttributeStream& stream, unsigned char* dst, size_t dst_stride) {
+        const size_t element_bytes = stream.components * getVertexComponentSize(stream.src_type);
+        if (stream.src_stride == element_bytes && dst_stride == element_bytes && stream.dst_offset == 0u) {
+            memcpy(dst, stream.src, element_bytes * stream.count);
+            return;
+        }
+        for (size_t element = 0u; element < stream.count; ++element) {
+            memcpy(dst + element * dst_stride + stream.dst_offset, stream.src + element * stream.src_stride, element_bytes);
+        }
+    }
+}
+
+size_t getVertexComponentSize(VertexComponentType type) {
+    switch (type) {
+        case VertexComponentType::INT8: return 1u;
+        case VertexComponentType::UINT8: return 1u;
+        case VertexComponentType::INT16: return 2u;
+        case VertexComponentType::UINT16: return 2u;
+        case VertexComponentType::INT32: return 4u;
+        case VertexComponentType::UINT32: return 4u;
+        case VertexComponentType::FLOAT32: return 4u;
+        default: return 0u;
+    }
+}
+
+void convertVertexStream(const VertexAttributeStream& stream, unsigned char* dst, size_t dst_stride) {
+    if (stream.src_type == VertexComponentType::UNSUPPORTED || stream.dst_type == VertexComponentType::UNSUPPORTED) return;
+
+    // A normalized integer source only needs work when the shader reads float, otherwise the bits go as they are.
+    if (stream.src_type == stream.dst_type) {
+        copyElements(stream, dst, dst_stride);
+        return;
+    }
+
+    switch (stream.dst_type) {
+        case VertexComponentType::INT8: convertFrom<int8_t>(stream, dst, dst_stride); break;
+        case VertexComponentType::UINT8: convertFrom<uint8_t>(stream, dst, dst_stride); break;
+        case VertexComponentType::INT16: convertFrom<int16_t>(stream, dst, dst_stride); break;
+        case VertexComponentType::UINT16: convertFrom<uint16_t>(stream, dst, dst_stride); break;
+        case VertexComponentType::INT32: convertFrom<int32_t>(stream, dst, dst_stride); break;
+        case VertexComponentType::UINT32: convertFrom<uint32_t>(stream, dst, dst_stride); break;
+        case VertexComponentType::FLOAT32: convertFrom<float>(stream, dst, dst_stride); break;
+        default: break;
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Component types of glTF accessors and of the vertex formats the shaders ask for.
+enum class VertexComponentType : uint8_t {
+    INT8,
+    UINT8,
+    INT16,
+    UINT16,
+    INT32,
+    UINT32,
+    FLOAT32,
+    UNSUPPORTED
+};
+
+// One attribute of a primitive: where its components are read from and where they land in the interleaved vertex.
+struct VertexAttributeStream {
+    const unsigned char* src = nullptr; // First component of the first element
+    size_t src_stride = 0u;
+    VertexComponentType src_type = VertexComponentType::UNSUPPORTED;
+    bool normalized = false; // Integer sources map to [0, 1] or [-1, 1] when the destination is float
+    size_t dst_offset = 0u;
+    VertexComponentType dst_type = VertexComponentType::UNSUPPORTED;
+    uint32_t components = 0u; // Per element, destination components past this count are left untouched
+    size_t count = 0u;
+};
+
+size_t getVertexComponentSize(VertexComponentType type);
+
+// Equal component types are copied as whole elements, the rest are converted component by component. Normalized 8 and
+// 16 bit unsigned sources are widened to float with SSE2 when it is available.
+void convertVertexStream(const VertexAttributeStream& stream, unsigned char* dst, size_t dst_stride);
@@ -0,0 +1,258 @@
+#define STB_IMAGE_IMPLEMENTATION
+#define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_NO_STB_IMAGE_WRITE
+#include <tiny_gltf.h>
+
+#include "tools/ktx2_file.h"
+#include "tools/texture_tools.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Offline texture cooker: encodes the images of glTF models to BC compressed KTX2 files with their full mip chain,
+// written where MeshNodeLoader looks for them (see getCookedTexturePath()). Normal maps get BC5, their red and green
+// channels, other images BC7 unless another color format is asked for.
+//
+// texture_cooker [--color bc7|bc3|bc1] [--textures <dir>] [--force] <model.gltf|directory>...
+
+namespace {
+    struct CookerOptions {
+        VkFormat color_format = VK_FORMAT_BC7_UNORM_BLOCK;
+        std::optional<std::filesystem::path> textures_dir; // <model dir>/../textures by default
+        bool force = false;
+        std::vector<std::filesystem::path> inputs;
+    };
+
+    struct CookerStats {
+        size_t cooked = 0u;
+        size_t skipped = 0u;
+        size_t failed = 0u;
+        uint64_t source_bytes = 0u; // Mip chains as RGBA8, what the images take uncooked
+        uint64_t cooked_bytes = 0u;
+    };
+
+    // The encoded bytes are kept, images are decoded when they are cooked.
+    bool KeepImageBytes(tinygltf::Image* image, const int image_idx, std::string* err, std::string* warn, int req_width, int req_height, const unsigned char* bytes, int size, void* user_data) {
+        image->image.assign(bytes, bytes + size);
+        return true;
+    }
+
+    std::optional<CookerOptions> ParseOptions(int argc, char** argv) {
+        CookerOptions options;
+        for(int arg_idx = 1; arg_idx < argc; ++arg_idx) {
+            const std::string arg = argv[arg_idx];
+            if(arg == "--color" && arg_idx + 1 < argc) {
+                const std::string format = argv[++arg_idx];
+                if(format == "bc7") options.color_format = VK_FORMAT_BC7_UNORM_BLOCK;
+                else if(format == "bc3") options.color_format = VK_FORMAT_BC3_UNORM_BLOCK;
+                else if(format == "bc1") options.color_format = VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+                else return std::nullopt;
+            }
+            else if(arg == "--textures" && arg_idx + 1 < argc) {
+                options.textures_dir = argv[++arg_idx];
+            }
+            else if(arg == "--force") {
+                options.force = true;
+            }
+            else if(arg.starts_with("--")) {
+                return std::nullopt;
+            }
+            else {
+                options.inputs.emplace_back(arg);
+            }
+        }
+        if(options.inputs.empty()) return std::nullopt;
+
+        return options;
+    }
+
+    std::vector<std::filesystem::path> FindModels(const std::vector<std::filesystem::path>& inputs) {
+        std::vector<std::filesystem::path> models;
+        for(const std::filesystem::path& input : inputs) {
+            if(!std::filesystem::is_directory(input)) {
+                models.push_back(input);
+                continue;
+            }
+            for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(input)) {
+                const std::filesystem::path extension = entry.path().extension();
+                if(entry.is_regular_file() && (extension == ".gltf" || extension == ".glb")) {
+                    models.push_back(entry.path());
+                }
+            }
+        }
+        std::sort(models.begin(), models.end());
+
+        return models;
+    }
+
+    std::vector<unsigned char> ReadFile(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        if(!file.is_open()) return {};
+
+        return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    bool IsUpToDate(const std::filesystem::path& output, const std::filesystem::path& source) {
+        std::error_code ec;
+        const std::filesystem::file_time_type output_time = std::filesystem::last_write_time(output, ec);
+        if(ec) return false;
+
+        return output_time >= std::filesystem::last_write_time(source, ec) && !ec;
+    }
+
+    bool HasAlpha(const unsigned char* rgba, VkExtent2D extent) {
+        const size_t texel_count = static_cast<size_t>(extent.width) * extent.height;
+        for(size_t texel = 0u; texel < texel_count; ++texel) {
+            if(rgba[texel * 4u + 3u] != 255u) return true;
+        }
+        return false;
+    }
+
+    bool CookImage(const std::vector<unsigned char>& encoded, bool normal_map, const CookerOptions& options, const std::filesystem::path& output, CookerStats& stats) {
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        stbi_uc* pixels = stbi_load_from_memory(encoded.data(), static_cast<int>(encoded.size()), &width, &height, &channels, STBI_rgb_alpha);
+        if(!pixels) return false;
+
+        const VkExtent2D extent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+        VkFormat format = options.color_format;
+        if(normal_map) {
+            format = VK_FORMAT_BC5_UNORM_BLOCK;
+        }
+        else if(format == VK_FORMAT_BC1_RGB_UNORM_BLOCK && HasAlpha(pixels, extent)) {
+            // Only the four color mode is encoded, alpha needs BC3.
+            format = VK_FORMAT_BC3_UNORM_BLOCK;
+        }
+
+        MipChain mip_chain = buildMipChain(pixels, extent);
+        stbi_image_free(pixels);
+
+        std::vector<unsigned char> levels;
+        std::vector<VkDeviceSize> level_offsets;
+        for(uint32_t mip_level = 0u; mip_level + 1u < mip_chain.offsets.size(); ++mip_level) {
+            std::vector<unsigned char> level = compressLevel(format, mip_chain.data.data() + mip_chain.offsets[mip_level], getMipExtent(extent, mip_level));
+            level_offsets.push_back(levels.size());
+            levels.insert(levels.end(), level.begin(), level.end());
+        }
+        level_offsets.push_back(levels.size());
+
+        stats.source_bytes += mip_chain.data.size();
+        stats.cooked_bytes += levels.size();
+
+        Ktx2File ktx2_file;
+        ktx2_file.setImage(format, extent, std::move(levels), std::move(level_offsets));
+        return ktx2_file.save(output.string());
+    }
+
+    // Images of a model that are sampled as normal maps.
+    std::unordered_set<int> FindNormalMaps(const tinygltf::Model& model) {
+        std::unordered_set<int> normal_maps;
+        for(const tinygltf::Material& material : model.materials) {
+            const int texture_idx = material.normalTexture.index;
+            if(texture_idx >= 0 && texture_idx < static_cast<int>(model.textures.size()) && model.textures[texture_idx].source >= 0) {
+                normal_maps.insert(model.textures[texture_idx].source);
+            }
+        }
+        return normal_maps;
+    }
+
+    void CookModel(const std::filesystem::path& model_path, const CookerOptions& options, std::unordered_set<std::string>& cooked_outputs, CookerStats& stats) {
+        tinygltf::TinyGLTF gltf_ctx;
+        gltf_ctx.SetImageLoader(KeepImageBytes, nullptr);
+
+        tinygltf::Model model;
+        std::string load_error;
+        std::string load_warning;
+        bool load_result = false;
+        if(model_path.extension() == ".glb") {
+            load_result = gltf_ctx.LoadBinaryFromFile(&model, &load_error, &load_warning, model_path.string());
+        }
+        else {
+            load_result = gltf_ctx.LoadASCIIFromFile(&model, &load_error, &load_warning, model_path.string());
+        }
+        if(!load_result) {
+            std::cout << "failed to load " << model_path.string() << ": " << load_error << std::endl;
+            ++stats.failed;
+            return;
+        }
+
+        const std::filesystem::path model_dir = model_path.parent_path();
+        const std::filesystem::path textures_dir = options.textures_dir.value_or(model_dir / ".." / "textures");
+        const std::unordered_set<int> normal_maps = FindNormalMaps(model);
+
+        for(size_t image_idx = 0u; image_idx < model.images.size(); ++image_idx) {
+            const tinygltf::Image& image = model.images[image_idx];
+
+            // Image files are cooked next to themselves, embedded images next to the model.
+            std::filesystem::path source_path = model_path;
+            std::filesystem::path output_path;
+            std::vector<unsigned char> encoded;
+            if(image.uri.empty() || image.uri.starts_with("data:")) {
+                output_path = getCookedTexturePath(model_path, static_cast<int>(image_idx));
+                encoded = image.image;
+            }
+            else {
+                source_path = model_dir / image.uri;
+                if(!std::filesystem::exists(source_path)) {
+                    source_path = textures_dir / image.uri;
+                }
+                output_path = getCookedTexturePath(source_path);
+            }
+
+            if(!cooked_outputs.insert(std::filesystem::weakly_canonical(output_path).string()).second) continue;
+            if(!options.force && IsUpToDate(output_path, source_path)) {
+                ++stats.skipped;
+                continue;
+            }
+            if(encoded.empty()) {
+                encoded = ReadFile(source_path);
+            }
+
+            if(encoded.empty() || !CookImage(encoded, normal_maps.contains(static_cast<int>(image_idx)), options, output_path, stats)) {
+                std::cout << "failed to cook image " << image_idx << " of " << model_path.string() << std::endl;
+                ++stats.failed;
+                continue;
+            }
+            std::cout << output_path.string() << std::endl;
+            ++stats.cooked;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    std::optional<CookerOptions> options = ParseOptions(argc, argv);
+    if(!options) {
+        std::cout << "usage: texture_cooker [--color bc7|bc3|bc1] [--textures <dir>] [--force] <model.gltf|directory>..." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    CookerStats stats;
+    std::unordered_set<std::string> cooked_outputs;
+    try {
+        for(const std::filesystem::path& model_path : FindModels(options->inputs)) {
+            CookModel(model_path, *options, cooked_outputs, stats);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << stats.cooked << " cooked, " << stats.skipped << " up to date, " << stats.failed << " failed";
+    if(stats.cooked) {
+        std::cout << ", " << stats.source_bytes / 1024u << " KB of RGBA8 levels to " << stats.cooked_bytes / 1024u << " KB";
+    }
+    std::cout << std::endl;
+
+    return stats.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+// Dmitry Vyukov's bounded MPMC ring. Elements live in place inside the ring, a push or pop is one CAS on the ticket
+// plus one release store on the cell sequence, no locks and no allocations after construction.
+template<typename DataType>
+class BoundedMPMCQueue {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 4096u;
+
+    explicit BoundedMPMCQueue(size_t capacity = DEFAULT_CAPACITY) : m_enqueue_pos(0u), m_dequeue_pos(0u), m_push_epoch(0u), m_pop_epoch(0u) {
+        size_t cap = 2u;
+        while(cap < capacity) cap <<= 1u;
+        m_mask = cap - 1u;
+        m_cells.reset(new Cell[cap]);
+        for(size_t i = 0u; i < cap; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~BoundedMPMCQueue() {
+        DataType value;
+        while(TryPop(value)) {}
+    }
+
+    BoundedMPMCQueue(const BoundedMPMCQueue& other) = delete;
+    BoundedMPMCQueue(BoundedMPMCQueue&& other) = delete;
+    BoundedMPMCQueue& operator=(const BoundedMPMCQueue& other) = delete;
+    BoundedMPMCQueue& operator=(BoundedMPMCQueue&& other) = delete;
+
+    template<typename U>
+    bool TryPush(U&& value) {
+        size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while(true) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if(diff == 0) {
+                if(m_enqueue_pos.compare_exchange_weak(pos, pos + 1u, std::memory_order_relaxed)) break;
+            }
+            else if(diff < 0) {
+                return false;
+            }
+            else {
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        new (cell->storage) DataType(std::forward<U>(value));
+        cell->sequence.store(pos + 1u, std::memory_order_release);
+        signal(m_push_epoch);
+        return true;
+    }
+
+    bool TryPop(DataType& value) {
+        size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while(true) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1u);
+            if(diff == 0) {
+                if(m_dequeue_pos.compare_exchange_weak(pos, pos + 1u, std::memory_order_relaxed)) break;
+            }
+            else if(diff < 0) {
+                return false;
+            }
+            else {
+                pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        DataType* stored = std::launder(reinterpret_cast<DataType*>(cell->storage));
+        value = std::move(*stored);
+        stored->~DataType();
+        cell->sequence.store(pos + m_mask + 1u, std::memory_order_release);
+        signal(m_pop_epoch);
+        return true;
+    }
+
+    void Push(DataType value) {
+        if(TryPush(std::move(value))) return;
+        wait_for(m_pop_epoch, [this, &value]() { return TryPush(std::move(value)); });
+    }
+
+    void WaitAndPop(DataType& value) {
+        if(TryPop(value)) return;
+        wait_for(m_push_epoch, [this, &value]() { return TryPop(value); });
+    }
+
+    bool Empty() const {
+        return Size() == 0u;
+    }
+
+    size_t Size() const {
+        size_t enqueue_pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        size_t dequeue_pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0u;
+    }
+
+    size_t Capacity() const {
+        return m_mask + 1u;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        alignas(DataType) unsigned char storage[sizeof(DataType)];
+    };
+
+    // Event count: the low bit of an epoch is set by threads about to sleep on it. The first signal after that clears
+    // it while moving to the next epoch and wakes them, later signals see it clear and skip the wake until someone
+    // sleeps again. Counting sleepers instead woke them on every push or pop until they got to run.
+    static constexpr uint32_t WAITING_BIT = 1u;
+
+    static void signal(std::atomic<uint32_t>& epoch) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint32_t current = epoch.load(std::memory_order_relaxed);
+        if(!(current & WAITING_BIT)) return;
+        // A failed exchange means another signal already moved the epoch on and woke everyone.
+        if(epoch.compare_exchange_strong(current, (current | WAITING_BIT) + 1u, std::memory_order_seq_cst)) {
+            epoch.notify_all();
+        }
+    }
+
+    template<typename TryFn>
+    static void wait_for(std::atomic<uint32_t>& epoch, TryFn&& try_fn) {
+        while(true) {
+            uint32_t current = epoch.fetch_or(WAITING_BIT, std::memory_order_seq_cst) | WAITING_BIT;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(try_fn()) return;
+            epoch.wait(current, std::memory_order_seq_cst);
+        }
+    }
+
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask;
+    alignas(64) std::atomic<size_t> m_enqueue_pos;
+    alignas(64) std::atomic<size_t> m_dequeue_pos;
+    alignas(64) std::atomic<uint32_t> m_push_epoch;
+    std::atomic<uint32_t> m_pop_epoch;
+};
@@ -0,0 +1,80 @@
+#include "buddy_allocator.h"
+
+#include <algorithm>
+#include <bit>
+
+BuddyAllocator::BuddyAllocator(uint64_t capacity, uint64_t min_block_size) : m_used_size(0u) {
+    min_block_size = std::bit_ceil(std::max<uint64_t>(min_block_size, 1u));
+    m_capacity = std::bit_floor(std::max(capacity, min_block_size));
+    m_min_block_log2 = std::countr_zero(min_block_size);
+    m_max_order = std::countr_zero(m_capacity) - m_min_block_log2;
+    m_free_lists.resize(m_max_order + 1u);
+    m_free_lists[m_max_order].insert(0u);
+}
+
+bool BuddyAllocator::allocate(uint64_t size, uint64_t alignment, uint64_t& out_offset, uint64_t& out_size) {
+    if (size == 0u || size > m_capacity || alignment > m_capacity) {
+        return false;
+    }
+
+    uint32_t order = order_for_size(std::max(size, alignment));
+    uint32_t current_order = order;
+    while (current_order <= m_max_order && m_free_lists[current_order].empty()) {
+        ++current_order;
+    }
+    if (current_order > m_max_order) {
+        return false;
+    }
+
+    uint64_t offset = *m_free_lists[current_order].begin();
+    m_free_lists[current_order].erase(m_free_lists[current_order].begin());
+    while (current_order > order) {
+        --current_order;
+        uint64_t buddy_offset = offset + (uint64_t(1u) << (current_order + m_min_block_log2));
+        m_free_lists[current_order].insert(buddy_offset);
+    }
+
+    out_offset = offset;
+    out_size = uint64_t(1u) << (order + m_min_block_log2);
+    m_used_size += out_size;
+
+    return true;
+}
+
+void BuddyAllocator::free(uint64_t offset, uint64_t size) {
+    uint32_t order = order_for_size(size);
+    m_used_size -= uint64_t(1u) << (order + m_min_block_log2);
+
+    while (order < m_max_order) {
+        uint64_t buddy_offset = offset ^ (uint64_t(1u) << (order + m_min_block_log2));
+        auto buddy = m_free_lists[order].find(buddy_offset);
+        if (buddy == m_free_lists[order].end()) {
+            break;
+        }
+        m_free_lists[order].erase(buddy);
+        offset = std::min(offset, buddy_offset);
+        ++order;
+    }
+    m_free_lists[order].insert(offset);
+}
+
+bool BuddyAllocator::empty() const {
+    return m_used_size == 0u;
+}
+
+uint64_t BuddyAllocator::get_capacity() const {
+    return m_capacity;
+}
+
+uint64_t BuddyAllocator::get_used_size() const {
+    return m_used_size;
+}
+
+uint64_t BuddyAllocator::get_min_block_size() const {
+    return uint64_t(1u) << m_min_block_log2;
+}
+
+uint32_t BuddyAllocator::order_for_size(uint64_t size) const {
+    uint64_t block_size = std::bit_ceil(std::max(size, uint64_t(1u) << m_min_block_log2));
+    return std::countr_zero(block_size) - m_min_block_log2;
+}
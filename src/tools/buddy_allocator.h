@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+// Binary buddy allocator over an abstract [0, capacity) range. Every block is aligned to its own size, so any
+// alignment up to the block size comes for free.
+class BuddyAllocator {
+public:
+    BuddyAllocator(uint64_t capacity, uint64_t min_block_size);
+
+    bool allocate(uint64_t size, uint64_t alignment, uint64_t& out_offset, uint64_t& out_size);
+    void free(uint64_t offset, uint64_t size);
+
+    bool empty() const;
+    uint64_t get_capacity() const;
+    uint64_t get_used_size() const;
+    uint64_t get_min_block_size() const;
+
+private:
+    uint32_t order_for_size(uint64_t size) const;
+
+    uint64_t m_capacity;
+    uint32_t m_min_block_log2;
+    uint32_t m_max_order;
+    uint64_t m_used_size;
+    std::vector<std::set<uint64_t>> m_free_lists;
+};
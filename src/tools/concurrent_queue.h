@@ -0,0 +1,14 @@
+#pragma once
+
+#include "bounded_mpmc_queue.h"
+#include "thread_safe_queue.h"
+
+// Backend for the engine's cross-thread queues, picked at compile time. The lock-free ring is bounded, producers block
+// in Push while it is full.
+#if defined(MASIC_LOCK_FREE_QUEUES)
+template<typename DataType>
+using ConcurrentQueue = BoundedMPMCQueue<DataType>;
+#else
+template<typename DataType>
+using ConcurrentQueue = ThreadSafeQueue<DataType>;
+#endif
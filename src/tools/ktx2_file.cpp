@@ -0,0 +1,281 @@
+#include "ktx2_file.h"
+
+#include "texture_tools.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+    constexpr unsigned char IDENTIFIER[12] = {0xABu, 0x4Bu, 0x54u, 0x58u, 0x20u, 0x32u, 0x30u, 0xBBu, 0x0Du, 0x0Au, 0x1Au, 0x0Au};
+    constexpr size_t HEADER_SIZE = 80u; // Identifier, image description and index, the level index follows
+    constexpr size_t LEVEL_INDEX_ENTRY_SIZE = 24u;
+
+    // Header fields, all little endian.
+    constexpr size_t VK_FORMAT_OFFSET = 12u;
+    constexpr size_t TYPE_SIZE_OFFSET = 16u;
+    constexpr size_t PIXEL_WIDTH_OFFSET = 20u;
+    constexpr size_t PIXEL_HEIGHT_OFFSET = 24u;
+    constexpr size_t PIXEL_DEPTH_OFFSET = 28u;
+    constexpr size_t LAYER_COUNT_OFFSET = 32u;
+    constexpr size_t FACE_COUNT_OFFSET = 36u;
+    constexpr size_t LEVEL_COUNT_OFFSET = 40u;
+    constexpr size_t SUPERCOMPRESSION_OFFSET = 44u;
+    constexpr size_t DFD_OFFSET = 48u;
+    constexpr size_t KVD_OFFSET = 56u;
+    constexpr size_t SGD_OFFSET = 64u;
+
+    // Khronos data format descriptor values.
+    constexpr uint32_t KHR_DF_MODEL_RGBSDA = 1u;
+    constexpr uint32_t KHR_DF_MODEL_BC1A = 128u;
+    constexpr uint32_t KHR_DF_MODEL_BC3 = 130u;
+    constexpr uint32_t KHR_DF_MODEL_BC5 = 132u;
+    constexpr uint32_t KHR_DF_MODEL_BC7 = 134u;
+    constexpr uint32_t KHR_DF_PRIMARIES_BT709 = 1u;
+    constexpr uint32_t KHR_DF_TRANSFER_LINEAR = 1u;
+    constexpr uint32_t KHR_DF_TRANSFER_SRGB = 2u;
+    constexpr uint32_t KHR_DF_CHANNEL_ALPHA = 15u;
+    constexpr uint32_t KHR_DF_SAMPLE_DATATYPE_LINEAR = 0x10u;
+
+    template<typename T>
+    T readValue(const unsigned char* data, size_t offset) {
+        T value;
+        std::memcpy(&value, data + offset, sizeof(T));
+        return value;
+    }
+
+    template<typename T>
+    void writeValue(std::vector<unsigned char>& data, size_t offset, T value) {
+        std::memcpy(data.data() + offset, &value, sizeof(T));
+    }
+
+    bool isSrgb(VkFormat format) {
+        switch (format) {
+            case VK_FORMAT_R8G8B8A8_SRGB:
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+            case VK_FORMAT_BC7_SRGB_BLOCK: return true;
+            default: return false;
+        }
+    }
+
+    // Loadable header: a 2D texture without layers, faces and supercompression, in a format with a known texel block.
+    VkFormat readHeaderFormat(const unsigned char* data, size_t size) {
+        if(!Ktx2File::isKtx2(data, size) || size < HEADER_SIZE) return VK_FORMAT_UNDEFINED;
+        if(readValue<uint32_t>(data, SUPERCOMPRESSION_OFFSET) != 0u) return VK_FORMAT_UNDEFINED;
+        if(readValue<uint32_t>(data, PIXEL_DEPTH_OFFSET) > 1u || readValue<uint32_t>(data, LAYER_COUNT_OFFSET) > 1u || readValue<uint32_t>(data, FACE_COUNT_OFFSET) != 1u) return VK_FORMAT_UNDEFINED;
+        if(!readValue<uint32_t>(data, PIXEL_WIDTH_OFFSET) || !readValue<uint32_t>(data, PIXEL_HEIGHT_OFFSET)) return VK_FORMAT_UNDEFINED;
+
+        VkFormat format = static_cast<VkFormat>(readValue<uint32_t>(data, VK_FORMAT_OFFSET));
+        return getTexelBlock(format).bytes ? format : VK_FORMAT_UNDEFINED;
+    }
+}
+
+bool Ktx2File::isKtx2(const unsigned char* data, size_t size) {
+    return size >= sizeof(IDENTIFIER) && std::equal(std::begin(IDENTIFIER), std::end(IDENTIFIER), data);
+}
+
+VkFormat Ktx2File::readFormat(const std::string& path_to_file) {
+    std::ifstream file(path_to_file, std::ios::binary);
+    if(!file.is_open()) return VK_FORMAT_UNDEFINED;
+
+    unsigned char header[HEADER_SIZE];
+    if(!file.read(reinterpret_cast<char*>(header), HEADER_SIZE)) return VK_FORMAT_UNDEFINED;
+    return readHeaderFormat(header, HEADER_SIZE);
+}
+
+bool Ktx2File::load(const std::string& path_to_file) {
+    std::ifstream file(path_to_file, std::ios::binary);
+    if(!file.is_open()) return false;
+
+    std::vector<unsigned char> data(std::istreambuf_iterator<char>(file), {});
+    return load(data.data(), data.size());
+}
+
+bool Ktx2File::load(const unsigned char* data, size_t size) {
+    const VkFormat format = readHeaderFormat(data, size);
+    if(format == VK_FORMAT_UNDEFINED) return false;
+
+    const VkExtent2D extent = { readValue<uint32_t>(data, PIXEL_WIDTH_OFFSET), readValue<uint32_t>(data, PIXEL_HEIGHT_OFFSET) };
+    const uint32_t level_count = std::max(readValue<uint32_t>(data, LEVEL_COUNT_OFFSET), 1u);
+    const uint32_t full_chain = static_cast<uint32_t>(std::bit_width(std::max(extent.width, extent.height)));
+    if(level_count > full_chain || HEADER_SIZE + static_cast<size_t>(level_count) * LEVEL_INDEX_ENTRY_SIZE > size) return false;
+
+    std::vector<VkDeviceSize> level_offsets;
+    VkDeviceSize levels_size = 0u;
+    for(uint32_t level = 0u; level < level_count; ++level) {
+        const VkExtent2D level_extent = getMipExtent(extent, level);
+        const size_t index_entry = HEADER_SIZE + static_cast<size_t>(level) * LEVEL_INDEX_ENTRY_SIZE;
+        const uint64_t byte_offset = readValue<uint64_t>(data, index_entry);
+        const uint64_t byte_length = readValue<uint64_t>(data, index_entry + 8u);
+        if(byte_length != getLevelSize(format, level_extent) || byte_offset > size || byte_length > size - byte_offset) return false;
+
+        level_offsets.push_back(levels_size);
+        levels_size += byte_length;
+    }
+    level_offsets.push_back(levels_size);
+
+    std::vector<unsigned char> levels(levels_size);
+    for(uint32_t level = 0u; level < level_count; ++level) {
+        const size_t index_entry = HEADER_SIZE + static_cast<size_t>(level) * LEVEL_INDEX_ENTRY_SIZE;
+        const uint64_t byte_offset = readValue<uint64_t>(data, index_entry);
+        std::memcpy(levels.data() + level_offsets[level], data + byte_offset, level_offsets[level + 1u] - level_offsets[level]);
+    }
+
+    setImage(format, extent, std::move(levels), std::move(level_offsets));
+    return true;
+}
+
+// Level index, data format descriptor, then the levels from the smallest one on, as the specification recommends so a
+// partial read already has the low resolution ones.
+bool Ktx2File::save(const std::string& path_to_file) const {
+    const std::vector<uint32_t> dfd = makeDataFormatDescriptor();
+    const uint32_t level_count = getLevelCount();
+    const TexelBlock texel_block = getTexelBlock(m_format);
+    const size_t level_alignment = std::lcm<size_t>(texel_block.bytes, 4u);
+
+    const size_t dfd_offset = HEADER_SIZE + static_cast<size_t>(level_count) * LEVEL_INDEX_ENTRY_SIZE;
+    const size_t dfd_size = dfd.size() * sizeof(uint32_t);
+    size_t file_size = dfd_offset + dfd_size;
+    std::vector<size_t> file_offsets(level_count);
+    for(uint32_t level = level_count; level-- > 0u;) {
+        file_size = (file_size + level_alignment - 1u) / level_alignment * level_alignment;
+        file_offsets[level] = file_size;
+        file_size += m_level_offsets[level + 1u] - m_level_offsets[level];
+    }
+
+    std::vector<unsigned char> data(file_size, 0u);
+    std::copy(std::begin(IDENTIFIER), std::end(IDENTIFIER), data.begin());
+    writeValue<uint32_t>(data, VK_FORMAT_OFFSET, static_cast<uint32_t>(m_format));
+    writeValue<uint32_t>(data, TYPE_SIZE_OFFSET, 1u);
+    writeValue<uint32_t>(data, PIXEL_WIDTH_OFFSET, m_extent.width);
+    writeValue<uint32_t>(data, PIXEL_HEIGHT_OFFSET, m_extent.height);
+    writeValue<uint32_t>(data, PIXEL_DEPTH_OFFSET, 0u);
+    writeValue<uint32_t>(data, LAYER_COUNT_OFFSET, 0u);
+    writeValue<uint32_t>(data, FACE_COUNT_OFFSET, 1u);
+    writeValue<uint32_t>(data, LEVEL_COUNT_OFFSET, level_count);
+    writeValue<uint32_t>(data, SUPERCOMPRESSION_OFFSET, 0u);
+    writeValue<uint32_t>(data, DFD_OFFSET, static_cast<uint32_t>(dfd_offset));
+    writeValue<uint32_t>(data, DFD_OFFSET + 4u, static_cast<uint32_t>(dfd_size));
+    writeValue<uint32_t>(data, KVD_OFFSET, 0u);
+    writeValue<uint32_t>(data, KVD_OFFSET + 4u, 0u);
+    writeValue<uint64_t>(data, SGD_OFFSET, 0u);
+    writeValue<uint64_t>(data, SGD_OFFSET + 8u, 0u);
+
+    for(uint32_t level = 0u; level < level_count; ++level) {
+        const size_t index_entry = HEADER_SIZE + static_cast<size_t>(level) * LEVEL_INDEX_ENTRY_SIZE;
+        const uint64_t byte_length = m_level_offsets[level + 1u] - m_level_offsets[level];
+        writeValue<uint64_t>(data, index_entry, file_offsets[level]);
+        writeValue<uint64_t>(data, index_entry + 8u, byte_length);
+        writeValue<uint64_t>(data, index_entry + 16u, byte_length);
+        std::memcpy(data.data() + file_offsets[level], m_levels.data() + m_level_offsets[level], byte_length);
+    }
+    std::memcpy(data.data() + dfd_offset, dfd.data(), dfd_size);
+
+    std::ofstream file(path_to_file, std::ios::binary | std::ios::trunc);
+    if(!file.is_open()) return false;
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(file);
+}
+
+void Ktx2File::setImage(VkFormat format, VkExtent2D extent, std::vector<unsigned char> levels, std::vector<VkDeviceSize> level_offsets) {
+    m_format = format;
+    m_extent = extent;
+    m_levels = std::move(levels);
+    m_level_offsets = std::move(level_offsets);
+}
+
+VkFormat Ktx2File::getFormat() const {
+    return m_format;
+}
+
+VkExtent2D Ktx2File::getExtent() const {
+    return m_extent;
+}
+
+uint32_t Ktx2File::getLevelCount() const {
+    return m_level_offsets.empty() ? 0u : static_cast<uint32_t>(m_level_offsets.size() - 1u);
+}
+
+std::vector<unsigned char>& Ktx2File::getLevels() {
+    return m_levels;
+}
+
+const std::vector<VkDeviceSize>& Ktx2File::getLevelOffsets() const {
+    return m_level_offsets;
+}
+
+// Basic descriptor block: color model, primaries, transfer function, texel block and one sample per channel.
+std::vector<uint32_t> Ktx2File::makeDataFormatDescriptor() const {
+    struct Sample {
+        uint32_t bit_offset;
+        uint32_t bit_length;
+        uint32_t channel;
+        uint32_t upper;
+    };
+
+    uint32_t color_model = 0u;
+    std::vector<Sample> samples;
+    switch (m_format) {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+            color_model = KHR_DF_MODEL_RGBSDA;
+            samples = {{0u, 8u, 0u, 255u}, {8u, 8u, 1u, 255u}, {16u, 8u, 2u, 255u}, {24u, 8u, KHR_DF_CHANNEL_ALPHA, 255u}};
+            break;
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            color_model = KHR_DF_MODEL_BC1A;
+            samples = {{0u, 64u, 0u, UINT32_MAX}};
+            break;
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            color_model = KHR_DF_MODEL_BC1A;
+            samples = {{0u, 64u, 1u, UINT32_MAX}}; // Alpha present
+            break;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+            color_model = KHR_DF_MODEL_BC3;
+            samples = {{0u, 64u, KHR_DF_CHANNEL_ALPHA, UINT32_MAX}, {64u, 64u, 0u, UINT32_MAX}};
+            break;
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+            color_model = KHR_DF_MODEL_BC5;
+            samples = {{0u, 64u, 0u, UINT32_MAX}, {64u, 64u, 1u, UINT32_MAX}};
+            break;
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            color_model = KHR_DF_MODEL_BC7;
+            samples = {{0u, 128u, 0u, UINT32_MAX}};
+            break;
+        default:
+            throw std::runtime_error("no ktx2 data format descriptor for the texture format!");
+    }
+
+    const bool srgb = isSrgb(m_format);
+    const TexelBlock texel_block = getTexelBlock(m_format);
+    const uint32_t block_size = 24u + 16u * static_cast<uint32_t>(samples.size());
+
+    std::vector<uint32_t> dfd;
+    dfd.push_back(4u + block_size); // Total size
+    dfd.push_back(0u); // Khronos vendor, basic descriptor type
+    dfd.push_back(2u | (block_size << 16u)); // Version 1.3
+    dfd.push_back(color_model | (KHR_DF_PRIMARIES_BT709 << 8u) | ((srgb ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR) << 16u));
+    dfd.push_back((texel_block.width - 1u) | ((texel_block.height - 1u) << 8u));
+    dfd.push_back(texel_block.bytes);
+    dfd.push_back(0u);
+    for(const Sample& sample : samples) {
+        // Alpha is never sRGB encoded.
+        const uint32_t channel_type = sample.channel | (srgb && sample.channel == KHR_DF_CHANNEL_ALPHA ? KHR_DF_SAMPLE_DATATYPE_LINEAR : 0u);
+        dfd.push_back(sample.bit_offset | ((sample.bit_length - 1u) << 16u) | (channel_type << 24u));
+        dfd.push_back(0u); // Sample position
+        dfd.push_back(0u); // Lower
+        dfd.push_back(sample.upper);
+    }
+
+    return dfd;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// KTX2 container of one 2D texture: no array layers, cube faces, depth or supercompression, which is what
+// texture_cooker writes. Levels are kept tightly packed from level 0 on, the order uploads take them in, whatever the
+// order in the file. Formats are limited to those getTexelBlock() knows.
+class Ktx2File {
+public:
+    static bool isKtx2(const unsigned char* data, size_t size);
+    // Reads only the header, VK_FORMAT_UNDEFINED when the file is not a KTX2 texture this class can load.
+    static VkFormat readFormat(const std::string& path_to_file);
+
+    bool load(const std::string& path_to_file);
+    bool load(const unsigned char* data, size_t size);
+    // Throws for formats without a data format descriptor here: RGBA8, BC1, BC3, BC5 and BC7 are written.
+    bool save(const std::string& path_to_file) const;
+
+    void setImage(VkFormat format, VkExtent2D extent, std::vector<unsigned char> levels, std::vector<VkDeviceSize> level_offsets);
+
+    VkFormat getFormat() const;
+    VkExtent2D getExtent() const;
+    uint32_t getLevelCount() const;
+    std::vector<unsigned char>& getLevels();
+    const std::vector<VkDeviceSize>& getLevelOffsets() const; // One past the last level too
+
+private:
+    std::vector<uint32_t> makeDataFormatDescriptor() const;
+
+    VkFormat m_format = VK_FORMAT_UNDEFINED;
+    VkExtent2D m_extent{};
+    std::vector<unsigned char> m_levels;
+    std::vector<VkDeviceSize> m_level_offsets;
+};
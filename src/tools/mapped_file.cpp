@@ -0,0 +1,130 @@
+#include "mapped_file.h"
+
+#include <utility>
+
+#if defined(_WIN32) || defined(_WIN64)
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if(this == &other) return *this;
+
+    close();
+    m_data = std::exchange(other.m_data, nullptr);
+    m_size = std::exchange(other.m_size, 0u);
+#if defined(_WIN32) || defined(_WIN64)
+    m_file = std::exchange(other.m_file, nullptr);
+    m_mapping = std::exchange(other.m_mapping, nullptr);
+#else
+    m_file = std::exchange(other.m_file, -1);
+#endif
+    return *this;
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+bool MappedFile::open(const std::string& file_name) {
+    close();
+
+    HANDLE file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE) return false;
+    m_file = file;
+
+    LARGE_INTEGER file_size{};
+    if(!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        close();
+        return false;
+    }
+
+    m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0u, 0u, nullptr);
+    if(!m_mapping) {
+        close();
+        return false;
+    }
+
+    m_data = static_cast<const unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0u, 0u, 0u));
+    if(!m_data) {
+        close();
+        return false;
+    }
+    m_size = static_cast<size_t>(file_size.QuadPart);
+
+    return true;
+}
+
+void MappedFile::close() {
+    if(m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    if(m_mapping) {
+        CloseHandle(m_mapping);
+    }
+    if(m_file) {
+        CloseHandle(m_file);
+    }
+    m_data = nullptr;
+    m_size = 0u;
+    m_mapping = nullptr;
+    m_file = nullptr;
+}
+#else
+bool MappedFile::open(const std::string& file_name) {
+    close();
+
+    m_file = ::open(file_name.c_str(), O_RDONLY);
+    if(m_file == -1) return false;
+
+    struct stat file_stat{};
+    if(fstat(m_file, &file_stat) != 0 || file_stat.st_size == 0) {
+        close();
+        return false;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, m_file, 0);
+    if(data == MAP_FAILED) {
+        close();
+        return false;
+    }
+    m_data = static_cast<const unsigned char*>(data);
+    m_size = static_cast<size_t>(file_stat.st_size);
+
+    return true;
+}
+
+void MappedFile::close() {
+    if(m_data) {
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+    if(m_file != -1) {
+        ::close(m_file);
+    }
+    m_data = nullptr;
+    m_size = 0u;
+    m_file = -1;
+}
+#endif
+
+bool MappedFile::isOpen() const {
+    return m_data != nullptr;
+}
+
+const unsigned char* MappedFile::data() const {
+    return m_data;
+}
+
+size_t MappedFile::size() const {
+    return m_size;
+}
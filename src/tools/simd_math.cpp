@@ -0,0 +1,157 @@
+#include "simd_math.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(MASIC_SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(MASIC_SIMD_SSE)
+#include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr float SHEAR_EPSILON = 1.0e-4f;
+    constexpr float SCALE_EPSILON = 1.0e-12f;
+}
+
+void mat4Mul(const glm::mat4& a, const glm::mat4& b, glm::mat4& out) {
+#if defined(MASIC_SIMD_AVX2)
+    // Two result columns per iteration, every 128 bit lane holds one column of the result.
+    const float* pa = &a[0][0];
+    const float* pb = &b[0][0];
+    const __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(pa + 0));
+    const __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(pa + 4));
+    const __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(pa + 8));
+    const __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(pa + 12));
+    const __m256 b01 = _mm256_loadu_ps(pb + 0);
+    const __m256 b23 = _mm256_loadu_ps(pb + 8);
+
+    __m256 r01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+    __m256 r23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+#if defined(__FMA__)
+    r01 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b01, 0x55), r01);
+    r23 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b23, 0x55), r23);
+    r01 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b01, 0xAA), r01);
+    r23 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b23, 0xAA), r23);
+    r01 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b01, 0xFF), r01);
+    r23 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b23, 0xFF), r23);
+#else
+    r01 = _mm256_add_ps(r01, _mm256_mul_ps(a1, _mm256_permute_ps(b01, 0x55)));
+    r23 = _mm256_add_ps(r23, _mm256_mul_ps(a1, _mm256_permute_ps(b23, 0x55)));
+    r01 = _mm256_add_ps(r01, _mm256_mul_ps(a2, _mm256_permute_ps(b01, 0xAA)));
+    r23 = _mm256_add_ps(r23, _mm256_mul_ps(a2, _mm256_permute_ps(b23, 0xAA)));
+    r01 = _mm256_add_ps(r01, _mm256_mul_ps(a3, _mm256_permute_ps(b01, 0xFF)));
+    r23 = _mm256_add_ps(r23, _mm256_mul_ps(a3, _mm256_permute_ps(b23, 0xFF)));
+#endif
+    float* po = &out[0][0];
+    _mm256_storeu_ps(po + 0, r01);
+    _mm256_storeu_ps(po + 8, r23);
+#elif defined(MASIC_SIMD_SSE)
+    const float* pa = &a[0][0];
+    const float* pb = &b[0][0];
+    const __m128 a0 = _mm_loadu_ps(pa + 0);
+    const __m128 a1 = _mm_loadu_ps(pa + 4);
+    const __m128 a2 = _mm_loadu_ps(pa + 8);
+    const __m128 a3 = _mm_loadu_ps(pa + 12);
+
+    __m128 r[4];
+    for (int j = 0; j < 4; ++j) {
+        const __m128 bj = _mm_loadu_ps(pb + 4 * j);
+        __m128 c = _mm_mul_ps(a0, _mm_shuffle_ps(bj, bj, _MM_SHUFFLE(0, 0, 0, 0)));
+        c = _mm_add_ps(c, _mm_mul_ps(a1, _mm_shuffle_ps(bj, bj, _MM_SHUFFLE(1, 1, 1, 1))));
+        c = _mm_add_ps(c, _mm_mul_ps(a2, _mm_shuffle_ps(bj, bj, _MM_SHUFFLE(2, 2, 2, 2))));
+        c = _mm_add_ps(c, _mm_mul_ps(a3, _mm_shuffle_ps(bj, bj, _MM_SHUFFLE(3, 3, 3, 3))));
+        r[j] = c;
+    }
+
+    float* po = &out[0][0];
+    for (int j = 0; j < 4; ++j) {
+        _mm_storeu_ps(po + 4 * j, r[j]);
+    }
+#else
+    out = a * b;
+#endif
+}
+
+static bool checkAffineNoShear(const glm::mat4& m, float& out_l0, float& out_l1, float& out_l2) {
+    if (m[0][3] != 0.0f || m[1][3] != 0.0f || m[2][3] != 0.0f || m[3][3] != 1.0f) return false;
+
+    const glm::vec3 c0(m[0]);
+    const glm::vec3 c1(m[1]);
+    const glm::vec3 c2(m[2]);
+    const float l0 = out_l0 = glm::dot(c0, c0);
+    const float l1 = out_l1 = glm::dot(c1, c1);
+    const float l2 = out_l2 = glm::dot(c2, c2);
+    if (l0 < SCALE_EPSILON || l1 < SCALE_EPSILON || l2 < SCALE_EPSILON) return false;
+
+    // |cos| of the angle between every pair of basis vectors has to be close to zero.
+    const float d01 = glm::dot(c0, c1);
+    const float d02 = glm::dot(c0, c2);
+    const float d12 = glm::dot(c1, c2);
+    const float eps2 = SHEAR_EPSILON * SHEAR_EPSILON;
+
+    return d01 * d01 <= eps2 * l0 * l1 && d02 * d02 <= eps2 * l0 * l2 && d12 * d12 <= eps2 * l1 * l2;
+}
+
+bool isAffineNoShear(const glm::mat4& m) {
+    float l0, l1, l2;
+    return checkAffineNoShear(m, l0, l1, l2);
+}
+
+glm::mat4 affineInverseNoShear(const glm::mat4& m) {
+    const glm::vec3 c0(m[0]);
+    const glm::vec3 c1(m[1]);
+    const glm::vec3 c2(m[2]);
+    const glm::vec3 t(m[3]);
+
+    // Rows of the inverse 3x3 part.
+    const glm::vec3 r0 = c0 / glm::dot(c0, c0);
+    const glm::vec3 r1 = c1 / glm::dot(c1, c1);
+    const glm::vec3 r2 = c2 / glm::dot(c2, c2);
+
+    glm::mat4 inv;
+    inv[0] = glm::vec4(r0.x, r1.x, r2.x, 0.0f);
+    inv[1] = glm::vec4(r0.y, r1.y, r2.y, 0.0f);
+    inv[2] = glm::vec4(r0.z, r1.z, r2.z, 0.0f);
+    inv[3] = glm::vec4(-glm::dot(r0, t), -glm::dot(r1, t), -glm::dot(r2, t), 1.0f);
+
+    return inv;
+}
+
+glm::mat4 affineInverseUniformScale(const glm::mat4& m) {
+    const glm::vec3 c0(m[0]);
+    const glm::vec3 t(m[3]);
+    const float inv_scale2 = 1.0f / glm::dot(c0, c0);
+
+    glm::mat4 inv;
+    inv[0] = glm::vec4(m[0][0], m[1][0], m[2][0], 0.0f) * inv_scale2;
+    inv[1] = glm::vec4(m[0][1], m[1][1], m[2][1], 0.0f) * inv_scale2;
+    inv[2] = glm::vec4(m[0][2], m[1][2], m[2][2], 0.0f) * inv_scale2;
+    inv[3] = -(inv[0] * t.x + inv[1] * t.y + inv[2] * t.z);
+    inv[3].w = 1.0f;
+
+    return inv;
+}
+
+glm::mat4 fastInverse(const glm::mat4& m, InversePath& out_path) {
+    float l0, l1, l2;
+    if (!checkAffineNoShear(m, l0, l1, l2)) {
+        out_path = InversePath::GENERAL;
+        return glm::inverse(m);
+    }
+
+    const float max_l = std::max(l0, std::max(l1, l2));
+    const float min_l = std::min(l0, std::min(l1, l2));
+    if (max_l - min_l <= SHEAR_EPSILON * max_l) {
+        out_path = InversePath::UNIFORM_SCALE;
+        return affineInverseUniformScale(m);
+    }
+
+    out_path = InversePath::AFFINE;
+    return affineInverseNoShear(m);
+}
+
+glm::mat4 fastInverse(const glm::mat4& m) {
+    InversePath path;
+    return fastInverse(m, path);
+}
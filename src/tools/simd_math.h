@@ -0,0 +1,44 @@
+#pragma once
+
+#define GLM_ENABLE_EXPERIMENTAL
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#include <glm/glm.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include <cstdint>
+
+#if defined(__AVX2__)
+#define MASIC_SIMD_AVX2 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MASIC_SIMD_SSE 1
+#endif
+
+enum class InversePath : uint8_t {
+    UNIFORM_SCALE,
+    AFFINE,
+    GENERAL
+};
+
+// out = a * b for column major matrices, out may alias a or b.
+void mat4Mul(const glm::mat4& a, const glm::mat4& b, glm::mat4& out);
+
+// True when the bottom row is (0, 0, 0, 1) and the basis vectors are mutually orthogonal, i.e. the matrix is a
+// translation * rotation * (possibly non uniform) axis aligned scale without any shear or projection.
+bool isAffineNoShear(const glm::mat4& m);
+
+// Inverse of a matrix that passed isAffineNoShear(). The 3x3 part is inverted as its transpose with every row divided
+// by the squared basis length and the translation is rotated back and negated.
+glm::mat4 affineInverseNoShear(const glm::mat4& m);
+
+// Inverse of a matrix that passed isAffineNoShear() with all three basis vectors of the same length, which is just the
+// transposed 3x3 part divided by the squared scale.
+glm::mat4 affineInverseUniformScale(const glm::mat4& m);
+
+// Picks the cheapest inverse that is valid for m and falls back to glm::inverse() for sheared or projective matrices.
+glm::mat4 fastInverse(const glm::mat4& m);
+glm::mat4 fastInverse(const glm::mat4& m, InversePath& out_path);
@@ -0,0 +1,77 @@
+#include "string_intern_table.h"
+
+namespace {
+    constexpr size_t INITIAL_CAPACITY = 64u;
+}
+
+StringInternTable::StringInternTable() : m_slots(INITIAL_CAPACITY) {}
+
+StringInternTable::StringId StringInternTable::intern(std::string_view str) {
+    const uint32_t hash = hashString(str);
+    size_t slot = findSlot(str, hash);
+    if (m_slots[slot].id != NO_ID) return m_slots[slot].id;
+
+    // Keep the load factor under 1/2 so probe sequences stay short.
+    if ((m_strings.size() + 1u) * 2u > m_slots.size()) {
+        grow();
+        slot = findSlot(str, hash);
+    }
+
+    const StringId id = static_cast<StringId>(m_strings.size());
+    m_strings.emplace_back(str);
+    m_slots[slot] = { hash, id };
+
+    return id;
+}
+
+StringInternTable::StringId StringInternTable::find(std::string_view str) const {
+    return m_slots[findSlot(str, hashString(str))].id;
+}
+
+const std::string& StringInternTable::get(StringId id) const {
+    return m_strings[id];
+}
+
+size_t StringInternTable::size() const {
+    return m_strings.size();
+}
+
+void StringInternTable::clear() {
+    m_strings.clear();
+    m_slots.assign(INITIAL_CAPACITY, {});
+}
+
+// FNV-1a
+uint32_t StringInternTable::hashString(std::string_view str) {
+    uint32_t hash = 2166136261u;
+    for (char c : str) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+size_t StringInternTable::findSlot(std::string_view str, uint32_t hash) const {
+    const size_t mask = m_slots.size() - 1u;
+    size_t slot = hash & mask;
+    while (m_slots[slot].id != NO_ID) {
+        if (m_slots[slot].hash == hash && m_strings[m_slots[slot].id] == str) break;
+        slot = (slot + 1u) & mask;
+    }
+    return slot;
+}
+
+void StringInternTable::grow() {
+    std::vector<Slot> old_slots(m_slots.size() * 2u);
+    old_slots.swap(m_slots);
+
+    const size_t mask = m_slots.size() - 1u;
+    for (const Slot& old_slot : old_slots) {
+        if (old_slot.id == NO_ID) continue;
+        size_t slot = old_slot.hash & mask;
+        while (m_slots[slot].id != NO_ID) {
+            slot = (slot + 1u) & mask;
+        }
+        m_slots[slot] = old_slot;
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Stores every distinct string once and hands out dense ids for them. Lookups go through a flat open addressing table
+// with linear probing, strings are never removed so the table needs no tombstones.
+class StringInternTable {
+public:
+    using StringId = uint32_t;
+    inline static const StringId NO_ID = -1;
+
+    StringInternTable();
+
+    StringId intern(std::string_view str);
+    StringId find(std::string_view str) const;
+
+    const std::string& get(StringId id) const;
+    size_t size() const;
+    void clear();
+
+private:
+    struct Slot {
+        uint32_t hash = 0u;
+        StringId id = NO_ID;
+    };
+
+    static uint32_t hashString(std::string_view str);
+    size_t findSlot(std::string_view str, uint32_t hash) const;
+    void grow();
+
+    std::vector<Slot> m_slots;
+    std::vector<std::string> m_strings;
+};
@@ -968,6 +968,18 @@ VkDescriptorSetLayoutCreateFlagBits getDescriptorSetLayoutCreateFlag(const std::
     return res;
 }
 
+VkDescriptorBindingFlagBits getDescriptorBindingFlag(const std::string& flag_str) {
+	using namespace std::literals;
+    VkDescriptorBindingFlagBits res{};
+
+         if(flag_str == "update_after_bind"s) {res = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;}
+	else if(flag_str == "update_unused_while_pending"s) {res = VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;}
+	else if(flag_str == "partially_bound"s) {res = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;}
+	else if(flag_str == "variable_descriptor_count"s) {res = VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;}
+    
+    return res;
+}
+
 VkPipelineCreateFlagBits getPipelineCreateFlag(const std::string& flag_str) {
 	using namespace std::literals;
     VkPipelineCreateFlagBits res{};
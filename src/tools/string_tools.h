@@ -176,6 +176,7 @@ VkBlendOp getBlendOp(const std::string& op_str);
 VkColorComponentFlagBits getColorComponentFlag(const std::string& mask_str);
 VkDynamicState getDynamicState(const std::string& dynamic_str);
 VkDescriptorSetLayoutCreateFlagBits getDescriptorSetLayoutCreateFlag(const std::string& flag_str);
+VkDescriptorBindingFlagBits getDescriptorBindingFlag(const std::string& flag_str);
 VkPipelineCreateFlagBits getPipelineCreateFlag(const std::string& flag_str);
 VkVertexInputRate getVertexInputRate(const std::string& rate_str);
 //VkFormat getAttributeFormat(VertexAttributeFormat attrib_format);
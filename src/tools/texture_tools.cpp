@@ -0,0 +1,428 @@
+#include "texture_tools.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    constexpr uint32_t RGBA_SIZE = 4u;
+    constexpr uint32_t BLOCK_TEXELS = 16u;
+
+    using Block = unsigned char[BLOCK_TEXELS][RGBA_SIZE];
+
+    enum class BlockEncoder { BC1, BC3, BC5, BC7 };
+
+    // 2x2 box filter, the last row or column of odd sizes is repeated.
+    void downsample(const unsigned char* src, VkExtent2D src_extent, unsigned char* dst, VkExtent2D dst_extent) {
+        for(uint32_t y = 0u; y < dst_extent.height; ++y) {
+            const uint32_t y0 = std::min(y * 2u, src_extent.height - 1u);
+            const uint32_t y1 = std::min(y * 2u + 1u, src_extent.height - 1u);
+            for(uint32_t x = 0u; x < dst_extent.width; ++x) {
+                const uint32_t x0 = std::min(x * 2u, src_extent.width - 1u);
+                const uint32_t x1 = std::min(x * 2u + 1u, src_extent.width - 1u);
+                const unsigned char* p00 = src + (static_cast<size_t>(y0) * src_extent.width + x0) * RGBA_SIZE;
+                const unsigned char* p01 = src + (static_cast<size_t>(y0) * src_extent.width + x1) * RGBA_SIZE;
+                const unsigned char* p10 = src + (static_cast<size_t>(y1) * src_extent.width + x0) * RGBA_SIZE;
+                const unsigned char* p11 = src + (static_cast<size_t>(y1) * src_extent.width + x1) * RGBA_SIZE;
+                unsigned char* out = dst + (static_cast<size_t>(y) * dst_extent.width + x) * RGBA_SIZE;
+                for(uint32_t c = 0u; c < RGBA_SIZE; ++c) {
+                    out[c] = static_cast<unsigned char>((p00[c] + p01[c] + p10[c] + p11[c] + 2u) / 4u);
+                }
+            }
+        }
+    }
+
+    // Texels past the borders repeat the last row or column.
+    void fetchBlock(const unsigned char* rgba, VkExtent2D extent, uint32_t block_x, uint32_t block_y, Block& block) {
+        for(uint32_t y = 0u; y < 4u; ++y) {
+            const uint32_t src_y = std::min(block_y * 4u + y, extent.height - 1u);
+            for(uint32_t x = 0u; x < 4u; ++x) {
+                const uint32_t src_x = std::min(block_x * 4u + x, extent.width - 1u);
+                std::copy_n(rgba + (static_cast<size_t>(src_y) * extent.width + src_x) * RGBA_SIZE, RGBA_SIZE, block[y * 4u + x]);
+            }
+        }
+    }
+
+    // Texels with the lowest and highest projection on the principal axis of the first channels, found by a few power
+    // iterations on their covariance.
+    void findEndpoints(const Block& block, uint32_t channels, int low[RGBA_SIZE], int high[RGBA_SIZE]) {
+        float mean[RGBA_SIZE] = {};
+        for(uint32_t i = 0u; i < BLOCK_TEXELS; ++i) {
+            for(uint32_t c = 0u; c < channels; ++c) mean[c] += block[i][c];
+        }
+        for(uint32_t c = 0u; c < channels; ++c) mean[c] /= static_cast<float>(BLOCK_TEXELS);
+
+        float covariance[RGBA_SIZE][RGBA_SIZE] = {};
+        for(uint32_t i = 0u; i < BLOCK_TEXELS; ++i) {
+            for(uint32_t r = 0u; r < channels; ++r) {
+                for(uint32_t c = 0u; c < channels; ++c) {
+                    covariance[r][c] += (block[i][r] - mean[r]) * (block[i][c] - mean[c]);
+                }
+            }
+        }
+
+        float axis[RGBA_SIZE] = {1.0f, 1.0f, 1.0f, 1.0f};
+        for(uint32_t iteration = 0u; iteration < 8u; ++iteration) {
+            float next[RGBA_SIZE] = {};
+            float length = 0.0f;
+            for(uint32_t r = 0u; r < channels; ++r) {
+                for(uint32_t c = 0u; c < channels; ++c) next[r] += covariance[r][c] * axis[c];
+                length = std::max(length, std::abs(next[r]));
+            }
+            if(length < 1e-6f) break;
+            for(uint32_t c = 0u; c < channels; ++c) axis[c] = next[c] / length;
+        }
+
+        uint32_t low_idx = 0u;
+        uint32_t high_idx = 0u;
+        float low_t = std::numeric_limits<float>::max();
+        float high_t = std::numeric_limits<float>::lowest();
+        for(uint32_t i = 0u; i < BLOCK_TEXELS; ++i) {
+            float t = 0.0f;
+            for(uint32_t c = 0u; c < channels; ++c) t += (block[i][c] - mean[c]) * axis[c];
+            if(t < low_t) { low_t = t; low_idx = i; }
+            if(t > high_t) { high_t = t; high_idx = i; }
+        }
+        for(uint32_t c = 0u; c < RGBA_SIZE; ++c) {
+            low[c] = c < channels ? block[low_idx][c] : 0;
+            high[c] = c < channels ? block[high_idx][c] : 0;
+        }
+    }
+
+    int getSquaredDistance(const unsigned char* texel, const int* color, uint32_t channels) {
+        int distance = 0;
+        for(uint32_t c = 0u; c < channels; ++c) {
+            const int d = texel[c] - color[c];
+            distance += d * d;
+        }
+        return distance;
+    }
+
+    uint16_t packRgb565(const int color[RGBA_SIZE]) {
+        const uint32_t r = static_cast<uint32_t>((color[0] * 31 + 127) / 255);
+        const uint32_t g = static_cast<uint32_t>((color[1] * 63 + 127) / 255);
+        const uint32_t b = static_cast<uint32_t>((color[2] * 31 + 127) / 255);
+        return static_cast<uint16_t>((r << 11u) | (g << 5u) | b);
+    }
+
+    void unpackRgb565(uint16_t packed, int color[RGBA_SIZE]) {
+        const int r = (packed >> 11u) & 31;
+        const int g = (packed >> 5u) & 63;
+        const int b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+        color[3] = 255;
+    }
+
+    // BC1 color block in four color mode, which BC3 also uses for its colors.
+    void encodeColorBlock(const Block& block, unsigned char* out) {
+        int low[RGBA_SIZE];
+        int high[RGBA_SIZE];
+        findEndpoints(block, 3u, low, high);
+
+        uint16_t color0 = packRgb565(high);
+        uint16_t color1 = packRgb565(low);
+        if(color0 < color1) std::swap(color0, color1);
+
+        uint32_t indices = 0u;
+        if(color0 != color1) {
+            int palette[4][RGBA_SIZE];
+            unpackRgb565(color0, palette[0]);
+            unpackRgb565(color1, palette[1]);
+            for(uint32_t c = 0u; c < 3u; ++c) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+            }
+            for(uint32_t i = 0u; i < BLOCK_TEXELS; ++i) {
+                uint32_t best = 0u;
+                int best_distance = std::numeric_limits<int>::max();
+                for(uint32_t p = 0u; p < 4u; ++p) {
+                    const int distance = getSquaredDistance(block[i], palette[p], 3u);
+                    if(distance < best_distance) { best_distance = distance; best = p; }
+                }
+                indices |= best << (i * 2u);
+            }
+        }
+
+        out[0] = static_cast<unsigned char>(color0 & 0xFFu);
+        out[1] = static_cast<unsigned char>(color0 >> 8u);
+        out[2] = static_cast<unsigned char>(color1 & 0xFFu);
+        out[3] = static_cast<unsigned char>(color1 >> 8u);
+        for(uint32_t b = 0u; b < 4u; ++b) out[4u + b] = static_cast<unsigned char>((indices >> (b * 8u)) & 0xFFu);
+    }
+
+    // BC4 block of one channel in eight value mode, BC3 alpha and both halves of BC5.
+    void encodeChannelBlock(const Block& block, uint32_t channel, unsigned char* out) {
+        int value0 = 0;
+        int value1 = 255;
+        for(uint32_t i = 0u; i < BLOCK_TEXELS; ++i) {
+            value0 = std::max<int>(value0, block[i][channel]);
+            value1 = std::min<int>(value1, block[i][channel]);
+        }
+
+        uint64_t indices = 0u;
+        if(value0 != value1) {
+            int palette[8] = {value0, value1};
+            for(int k = 1; k < 7; ++k) {
+                palette[k + 1] = ((7 - k) * value0 + k * value1 + 3) / 7;
+            }
+            for(uint32_t i = 0u; i < BLOCK_TEXELS; ++i) {
+                uint64_t best = 0u;
+                int best_distance = std::numeric_limits<int>::max();
+                for(uint32_t p = 0u; p < 8u; ++p) {
+                    const int distance = std::abs(block[i][channel] - palette[p]);
+                    if(distance < best_distance) { best_distance = distance; best = p; }
+                }
+                indices |= best << (i * 3u);
+            }
+        }
+
+        out[0] = static_cast<unsigned char>(value0);
+        out[1] = static_cast<unsigned char>(value1);
+        for(uint32_t b = 0u; b < 6u; ++b) out[2u + b] = static_cast<unsigned char>((indices >> (b * 8u)) & 0xFFu);
+    }
+
+    // Endpoint of 7 bits per channel plus a shared p-bit, the p-bit is chosen by the smaller error.
+    void quantizeBc7Endpoint(const int endpoint[RGBA_SIZE], int quantized[RGBA_SIZE], int& p_bit) {
+        int best_error = std::numeric_limits<int>::max();
+        for(int p = 0; p < 2; ++p) {
+            int candidate[RGBA_SIZE];
+            int error = 0;
+            for(uint32_t c = 0u; c < RGBA_SIZE; ++c) {
+                candidate[c] = std::clamp((endpoint[c] - p + 1) / 2, 0, 127);
+                const int d = ((candidate[c] << 1) | p) - endpoint[c];
+                error += d * d;
+            }
+            if(error < best_error) {
+                best_error = error;
+                p_bit = p;
+                std::copy_n(candidate, RGBA_SIZE, quantized);
+            }
+        }
+    }
+
+    class BitWriter {
+    public:
+        explicit BitWriter(unsigned char* out) : m_out(out) { std::fill_n(m_out, 16u, static_cast<unsigned char>(0u)); }
+
+        void write(uint32_t value, uint32_t bits) {
+            for(uint32_t b = 0u; b < bits; ++b, ++m_position) {
+                if((value >> b) & 1u) m_out[m_position / 8u] |= static_cast<unsigned char>(1u << (m_position % 8u));
+            }
+        }
+
+    private:
+        unsigned char* m_out;
+        uint32_t m_position = 0u;
+    };
+
+    // Mode 6 only: one subset, RGBA endpoints and 4 bit indices. It suits smooth color and alpha gradients, blocks with
+    // several distinct colors lose more than they would with the partitioned modes.
+    void encodeBc7Block(const Block& block, unsigned char* out) {
+        static constexpr int WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+        int endpoints[2][RGBA_SIZE];
+        findEndpoints(block, RGBA_SIZE, endpoints[0], endpoints[1]);
+
+        int quantized[2][RGBA_SIZE];
+        int p_bits[2] = {};
+        quantizeBc7Endpoint(endpoints[0], quantized[0], p_bits[0]);
+        quantizeBc7Endpoint(endpoints[1], quantized[1], p_bits[1]);
+
+        int palette[16][RGBA_SIZE];
+        for(uint32_t p = 0u; p < 16u; ++p) {
+            for(uint32_t c = 0u; c < RGBA_SIZE; ++c) {
+                const int value0 = (quantized[0][c] << 1) | p_bits[0];
+                const int value1 = (quantized[1][c] << 1) | p_bits[1];
+                palette[p][c] = ((64 - WEIGHTS[p]) * value0 + WEIGHTS[p] * value1 + 32) >> 6;
+            }
+        }
+
+        uint32_t indices[BLOCK_TEXELS];
+        for(uint32_t i = 0u; i < BLOCK_TEXELS; ++i) {
+            uint32_t best = 0u;
+            int best_distance = std::numeric_limits<int>::max();
+            for(uint32_t p = 0u; p < 16u; ++p) {
+                const int distance = getSquaredDistance(block[i], palette[p], RGBA_SIZE);
+                if(distance < best_distance) { best_distance = distance; best = p; }
+            }
+            indices[i] = best;
+        }
+
+        // The anchor index is stored without its top bit, swapping the endpoints clears it.
+        if(indices[0] & 8u) {
+            std::swap(quantized[0], quantized[1]);
+            std::swap(p_bits[0], p_bits[1]);
+            for(uint32_t& index : indices) index = 15u - index;
+        }
+
+        BitWriter writer(out);
+        writer.write(1u << 6u, 7u);
+        for(uint32_t c = 0u; c < RGBA_SIZE; ++c) {
+            writer.write(static_cast<uint32_t>(quantized[0][c]), 7u);
+            writer.write(static_cast<uint32_t>(quantized[1][c]), 7u);
+        }
+        writer.write(static_cast<uint32_t>(p_bits[0]), 1u);
+        writer.write(static_cast<uint32_t>(p_bits[1]), 1u);
+        writer.write(indices[0], 3u);
+        for(uint32_t i = 1u; i < BLOCK_TEXELS; ++i) {
+            writer.write(indices[i], 4u);
+        }
+    }
+}
+
+TexelBlock getTexelBlock(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_R8_SRGB: return {1u, 1u, 1u};
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8_SRGB: return {1u, 1u, 2u};
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB: return {1u, 1u, 4u};
+        case VK_FORMAT_R16G16B16A16_SFLOAT: return {1u, 1u, 8u};
+        case VK_FORMAT_R32G32B32A32_SFLOAT: return {1u, 1u, 16u};
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+        case VK_FORMAT_BC4_SNORM_BLOCK: return {4u, 4u, 8u};
+        case VK_FORMAT_BC2_UNORM_BLOCK:
+        case VK_FORMAT_BC2_SRGB_BLOCK:
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+        case VK_FORMAT_BC5_SNORM_BLOCK:
+        case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+        case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK: return {4u, 4u, 16u};
+        case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+        case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+        case VK_FORMAT_EAC_R11_SNORM_BLOCK: return {4u, 4u, 8u};
+        case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+        case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+        case VK_FORMAT_EAC_R11G11_SNORM_BLOCK: return {4u, 4u, 16u};
+        case VK_FORMAT_ASTC_4x4_UNORM_BLOCK: case VK_FORMAT_ASTC_4x4_SRGB_BLOCK: return {4u, 4u, 16u};
+        case VK_FORMAT_ASTC_5x4_UNORM_BLOCK: case VK_FORMAT_ASTC_5x4_SRGB_BLOCK: return {5u, 4u, 16u};
+        case VK_FORMAT_ASTC_5x5_UNORM_BLOCK: case VK_FORMAT_ASTC_5x5_SRGB_BLOCK: return {5u, 5u, 16u};
+        case VK_FORMAT_ASTC_6x5_UNORM_BLOCK: case VK_FORMAT_ASTC_6x5_SRGB_BLOCK: return {6u, 5u, 16u};
+        case VK_FORMAT_ASTC_6x6_UNORM_BLOCK: case VK_FORMAT_ASTC_6x6_SRGB_BLOCK: return {6u, 6u, 16u};
+        case VK_FORMAT_ASTC_8x5_UNORM_BLOCK: case VK_FORMAT_ASTC_8x5_SRGB_BLOCK: return {8u, 5u, 16u};
+        case VK_FORMAT_ASTC_8x6_UNORM_BLOCK: case VK_FORMAT_ASTC_8x6_SRGB_BLOCK: return {8u, 6u, 16u};
+        case VK_FORMAT_ASTC_8x8_UNORM_BLOCK: case VK_FORMAT_ASTC_8x8_SRGB_BLOCK: return {8u, 8u, 16u};
+        case VK_FORMAT_ASTC_10x5_UNORM_BLOCK: case VK_FORMAT_ASTC_10x5_SRGB_BLOCK: return {10u, 5u, 16u};
+        case VK_FORMAT_ASTC_10x6_UNORM_BLOCK: case VK_FORMAT_ASTC_10x6_SRGB_BLOCK: return {10u, 6u, 16u};
+        case VK_FORMAT_ASTC_10x8_UNORM_BLOCK: case VK_FORMAT_ASTC_10x8_SRGB_BLOCK: return {10u, 8u, 16u};
+        case VK_FORMAT_ASTC_10x10_UNORM_BLOCK: case VK_FORMAT_ASTC_10x10_SRGB_BLOCK: return {10u, 10u, 16u};
+        case VK_FORMAT_ASTC_12x10_UNORM_BLOCK: case VK_FORMAT_ASTC_12x10_SRGB_BLOCK: return {12u, 10u, 16u};
+        case VK_FORMAT_ASTC_12x12_UNORM_BLOCK: case VK_FORMAT_ASTC_12x12_SRGB_BLOCK: return {12u, 12u, 16u};
+        default: return {};
+    }
+}
+
+VkDeviceSize getLevelSize(VkFormat format, VkExtent2D extent) {
+    const TexelBlock texel_block = getTexelBlock(format);
+    if(!texel_block.bytes) return 0u;
+
+    const VkDeviceSize blocks_x = (extent.width + texel_block.width - 1u) / texel_block.width;
+    const VkDeviceSize blocks_y = (extent.height + texel_block.height - 1u) / texel_block.height;
+    return blocks_x * blocks_y * texel_block.bytes;
+}
+
+VkExtent2D getMipExtent(VkExtent2D extent, uint32_t mip_level) {
+    return { std::max(extent.width >> mip_level, 1u), std::max(extent.height >> mip_level, 1u) };
+}
+
+MipChain buildMipChain(const unsigned char* rgba, VkExtent2D extent) {
+    MipChain chain;
+    chain.extent = extent;
+
+    VkDeviceSize chain_size = 0u;
+    for(uint32_t mip_level = 0u;; ++mip_level) {
+        VkExtent2D mip_extent = getMipExtent(extent, mip_level);
+        chain.offsets.push_back(chain_size);
+        chain_size += static_cast<VkDeviceSize>(mip_extent.width) * mip_extent.height * RGBA_SIZE;
+        if(mip_extent.width == 1u && mip_extent.height == 1u) break;
+    }
+    chain.offsets.push_back(chain_size);
+
+    chain.data.resize(chain_size);
+    std::copy(rgba, rgba + chain.offsets[1], chain.data.begin());
+    for(uint32_t mip_level = 1u; mip_level + 1u < chain.offsets.size(); ++mip_level) {
+        downsample(
+            chain.data.data() + chain.offsets[mip_level - 1u],
+            getMipExtent(extent, mip_level - 1u),
+            chain.data.data() + chain.offsets[mip_level],
+            getMipExtent(extent, mip_level)
+        );
+    }
+
+    return chain;
+}
+
+std::vector<unsigned char> compressLevel(VkFormat format, const unsigned char* rgba, VkExtent2D extent) {
+    BlockEncoder encoder;
+    switch (format) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK: encoder = BlockEncoder::BC1; break;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK: encoder = BlockEncoder::BC3; break;
+        case VK_FORMAT_BC5_UNORM_BLOCK: encoder = BlockEncoder::BC5; break;
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK: encoder = BlockEncoder::BC7; break;
+        default: throw std::runtime_error("unsupported texture compression format!");
+    }
+
+    const TexelBlock texel_block = getTexelBlock(format);
+    const uint32_t blocks_x = (extent.width + 3u) / 4u;
+    const uint32_t blocks_y = (extent.height + 3u) / 4u;
+    std::vector<unsigned char> compressed(static_cast<size_t>(blocks_x) * blocks_y * texel_block.bytes);
+
+    Block block;
+    for(uint32_t block_y = 0u; block_y < blocks_y; ++block_y) {
+        for(uint32_t block_x = 0u; block_x < blocks_x; ++block_x) {
+            fetchBlock(rgba, extent, block_x, block_y, block);
+            unsigned char* out = compressed.data() + (static_cast<size_t>(block_y) * blocks_x + block_x) * texel_block.bytes;
+            switch (encoder) {
+                case BlockEncoder::BC1:
+                    encodeColorBlock(block, out);
+                    break;
+                case BlockEncoder::BC3:
+                    encodeChannelBlock(block, 3u, out);
+                    encodeColorBlock(block, out + 8u);
+                    break;
+                case BlockEncoder::BC5:
+                    encodeChannelBlock(block, 0u, out);
+                    encodeChannelBlock(block, 1u, out + 8u);
+                    break;
+                case BlockEncoder::BC7:
+                    encodeBc7Block(block, out);
+                    break;
+            }
+        }
+    }
+
+    return compressed;
+}
+
+std::filesystem::path getCookedTexturePath(const std::filesystem::path& image_path) {
+    std::filesystem::path cooked_path = image_path;
+    cooked_path.replace_extension(".ktx2");
+    return cooked_path;
+}
+
+std::filesystem::path getCookedTexturePath(const std::filesystem::path& model_path, int image_idx) {
+    return model_path.parent_path() / (model_path.stem().string() + "_image" + std::to_string(image_idx) + ".ktx2");
+}
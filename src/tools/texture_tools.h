@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Texel block of a format: 1x1 for plain formats, the compression block for BC, ETC2/EAC and ASTC. Zero for formats
+// textures do not use.
+struct TexelBlock {
+    uint32_t width = 0u;
+    uint32_t height = 0u;
+    uint32_t bytes = 0u;
+};
+
+// RGBA8 levels down to 1x1, tightly packed in level order. offsets has one entry past the last level.
+struct MipChain {
+    VkExtent2D extent{};
+    std::vector<unsigned char> data;
+    std::vector<VkDeviceSize> offsets;
+};
+
+TexelBlock getTexelBlock(VkFormat format);
+VkDeviceSize getLevelSize(VkFormat format, VkExtent2D extent);
+VkExtent2D getMipExtent(VkExtent2D extent, uint32_t mip_level);
+
+// Levels are built with a 2x2 box filter, the way VulkanCommandManager::generateMipmaps blits them.
+MipChain buildMipChain(const unsigned char* rgba, VkExtent2D extent);
+
+// Encodes one RGBA8 level to BC1, BC3, BC5 (red and green) or BC7 (mode 6 only), borders are clamped to full blocks.
+// Throws for other formats.
+std::vector<unsigned char> compressLevel(VkFormat format, const unsigned char* rgba, VkExtent2D extent);
+
+// Where texture_cooker writes the KTX2 file of an image file, and of the image_idx-th embedded image of a model.
+std::filesystem::path getCookedTexturePath(const std::filesystem::path& image_path);
+std::filesystem::path getCookedTexturePath(const std::filesystem::path& model_path, int image_idx);
@@ -1,5 +1,19 @@
 #include "thread_pool.h"
 
+namespace {
+    thread_local ThreadPool* t_current_pool = nullptr;
+    thread_local int t_worker_index = -1;
+
+    constexpr int SPIN_BEFORE_PARK = 32;
+
+    uint32_t xorshift32(uint32_t& state) {
+        state ^= state << 13u;
+        state ^= state >> 17u;
+        state ^= state << 5u;
+        return state;
+    }
+}
+
 scope_thread::scope_thread(std::thread t) noexcept : m_thread(std::move(t)) {}
 
 scope_thread::scope_thread(scope_thread&& other) noexcept : m_thread(std::move(other.m_thread)) {}
@@ -66,31 +80,136 @@ join_threads::~join_threads() {
     }
 }
 
-ThreadPool::ThreadPool() : m_done(false), m_joiner(m_threads) {
-    const unsigned thread_count = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() / 2u : 1u;
+ThreadPool::ThreadPool() : ThreadPool(std::max(std::thread::hardware_concurrency() / 2u, 1u)) {}
+
+ThreadPool::ThreadPool(unsigned thread_count) : m_done(false), m_work_epoch(0u), m_sleeping(0u), m_joiner(m_threads) {
+    thread_count = std::max(thread_count, 1u);
+    m_workers.reserve(thread_count);
+    for(unsigned i = 0; i < thread_count; ++i) {
+        std::unique_ptr<WorkerData> worker = std::make_unique<WorkerData>();
+        worker->rng_state = 0x9E3779B9u * (i + 1u);
+        m_workers.push_back(std::move(worker));
+    }
+
     try {
         for(unsigned i = 0; i < thread_count; ++i) {
-            m_threads.push_back(std::thread(&ThreadPool::worker_thread, this));
+            m_threads.push_back(std::thread(&ThreadPool::worker_thread, this, static_cast<int>(i)));
         }
     }
     catch(...) {
         m_done = true;
+        m_work_epoch.fetch_add(1u);
+        m_work_epoch.notify_all();
         throw;
     }
 }
 
 ThreadPool::~ThreadPool() {
     m_done = true;
+    m_work_epoch.fetch_add(1u);
+    m_work_epoch.notify_all();
+}
+
+unsigned ThreadPool::getThreadCount() const {
+    return static_cast<unsigned>(m_workers.size());
+}
+
+int ThreadPool::current_worker_index() const {
+    return t_current_pool == this ? t_worker_index : -1;
+}
+
+void ThreadPool::push_task(PoolTask* task) {
+    int worker_index = current_worker_index();
+    if(worker_index >= 0) {
+        m_workers[worker_index]->deque.Push(task);
+    }
+    else {
+        m_injection_queue.Push(task);
+    }
+    wake_one();
+}
+
+void ThreadPool::wake_one() {
+    m_work_epoch.fetch_add(1u);
+    if(m_sleeping.load() > 0u) {
+        m_work_epoch.notify_one();
+    }
 }
 
-void ThreadPool::worker_thread() {
-    while(!m_done) {
-        FunctionWrapper task;
-        if(m_work_queue.TryPop(task)) {
-            task();
+PoolTask* ThreadPool::find_task(int worker_index) {
+    PoolTask* task = nullptr;
+    if(worker_index >= 0 && m_workers[worker_index]->deque.Pop(task)) {
+        return task;
+    }
+    if(m_injection_queue.TryPop(task)) {
+        return task;
+    }
+    return steal_task(worker_index);
+}
+
+PoolTask* ThreadPool::steal_task(int worker_index) {
+    const size_t worker_count = m_workers.size();
+    thread_local uint32_t t_external_rng_state = 0x2545F491u;
+    uint32_t& rng_state = worker_index >= 0 ? m_workers[worker_index]->rng_state : t_external_rng_state;
+    const size_t first_victim = xorshift32(rng_state) % worker_count;
+
+    PoolTask* task = nullptr;
+    for(size_t i = 0u; i < worker_count; ++i) {
+        size_t victim = (first_victim + i) % worker_count;
+        if(static_cast<int>(victim) == worker_index) continue;
+        if(m_workers[victim]->deque.Steal(task)) {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void ThreadPool::wait_for(std::atomic<size_t>& remaining) {
+    const int worker_index = current_worker_index();
+    size_t left = remaining.load(std::memory_order_acquire);
+    while(left != 0u) {
+        if(PoolTask* task = find_task(worker_index)) {
+            task->Execute();
         }
         else {
+            remaining.wait(left, std::memory_order_acquire);
+        }
+        left = remaining.load(std::memory_order_acquire);
+    }
+}
+
+void ThreadPool::worker_thread(int worker_index) {
+    t_current_pool = this;
+    t_worker_index = worker_index;
+
+    int idle_spins = 0;
+    while(true) {
+        if(PoolTask* task = find_task(worker_index)) {
+            task->Execute();
+            idle_spins = 0;
+            continue;
+        }
+        if(idle_spins++ < SPIN_BEFORE_PARK) {
             std::this_thread::yield();
+            continue;
         }
+
+        uint32_t epoch = m_work_epoch.load();
+        if(PoolTask* task = find_task(worker_index)) {
+            task->Execute();
+            idle_spins = 0;
+            continue;
+        }
+        if(m_done) {
+            break;
+        }
+
+        m_sleeping.fetch_add(1u);
+        m_work_epoch.wait(epoch);
+        m_sleeping.fetch_sub(1u);
+        idle_spins = 0;
     }
+
+    t_current_pool = nullptr;
+    t_worker_index = -1;
 }
@@ -1,13 +1,18 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
+#include <exception>
 #include <functional>
 #include <future>
+#include <memory>
 #include <thread>
 #include <type_traits>
 #include <vector>
 
-#include "thread_safe_queue.h"
+#include "concurrent_queue.h"
+#include "cpu_load_balance.h"
+#include "work_stealing_deque.h"
 
 class join_threads {
 public:
@@ -47,7 +52,7 @@ class FunctionWrapper {
 public:
 
     template<typename F>
-    FunctionWrapper(F&& f_) : m_impl(new ImplType<F>(std::move(f_))) {}
+    FunctionWrapper(F&& f_) : m_impl(new ImplType<std::decay_t<F>>(std::forward<F>(f_))) {}
 
     FunctionWrapper() = default;
     FunctionWrapper(FunctionWrapper&& other) : m_impl(std::move(other.m_impl)) {}
@@ -76,21 +81,34 @@ private:
     template<typename F>
     struct ImplType : ImplBase {
         F f;
-        ImplType(F&& f_) : f(std::move(f_)) {}
-        void call() {
+        template<typename U>
+        ImplType(U&& f_) : f(std::forward<U>(f_)) {}
+        void Call() override {
             f();
         }
     };
 };
 
+class PoolTask {
+public:
+    virtual ~PoolTask() = default;
+    virtual void Execute() = 0;
+};
+
 class ThreadPool {
 public:
     ThreadPool();
+    ThreadPool(unsigned thread_count);
     ~ThreadPool();
 
+    ThreadPool(const ThreadPool& other) = delete;
+    ThreadPool(ThreadPool&& other) = delete;
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+    ThreadPool& operator=(ThreadPool&& other) = delete;
+
     template<typename FunctionType>
     void Submit(FunctionType fn) {
-        m_work_queue.Push(std::function<void()>(fn));
+        push_task(new SubmittedTask(FunctionWrapper(std::move(fn))));
     }
 
     // template<typename FunctionType>
@@ -105,11 +123,141 @@ public:
     //     return res;
     // }
 
+    // fn(first, last) is called once per block. There is a block for every worker and one for the calling thread, as
+    // long as each gets at least grain items (CPULoadBalanceParams::max_threads). The pool size decides, not the cores
+    // the machine reports. The calling thread runs one block itself and helps with queued work until every block is done.
+    // If a block throws, blocks that have not started yet are skipped and the first exception is rethrown on the
+    // calling thread once no task refers to its stack anymore.
+    template<typename FunctionType>
+    void ParallelForRange(size_t begin, size_t end, size_t grain, FunctionType&& fn) {
+        if(end <= begin) return;
+        const size_t amt_work = end - begin;
+        const CPULoadBalanceParams params(amt_work, static_cast<unsigned long>(std::max<size_t>(grain, 1u)));
+        const size_t num_blocks = std::min(params.max_threads, static_cast<size_t>(getThreadCount()) + 1u);
+        if(num_blocks <= 1u) {
+            fn(begin, end);
+            return;
+        }
+
+        const size_t block_size = amt_work / num_blocks;
+        RangeState state(num_blocks - 1u);
+        std::vector<RangeTask<std::remove_reference_t<FunctionType>>> blocks;
+        blocks.reserve(num_blocks - 1u);
+        size_t block_start = begin;
+        for(size_t i = 0u; i < num_blocks - 1u; ++i) {
+            size_t block_end = block_start + block_size;
+            blocks.emplace_back(&fn, block_start, block_end, &state);
+            block_start = block_end;
+        }
+        for(auto& block : blocks) {
+            push_task(&block);
+        }
+
+        try {
+            fn(block_start, end);
+        }
+        catch(...) {
+            state.Fail(std::current_exception());
+        }
+        wait_for(state.remaining);
+        // The blocks that finished last may still be waking this thread, state and blocks are freed once they let go.
+        while(state.released.load(std::memory_order_acquire) != 0u) {
+            std::this_thread::yield();
+        }
+        if(state.error) {
+            std::rethrow_exception(state.error);
+        }
+    }
+
+    template<typename FunctionType>
+    void ParallelFor(size_t begin, size_t end, size_t grain, FunctionType&& fn) {
+        ParallelForRange(begin, end, grain, [&fn](size_t first, size_t last) {
+            for(size_t i = first; i < last; ++i) {
+                fn(i);
+            }
+        });
+    }
+
+    unsigned getThreadCount() const;
+
 private:
+    class SubmittedTask : public PoolTask {
+    public:
+        SubmittedTask(FunctionWrapper fn) : m_fn(std::move(fn)) {}
+        void Execute() override {
+            m_fn();
+            delete this;
+        }
+
+    private:
+        FunctionWrapper m_fn;
+    };
+
+    // Shared by the blocks of one ParallelForRange call, lives on the calling thread's stack.
+    struct RangeState {
+        explicit RangeState(size_t block_count) : remaining(block_count), released(block_count) {}
+
+        // Only the first exception is kept, error is published to the caller by the release in remaining.
+        void Fail(std::exception_ptr exception) {
+            if(!failed.test_and_set(std::memory_order_acq_rel)) {
+                error = std::move(exception);
+            }
+        }
+
+        std::atomic<size_t> remaining; // Blocks not done yet, the calling thread sleeps on it
+        std::atomic<size_t> released; // Blocks that may still touch the state, decremented as their very last access
+        std::atomic_flag failed;
+        std::exception_ptr error;
+    };
+
+    template<typename FunctionType>
+    class RangeTask : public PoolTask {
+    public:
+        RangeTask(FunctionType* fn, size_t first, size_t last, RangeState* state) : m_fn(fn), m_first(first), m_last(last), m_state(state) {}
+        // The task lives in the calling thread's blocks, once released is decremented neither it nor the state may be
+        // touched: the calling thread is free to return.
+        void Execute() override {
+            RangeState* state = m_state;
+            if(!state->failed.test(std::memory_order_acquire)) {
+                try {
+                    (*m_fn)(m_first, m_last);
+                }
+                catch(...) {
+                    state->Fail(std::current_exception());
+                }
+            }
+            if(state->remaining.fetch_sub(1u, std::memory_order_acq_rel) == 1u) {
+                state->remaining.notify_all();
+            }
+            state->released.fetch_sub(1u, std::memory_order_release);
+        }
+
+    private:
+        FunctionType* m_fn;
+        size_t m_first;
+        size_t m_last;
+        RangeState* m_state;
+    };
+
+    struct WorkerData {
+        WorkStealingDeque<PoolTask*> deque;
+        uint32_t rng_state;
+    };
+
+    void push_task(PoolTask* task);
+    PoolTask* find_task(int worker_index);
+    PoolTask* steal_task(int worker_index);
+    void wait_for(std::atomic<size_t>& remaining);
+    void wake_one();
+    int current_worker_index() const;
+
     std::atomic_bool m_done;
-    ThreadSafeQueue<FunctionWrapper> m_work_queue;
+    std::atomic<uint32_t> m_work_epoch;
+    std::atomic<uint32_t> m_sleeping;
+    ConcurrentQueue<PoolTask*> m_injection_queue;
+    std::vector<std::unique_ptr<WorkerData>> m_workers;
     std::vector<std::thread> m_threads;
     join_threads m_joiner;
 
-    void worker_thread();
+    void worker_thread(int worker_index);
 };
\ No newline at end of file
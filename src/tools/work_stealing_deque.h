@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Chase-Lev deque (Le, Pop, Cohen, Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models").
+// Push and Pop are owner-only, Steal may be called from any thread.
+template<typename DataType>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable_v<DataType>, "WorkStealingDeque stores trivially copyable elements only");
+
+public:
+    explicit WorkStealingDeque(size_t capacity = 256u) : m_top(0), m_bottom(0) {
+        size_t cap = 1u;
+        while(cap < capacity) cap <<= 1u;
+        m_buffers.push_back(std::make_unique<Buffer>(cap));
+        m_buffer.store(m_buffers.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque& other) = delete;
+    WorkStealingDeque(WorkStealingDeque&& other) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque& other) = delete;
+    WorkStealingDeque& operator=(WorkStealingDeque&& other) = delete;
+
+    void Push(DataType value) {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_acquire);
+        Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+        if(b - t > static_cast<int64_t>(buffer->mask)) {
+            buffer = grow(buffer, t, b);
+        }
+        buffer->put(b, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    bool Pop(DataType& value) {
+        int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+
+        if(t > b) {
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        value = buffer->get(b);
+        if(t == b) {
+            bool won = m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    bool Steal(DataType& value) {
+        int64_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = m_bottom.load(std::memory_order_acquire);
+        if(t >= b) {
+            return false;
+        }
+
+        Buffer* buffer = m_buffer.load(std::memory_order_acquire);
+        value = buffer->get(t);
+        return m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    bool Empty() const {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+        return t >= b;
+    }
+
+    size_t Size() const {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0u;
+    }
+
+private:
+    struct Buffer {
+        explicit Buffer(size_t capacity) : mask(capacity - 1u), slots(new std::atomic<DataType>[capacity]) {}
+
+        DataType get(int64_t index) const {
+            return slots[static_cast<size_t>(index) & mask].load(std::memory_order_relaxed);
+        }
+
+        void put(int64_t index, DataType value) {
+            slots[static_cast<size_t>(index) & mask].store(value, std::memory_order_relaxed);
+        }
+
+        size_t mask;
+        std::unique_ptr<std::atomic<DataType>[]> slots;
+    };
+
+    Buffer* grow(Buffer* old_buffer, int64_t top, int64_t bottom) {
+        m_buffers.push_back(std::make_unique<Buffer>((old_buffer->mask + 1u) << 1u));
+        Buffer* new_buffer = m_buffers.back().get();
+        for(int64_t i = top; i < bottom; ++i) {
+            new_buffer->put(i, old_buffer->get(i));
+        }
+        m_buffer.store(new_buffer, std::memory_order_release);
+        return new_buffer;
+    }
+
+    alignas(64) std::atomic<int64_t> m_top;
+    alignas(64) std::atomic<int64_t> m_bottom;
+    alignas(64) std::atomic<Buffer*> m_buffer;
+    // Retired buffers stay alive until the deque dies, a thief may still be reading from them.
+    std::vector<std::unique_ptr<Buffer>> m_buffers;
+};
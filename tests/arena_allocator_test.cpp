@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+
+#include "../src/tools/arena_allocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace {
+    // Hands out mini heaps one after another and remembers which are still alive.
+    class FakeBackingAllocator : public IBackingAllocator {
+    public:
+        explicit FakeBackingAllocator(uint32_t max_heaps = ~0u) : m_max_heaps(max_heaps) {}
+
+        bool allocate_backing_heap(uint64_t size, BackingAllocation& backing) override {
+            if(live_heaps >= m_max_heaps) return false;
+            backing.offset = m_next_offset;
+            backing.size = size;
+            m_next_offset += size;
+            ++live_heaps;
+            return true;
+        }
+
+        void free_backing_heap(const BackingAllocation&) override {
+            --live_heaps;
+        }
+
+        uint32_t live_heaps = 0u;
+
+    private:
+        uint32_t m_max_heaps;
+        uint64_t m_next_offset = 0u;
+    };
+
+    constexpr uint64_t SUB_BLOCK_SIZE = 256u;
+    constexpr uint64_t HEAP_SIZE = SUB_BLOCK_SIZE * LegionAllocator::NUM_SUB_BLOCKS;
+}
+
+class ArenaAllocatorTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        arena.set_sub_block_size(SUB_BLOCK_SIZE);
+        arena.set_backing_allocator(&backing);
+    }
+
+    FakeBackingAllocator backing;
+    ArenaAllocator arena;
+};
+
+TEST_F(ArenaAllocatorTest, RejectsEmptyAndOversizedRequests) {
+    ArenaAllocation alloc;
+    EXPECT_EQ(arena.get_max_allocation_size(), HEAP_SIZE);
+    EXPECT_FALSE(arena.allocate(0u, alloc));
+    EXPECT_FALSE(arena.allocate(HEAP_SIZE + 1u, alloc));
+    EXPECT_EQ(backing.live_heaps, 0u);
+}
+
+TEST_F(ArenaAllocatorTest, RoundsUpToWholeSubBlocks) {
+    ArenaAllocation alloc;
+    ASSERT_TRUE(arena.allocate(300u, alloc));
+    EXPECT_EQ(alloc.range.size, 2u * SUB_BLOCK_SIZE);
+    EXPECT_EQ(std::popcount(alloc.range.mask), 2);
+    EXPECT_EQ(alloc.range.offset % SUB_BLOCK_SIZE, 0u);
+}
+
+TEST_F(ArenaAllocatorTest, PacksAHeapBeforeOpeningTheNext) {
+    std::vector<ArenaAllocation> allocs(LegionAllocator::NUM_SUB_BLOCKS);
+    for(ArenaAllocation& alloc : allocs) {
+        ASSERT_TRUE(arena.allocate(SUB_BLOCK_SIZE, alloc));
+    }
+    EXPECT_EQ(backing.live_heaps, 1u);
+    EXPECT_EQ(arena.get_heap_count(), 1u);
+
+    std::vector<uint64_t> offsets;
+    for(const ArenaAllocation& alloc : allocs) {
+        EXPECT_LT(alloc.range.offset, HEAP_SIZE);
+        offsets.push_back(alloc.range.offset);
+    }
+    std::sort(offsets.begin(), offsets.end());
+    EXPECT_EQ(std::adjacent_find(offsets.begin(), offsets.end()), offsets.end());
+
+    ArenaAllocation next;
+    ASSERT_TRUE(arena.allocate(SUB_BLOCK_SIZE, next));
+    EXPECT_EQ(backing.live_heaps, 2u);
+    EXPECT_GE(next.range.offset, HEAP_SIZE);
+}
+
+TEST_F(ArenaAllocatorTest, MultiBlockRunsAreContiguousAndDisjoint) {
+    std::vector<ArenaAllocation> allocs(10u);
+    uint32_t used_mask = 0u;
+    for(ArenaAllocation& alloc : allocs) {
+        ASSERT_TRUE(arena.allocate(3u * SUB_BLOCK_SIZE, alloc));
+        const uint32_t run = alloc.range.mask >> std::countr_zero(alloc.range.mask);
+        EXPECT_EQ(run, 0b111u);
+        EXPECT_EQ(used_mask & alloc.range.mask, 0u);
+        used_mask |= alloc.range.mask;
+    }
+    EXPECT_EQ(backing.live_heaps, 1u);
+
+    // Two sub blocks are left, a run of three has to go to a new heap.
+    ArenaAllocation alloc;
+    ASSERT_TRUE(arena.allocate(3u * SUB_BLOCK_SIZE, alloc));
+    EXPECT_EQ(backing.live_heaps, 2u);
+}
+
+TEST_F(ArenaAllocatorTest, ReusesFreedSubBlocks) {
+    std::vector<ArenaAllocation> allocs(LegionAllocator::NUM_SUB_BLOCKS);
+    for(ArenaAllocation& alloc : allocs) {
+        ASSERT_TRUE(arena.allocate(SUB_BLOCK_SIZE, alloc));
+    }
+    const uint64_t freed_offset = allocs[7].range.offset;
+    arena.free(allocs[7]);
+
+    ASSERT_TRUE(arena.allocate(SUB_BLOCK_SIZE, allocs[7]));
+    EXPECT_EQ(allocs[7].range.offset, freed_offset);
+    EXPECT_EQ(backing.live_heaps, 1u);
+}
+
+TEST_F(ArenaAllocatorTest, FragmentedHeapsDoNotTakeLongerRuns) {
+    std::vector<ArenaAllocation> allocs(LegionAllocator::NUM_SUB_BLOCKS);
+    for(ArenaAllocation& alloc : allocs) {
+        ASSERT_TRUE(arena.allocate(SUB_BLOCK_SIZE, alloc));
+    }
+    for(size_t i = 0u; i < allocs.size(); i += 2u) {
+        arena.free(allocs[i]);
+    }
+
+    ArenaAllocation pair;
+    ASSERT_TRUE(arena.allocate(2u * SUB_BLOCK_SIZE, pair));
+    EXPECT_EQ(backing.live_heaps, 2u);
+    EXPECT_GE(pair.range.offset, HEAP_SIZE);
+
+    ArenaAllocation single;
+    ASSERT_TRUE(arena.allocate(SUB_BLOCK_SIZE, single));
+    EXPECT_LT(single.range.offset, HEAP_SIZE);
+}
+
+TEST_F(ArenaAllocatorTest, ReturnsEmptyHeapsToTheBackingAllocator) {
+    std::vector<ArenaAllocation> allocs(LegionAllocator::NUM_SUB_BLOCKS + 1u);
+    for(ArenaAllocation& alloc : allocs) {
+        ASSERT_TRUE(arena.allocate(SUB_BLOCK_SIZE, alloc));
+    }
+    EXPECT_EQ(backing.live_heaps, 2u);
+
+    for(ArenaAllocation& alloc : allocs) {
+        arena.free(alloc);
+    }
+    EXPECT_EQ(backing.live_heaps, 0u);
+    EXPECT_EQ(arena.get_heap_count(), 0u);
+}
+
+TEST(ArenaAllocator, FailsOnceTheBackingAllocatorIsExhausted) {
+    FakeBackingAllocator backing(1u);
+    ArenaAllocator arena;
+    arena.set_sub_block_size(SUB_BLOCK_SIZE);
+    arena.set_backing_allocator(&backing);
+
+    ArenaAllocation whole;
+    ASSERT_TRUE(arena.allocate(HEAP_SIZE, whole));
+    ArenaAllocation alloc;
+    EXPECT_FALSE(arena.allocate(SUB_BLOCK_SIZE, alloc));
+
+    arena.free(whole);
+    EXPECT_TRUE(arena.allocate(SUB_BLOCK_SIZE, alloc));
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include "../src/tools/bounded_mpmc_queue.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+TEST(BoundedMPMCQueue, CapacityIsRoundedUpToAPowerOfTwo) {
+    EXPECT_EQ(BoundedMPMCQueue<int>(1u).Capacity(), 2u);
+    EXPECT_EQ(BoundedMPMCQueue<int>(100u).Capacity(), 128u);
+    EXPECT_EQ(BoundedMPMCQueue<int>(256u).Capacity(), 256u);
+}
+
+TEST(BoundedMPMCQueue, PopsInPushOrderOnOneThread) {
+    BoundedMPMCQueue<int> queue(8u);
+    for(int value = 0; value < 5; ++value) {
+        EXPECT_TRUE(queue.TryPush(value));
+    }
+    EXPECT_EQ(queue.Size(), 5u);
+
+    int value = -1;
+    for(int expected = 0; expected < 5; ++expected) {
+        ASSERT_TRUE(queue.TryPop(value));
+        EXPECT_EQ(value, expected);
+    }
+    EXPECT_FALSE(queue.TryPop(value));
+    EXPECT_TRUE(queue.Empty());
+}
+
+TEST(BoundedMPMCQueue, TryPushFailsWhileFull) {
+    BoundedMPMCQueue<int> queue(4u);
+    for(int value = 0; value < 4; ++value) {
+        EXPECT_TRUE(queue.TryPush(value));
+    }
+    EXPECT_FALSE(queue.TryPush(4));
+
+    int value = -1;
+    ASSERT_TRUE(queue.TryPop(value));
+    EXPECT_TRUE(queue.TryPush(4));
+}
+
+TEST(BoundedMPMCQueue, WrapsAroundManyTimes) {
+    BoundedMPMCQueue<int> queue(4u);
+    int value = -1;
+    for(int round = 0; round < 1000; ++round) {
+        ASSERT_TRUE(queue.TryPush(round));
+        ASSERT_TRUE(queue.TryPush(round + 1));
+        ASSERT_TRUE(queue.TryPop(value));
+        EXPECT_EQ(value, round);
+        ASSERT_TRUE(queue.TryPop(value));
+        EXPECT_EQ(value, round + 1);
+    }
+}
+
+TEST(BoundedMPMCQueue, DestroysElementsLeftInTheRing) {
+    std::shared_ptr<int> shared = std::make_shared<int>(7);
+    {
+        BoundedMPMCQueue<std::shared_ptr<int>> queue(4u);
+        queue.Push(shared);
+        queue.Push(shared);
+        EXPECT_EQ(shared.use_count(), 3);
+    }
+    EXPECT_EQ(shared.use_count(), 1);
+}
+
+// Producers block in Push on a ring far smaller than what goes through it, every value has to come out exactly once.
+TEST(BoundedMPMCQueue, DeliversEveryValueOnceAcrossThreads) {
+    constexpr uint32_t PRODUCERS = 4u;
+    constexpr uint32_t CONSUMERS = 4u;
+    constexpr uint32_t VALUES_PER_PRODUCER = 20000u;
+    constexpr uint32_t VALUES_PER_CONSUMER = PRODUCERS * VALUES_PER_PRODUCER / CONSUMERS;
+
+    BoundedMPMCQueue<uint32_t> queue(16u);
+    std::vector<std::vector<uint32_t>> popped(CONSUMERS);
+    std::vector<std::thread> threads;
+    for(uint32_t consumer = 0u; consumer < CONSUMERS; ++consumer) {
+        threads.emplace_back([&queue, &popped, consumer]() {
+            popped[consumer].reserve(VALUES_PER_CONSUMER);
+            for(uint32_t i = 0u; i < VALUES_PER_CONSUMER; ++i) {
+                uint32_t value = 0u;
+                queue.WaitAndPop(value);
+                popped[consumer].push_back(value);
+            }
+        });
+    }
+    for(uint32_t producer = 0u; producer < PRODUCERS; ++producer) {
+        threads.emplace_back([&queue, producer]() {
+            for(uint32_t i = 0u; i < VALUES_PER_PRODUCER; ++i) {
+                queue.Push(producer * VALUES_PER_PRODUCER + i);
+            }
+        });
+    }
+    for(std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<uint32_t> all_values;
+    for(const std::vector<uint32_t>& values : popped) {
+        // Values of one producer reach one consumer in the order they were pushed.
+        std::vector<uint32_t> last_of_producer(PRODUCERS, 0u);
+        std::vector<bool> seen_producer(PRODUCERS, false);
+        for(uint32_t value : values) {
+            const uint32_t producer = value / VALUES_PER_PRODUCER;
+            if(seen_producer[producer]) {
+                EXPECT_GT(value, last_of_producer[producer]);
+            }
+            seen_producer[producer] = true;
+            last_of_producer[producer] = value;
+        }
+        all_values.insert(all_values.end(), values.begin(), values.end());
+    }
+    std::sort(all_values.begin(), all_values.end());
+    ASSERT_EQ(all_values.size(), PRODUCERS * VALUES_PER_PRODUCER);
+    for(uint32_t i = 0u; i < all_values.size(); ++i) {
+        ASSERT_EQ(all_values[i], i);
+    }
+    EXPECT_TRUE(queue.Empty());
+}
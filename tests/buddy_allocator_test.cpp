@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include "../src/tools/buddy_allocator.h"
+
+#include <cstdint>
+#include <vector>
+
+TEST(BuddyAllocator, RoundsCapacityAndBlockSizeToPowersOfTwo) {
+    BuddyAllocator buddy(1000u, 48u);
+    EXPECT_EQ(buddy.get_capacity(), 512u);
+    EXPECT_EQ(buddy.get_min_block_size(), 64u);
+    EXPECT_TRUE(buddy.empty());
+}
+
+TEST(BuddyAllocator, SplitsTheSmallestFittingBlock) {
+    BuddyAllocator buddy(1024u, 64u);
+    uint64_t offset = 0u;
+    uint64_t size = 0u;
+
+    ASSERT_TRUE(buddy.allocate(64u, 1u, offset, size));
+    EXPECT_EQ(offset, 0u);
+    EXPECT_EQ(size, 64u);
+
+    ASSERT_TRUE(buddy.allocate(64u, 1u, offset, size));
+    EXPECT_EQ(offset, 64u);
+
+    ASSERT_TRUE(buddy.allocate(100u, 1u, offset, size));
+    EXPECT_EQ(offset, 128u);
+    EXPECT_EQ(size, 128u);
+
+    ASSERT_TRUE(buddy.allocate(256u, 1u, offset, size));
+    EXPECT_EQ(offset, 256u);
+    EXPECT_EQ(buddy.get_used_size(), 64u + 64u + 128u + 256u);
+}
+
+TEST(BuddyAllocator, MergesBuddiesBackInAnyFreeOrder) {
+    BuddyAllocator buddy(1024u, 64u);
+    std::vector<uint64_t> offsets;
+    uint64_t offset = 0u;
+    uint64_t size = 0u;
+    while(buddy.allocate(64u, 1u, offset, size)) {
+        offsets.push_back(offset);
+    }
+    ASSERT_EQ(offsets.size(), 16u);
+
+    for(size_t i = 0u; i < offsets.size(); i += 2u) {
+        buddy.free(offsets[i], 64u);
+    }
+    // Half the range is free but every free block sits next to a used buddy.
+    EXPECT_FALSE(buddy.allocate(128u, 1u, offset, size));
+
+    for(size_t i = offsets.size() - 1u; i < offsets.size(); i -= 2u) {
+        buddy.free(offsets[i], 64u);
+    }
+    EXPECT_TRUE(buddy.empty());
+    ASSERT_TRUE(buddy.allocate(1024u, 1u, offset, size));
+    EXPECT_EQ(offset, 0u);
+    EXPECT_EQ(size, 1024u);
+}
+
+TEST(BuddyAllocator, AlignsOffsetsAboveTheBlockSize) {
+    BuddyAllocator buddy(4096u, 64u);
+    uint64_t offset = 0u;
+    uint64_t size = 0u;
+    ASSERT_TRUE(buddy.allocate(64u, 1u, offset, size));
+
+    ASSERT_TRUE(buddy.allocate(64u, 1024u, offset, size));
+    EXPECT_EQ(offset % 1024u, 0u);
+    EXPECT_NE(offset, 0u);
+    EXPECT_GE(size, 1024u);
+}
+
+TEST(BuddyAllocator, FailsWhenExhausted) {
+    BuddyAllocator buddy(1024u, 64u);
+    uint64_t offset = 0u;
+    uint64_t size = 0u;
+    EXPECT_FALSE(buddy.allocate(0u, 1u, offset, size));
+    EXPECT_FALSE(buddy.allocate(2048u, 1u, offset, size));
+    EXPECT_FALSE(buddy.allocate(64u, 2048u, offset, size));
+
+    ASSERT_TRUE(buddy.allocate(1024u, 1u, offset, size));
+    EXPECT_FALSE(buddy.allocate(64u, 1u, offset, size));
+
+    buddy.free(offset, size);
+    EXPECT_TRUE(buddy.allocate(64u, 1u, offset, size));
+}
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include "../src/graphics/drawables/draw_batcher.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+    // Stand-ins for the pipeline, material and buffer objects, the batcher only compares their addresses.
+    const int PIPELINES[2] = {};
+    const int MATERIALS[2] = {};
+    const int BUFFERS[4] = {};
+
+    DrawBatcher::Key makeKey(int pipeline, int material, int vertex_buffer, int index_buffer) {
+        return { &PIPELINES[pipeline], &MATERIALS[material], &BUFFERS[vertex_buffer], &BUFFERS[index_buffer] };
+    }
+
+    glm::mat4 makeModel(float x) {
+        return glm::translate(glm::mat4(1.0f), glm::vec3(x, 2.0f * x, -x));
+    }
+
+    void expectNear(const glm::mat4& a, const glm::mat4& b) {
+        for(int column = 0; column < 4; ++column) {
+            for(int row = 0; row < 4; ++row) {
+                EXPECT_NEAR(a[column][row], b[column][row], 1e-5f) << column << " " << row;
+            }
+        }
+    }
+}
+
+TEST(DrawBatcher, KeysCompareByEveryMember) {
+    const DrawBatcher::Key key = makeKey(0, 0, 0, 1);
+    EXPECT_EQ(key, makeKey(0, 0, 0, 1));
+    EXPECT_NE(key, makeKey(1, 0, 0, 1));
+    EXPECT_NE(key, makeKey(0, 1, 0, 1));
+    EXPECT_NE(key, makeKey(0, 0, 2, 1));
+    EXPECT_NE(key, makeKey(0, 0, 0, 3));
+}
+
+TEST(DrawBatcher, EqualKeysShareOneBatch) {
+    DrawBatcher batcher;
+    for(uint32_t i = 0u; i < 5u; ++i) {
+        batcher.add(makeKey(0, 0, 0, 1), 10u + i, makeModel(float(i)), 36u);
+    }
+    batcher.build();
+
+    ASSERT_EQ(batcher.getBatches().size(), 1u);
+    const DrawBatcher::Batch& batch = batcher.getBatches()[0];
+    EXPECT_EQ(batch.leader_id, 10u);
+    EXPECT_EQ(batch.first_instance, 0u);
+    EXPECT_EQ(batch.instance_count, 5u);
+
+    ASSERT_EQ(batcher.getCommands().size(), 1u);
+    const VkDrawIndexedIndirectCommand& command = batcher.getCommands()[0];
+    EXPECT_EQ(command.indexCount, 36u);
+    EXPECT_EQ(command.instanceCount, 5u);
+    EXPECT_EQ(command.firstIndex, 0u);
+    EXPECT_EQ(command.vertexOffset, 0);
+    EXPECT_EQ(command.firstInstance, 0u);
+}
+
+TEST(DrawBatcher, SplitsByPipelineMaterialAndBuffers) {
+    DrawBatcher batcher;
+    const std::vector<DrawBatcher::Key> keys = {
+        makeKey(0, 0, 0, 1),
+        makeKey(1, 0, 0, 1),
+        makeKey(0, 1, 0, 1),
+        makeKey(0, 0, 2, 1),
+        makeKey(0, 0, 0, 3),
+    };
+    for(uint32_t i = 0u; i < keys.size(); ++i) {
+        batcher.add(keys[i], i, makeModel(float(i)), 6u * (i + 1u));
+        batcher.add(keys[i], 100u + i, makeModel(float(i)), 6u * (i + 1u));
+    }
+    batcher.build();
+
+    ASSERT_EQ(batcher.getBatches().size(), keys.size());
+    ASSERT_EQ(batcher.getCommands().size(), keys.size());
+    uint32_t next_instance = 0u;
+    for(size_t i = 0u; i < batcher.getBatches().size(); ++i) {
+        const DrawBatcher::Batch& batch = batcher.getBatches()[i];
+        const VkDrawIndexedIndirectCommand& command = batcher.getCommands()[i];
+        EXPECT_EQ(batch.instance_count, 2u);
+        EXPECT_EQ(batch.first_instance, next_instance);
+        EXPECT_EQ(command.firstInstance, next_instance);
+        EXPECT_EQ(command.instanceCount, 2u);
+        EXPECT_EQ(command.indexCount, 6u * (batch.leader_id + 1u));
+        EXPECT_EQ(batch.key, keys[batch.leader_id]);
+        if(i > 0u) {
+            EXPECT_LT(batcher.getBatches()[i - 1u].key, batch.key);
+        }
+        next_instance += batch.instance_count;
+    }
+    EXPECT_EQ(next_instance, batcher.getInstances().size());
+}
+
+// Draws of one batch keep their add() order, the instance array and draw order line up with the batches.
+TEST(DrawBatcher, InstancesFollowTheDrawOrder) {
+    DrawBatcher batcher;
+    const DrawBatcher::Key a = makeKey(0, 0, 0, 1);
+    const DrawBatcher::Key b = makeKey(0, 1, 0, 1);
+    const std::vector<DrawBatcher::Key> added = { b, a, b, a, a, b };
+    for(uint32_t i = 0u; i < added.size(); ++i) {
+        batcher.add(added[i], i, makeModel(float(i + 1u)), 3u, 40u + i);
+    }
+    batcher.build();
+
+    const std::vector<uint32_t> expected_order = a < b ? std::vector<uint32_t>{ 1u, 3u, 4u, 0u, 2u, 5u } : std::vector<uint32_t>{ 0u, 2u, 5u, 1u, 3u, 4u };
+    EXPECT_EQ(batcher.getDrawOrder(), expected_order);
+
+    ASSERT_EQ(batcher.getInstances().size(), added.size());
+    for(size_t i = 0u; i < expected_order.size(); ++i) {
+        const uint32_t draw_id = expected_order[i];
+        const DrawBatcher::InstanceData& instance = batcher.getInstances()[i];
+        const glm::mat4 model = makeModel(float(draw_id + 1u));
+        EXPECT_EQ(instance.model, model);
+        expectNear(instance.inv_model, glm::inverse(model));
+        EXPECT_EQ(instance.material, glm::uvec4(40u + draw_id, 0u, 0u, 0u));
+    }
+
+    ASSERT_EQ(batcher.getBatches().size(), 2u);
+    EXPECT_EQ(batcher.getBatches()[0].leader_id, expected_order[0]);
+    EXPECT_EQ(batcher.getBatches()[1].leader_id, expected_order[3]);
+    EXPECT_EQ(batcher.getCommands()[1].firstInstance, 3u);
+}
+
+TEST(DrawBatcher, InverseHandlesScaledAndRotatedModels) {
+    DrawBatcher batcher;
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, -2.0f, 3.0f));
+    model = glm::rotate(model, 0.7f, glm::vec3(0.3f, 1.0f, 0.2f));
+    model = glm::scale(model, glm::vec3(2.0f, 0.5f, 3.0f));
+    batcher.add(makeKey(0, 0, 0, 1), 0u, model, 3u);
+    batcher.build();
+
+    ASSERT_EQ(batcher.getInstances().size(), 1u);
+    expectNear(batcher.getInstances()[0].inv_model, glm::inverse(model));
+}
+
+TEST(DrawBatcher, BuildStartsOverAndClearForgetsDraws) {
+    DrawBatcher batcher;
+    batcher.add(makeKey(0, 0, 0, 1), 0u, makeModel(1.0f), 3u);
+    batcher.add(makeKey(1, 0, 0, 1), 1u, makeModel(2.0f), 3u);
+    batcher.build();
+    batcher.build();
+    EXPECT_EQ(batcher.getBatches().size(), 2u);
+    EXPECT_EQ(batcher.getInstances().size(), 2u);
+    EXPECT_EQ(batcher.getCommands().size(), 2u);
+
+    batcher.clear();
+    batcher.build();
+    EXPECT_TRUE(batcher.getBatches().empty());
+    EXPECT_TRUE(batcher.getInstances().empty());
+    EXPECT_TRUE(batcher.getCommands().empty());
+    EXPECT_TRUE(batcher.getDrawOrder().empty());
+}
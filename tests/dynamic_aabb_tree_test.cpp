@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include "../src/physics/dynamic_aabb_tree.h"
+#include "../src/physics/frustum_culler.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+    std::vector<BoundingBox> randomBoxes(size_t count, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+        std::uniform_real_distribution<float> size(0.1f, 4.0f);
+        std::vector<BoundingBox> boxes;
+        boxes.reserve(count);
+        for (size_t i = 0u; i < count; ++i) {
+            boxes.emplace_back(glm::vec3(position(rng), position(rng), position(rng)), glm::vec3(size(rng), size(rng), size(rng)));
+        }
+        return boxes;
+    }
+
+    bool overlaps(const BoundingBox& a, const BoundingBox& b) {
+        return glm::all(glm::lessThanEqual(glm::abs(a.Center - b.Center), a.Extents + b.Extents));
+    }
+
+    std::vector<uint32_t> sorted(std::vector<uint32_t> values) {
+        std::sort(values.begin(), values.end());
+        return values;
+    }
+
+    // The frustum built from the projection looks down +z, the eye only moves it.
+    BoundingFrustum worldFrustum(const glm::vec3& eye) {
+        const BoundingFrustum view_frustum(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 150.0f));
+        BoundingFrustum world_frustum;
+        view_frustum.Transform(world_frustum, glm::translate(glm::mat4(1.0f), eye));
+        return world_frustum;
+    }
+}
+
+TEST(DynamicAABBTree, QueryOverlapMatchesBruteForce) {
+    const std::vector<BoundingBox> boxes = randomBoxes(2000u, 1u);
+    DynamicAABBTree tree;
+    for (uint32_t i = 0u; i < boxes.size(); ++i) {
+        tree.createProxy(boxes[i], i);
+    }
+    EXPECT_EQ(tree.getProxyCount(), boxes.size());
+
+    std::vector<uint32_t> hits(boxes.size());
+    for (const BoundingBox& query : randomBoxes(50u, 2u)) {
+        const BoundingBox wide(query.Center, query.Extents * 5.0f);
+        hits.resize(tree.queryOverlap(wide, hits.data(), boxes.size()));
+
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0u; i < boxes.size(); ++i) {
+            if (overlaps(boxes[i], wide)) expected.push_back(i);
+        }
+        EXPECT_EQ(sorted(hits), expected);
+        hits.resize(boxes.size());
+    }
+}
+
+TEST(DynamicAABBTree, QueryFrustumMatchesFrustumCuller) {
+    const std::vector<BoundingBox> boxes = randomBoxes(2000u, 3u);
+    DynamicAABBTree tree;
+    FrustumCuller culler;
+    for (uint32_t i = 0u; i < boxes.size(); ++i) {
+        tree.createProxy(boxes[i], i);
+        culler.add(boxes[i]);
+    }
+
+    const glm::vec3 eyes[] = { glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-60.0f, 10.0f, -30.0f), glm::vec3(50.0f, 40.0f, -90.0f) };
+    std::vector<uint32_t> hits(boxes.size());
+    std::vector<uint32_t> expected;
+    for (const glm::vec3& eye : eyes) {
+        const BoundingFrustum frustum = worldFrustum(eye);
+        hits.resize(tree.queryFrustum(frustum, hits.data(), boxes.size()));
+
+        culler.setFrustum(frustum);
+        culler.cull(expected);
+        EXPECT_FALSE(expected.empty());
+        EXPECT_LT(expected.size(), boxes.size());
+        EXPECT_EQ(sorted(hits), sorted(expected));
+        hits.resize(boxes.size());
+    }
+}
+
+TEST(DynamicAABBTree, RayCastReportsEveryBoxOnTheRay) {
+    DynamicAABBTree tree;
+    for (uint32_t i = 0u; i < 10u; ++i) {
+        tree.createProxy(BoundingBox(glm::vec3(10.0f * static_cast<float>(i + 1u), 0.0f, 0.0f), glm::vec3(1.0f)), i);
+        tree.createProxy(BoundingBox(glm::vec3(10.0f * static_cast<float>(i + 1u), 10.0f, 0.0f), glm::vec3(1.0f)), 100u + i);
+    }
+
+    std::vector<DynamicAABBTree::RayHit> hits(32u);
+    hits.resize(tree.rayCast(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 55.0f, hits.data(), hits.size()));
+    std::vector<uint32_t> ids;
+    for (const DynamicAABBTree::RayHit& hit : hits) {
+        ids.push_back(hit.user_data);
+        EXPECT_FLOAT_EQ(hit.distance, 10.0f * static_cast<float>(hit.user_data + 1u) - 1.0f);
+    }
+    EXPECT_EQ(sorted(ids), (std::vector<uint32_t>{ 0u, 1u, 2u, 3u, 4u }));
+
+    DynamicAABBTree::RayHit closest{};
+    ASSERT_TRUE(tree.rayCastClosest(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 1000.0f, closest));
+    EXPECT_EQ(closest.user_data, 0u);
+    EXPECT_FLOAT_EQ(closest.distance, 9.0f);
+    EXPECT_FALSE(tree.rayCastClosest(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 1000.0f, closest));
+}
+
+TEST(DynamicAABBTree, MoveInsideTheFatBoxKeepsTheLeaf) {
+    DynamicAABBTree tree(0.5f);
+    const DynamicAABBTree::ProxyId proxy = tree.createProxy(BoundingBox(glm::vec3(0.0f), glm::vec3(1.0f)), 7u);
+    tree.createProxy(BoundingBox(glm::vec3(20.0f), glm::vec3(1.0f)), 8u);
+
+    EXPECT_FALSE(tree.moveProxy(proxy, BoundingBox(glm::vec3(0.4f, 0.0f, -0.4f), glm::vec3(1.0f))));
+    EXPECT_TRUE(tree.moveProxy(proxy, BoundingBox(glm::vec3(5.0f, 0.0f, 0.0f), glm::vec3(1.0f))));
+    EXPECT_EQ(tree.getUserData(proxy), 7u);
+
+    const BoundingBox fat = tree.getFatBox(proxy);
+    EXPECT_FLOAT_EQ(fat.Center.x, 5.0f);
+    EXPECT_FLOAT_EQ(fat.Extents.x, 1.5f);
+
+    // The query tests the tight box, a box touching only the fat margin is not reported.
+    uint32_t hit = 0u;
+    EXPECT_EQ(tree.queryOverlap(BoundingBox(glm::vec3(3.75f, 0.0f, 0.0f), glm::vec3(0.2f)), &hit, 1u), 0u);
+    ASSERT_EQ(tree.queryOverlap(BoundingBox(glm::vec3(4.0f, 0.0f, 0.0f), glm::vec3(0.5f)), &hit, 1u), 1u);
+    EXPECT_EQ(hit, 7u);
+}
+
+TEST(DynamicAABBTree, DestroyAndClearRemoveProxies) {
+    const std::vector<BoundingBox> boxes = randomBoxes(500u, 4u);
+    DynamicAABBTree tree;
+    std::vector<DynamicAABBTree::ProxyId> proxies;
+    for (uint32_t i = 0u; i < boxes.size(); ++i) {
+        proxies.push_back(tree.createProxy(boxes[i], i));
+    }
+    for (uint32_t i = 0u; i < boxes.size(); i += 2u) {
+        tree.destroyProxy(proxies[i]);
+    }
+    EXPECT_EQ(tree.getProxyCount(), boxes.size() / 2u);
+    EXPECT_THROW(tree.destroyProxy(-1), std::runtime_error);
+
+    std::vector<uint32_t> hits(boxes.size());
+    hits.resize(tree.queryOverlap(BoundingBox(glm::vec3(0.0f), glm::vec3(200.0f)), hits.data(), hits.size()));
+    ASSERT_EQ(hits.size(), boxes.size() / 2u);
+    for (uint32_t id : hits) {
+        EXPECT_EQ(id % 2u, 1u);
+    }
+
+    tree.clear();
+    EXPECT_EQ(tree.getProxyCount(), 0u);
+    EXPECT_EQ(tree.getHeight(), 0);
+    EXPECT_EQ(tree.queryOverlap(BoundingBox(glm::vec3(0.0f), glm::vec3(200.0f)), hits.data(), hits.size()), 0u);
+}
+
+TEST(DynamicAABBTree, QueriesStopAtCapacity) {
+    DynamicAABBTree tree;
+    for (uint32_t i = 0u; i < 100u; ++i) {
+        tree.createProxy(BoundingBox(glm::vec3(static_cast<float>(i), 0.0f, 0.0f), glm::vec3(0.25f)), i);
+    }
+    std::vector<uint32_t> hits(10u);
+    EXPECT_EQ(tree.queryOverlap(BoundingBox(glm::vec3(50.0f, 0.0f, 0.0f), glm::vec3(100.0f)), hits.data(), hits.size()), 10u);
+    EXPECT_EQ(tree.queryFrustum(worldFrustum(glm::vec3(50.0f, 0.0f, -60.0f)), hits.data(), hits.size()), 10u);
+    EXPECT_EQ(tree.queryOverlap(BoundingBox(glm::vec3(50.0f, 0.0f, 0.0f), glm::vec3(100.0f)), hits.data(), 0u), 0u);
+}
+
+// Sorted inserts degenerate an unbalanced tree into a list, the rotations keep it logarithmic.
+TEST(DynamicAABBTree, SortedInsertsStayBalanced) {
+    constexpr uint32_t COUNT = 10000u;
+    DynamicAABBTree tree;
+    for (uint32_t i = 0u; i < COUNT; ++i) {
+        tree.createProxy(BoundingBox(glm::vec3(static_cast<float>(i), 0.0f, 0.0f), glm::vec3(0.4f)), i);
+    }
+    EXPECT_EQ(tree.getProxyCount(), COUNT);
+    EXPECT_LE(tree.getHeight(), 4 * static_cast<int>(std::ceil(std::log2(static_cast<float>(COUNT)))));
+    EXPECT_GT(tree.getAreaRatio(), 0.0f);
+}
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include "../src/scene/gltf_geometry.h"
+#include "../src/tools/thread_pool.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    // Float position and normal, then texture coordinates converted from normalized 16 bit integers.
+    constexpr size_t VERTEX_SIZE = 32u;
+
+    GltfVertexLayout getLayout() {
+        GltfVertexLayout layout;
+        layout.vertex_size = VERTEX_SIZE;
+        layout.attributes = {
+            { "POSITION", 0u, VertexComponentType::FLOAT32, 3u },
+            { "NORMAL", 12u, VertexComponentType::FLOAT32, 3u },
+            { "TEXCOORD_0", 24u, VertexComponentType::FLOAT32, 2u },
+        };
+        return layout;
+    }
+
+    // Every view and accessor goes to the one buffer of the model.
+    int addAccessor(tinygltf::Model& model, const void* data, size_t size, size_t stride, size_t byte_offset, size_t count, int component_type, int type, bool normalized = false) {
+        tinygltf::Buffer& buffer = model.buffers.front();
+        tinygltf::BufferView view;
+        view.buffer = 0;
+        view.byteOffset = buffer.data.size();
+        view.byteLength = size;
+        view.byteStride = stride;
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        buffer.data.insert(buffer.data.end(), bytes, bytes + size);
+        model.bufferViews.push_back(view);
+
+        tinygltf::Accessor accessor;
+        accessor.bufferView = static_cast<int>(model.bufferViews.size() - 1u);
+        accessor.byteOffset = byte_offset;
+        accessor.count = count;
+        accessor.componentType = component_type;
+        accessor.type = type;
+        accessor.normalized = normalized;
+        model.accessors.push_back(accessor);
+        return static_cast<int>(model.accessors.size() - 1u);
+    }
+
+    // A side x side grid of quads, position and normal interleaved in one view, triangles in shuffled order.
+    tinygltf::Primitive addGrid(tinygltf::Model& model, uint32_t side, std::mt19937& rng, bool indexed) {
+        std::vector<float> position_normal;
+        std::vector<uint16_t> texcoords;
+        for (uint32_t y = 0u; y <= side; ++y) {
+            for (uint32_t x = 0u; x <= side; ++x) {
+                position_normal.insert(position_normal.end(), { static_cast<float>(x), static_cast<float>(y), 0.5f * static_cast<float>((x * y) % 3u), 0.0f, 0.0f, 1.0f });
+                texcoords.insert(texcoords.end(), { static_cast<uint16_t>(x * 65535u / side), static_cast<uint16_t>(y * 65535u / side) });
+            }
+        }
+        std::vector<std::array<uint16_t, 3>> triangles;
+        for (uint32_t y = 0u; y < side; ++y) {
+            for (uint32_t x = 0u; x < side; ++x) {
+                const uint16_t corner = static_cast<uint16_t>(y * (side + 1u) + x);
+                triangles.push_back({ corner, static_cast<uint16_t>(corner + 1u), static_cast<uint16_t>(corner + side + 1u) });
+                triangles.push_back({ static_cast<uint16_t>(corner + 1u), static_cast<uint16_t>(corner + side + 2u), static_cast<uint16_t>(corner + side + 1u) });
+            }
+        }
+        std::shuffle(triangles.begin(), triangles.end(), rng);
+
+        tinygltf::Primitive primitive;
+        primitive.mode = TINYGLTF_MODE_TRIANGLES;
+        if (!indexed) {
+            // Unrolled into a triangle soup, the primitive then has no index accessor.
+            std::vector<float> soup_position_normal;
+            std::vector<uint16_t> soup_texcoords;
+            for (const std::array<uint16_t, 3>& triangle : triangles) {
+                for (uint16_t index : triangle) {
+                    soup_position_normal.insert(soup_position_normal.end(), position_normal.begin() + index * 6u, position_normal.begin() + index * 6u + 6u);
+                    soup_texcoords.insert(soup_texcoords.end(), texcoords.begin() + index * 2u, texcoords.begin() + index * 2u + 2u);
+                }
+            }
+            position_normal.swap(soup_position_normal);
+            texcoords.swap(soup_texcoords);
+        }
+
+        const size_t vertex_count = texcoords.size() / 2u;
+        const size_t interleaved_size = position_normal.size() * sizeof(float);
+        primitive.attributes["POSITION"] = addAccessor(model, position_normal.data(), interleaved_size, 6u * sizeof(float), 0u, vertex_count, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3);
+        primitive.attributes["NORMAL"] = addAccessor(model, position_normal.data(), interleaved_size, 6u * sizeof(float), 3u * sizeof(float), vertex_count, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3);
+        primitive.attributes["TEXCOORD_0"] = addAccessor(model, texcoords.data(), texcoords.size() * sizeof(uint16_t), 0u, 0u, vertex_count, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, TINYGLTF_TYPE_VEC2, true);
+        if (indexed) {
+            primitive.indices = addAccessor(model, triangles.data(), triangles.size() * sizeof(triangles.front()), 0u, 0u, triangles.size() * 3u, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, TINYGLTF_TYPE_SCALAR);
+        }
+        return primitive;
+    }
+
+    // Meshes of grids in a spread of sizes, a soup and a point list among them.
+    tinygltf::Model makeModel() {
+        std::mt19937 rng(1234u);
+        tinygltf::Model model;
+        model.buffers.emplace_back();
+        for (uint32_t mesh_idx = 0u; mesh_idx < 4u; ++mesh_idx) {
+            tinygltf::Mesh mesh;
+            for (uint32_t primitive_idx = 0u; primitive_idx < 5u; ++primitive_idx) {
+                mesh.primitives.push_back(addGrid(model, 2u + 3u * (mesh_idx * 5u + primitive_idx), rng, primitive_idx != 3u));
+            }
+            mesh.primitives.back().mode = TINYGLTF_MODE_POINTS;
+            model.meshes.push_back(mesh);
+        }
+        return model;
+    }
+
+    std::vector<GltfPrimitiveGeometry> makeGeometries(const tinygltf::Model& model, bool optimize) {
+        std::vector<GltfPrimitiveGeometry> geometries;
+        for (size_t mesh_idx = 0u; mesh_idx < model.meshes.size(); ++mesh_idx) {
+            for (size_t primitive_idx = 0u; primitive_idx < model.meshes[mesh_idx].primitives.size(); ++primitive_idx) {
+                GltfPrimitiveGeometry geometry;
+                geometry.mesh_idx = static_cast<int>(mesh_idx);
+                geometry.primitive_idx = static_cast<int>(primitive_idx);
+                geometry.layout = getLayout();
+                geometry.optimize = optimize;
+                geometries.push_back(geometry);
+            }
+        }
+        return geometries;
+    }
+}
+
+TEST(GltfGeometry, SerialAndParallelConversionAreByteIdentical) {
+    const tinygltf::Model model = makeModel();
+    ThreadPool pool(4u);
+    for (bool optimize : { false, true }) {
+        std::vector<GltfPrimitiveGeometry> serial = makeGeometries(model, optimize);
+        std::vector<GltfPrimitiveGeometry> parallel = makeGeometries(model, optimize);
+        convertGltfPrimitives(model, serial, nullptr);
+        convertGltfPrimitives(model, parallel, &pool);
+
+        ASSERT_EQ(serial.size(), parallel.size());
+        for (size_t i = 0u; i < serial.size(); ++i) {
+            SCOPED_TRACE("optimize " + std::to_string(optimize) + ", geometry " + std::to_string(i));
+            ASSERT_FALSE(serial[i].vertices.empty());
+            EXPECT_EQ(serial[i].vertices, parallel[i].vertices);
+            EXPECT_EQ(serial[i].indices, parallel[i].indices);
+            EXPECT_EQ(serial[i].optimized, parallel[i].optimized);
+            EXPECT_EQ(serial[i].cache_after.transformed, parallel[i].cache_after.transformed);
+            EXPECT_EQ(std::memcmp(&serial[i].aabb, &parallel[i].aabb, sizeof(BoundingBox)), 0);
+        }
+    }
+}
+
+TEST(GltfGeometry, OnlyTriangleListsAreOptimized) {
+    const tinygltf::Model model = makeModel();
+    std::vector<GltfPrimitiveGeometry> geometries = makeGeometries(model, true);
+    convertGltfPrimitives(model, geometries, nullptr);
+    for (const GltfPrimitiveGeometry& geometry : geometries) {
+        const tinygltf::Primitive& primitive = model.meshes[geometry.mesh_idx].primitives[geometry.primitive_idx];
+        EXPECT_EQ(geometry.optimized, primitive.mode == TINYGLTF_MODE_TRIANGLES);
+        if (geometry.optimized) {
+            EXPECT_LE(geometry.cache_after.transformed, geometry.cache_before.transformed);
+        }
+    }
+}
+
+TEST(GltfGeometry, ConvertsInterleavedAndNormalizedAttributes) {
+    const tinygltf::Model model = makeModel();
+    std::vector<GltfPrimitiveGeometry> geometries = makeGeometries(model, false);
+    convertGltfPrimitives(model, geometries, nullptr);
+
+    // The last grid corner of the first primitive, a 2 x 2 grid.
+    const GltfPrimitiveGeometry& grid = geometries.front();
+    ASSERT_EQ(grid.vertices.size(), 9u * VERTEX_SIZE);
+    float vertex[8];
+    std::memcpy(vertex, grid.vertices.data() + 8u * VERTEX_SIZE, sizeof(vertex));
+    EXPECT_EQ(vertex[0], 2.0f);
+    EXPECT_EQ(vertex[1], 2.0f);
+    EXPECT_EQ(vertex[2], 0.5f);
+    EXPECT_EQ(vertex[5], 1.0f);
+    EXPECT_EQ(vertex[6], 1.0f);
+    EXPECT_EQ(vertex[7], 1.0f);
+    EXPECT_EQ(grid.aabb.Center.x, 1.0f);
+    EXPECT_EQ(grid.aabb.Extents.x, 1.0f);
+
+    // Without an index accessor the vertices are drawn in order.
+    const GltfPrimitiveGeometry& soup = geometries[3];
+    ASSERT_EQ(soup.indices.size(), soup.vertices.size() / VERTEX_SIZE);
+    for (size_t i = 0u; i < soup.indices.size(); ++i) {
+        ASSERT_EQ(soup.indices[i], i);
+    }
+}
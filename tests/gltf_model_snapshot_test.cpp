@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+
+#include "../src/scene/gltf_model_snapshot.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+    // A field of every kind the snapshot stores, most of them away from their defaults.
+    tinygltf::Model makeModel() {
+        tinygltf::Model model;
+
+        tinygltf::Buffer& buffer = model.buffers.emplace_back();
+        buffer.name = "geometry";
+        buffer.uri = "scene.bin";
+        for (int i = 0; i < 256; ++i) {
+            buffer.data.push_back(static_cast<unsigned char>(i));
+        }
+
+        tinygltf::BufferView& view = model.bufferViews.emplace_back();
+        view.buffer = 0;
+        view.byteOffset = 16u;
+        view.byteLength = 192u;
+        view.byteStride = 12u;
+        view.target = 34962;
+
+        tinygltf::Accessor& accessor = model.accessors.emplace_back();
+        accessor.name = "positions";
+        accessor.bufferView = 0;
+        accessor.byteOffset = 4u;
+        accessor.normalized = true;
+        accessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+        accessor.count = 16u;
+        accessor.type = TINYGLTF_TYPE_VEC3;
+        accessor.minValues = { -1.0, -2.0, -3.0 };
+        accessor.maxValues = { 1.0, 2.0, 3.0 };
+
+        tinygltf::Mesh& mesh = model.meshes.emplace_back();
+        mesh.name = "body";
+        tinygltf::Primitive& primitive = mesh.primitives.emplace_back();
+        primitive.attributes = { { "POSITION", 0 }, { "NORMAL", 0 } };
+        primitive.material = 0;
+        primitive.indices = 0;
+        primitive.mode = TINYGLTF_MODE_TRIANGLES;
+
+        tinygltf::Node& root = model.nodes.emplace_back();
+        root.name = "root";
+        root.children = { 1 };
+        root.matrix = std::vector<double>(16u, 0.5);
+        tinygltf::Node& child = model.nodes.emplace_back();
+        child.name = "child";
+        child.mesh = 0;
+        child.skin = 0;
+        child.rotation = { 0.0, 0.0, 0.0, 1.0 };
+        child.scale = { 2.0, 2.0, 2.0 };
+        child.translation = { 1.0, 0.0, -1.0 };
+        child.extensions_json_string = R"({"KHR_lights_punctual":{"light":0}})";
+
+        tinygltf::Skin& skin = model.skins.emplace_back();
+        skin.name = "armature";
+        skin.inverseBindMatrices = 0;
+        skin.skeleton = 0;
+        skin.joints = { 0, 1 };
+
+        tinygltf::Scene& scene = model.scenes.emplace_back();
+        scene.name = "scene";
+        scene.nodes = { 0 };
+        model.defaultScene = 0;
+
+        tinygltf::Animation& animation = model.animations.emplace_back();
+        animation.name = "walk";
+        animation.channels.push_back({});
+        animation.channels.back().sampler = 0;
+        animation.channels.back().target_node = 1;
+        animation.channels.back().target_path = "rotation";
+        animation.samplers.push_back({});
+        animation.samplers.back().input = 0;
+        animation.samplers.back().output = 0;
+        animation.samplers.back().interpolation = "STEP";
+
+        tinygltf::Material& material = model.materials.emplace_back();
+        material.name = "skin";
+        material.pbrMetallicRoughness.baseColorFactor = { 0.5, 0.25, 0.125, 1.0 };
+        material.pbrMetallicRoughness.baseColorTexture.index = 0;
+        material.pbrMetallicRoughness.metallicFactor = 0.25;
+        material.pbrMetallicRoughness.roughnessFactor = 0.75;
+        material.normalTexture.index = 0;
+        material.normalTexture.scale = 0.5;
+        material.emissiveFactor = { 0.1, 0.2, 0.3 };
+        material.alphaMode = "MASK";
+        material.doubleSided = true;
+        material.extensions_json_string = R"({"KHR_materials_specular":{}})";
+
+        tinygltf::Texture& texture = model.textures.emplace_back();
+        texture.source = 0;
+        texture.sampler = 0;
+
+        tinygltf::Image& image = model.images.emplace_back();
+        image.uri = "skin.png";
+        image.mimeType = "image/png";
+        image.image = { 0x89, 'P', 'N', 'G' };
+
+        tinygltf::Sampler& sampler = model.samplers.emplace_back();
+        sampler.minFilter = 9987;
+        sampler.magFilter = 9729;
+        sampler.wrapS = 33071;
+
+        model.extensions["KHR_lights_punctual"] = tinygltf::Value();
+        model.extensions_json_string = R"({"KHR_lights_punctual":{"lights":[{"type":"point"}]}})";
+        return model;
+    }
+
+    bool readSnapshot(const std::vector<char>& snapshot, tinygltf::Model& model) {
+        return readGltfModelSnapshot(reinterpret_cast<const unsigned char*>(snapshot.data()), snapshot.size(), model);
+    }
+}
+
+TEST(GltfModelSnapshot, RoundTripKeepsWhatTheLoaderReads) {
+    const tinygltf::Model source = makeModel();
+    tinygltf::Model model;
+    ASSERT_TRUE(readSnapshot(writeGltfModelSnapshot(source), model));
+
+    ASSERT_EQ(model.buffers.size(), 1u);
+    EXPECT_EQ(model.buffers[0].uri, "scene.bin");
+    EXPECT_EQ(model.buffers[0].data, source.buffers[0].data);
+    ASSERT_EQ(model.bufferViews.size(), 1u);
+    EXPECT_EQ(model.bufferViews[0].byteOffset, 16u);
+    EXPECT_EQ(model.bufferViews[0].byteLength, 192u);
+    EXPECT_EQ(model.bufferViews[0].byteStride, 12u);
+    ASSERT_EQ(model.accessors.size(), 1u);
+    EXPECT_EQ(model.accessors[0].byteOffset, 4u);
+    EXPECT_TRUE(model.accessors[0].normalized);
+    EXPECT_EQ(model.accessors[0].count, 16u);
+    EXPECT_EQ(model.accessors[0].type, TINYGLTF_TYPE_VEC3);
+    EXPECT_EQ(model.accessors[0].maxValues, source.accessors[0].maxValues);
+
+    ASSERT_EQ(model.meshes.size(), 1u);
+    ASSERT_EQ(model.meshes[0].primitives.size(), 1u);
+    EXPECT_EQ(model.meshes[0].primitives[0].attributes, source.meshes[0].primitives[0].attributes);
+    EXPECT_EQ(model.meshes[0].primitives[0].mode, TINYGLTF_MODE_TRIANGLES);
+
+    ASSERT_EQ(model.nodes.size(), 2u);
+    EXPECT_EQ(model.nodes[0].children, std::vector<int>{ 1 });
+    EXPECT_EQ(model.nodes[0].matrix, source.nodes[0].matrix);
+    EXPECT_EQ(model.nodes[1].mesh, 0);
+    EXPECT_EQ(model.nodes[1].skin, 0);
+    EXPECT_EQ(model.nodes[1].translation, source.nodes[1].translation);
+    EXPECT_EQ(model.nodes[1].extensions_json_string, source.nodes[1].extensions_json_string);
+    ASSERT_EQ(model.skins.size(), 1u);
+    EXPECT_EQ(model.skins[0].joints, source.skins[0].joints);
+    ASSERT_EQ(model.scenes.size(), 1u);
+    EXPECT_EQ(model.scenes[0].nodes, std::vector<int>{ 0 });
+
+    ASSERT_EQ(model.animations.size(), 1u);
+    EXPECT_EQ(model.animations[0].name, "walk");
+    EXPECT_EQ(model.animations[0].channels[0].target_node, 1);
+    EXPECT_EQ(model.animations[0].channels[0].target_path, "rotation");
+    EXPECT_EQ(model.animations[0].samplers[0].interpolation, "STEP");
+
+    ASSERT_EQ(model.materials.size(), 1u);
+    const tinygltf::Material& material = model.materials[0];
+    EXPECT_EQ(material.pbrMetallicRoughness.baseColorFactor, source.materials[0].pbrMetallicRoughness.baseColorFactor);
+    EXPECT_EQ(material.pbrMetallicRoughness.baseColorTexture.index, 0);
+    EXPECT_EQ(material.pbrMetallicRoughness.metallicRoughnessTexture.index, -1);
+    EXPECT_EQ(material.pbrMetallicRoughness.roughnessFactor, 0.75);
+    EXPECT_EQ(material.normalTexture.scale, 0.5);
+    EXPECT_EQ(material.emissiveFactor, source.materials[0].emissiveFactor);
+    EXPECT_EQ(material.alphaMode, "MASK");
+    EXPECT_TRUE(material.doubleSided);
+    EXPECT_EQ(material.extensions_json_string, source.materials[0].extensions_json_string);
+
+    ASSERT_EQ(model.images.size(), 1u);
+    EXPECT_EQ(model.images[0].uri, "skin.png");
+    EXPECT_EQ(model.images[0].image, source.images[0].image);
+    EXPECT_EQ(model.images[0].width, -1);
+    ASSERT_EQ(model.samplers.size(), 1u);
+    EXPECT_EQ(model.samplers[0].minFilter, 9987);
+    EXPECT_EQ(model.samplers[0].wrapS, 33071);
+    EXPECT_EQ(model.textures[0].sampler, 0);
+
+    EXPECT_TRUE(model.extensions.contains("KHR_lights_punctual"));
+    EXPECT_EQ(model.extensions_json_string, source.extensions_json_string);
+}
+
+TEST(GltfModelSnapshot, TruncatedOrDamagedSnapshotsFail) {
+    const std::vector<char> snapshot = writeGltfModelSnapshot(makeModel());
+    tinygltf::Model model;
+    for (size_t size : { size_t{ 0u }, size_t{ 7u }, snapshot.size() / 2u, snapshot.size() - 1u }) {
+        const std::vector<char> truncated(snapshot.begin(), snapshot.begin() + static_cast<std::ptrdiff_t>(size));
+        EXPECT_FALSE(readSnapshot(truncated, model)) << size;
+    }
+
+    std::vector<char> longer = snapshot;
+    longer.push_back(0);
+    EXPECT_FALSE(readSnapshot(longer, model));
+
+    // The buffer count right after the header, far beyond what follows.
+    std::vector<char> damaged = snapshot;
+    const uint64_t buffer_count = UINT64_MAX / 2u;
+    std::memcpy(damaged.data() + 8u, &buffer_count, sizeof(buffer_count));
+    EXPECT_FALSE(readSnapshot(damaged, model));
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include "../src/tools/ktx2_file.h"
+#include "../src/tools/texture_tools.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    // Files go to a directory of their own, removed with the fixture.
+    class Ktx2FileTest : public testing::Test {
+    protected:
+        void SetUp() override {
+            m_dir = std::filesystem::temp_directory_path() / ("masic_ktx2_file_test_" + std::string(testing::UnitTest::GetInstance()->current_test_info()->name()));
+            std::filesystem::remove_all(m_dir);
+            std::filesystem::create_directories(m_dir);
+        }
+
+        void TearDown() override {
+            std::filesystem::remove_all(m_dir);
+        }
+
+        std::vector<unsigned char> readFile(const std::filesystem::path& path) const {
+            std::ifstream file(path, std::ios::binary);
+            return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), {});
+        }
+
+        std::filesystem::path m_dir;
+    };
+
+    std::vector<unsigned char> makeImage(VkExtent2D extent) {
+        std::vector<unsigned char> rgba(static_cast<size_t>(extent.width) * extent.height * 4u);
+        for (size_t i = 0u; i < rgba.size(); ++i) {
+            rgba[i] = static_cast<unsigned char>(i * 7u);
+        }
+        return rgba;
+    }
+
+    // The levels of the chain compressed one by one, the way texture_cooker does it.
+    Ktx2File makeCompressed(VkFormat format, VkExtent2D extent) {
+        const std::vector<unsigned char> rgba = makeImage(extent);
+        const MipChain chain = buildMipChain(rgba.data(), extent);
+
+        std::vector<unsigned char> levels;
+        std::vector<VkDeviceSize> offsets{ 0u };
+        for (uint32_t level = 0u; level + 1u < chain.offsets.size(); ++level) {
+            const std::vector<unsigned char> compressed = compressLevel(format, chain.data.data() + chain.offsets[level], getMipExtent(extent, level));
+            levels.insert(levels.end(), compressed.begin(), compressed.end());
+            offsets.push_back(levels.size());
+        }
+
+        Ktx2File ktx;
+        ktx.setImage(format, extent, std::move(levels), std::move(offsets));
+        return ktx;
+    }
+}
+
+TEST_F(Ktx2FileTest, Rgba8RoundTrip) {
+    const VkExtent2D extent{ 8u, 4u };
+    const std::vector<unsigned char> rgba = makeImage(extent);
+    MipChain chain = buildMipChain(rgba.data(), extent);
+    Ktx2File source;
+    source.setImage(VK_FORMAT_R8G8B8A8_SRGB, extent, chain.data, chain.offsets);
+
+    const std::filesystem::path path = m_dir / "rgba.ktx2";
+    ASSERT_TRUE(source.save(path.string()));
+    EXPECT_EQ(Ktx2File::readFormat(path.string()), VK_FORMAT_R8G8B8A8_SRGB);
+
+    Ktx2File loaded;
+    ASSERT_TRUE(loaded.load(path.string()));
+    EXPECT_EQ(loaded.getFormat(), VK_FORMAT_R8G8B8A8_SRGB);
+    EXPECT_EQ(loaded.getExtent().width, 8u);
+    EXPECT_EQ(loaded.getExtent().height, 4u);
+    EXPECT_EQ(loaded.getLevelCount(), 4u);
+    EXPECT_EQ(loaded.getLevelOffsets(), chain.offsets);
+    EXPECT_EQ(loaded.getLevels(), chain.data);
+}
+
+TEST_F(Ktx2FileTest, CompressedRoundTrip) {
+    for (VkFormat format : { VK_FORMAT_BC1_RGBA_UNORM_BLOCK, VK_FORMAT_BC3_SRGB_BLOCK, VK_FORMAT_BC5_UNORM_BLOCK, VK_FORMAT_BC7_UNORM_BLOCK }) {
+        // Levels below the block size still take a whole block.
+        Ktx2File source = makeCompressed(format, { 12u, 6u });
+        const std::filesystem::path path = m_dir / ("compressed" + std::to_string(static_cast<int>(format)) + ".ktx2");
+        ASSERT_TRUE(source.save(path.string())) << format;
+
+        Ktx2File loaded;
+        ASSERT_TRUE(loaded.load(path.string())) << format;
+        EXPECT_EQ(loaded.getFormat(), format);
+        EXPECT_EQ(loaded.getLevelCount(), 4u) << format;
+        EXPECT_EQ(loaded.getLevelOffsets(), source.getLevelOffsets()) << format;
+        EXPECT_EQ(loaded.getLevels(), source.getLevels()) << format;
+    }
+}
+
+TEST_F(Ktx2FileTest, LoadsFromMemory) {
+    Ktx2File source = makeCompressed(VK_FORMAT_BC7_SRGB_BLOCK, { 4u, 4u });
+    const std::filesystem::path path = m_dir / "memory.ktx2";
+    ASSERT_TRUE(source.save(path.string()));
+
+    const std::vector<unsigned char> data = readFile(path);
+    ASSERT_TRUE(Ktx2File::isKtx2(data.data(), data.size()));
+    Ktx2File loaded;
+    ASSERT_TRUE(loaded.load(data.data(), data.size()));
+    EXPECT_EQ(loaded.getLevels(), source.getLevels());
+}
+
+TEST_F(Ktx2FileTest, DamagedFilesAreRejected) {
+    Ktx2File source = makeCompressed(VK_FORMAT_BC1_RGB_UNORM_BLOCK, { 16u, 16u });
+    const std::filesystem::path path = m_dir / "damaged.ktx2";
+    ASSERT_TRUE(source.save(path.string()));
+    const std::vector<unsigned char> data = readFile(path);
+
+    Ktx2File loaded;
+    // Cut in the identifier, the header, the level index and the last level written, level 0.
+    for (size_t size : { size_t{ 4u }, size_t{ 60u }, size_t{ 100u }, data.size() - 1u }) {
+        EXPECT_FALSE(loaded.load(data.data(), size)) << size;
+    }
+
+    // A level count past the full chain.
+    std::vector<unsigned char> damaged = data;
+    damaged[40u] = 32u;
+    EXPECT_FALSE(loaded.load(damaged.data(), damaged.size()));
+
+    const std::vector<unsigned char> png = { 0x89u, 'P', 'N', 'G', 0x0Du, 0x0Au, 0x1Au, 0x0Au, 0u, 0u, 0u, 0u };
+    EXPECT_FALSE(Ktx2File::isKtx2(png.data(), png.size()));
+    EXPECT_EQ(Ktx2File::readFormat((m_dir / "missing.ktx2").string()), VK_FORMAT_UNDEFINED);
+}
+
+TEST_F(Ktx2FileTest, FormatsWithoutADescriptorThrow) {
+    Ktx2File ktx;
+    ktx.setImage(VK_FORMAT_ASTC_4x4_UNORM_BLOCK, { 4u, 4u }, std::vector<unsigned char>(16u), { 0u, 16u });
+    EXPECT_THROW(ktx.save((m_dir / "astc.ktx2").string()), std::runtime_error);
+}
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include "../src/scene/mesh_cache.h"
+#include "../src/scene/gltf_geometry.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+    void writeFile(const std::filesystem::path& path, const std::string& content) {
+        std::ofstream file(path, std::ios::out | std::ios::trunc | std::ios::binary);
+        file << content;
+    }
+
+    // A model with an external buffer and image in a directory of its own, removed with the fixture.
+    class MeshCacheTest : public testing::Test {
+    protected:
+        void SetUp() override {
+            m_dir = std::filesystem::temp_directory_path() / ("masic_mesh_cache_test_" + std::string(testing::UnitTest::GetInstance()->current_test_info()->name()));
+            std::filesystem::remove_all(m_dir);
+            std::filesystem::create_directories(m_dir);
+            m_model_path = m_dir / "model.gltf";
+            m_cache_path = MeshCache::makeCachePath(m_model_path);
+            writeFile(m_model_path, R"({"buffers":[{"uri":"model.bin"}]})");
+            writeFile(m_dir / "model.bin", std::string(64u, 'b'));
+            writeFile(m_dir / "skin.png", std::string(16u, 'p'));
+        }
+
+        void TearDown() override {
+            std::filesystem::remove_all(m_dir);
+        }
+
+        // Saves a snapshot and one primitive, as a load that missed the cache does.
+        void writeCache(const std::vector<char>& snapshot) {
+            std::filesystem::remove(m_cache_path);
+            MeshCache cache;
+            ASSERT_FALSE(cache.open(m_cache_path, m_model_path));
+            cache.setModel(snapshot, { "model.bin", "skin.png", "data:application/octet-stream;base64,AAAA", "" });
+            cache.add(getKey(), std::vector<char>(96u, 'v'), { 0u, 1u, 2u, 2u, 1u, 3u }, BoundingBox(glm::vec3(1.0f), glm::vec3(2.0f)));
+            ASSERT_TRUE(cache.hasPendingChanges());
+            cache.save();
+            ASSERT_FALSE(cache.hasPendingChanges());
+        }
+
+        static uint64_t getKey() {
+            GltfVertexLayout layout;
+            layout.vertex_size = 12u;
+            layout.attributes.push_back({ "POSITION", 0u, VertexComponentType::FLOAT32, 3u });
+            return MeshCache::makeKey(0, 0u, layout, true);
+        }
+
+        std::filesystem::path m_dir;
+        std::filesystem::path m_model_path;
+        std::filesystem::path m_cache_path;
+    };
+}
+
+TEST_F(MeshCacheTest, HitReturnsTheModelAndThePrimitives) {
+    const std::vector<char> snapshot = { 's', 'n', 'a', 'p', '\0', 's', 'h', 'o', 't' };
+    writeCache(snapshot);
+
+    MeshCache cache;
+    ASSERT_TRUE(cache.open(m_cache_path, m_model_path));
+    const unsigned char* model = nullptr;
+    size_t model_size = 0u;
+    ASSERT_TRUE(cache.findModel(model, model_size));
+    ASSERT_EQ(model_size, snapshot.size());
+    EXPECT_EQ(std::memcmp(model, snapshot.data(), snapshot.size()), 0);
+
+    MeshCache::Primitive primitive;
+    ASSERT_TRUE(cache.find(getKey(), primitive));
+    EXPECT_EQ(primitive.vertices_size, 96u);
+    ASSERT_EQ(primitive.index_count, 6u);
+    EXPECT_EQ(primitive.indices[5], 3u);
+    EXPECT_EQ(primitive.aabb.Extents.x, 2.0f);
+    EXPECT_FALSE(cache.hasPendingChanges());
+}
+
+TEST_F(MeshCacheTest, ChangedSourcesMakeTheCacheStale) {
+    writeCache({ 'm' });
+    MeshCache cache;
+    ASSERT_TRUE(cache.open(m_cache_path, m_model_path));
+
+    // Files change size here, write times of files written in a row may not differ.
+    writeFile(m_dir / "skin.png", std::string(17u, 'p'));
+    EXPECT_FALSE(cache.open(m_cache_path, m_model_path));
+
+    writeCache({ 'm' });
+    ASSERT_TRUE(cache.open(m_cache_path, m_model_path));
+    std::filesystem::remove(m_dir / "model.bin");
+    EXPECT_FALSE(cache.open(m_cache_path, m_model_path));
+
+    writeFile(m_dir / "model.bin", std::string(64u, 'b'));
+    writeCache({ 'm' });
+    ASSERT_TRUE(cache.open(m_cache_path, m_model_path));
+    writeFile(m_model_path, R"({"buffers":[{"uri":"model.bin"}],"scene":0})");
+    EXPECT_FALSE(cache.open(m_cache_path, m_model_path));
+}
+
+TEST_F(MeshCacheTest, AddingPrimitivesKeepsTheModel) {
+    writeCache({ 'm', 'o', 'd', 'e', 'l' });
+
+    MeshCache cache;
+    ASSERT_TRUE(cache.open(m_cache_path, m_model_path));
+    cache.add(getKey() + 1u, std::vector<char>(12u, 'w'), { 0u }, BoundingBox());
+    cache.save();
+
+    ASSERT_TRUE(cache.open(m_cache_path, m_model_path));
+    const unsigned char* model = nullptr;
+    size_t model_size = 0u;
+    ASSERT_TRUE(cache.findModel(model, model_size));
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(model), model_size), "model");
+    MeshCache::Primitive primitive;
+    EXPECT_TRUE(cache.find(getKey(), primitive));
+    EXPECT_TRUE(cache.find(getKey() + 1u, primitive));
+}
+
+TEST_F(MeshCacheTest, DamagedFilesAreRejected) {
+    // Cut in the header, the uris and the indices: header 0, entries 64, uris 128, model 192, vertices 256, indices 384.
+    for (uintmax_t size : { uintmax_t{ 0u }, uintmax_t{ 40u }, uintmax_t{ 140u }, uintmax_t{ 400u } }) {
+        writeCache({ 'm' });
+        std::filesystem::resize_file(m_cache_path, size);
+        MeshCache cache;
+        EXPECT_FALSE(cache.open(m_cache_path, m_model_path)) << size;
+        const unsigned char* model = nullptr;
+        size_t model_size = 0u;
+        EXPECT_FALSE(cache.findModel(model, model_size));
+    }
+}
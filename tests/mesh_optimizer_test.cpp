@@ -0,0 +1,272 @@
+#include <gtest/gtest.h>
+
+#include "../src/scene/mesh_optimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+    // Position first, the rest of the vertex is padding the fetch pass has to carry along.
+    constexpr size_t VERTEX_SIZE = 32u;
+
+    struct Mesh {
+        std::vector<unsigned char> vertices;
+        std::vector<uint32_t> indices;
+
+        size_t getVertexCount() const { return vertices.size() / VERTEX_SIZE; }
+
+        void addVertex(float x, float y, float z) {
+            const size_t offset = vertices.size();
+            vertices.resize(offset + VERTEX_SIZE);
+            const float position[3] = { x, y, z };
+            memcpy(vertices.data() + offset, position, sizeof(position));
+            const uint32_t id = static_cast<uint32_t>(offset / VERTEX_SIZE);
+            memcpy(vertices.data() + offset + sizeof(position), &id, sizeof(id));
+        }
+    };
+
+    // width x height quads, two triangles each, in scanline order.
+    Mesh makeGrid(uint32_t width, uint32_t height) {
+        Mesh mesh;
+        for(uint32_t y = 0u; y <= height; ++y) {
+            for(uint32_t x = 0u; x <= width; ++x) {
+                mesh.addVertex(static_cast<float>(x), static_cast<float>(y), 0.0f);
+            }
+        }
+        for(uint32_t y = 0u; y < height; ++y) {
+            for(uint32_t x = 0u; x < width; ++x) {
+                const uint32_t a = y * (width + 1u) + x;
+                const uint32_t c = a + width + 1u;
+                mesh.indices.insert(mesh.indices.end(), { a, c, a + 1u, a + 1u, c, c + 1u });
+            }
+        }
+        return mesh;
+    }
+
+    // segments x segments quads wrapped around a unit sphere, poles and seam duplicated like an exported UV sphere.
+    Mesh makeSphere(uint32_t segments) {
+        Mesh mesh;
+        for(uint32_t y = 0u; y <= segments; ++y) {
+            for(uint32_t x = 0u; x <= segments; ++x) {
+                const float theta = 3.14159f * y / segments;
+                const float phi = 6.28318f * x / segments;
+                mesh.addVertex(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            }
+        }
+        for(uint32_t y = 0u; y < segments; ++y) {
+            for(uint32_t x = 0u; x < segments; ++x) {
+                const uint32_t a = y * (segments + 1u) + x;
+                const uint32_t c = a + segments + 1u;
+                mesh.indices.insert(mesh.indices.end(), { a, c, a + 1u, a + 1u, c, c + 1u });
+            }
+        }
+        return mesh;
+    }
+
+    Mesh makeFan(uint32_t triangle_count) {
+        Mesh mesh;
+        mesh.addVertex(0.0f, 0.0f, 0.0f);
+        for(uint32_t i = 0u; i <= triangle_count; ++i) {
+            const float angle = 6.28318f * i / (triangle_count + 1u);
+            mesh.addVertex(std::cos(angle), std::sin(angle), 0.0f);
+        }
+        for(uint32_t i = 1u; i <= triangle_count; ++i) {
+            mesh.indices.insert(mesh.indices.end(), { 0u, i, i + 1u });
+        }
+        return mesh;
+    }
+
+    Mesh makeSoup(uint32_t vertex_count, uint32_t triangle_count, uint32_t seed) {
+        Mesh mesh;
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+        for(uint32_t i = 0u; i < vertex_count; ++i) {
+            mesh.addVertex(coordinate(rng), coordinate(rng), coordinate(rng));
+        }
+        std::uniform_int_distribution<uint32_t> vertex(0u, vertex_count - 1u);
+        for(uint32_t i = 0u; i < triangle_count * 3u; ++i) {
+            mesh.indices.push_back(vertex(rng));
+        }
+        return mesh;
+    }
+
+    void shuffleTriangles(std::vector<uint32_t>& indices, uint32_t seed) {
+        std::vector<std::array<uint32_t, 3>> triangles(indices.size() / 3u);
+        memcpy(triangles.data(), indices.data(), indices.size() * sizeof(uint32_t));
+        std::mt19937 rng(seed);
+        std::shuffle(triangles.begin(), triangles.end(), rng);
+        memcpy(indices.data(), triangles.data(), indices.size() * sizeof(uint32_t));
+    }
+
+    // Every triangle as the bytes of its three vertices, rotated to start at the smallest one so winding is kept but
+    // the starting corner does not matter, sorted so triangle order does not matter either.
+    std::vector<std::vector<unsigned char>> getTriangleSet(const std::vector<unsigned char>& vertices, const std::vector<uint32_t>& indices) {
+        std::vector<std::vector<unsigned char>> triangles;
+        for(size_t i = 0u; i < indices.size(); i += 3u) {
+            std::array<std::vector<unsigned char>, 3> corners;
+            for(size_t k = 0u; k < 3u; ++k) {
+                const unsigned char* vertex = vertices.data() + indices[i + k] * VERTEX_SIZE;
+                corners[k].assign(vertex, vertex + VERTEX_SIZE);
+            }
+            std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+            std::vector<unsigned char> triangle;
+            for(const std::vector<unsigned char>& corner : corners) {
+                triangle.insert(triangle.end(), corner.begin(), corner.end());
+            }
+            triangles.push_back(std::move(triangle));
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    // All three passes the way MeshNodeLoader runs them, the mesh is rewritten in place.
+    void optimizeMesh(Mesh& mesh) {
+        const size_t vertex_count = mesh.getVertexCount();
+        std::vector<uint32_t> cache_order(mesh.indices.size());
+        optimizeVertexCache(cache_order.data(), mesh.indices.data(), mesh.indices.size(), vertex_count);
+        optimizeOverdraw(mesh.indices.data(), cache_order.data(), cache_order.size(), mesh.vertices.data(), VERTEX_SIZE, vertex_count, 1.05f);
+
+        std::vector<unsigned char> fetch_order(mesh.vertices.size());
+        const size_t used = optimizeVertexFetch(fetch_order.data(), mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), vertex_count, VERTEX_SIZE);
+        fetch_order.resize(used * VERTEX_SIZE);
+        mesh.vertices = std::move(fetch_order);
+    }
+
+    void expectOptimizedMeshIsEquivalent(const Mesh& source) {
+        Mesh optimized = source;
+        optimizeMesh(optimized);
+
+        ASSERT_EQ(optimized.indices.size(), source.indices.size());
+        EXPECT_EQ(getTriangleSet(optimized.vertices, optimized.indices), getTriangleSet(source.vertices, source.indices));
+
+        // Vertices come in first use order, so walking the indices only ever meets the next unseen vertex.
+        uint32_t next_new_vertex = 0u;
+        for(uint32_t index : optimized.indices) {
+            ASSERT_LE(index, next_new_vertex);
+            if(index == next_new_vertex) ++next_new_vertex;
+        }
+        EXPECT_EQ(next_new_vertex, optimized.getVertexCount());
+    }
+}
+
+TEST(MeshOptimizer, AnalyzeCountsFifoMisses) {
+    // Two triangles sharing an edge: four distinct vertices, all misses, nothing reloaded.
+    const std::vector<uint32_t> quad = { 0u, 1u, 2u, 2u, 1u, 3u };
+    VertexCacheStats stats = analyzeVertexCache(quad.data(), quad.size(), 4u);
+    EXPECT_EQ(stats.triangles, 2u);
+    EXPECT_EQ(stats.vertices, 4u);
+    EXPECT_EQ(stats.transformed, 4u);
+    EXPECT_FLOAT_EQ(stats.getAcmr(), 2.0f);
+    EXPECT_FLOAT_EQ(stats.getAtvr(), 1.0f);
+
+    // Vertex 0 is pushed out of the 16 entry FIFO before it comes back.
+    std::vector<uint32_t> strip;
+    for(uint32_t i = 0u; i < 18u; ++i) {
+        strip.insert(strip.end(), { i, i + 1u, i + 2u });
+    }
+    strip.insert(strip.end(), { 0u, 1u, 2u });
+    VertexCacheStats evicted = analyzeVertexCache(strip.data(), strip.size(), 20u);
+    EXPECT_EQ(evicted.vertices, 20u);
+    EXPECT_EQ(evicted.transformed, 23u);
+}
+
+TEST(MeshOptimizer, EmptyInputIsANoOp) {
+    VertexCacheStats stats = analyzeVertexCache(nullptr, 0u, 0u);
+    EXPECT_EQ(stats.transformed, 0u);
+    EXPECT_EQ(stats.getAcmr(), 0.0f);
+
+    optimizeVertexCache(nullptr, nullptr, 0u, 0u);
+    optimizeOverdraw(nullptr, nullptr, 0u, nullptr, VERTEX_SIZE, 0u, 1.05f);
+    EXPECT_EQ(optimizeVertexFetch(nullptr, nullptr, 0u, nullptr, 0u, VERTEX_SIZE), 0u);
+}
+
+TEST(MeshOptimizer, KeepsTheTrianglesOfAGrid) {
+    expectOptimizedMeshIsEquivalent(makeGrid(40u, 25u));
+}
+
+TEST(MeshOptimizer, KeepsTheTrianglesOfAFan) {
+    expectOptimizedMeshIsEquivalent(makeFan(200u));
+}
+
+TEST(MeshOptimizer, KeepsDegenerateTriangles) {
+    Mesh mesh = makeGrid(8u, 8u);
+    mesh.indices.insert(mesh.indices.end(), { 5u, 5u, 6u, 7u, 7u, 7u, 3u, 4u, 3u });
+    expectOptimizedMeshIsEquivalent(mesh);
+
+    Mesh single;
+    single.addVertex(0.0f, 0.0f, 0.0f);
+    single.indices = { 0u, 0u, 0u };
+    expectOptimizedMeshIsEquivalent(single);
+}
+
+TEST(MeshOptimizer, KeepsTheTrianglesOfARandomSoup) {
+    for(uint32_t seed = 1u; seed <= 4u; ++seed) {
+        expectOptimizedMeshIsEquivalent(makeSoup(300u, 1000u, seed));
+    }
+}
+
+TEST(MeshOptimizer, DropsUnreferencedVertices) {
+    Mesh mesh = makeGrid(4u, 4u);
+    for(uint32_t i = 0u; i < 10u; ++i) {
+        mesh.addVertex(100.0f + i, 0.0f, 0.0f);
+    }
+    optimizeMesh(mesh);
+    EXPECT_EQ(mesh.getVertexCount(), 25u);
+    for(uint32_t index : mesh.indices) {
+        EXPECT_LT(index, 25u);
+    }
+}
+
+TEST(MeshOptimizer, ImprovesTheCacheOrderOfAShuffledGrid) {
+    Mesh mesh = makeGrid(64u, 64u);
+    shuffleTriangles(mesh.indices, 7u);
+    const VertexCacheStats before = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.getVertexCount());
+
+    std::vector<uint32_t> cache_order(mesh.indices.size());
+    optimizeVertexCache(cache_order.data(), mesh.indices.data(), mesh.indices.size(), mesh.getVertexCount());
+    const VertexCacheStats after = analyzeVertexCache(cache_order.data(), cache_order.size(), mesh.getVertexCount());
+
+    EXPECT_GT(before.getAcmr(), 2.5f);
+    EXPECT_LT(after.getAcmr(), 0.8f);
+    EXPECT_LT(after.getAtvr(), 1.5f);
+}
+
+TEST(MeshOptimizer, DoesNotMakeAFanWorse) {
+    Mesh mesh = makeFan(100u);
+    const VertexCacheStats before = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.getVertexCount());
+    std::vector<uint32_t> cache_order(mesh.indices.size());
+    optimizeVertexCache(cache_order.data(), mesh.indices.data(), mesh.indices.size(), mesh.getVertexCount());
+    EXPECT_LE(analyzeVertexCache(cache_order.data(), cache_order.size(), mesh.getVertexCount()).transformed, before.transformed);
+}
+
+// The measurement quoted when the passes went in: a 120 x 120 segment sphere with shuffled triangles and one
+// degenerate triangle, put through all three passes.
+TEST(MeshOptimizer, ReproducesTheShuffledSphereNumbers) {
+    Mesh mesh = makeSphere(120u);
+    mesh.indices.insert(mesh.indices.end(), { 5u, 5u, 6u });
+    shuffleTriangles(mesh.indices, 1u);
+    const size_t source_vertex_count = mesh.getVertexCount();
+    const VertexCacheStats before = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), source_vertex_count);
+
+    std::vector<uint32_t> cache_order(mesh.indices.size());
+    optimizeVertexCache(cache_order.data(), mesh.indices.data(), mesh.indices.size(), source_vertex_count);
+    const VertexCacheStats cache_only = analyzeVertexCache(cache_order.data(), cache_order.size(), source_vertex_count);
+
+    const Mesh source = mesh;
+    optimizeMesh(mesh);
+    const VertexCacheStats after = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.getVertexCount());
+
+    EXPECT_EQ(before.triangles, 28801u);
+    EXPECT_NEAR(before.getAcmr(), 3.00f, 0.01f);
+    EXPECT_NEAR(before.getAtvr(), 5.90f, 0.01f);
+    EXPECT_NEAR(after.getAcmr(), 0.71f, 0.01f);
+    EXPECT_NEAR(after.getAtvr(), 1.40f, 0.01f);
+    // The overdraw pass gives up at most the 5% its threshold allows.
+    EXPECT_LE(after.getAcmr(), cache_only.getAcmr() * 1.05f);
+    EXPECT_EQ(getTriangleSet(mesh.vertices, mesh.indices), getTriangleSet(source.vertices, source.indices));
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include "../src/scene/scene.h"
+#include "../src/scene/nodes/bone_node.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr uint32_t CHAIN_LENGTH = 64u;
+
+    // Bone chains built side by side, every level holds one bone of each and their indices interleave.
+    std::vector<std::vector<Scene::NodeIndex>> makeChains(const std::shared_ptr<Scene>& scene, uint32_t chain_count) {
+        std::vector<std::vector<Scene::NodeIndex>> chains(chain_count);
+        for (uint32_t bone = 0u; bone < CHAIN_LENGTH; ++bone) {
+            for (uint32_t chain = 0u; chain < chain_count; ++chain) {
+                const Scene::NodeIndex parent = bone == 0u ? 0u : chains[chain].back();
+                const glm::mat4 local = glm::translate(glm::mat4(1.0f), glm::vec3(static_cast<float>(chain), 1.0f, 0.0f));
+                std::shared_ptr<BoneNode> bone_node = std::make_shared<BoneNode>(scene, "bone_" + std::to_string(chain) + "_" + std::to_string(bone), local, parent);
+                scene->addProperty(bone_node);
+                chains[chain].push_back(bone_node->VGetNodeIndex());
+            }
+        }
+        return chains;
+    }
+
+    size_t queuedCount(const Scene& scene, Scene::NodeIndex node) {
+        const Scene::NodeIndexArray& dirty_nodes = scene.getDirtyNodes(static_cast<Scene::NodeLevel>(scene.getNodeLevel(node)));
+        return static_cast<size_t>(std::count(dirty_nodes.begin(), dirty_nodes.end(), node));
+    }
+}
+
+// Touching a bone queues its whole subtree, touching every bone of a chain from the leaf up used to queue the deepest
+// bones once per ancestor. The chains are deeper than the levels queued up front.
+TEST(Scene, EveryTouchedBoneIsQueuedOnce) {
+    std::shared_ptr<Scene> scene = std::make_shared<Scene>("skeleton");
+    const std::vector<std::vector<Scene::NodeIndex>> chains = makeChains(scene, 2u);
+    ASSERT_GT(CHAIN_LENGTH, static_cast<uint32_t>(MAX_NODE_LEVEL));
+    EXPECT_TRUE(scene->recalculateGlobalTransforms());
+
+    // Second chain from the root down, first from the leaf up: the queue order differs from the index order.
+    for (Scene::NodeIndex node : chains[1]) {
+        scene->setNodeLocalTransform(node, scene->getNodeLocalTransform(node));
+    }
+    for (auto it = chains[0].rbegin(); it != chains[0].rend(); ++it) {
+        scene->setNodeLocalTransform(*it, scene->getNodeLocalTransform(*it));
+    }
+
+    size_t queued = 0u;
+    for (Scene::NodeLevel level = 0u; level <= CHAIN_LENGTH + 1u; ++level) {
+        queued += scene->getDirtyNodes(level).size();
+    }
+    EXPECT_EQ(queued, 2u * CHAIN_LENGTH);
+    for (const std::vector<Scene::NodeIndex>& chain : chains) {
+        for (Scene::NodeIndex node : chain) {
+            EXPECT_EQ(queuedCount(*scene, node), 1u) << "node " << node;
+        }
+    }
+
+    scene->sortDirtyNodes();
+    for (Scene::NodeLevel level = 1u; level <= CHAIN_LENGTH; ++level) {
+        const Scene::NodeIndexArray& dirty_nodes = scene->getDirtyNodes(level);
+        EXPECT_EQ(dirty_nodes.size(), 2u);
+        EXPECT_TRUE(std::is_sorted(dirty_nodes.begin(), dirty_nodes.end())) << "level " << level;
+    }
+
+    EXPECT_TRUE(scene->recalculateGlobalTransforms());
+    for (Scene::NodeLevel level = 0u; level <= CHAIN_LENGTH; ++level) {
+        EXPECT_TRUE(scene->getDirtyNodes(level).empty());
+    }
+    const glm::mat4& leaf = scene->getNodeGlobalTransform(chains[1].back());
+    EXPECT_FLOAT_EQ(leaf[3].x, static_cast<float>(CHAIN_LENGTH));
+    EXPECT_FLOAT_EQ(leaf[3].y, static_cast<float>(CHAIN_LENGTH));
+}
+
+// Once propagated, a new frame queues the bones again.
+TEST(Scene, NextFrameQueuesAgain) {
+    std::shared_ptr<Scene> scene = std::make_shared<Scene>("skeleton");
+    const std::vector<std::vector<Scene::NodeIndex>> chains = makeChains(scene, 1u);
+    scene->recalculateGlobalTransforms();
+
+    for (int frame = 0; frame < 3; ++frame) {
+        for (Scene::NodeIndex node : chains[0]) {
+            scene->markAsChanged(node);
+        }
+        EXPECT_EQ(queuedCount(*scene, chains[0].front()), 1u);
+        EXPECT_EQ(queuedCount(*scene, chains[0].back()), 1u);
+        EXPECT_TRUE(scene->recalculateGlobalTransforms());
+    }
+    EXPECT_FALSE(scene->recalculateGlobalTransforms());
+}
@@ -0,0 +1,274 @@
+#include <gtest/gtest.h>
+
+#include "../src/tools/texture_tools.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    using Texel = std::array<int, 4>;
+
+    // Different along both axes, for the mip chain.
+    std::vector<unsigned char> makeGradient(VkExtent2D extent) {
+        std::vector<unsigned char> rgba(static_cast<size_t>(extent.width) * extent.height * 4u);
+        for (uint32_t y = 0u; y < extent.height; ++y) {
+            for (uint32_t x = 0u; x < extent.width; ++x) {
+                unsigned char* texel = rgba.data() + (static_cast<size_t>(y) * extent.width + x) * 4u;
+                texel[0] = static_cast<unsigned char>(x * 255u / std::max(extent.width - 1u, 1u));
+                texel[1] = static_cast<unsigned char>(y * 255u / std::max(extent.height - 1u, 1u));
+                texel[2] = static_cast<unsigned char>(128u);
+                texel[3] = static_cast<unsigned char>(255u - (x + y) * 255u / std::max(extent.width + extent.height - 2u, 1u));
+            }
+        }
+        return rgba;
+    }
+
+    // Changes along x only and every channel is a linear function of x, so the texels of a block lie on a line in color
+    // space. That is what a single subset of endpoints can represent, the error is down to the quantization.
+    std::vector<unsigned char> makeRamp(VkExtent2D extent) {
+        std::vector<unsigned char> rgba(static_cast<size_t>(extent.width) * extent.height * 4u);
+        for (uint32_t y = 0u; y < extent.height; ++y) {
+            for (uint32_t x = 0u; x < extent.width; ++x) {
+                const uint32_t t = x * 255u / std::max(extent.width - 1u, 1u);
+                unsigned char* texel = rgba.data() + (static_cast<size_t>(y) * extent.width + x) * 4u;
+                texel[0] = static_cast<unsigned char>(t);
+                texel[1] = static_cast<unsigned char>(255u - t);
+                texel[2] = static_cast<unsigned char>(64u + t / 2u);
+                texel[3] = static_cast<unsigned char>(255u - t / 4u);
+            }
+        }
+        return rgba;
+    }
+
+    Texel unpackRgb565(uint16_t packed) {
+        const int r = (packed >> 11u) & 31;
+        const int g = (packed >> 5u) & 63;
+        const int b = packed & 31;
+        return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255 };
+    }
+
+    // Reference decoders, written from the block layouts rather than from the encoders. Each returns the 16 texels of
+    // the block in row order.
+    std::array<Texel, 16> decodeBc1(const unsigned char* block) {
+        const uint16_t color0 = static_cast<uint16_t>(block[0] | (block[1] << 8u));
+        const uint16_t color1 = static_cast<uint16_t>(block[2] | (block[3] << 8u));
+        Texel palette[4] = { unpackRgb565(color0), unpackRgb565(color1) };
+        for (int c = 0; c < 3; ++c) {
+            if (color0 > color1) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            } else {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+        palette[2][3] = 255;
+        palette[3][3] = color0 > color1 ? 255 : 0;
+
+        std::array<Texel, 16> texels;
+        for (uint32_t i = 0u; i < 16u; ++i) {
+            texels[i] = palette[(block[4u + i / 4u] >> ((i % 4u) * 2u)) & 3u];
+        }
+        return texels;
+    }
+
+    std::array<int, 16> decodeBc4(const unsigned char* block) {
+        int palette[8] = { block[0], block[1] };
+        for (int k = 1; k < 7; ++k) {
+            palette[k + 1] = block[0] > block[1] ? ((7 - k) * palette[0] + k * palette[1]) / 7 : 0;
+        }
+        if (block[0] <= block[1]) {
+            for (int k = 1; k < 5; ++k) {
+                palette[k + 1] = ((5 - k) * palette[0] + k * palette[1]) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t indices = 0u;
+        for (uint32_t b = 0u; b < 6u; ++b) {
+            indices |= static_cast<uint64_t>(block[2u + b]) << (b * 8u);
+        }
+        std::array<int, 16> values;
+        for (uint32_t i = 0u; i < 16u; ++i) {
+            values[i] = palette[(indices >> (i * 3u)) & 7u];
+        }
+        return values;
+    }
+
+    uint32_t readBits(const unsigned char* block, uint32_t& position, uint32_t bits) {
+        uint32_t value = 0u;
+        for (uint32_t b = 0u; b < bits; ++b, ++position) {
+            value |= ((block[position / 8u] >> (position % 8u)) & 1u) << b;
+        }
+        return value;
+    }
+
+    // Mode 6 only, the test fails on any other mode.
+    std::array<Texel, 16> decodeBc7Mode6(const unsigned char* block) {
+        static constexpr int WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        uint32_t position = 0u;
+        EXPECT_EQ(readBits(block, position, 7u), 1u << 6u);
+        int endpoints[2][4];
+        for (int c = 0; c < 4; ++c) {
+            endpoints[0][c] = static_cast<int>(readBits(block, position, 7u));
+            endpoints[1][c] = static_cast<int>(readBits(block, position, 7u));
+        }
+        for (int e = 0; e < 2; ++e) {
+            const int p_bit = static_cast<int>(readBits(block, position, 1u));
+            for (int c = 0; c < 4; ++c) endpoints[e][c] = (endpoints[e][c] << 1) | p_bit;
+        }
+
+        std::array<Texel, 16> texels;
+        for (uint32_t i = 0u; i < 16u; ++i) {
+            const uint32_t index = readBits(block, position, i == 0u ? 3u : 4u);
+            for (int c = 0; c < 4; ++c) {
+                texels[i][c] = ((64 - WEIGHTS[index]) * endpoints[0][c] + WEIGHTS[index] * endpoints[1][c] + 32) >> 6;
+            }
+        }
+        return texels;
+    }
+
+    // Largest difference over the given channels between the source and what decode() makes of each block.
+    template<typename Decode>
+    int getMaxError(const std::vector<unsigned char>& rgba, VkExtent2D extent, const std::vector<unsigned char>& compressed, uint32_t block_bytes, int first_channel, int channel_count, Decode decode) {
+        const uint32_t blocks_x = (extent.width + 3u) / 4u;
+        int max_error = 0;
+        for (uint32_t y = 0u; y < extent.height; ++y) {
+            for (uint32_t x = 0u; x < extent.width; ++x) {
+                const unsigned char* block = compressed.data() + (static_cast<size_t>(y / 4u) * blocks_x + x / 4u) * block_bytes;
+                const Texel decoded = decode(block)[(y % 4u) * 4u + x % 4u];
+                const unsigned char* source = rgba.data() + (static_cast<size_t>(y) * extent.width + x) * 4u;
+                for (int c = first_channel; c < first_channel + channel_count; ++c) {
+                    max_error = std::max(max_error, std::abs(decoded[c] - source[c]));
+                }
+            }
+        }
+        return max_error;
+    }
+}
+
+TEST(TextureTools, LevelSizesRoundUpToWholeBlocks) {
+    EXPECT_EQ(getLevelSize(VK_FORMAT_R8G8B8A8_UNORM, { 5u, 3u }), 60u);
+    EXPECT_EQ(getLevelSize(VK_FORMAT_BC1_RGBA_UNORM_BLOCK, { 5u, 3u }), 16u);
+    EXPECT_EQ(getLevelSize(VK_FORMAT_BC7_UNORM_BLOCK, { 1u, 1u }), 16u);
+    EXPECT_EQ(getLevelSize(VK_FORMAT_ASTC_6x5_UNORM_BLOCK, { 13u, 11u }), 3u * 3u * 16u);
+    EXPECT_EQ(getLevelSize(VK_FORMAT_UNDEFINED, { 4u, 4u }), 0u);
+}
+
+TEST(TextureTools, MipChainGoesDownToOneTexel) {
+    const VkExtent2D extent{ 6u, 3u };
+    const std::vector<unsigned char> rgba = makeGradient(extent);
+    const MipChain chain = buildMipChain(rgba.data(), extent);
+
+    // 6x3, 3x1, 1x1.
+    ASSERT_EQ(chain.offsets, (std::vector<VkDeviceSize>{ 0u, 72u, 84u, 88u }));
+    ASSERT_EQ(chain.data.size(), 88u);
+    EXPECT_TRUE(std::equal(rgba.begin(), rgba.end(), chain.data.begin()));
+
+    // Each texel averages a 2x2 footprint. Level 1 has a single row, which stands in for the missing second one.
+    for (uint32_t c = 0u; c < 4u; ++c) {
+        const auto texel = [&](uint32_t x, uint32_t y) -> uint32_t { return rgba[(y * extent.width + x) * 4u + c]; };
+        EXPECT_EQ(chain.data[72u + c], (texel(0u, 0u) + texel(1u, 0u) + texel(0u, 1u) + texel(1u, 1u) + 2u) / 4u) << c;
+        const uint32_t level1_x0 = chain.data[72u + c];
+        const uint32_t level1_x1 = chain.data[72u + 4u + c];
+        EXPECT_EQ(chain.data[84u + c], (2u * level1_x0 + 2u * level1_x1 + 2u) / 4u) << c;
+    }
+}
+
+TEST(TextureTools, MipChainOfASolidColorStaysThatColor) {
+    const VkExtent2D extent{ 16u, 16u };
+    std::vector<unsigned char> rgba(static_cast<size_t>(extent.width) * extent.height * 4u);
+    for (size_t i = 0u; i < rgba.size(); i += 4u) {
+        rgba[i] = 10u; rgba[i + 1u] = 20u; rgba[i + 2u] = 30u; rgba[i + 3u] = 40u;
+    }
+    const MipChain chain = buildMipChain(rgba.data(), extent);
+    ASSERT_EQ(chain.offsets.size(), 6u);
+    for (size_t i = 0u; i < chain.data.size(); i += 4u) {
+        ASSERT_EQ(chain.data[i + 3u], 40u) << i;
+        ASSERT_EQ(chain.data[i], 10u) << i;
+    }
+}
+
+TEST(TextureTools, Bc1KeepsGradients) {
+    const VkExtent2D extent{ 16u, 16u };
+    const std::vector<unsigned char> rgba = makeRamp(extent);
+    const std::vector<unsigned char> compressed = compressLevel(VK_FORMAT_BC1_RGBA_UNORM_BLOCK, rgba.data(), extent);
+    ASSERT_EQ(compressed.size(), getLevelSize(VK_FORMAT_BC1_RGBA_UNORM_BLOCK, extent));
+    EXPECT_LE(getMaxError(rgba, extent, compressed, 8u, 0, 3, decodeBc1), 8);
+}
+
+TEST(TextureTools, Bc1SolidBlocksAreExactIn565) {
+    const VkExtent2D extent{ 4u, 4u };
+    std::vector<unsigned char> rgba(64u);
+    for (size_t i = 0u; i < rgba.size(); i += 4u) {
+        rgba[i] = 255u; rgba[i + 1u] = 0u; rgba[i + 2u] = 255u; rgba[i + 3u] = 255u;
+    }
+    const std::vector<unsigned char> compressed = compressLevel(VK_FORMAT_BC1_RGB_UNORM_BLOCK, rgba.data(), extent);
+    EXPECT_EQ(getMaxError(rgba, extent, compressed, 8u, 0, 4, decodeBc1), 0);
+}
+
+TEST(TextureTools, Bc3KeepsColorAndAlpha) {
+    const VkExtent2D extent{ 12u, 8u };
+    const std::vector<unsigned char> rgba = makeRamp(extent);
+    const std::vector<unsigned char> compressed = compressLevel(VK_FORMAT_BC3_UNORM_BLOCK, rgba.data(), extent);
+    ASSERT_EQ(compressed.size(), 3u * 2u * 16u);
+
+    const auto decode_alpha = [](const unsigned char* block) {
+        const std::array<int, 16> alpha = decodeBc4(block);
+        std::array<Texel, 16> texels{};
+        for (size_t i = 0u; i < 16u; ++i) texels[i][3] = alpha[i];
+        return texels;
+    };
+    const auto decode_color = [](const unsigned char* block) { return decodeBc1(block + 8u); };
+    EXPECT_LE(getMaxError(rgba, extent, compressed, 16u, 3, 1, decode_alpha), 3);
+    EXPECT_LE(getMaxError(rgba, extent, compressed, 16u, 0, 3, decode_color), 12);
+}
+
+TEST(TextureTools, Bc5KeepsRedAndGreen) {
+    const VkExtent2D extent{ 8u, 8u };
+    const std::vector<unsigned char> rgba = makeRamp(extent);
+    const std::vector<unsigned char> compressed = compressLevel(VK_FORMAT_BC5_UNORM_BLOCK, rgba.data(), extent);
+    ASSERT_EQ(compressed.size(), 4u * 16u);
+
+    const auto decode = [](const unsigned char* block) {
+        const std::array<int, 16> red = decodeBc4(block);
+        const std::array<int, 16> green = decodeBc4(block + 8u);
+        std::array<Texel, 16> texels{};
+        for (size_t i = 0u; i < 16u; ++i) {
+            texels[i][0] = red[i];
+            texels[i][1] = green[i];
+        }
+        return texels;
+    };
+    // 36 per texel, a block spans 109 in eight values.
+    EXPECT_LE(getMaxError(rgba, extent, compressed, 16u, 0, 2, decode), 8);
+}
+
+TEST(TextureTools, Bc7Mode6KeepsGradients) {
+    const VkExtent2D extent{ 16u, 12u };
+    const std::vector<unsigned char> rgba = makeRamp(extent);
+    const std::vector<unsigned char> compressed = compressLevel(VK_FORMAT_BC7_SRGB_BLOCK, rgba.data(), extent);
+    ASSERT_EQ(compressed.size(), getLevelSize(VK_FORMAT_BC7_SRGB_BLOCK, extent));
+    EXPECT_LE(getMaxError(rgba, extent, compressed, 16u, 0, 4, decodeBc7Mode6), 4);
+}
+
+TEST(TextureTools, PartialBlocksRepeatTheBorder) {
+    // A 5x5 level takes 2x2 blocks, the texels past the border are clamped to the last row and column.
+    const VkExtent2D extent{ 5u, 5u };
+    const std::vector<unsigned char> rgba = makeRamp(extent);
+    const std::vector<unsigned char> compressed = compressLevel(VK_FORMAT_BC7_UNORM_BLOCK, rgba.data(), extent);
+    ASSERT_EQ(compressed.size(), 4u * 16u);
+    EXPECT_LE(getMaxError(rgba, extent, compressed, 16u, 0, 4, decodeBc7Mode6), 4);
+}
+
+TEST(TextureTools, UnsupportedCompressionThrows) {
+    const std::vector<unsigned char> rgba(64u, 0u);
+    EXPECT_THROW(compressLevel(VK_FORMAT_BC2_UNORM_BLOCK, rgba.data(), { 4u, 4u }), std::runtime_error);
+    EXPECT_THROW(compressLevel(VK_FORMAT_R8G8B8A8_UNORM, rgba.data(), { 4u, 4u }), std::runtime_error);
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include "../src/tools/thread_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(ThreadPool, ParallelForVisitsEveryIndexOnce) {
+    ThreadPool pool(4u);
+    std::vector<std::atomic<uint32_t>> visits(10000u);
+    pool.ParallelFor(0u, visits.size(), 16u, [&visits](size_t i) {
+        visits[i].fetch_add(1u, std::memory_order_relaxed);
+    });
+    for(const std::atomic<uint32_t>& count : visits) {
+        ASSERT_EQ(count.load(), 1u);
+    }
+}
+
+TEST(ThreadPool, ParallelForRangeBlocksCoverTheRange) {
+    ThreadPool pool(3u);
+    std::vector<uint32_t> values(5000u, 0u);
+    pool.ParallelForRange(100u, values.size(), 8u, [&values](size_t first, size_t last) {
+        std::iota(values.begin() + first, values.begin() + last, static_cast<uint32_t>(first));
+    });
+    for(size_t i = 0u; i < values.size(); ++i) {
+        ASSERT_EQ(values[i], i < 100u ? 0u : i);
+    }
+}
+
+TEST(ThreadPool, EmptyRangeDoesNotCallTheFunction) {
+    ThreadPool pool(2u);
+    bool called = false;
+    pool.ParallelForRange(10u, 10u, 1u, [&called](size_t, size_t) { called = true; });
+    EXPECT_FALSE(called);
+}
+
+// Every block throws, the calling thread's block included: one exception comes out and no task outlives the call.
+TEST(ThreadPool, ParallelForRethrowsOnTheCallingThread) {
+    ThreadPool pool(4u);
+    for(int round = 0; round < 50; ++round) {
+        EXPECT_THROW(pool.ParallelForRange(0u, 4096u, 1u, [](size_t, size_t) {
+            throw std::runtime_error("block failed !");
+        }), std::runtime_error);
+    }
+
+    std::atomic<size_t> total(0u);
+    pool.ParallelFor(0u, 1000u, 1u, [&total](size_t i) { total.fetch_add(i, std::memory_order_relaxed); });
+    EXPECT_EQ(total.load(), 999u * 1000u / 2u);
+}
+
+TEST(ThreadPool, ParallelForRethrowsFromAWorkerBlock) {
+    ThreadPool pool(4u);
+    try {
+        pool.ParallelFor(0u, 4096u, 1u, [](size_t i) {
+            if(i == 0u) throw std::runtime_error("first index !");
+        });
+        FAIL() << "ParallelFor swallowed the exception";
+    }
+    catch(const std::runtime_error& error) {
+        EXPECT_STREQ(error.what(), "first index !");
+    }
+}
+
+TEST(ThreadPool, NestedParallelForFromAWorker) {
+    ThreadPool pool(2u);
+    std::atomic<size_t> total(0u);
+    pool.ParallelFor(0u, 8u, 1u, [&pool, &total](size_t) {
+        pool.ParallelFor(0u, 100u, 1u, [&total](size_t) { total.fetch_add(1u, std::memory_order_relaxed); });
+    });
+    EXPECT_EQ(total.load(), 800u);
+}
+
+// The calling thread's block waits for a worker block to start, which only happens if the range was split.
+TEST(ThreadPool, ParallelForRangeRunsBlocksOnWorkers) {
+    ThreadPool pool(3u);
+    const std::thread::id caller = std::this_thread::get_id();
+    std::atomic<size_t> worker_blocks(0u);
+    std::atomic<size_t> blocks(0u);
+    pool.ParallelForRange(0u, 4u, 1u, [&](size_t, size_t) {
+        blocks.fetch_add(1u, std::memory_order_relaxed);
+        if(std::this_thread::get_id() != caller) {
+            worker_blocks.fetch_add(1u, std::memory_order_release);
+            return;
+        }
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while(worker_blocks.load(std::memory_order_acquire) == 0u && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+    });
+    EXPECT_EQ(blocks.load(), 4u);
+    EXPECT_GT(worker_blocks.load(), 0u);
+}
+
+// Tiny ranges finish while the workers are still completing their blocks, the call must not return before they let
+// go of the blocks and their shared state.
+TEST(ThreadPool, ParallelForReturnsAfterEveryBlockReleasedItsState) {
+    ThreadPool pool(4u);
+    for(int round = 0; round < 20000; ++round) {
+        std::atomic<size_t> total(0u);
+        pool.ParallelFor(0u, 5u, 1u, [&total](size_t i) { total.fetch_add(i, std::memory_order_relaxed); });
+        ASSERT_EQ(total.load(), 10u);
+    }
+}
@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+
+#include "../src/scene/vertex_stream_converter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace {
+    template<typename T>
+    constexpr VertexComponentType getComponentType() {
+        if constexpr (std::is_same_v<T, int8_t>) return VertexComponentType::INT8;
+        else if constexpr (std::is_same_v<T, uint8_t>) return VertexComponentType::UINT8;
+        else if constexpr (std::is_same_v<T, int16_t>) return VertexComponentType::INT16;
+        else if constexpr (std::is_same_v<T, uint16_t>) return VertexComponentType::UINT16;
+        else if constexpr (std::is_same_v<T, int32_t>) return VertexComponentType::INT32;
+        else if constexpr (std::is_same_v<T, uint32_t>) return VertexComponentType::UINT32;
+        else return VertexComponentType::FLOAT32;
+    }
+
+    // Every value of Src worth checking: both ends, zero, one and a spread in between.
+    template<typename Src>
+    std::vector<Src> getSampleValues() {
+        std::vector<Src> values = { std::numeric_limits<Src>::lowest(), std::numeric_limits<Src>::max(), Src(0), Src(1) };
+        if constexpr (std::is_signed_v<Src>) {
+            values.insert(values.end(), { Src(-1), Src(std::numeric_limits<Src>::lowest() + 1) });
+        }
+        if constexpr (sizeof(Src) <= 2u) {
+            for(int64_t value = std::numeric_limits<Src>::lowest(); value <= std::numeric_limits<Src>::max(); value += 37) {
+                values.push_back(static_cast<Src>(value));
+            }
+        }
+        else {
+            values.insert(values.end(), { Src(12345), Src(1u << 20u), Src(-7.25f) });
+        }
+        return values;
+    }
+
+    // The glTF rules: unsigned c / max, signed max(c / max, -1), anything else a plain conversion.
+    template<typename Src, typename Dst>
+    Dst getExpected(Src value, bool normalized) {
+        if constexpr (std::is_same_v<Dst, float> && std::is_integral_v<Src>) {
+            if(normalized) {
+                const float scaled = static_cast<float>(value) * (1.0f / static_cast<float>(std::numeric_limits<Src>::max()));
+                return std::is_signed_v<Src> ? std::max(scaled, -1.0f) : scaled;
+            }
+        }
+        return static_cast<Dst>(value);
+    }
+
+    // Elements of `components` values sit in a padded source stride and land between other attributes of a wider
+    // destination vertex, which must come out untouched.
+    template<typename Src, typename Dst>
+    void expectConversion(uint32_t components, bool normalized) {
+        const std::vector<Src> samples = getSampleValues<Src>();
+        const size_t count = (samples.size() + components - 1u) / components;
+        const size_t src_stride = components * sizeof(Src) + 3u;
+        const size_t dst_offset = 4u;
+        const size_t dst_stride = dst_offset + components * sizeof(Dst) + 8u;
+
+        std::vector<unsigned char> src(count * src_stride, 0xCDu);
+        for(size_t i = 0u; i < count * components; ++i) {
+            const Src value = samples[i % samples.size()];
+            memcpy(src.data() + (i / components) * src_stride + (i % components) * sizeof(Src), &value, sizeof(Src));
+        }
+
+        VertexAttributeStream stream;
+        stream.src = src.data();
+        stream.src_stride = src_stride;
+        stream.src_type = getComponentType<Src>();
+        stream.normalized = normalized;
+        stream.dst_offset = dst_offset;
+        stream.dst_type = getComponentType<Dst>();
+        stream.components = components;
+        stream.count = count;
+
+        std::vector<unsigned char> dst(count * dst_stride, 0xABu);
+        convertVertexStream(stream, dst.data(), dst_stride);
+
+        for(size_t element = 0u; element < count; ++element) {
+            const unsigned char* dst_element = dst.data() + element * dst_stride;
+            for(size_t byte = 0u; byte < dst_offset; ++byte) {
+                ASSERT_EQ(dst_element[byte], 0xABu);
+            }
+            for(uint32_t component = 0u; component < components; ++component) {
+                const Src value = samples[(element * components + component) % samples.size()];
+                Dst result;
+                memcpy(&result, dst_element + dst_offset + component * sizeof(Dst), sizeof(Dst));
+                ASSERT_EQ(result, (getExpected<Src, Dst>(value, normalized))) << "element " << element << " component " << component << " value " << +value;
+            }
+            for(size_t byte = dst_offset + components * sizeof(Dst); byte < dst_stride; ++byte) {
+                ASSERT_EQ(dst_element[byte], 0xABu);
+            }
+        }
+    }
+
+    template<typename Src, typename Dst>
+    void expectConversionForAllWidths(bool normalized) {
+        for(uint32_t components = 1u; components <= 4u; ++components) {
+            SCOPED_TRACE(components);
+            expectConversion<Src, Dst>(components, normalized);
+        }
+    }
+}
+
+TEST(VertexStreamConverter, ComponentSizes) {
+    EXPECT_EQ(getVertexComponentSize(VertexComponentType::INT8), 1u);
+    EXPECT_EQ(getVertexComponentSize(VertexComponentType::UINT16), 2u);
+    EXPECT_EQ(getVertexComponentSize(VertexComponentType::FLOAT32), 4u);
+    EXPECT_EQ(getVertexComponentSize(VertexComponentType::UNSUPPORTED), 0u);
+}
+
+TEST(VertexStreamConverter, NormalizedUnsignedToFloat) {
+    expectConversionForAllWidths<uint8_t, float>(true);
+    expectConversionForAllWidths<uint16_t, float>(true);
+}
+
+TEST(VertexStreamConverter, NormalizedSignedToFloatClampsTheLowestValue) {
+    expectConversionForAllWidths<int8_t, float>(true);
+    expectConversionForAllWidths<int16_t, float>(true);
+
+    const int8_t lowest = std::numeric_limits<int8_t>::lowest();
+    EXPECT_EQ((getExpected<int8_t, float>(lowest, true)), -1.0f);
+}
+
+TEST(VertexStreamConverter, UnnormalizedIntegersToFloat) {
+    expectConversionForAllWidths<uint8_t, float>(false);
+    expectConversionForAllWidths<int8_t, float>(false);
+    expectConversionForAllWidths<uint16_t, float>(false);
+    expectConversionForAllWidths<int16_t, float>(false);
+}
+
+TEST(VertexStreamConverter, IntegerWidening) {
+    expectConversionForAllWidths<uint8_t, uint16_t>(false);
+    expectConversionForAllWidths<uint8_t, uint32_t>(false);
+    expectConversionForAllWidths<uint16_t, uint32_t>(false);
+    expectConversionForAllWidths<int8_t, int16_t>(false);
+    expectConversionForAllWidths<int16_t, int32_t>(false);
+    // Joint indices are declared normalized by some exporters, integer destinations ignore the flag.
+    expectConversionForAllWidths<uint8_t, uint32_t>(true);
+}
+
+TEST(VertexStreamConverter, SameTypeIsCopied) {
+    expectConversionForAllWidths<float, float>(false);
+    expectConversionForAllWidths<uint16_t, uint16_t>(true);
+}
+
+TEST(VertexStreamConverter, TightlyPackedSameTypeIsCopiedInOneGo) {
+    const std::vector<float> src = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f };
+    VertexAttributeStream stream;
+    stream.src = reinterpret_cast<const unsigned char*>(src.data());
+    stream.src_stride = 3u * sizeof(float);
+    stream.src_type = VertexComponentType::FLOAT32;
+    stream.dst_type = VertexComponentType::FLOAT32;
+    stream.components = 3u;
+    stream.count = 2u;
+
+    std::vector<float> dst(6u, 0.0f);
+    convertVertexStream(stream, reinterpret_cast<unsigned char*>(dst.data()), 3u * sizeof(float));
+    EXPECT_EQ(dst, src);
+}
+
+// More than four components never take the SIMD path, so the same data through both shows they agree.
+TEST(VertexStreamConverter, SimdAndScalarPathsAgree) {
+    std::vector<uint16_t> src;
+    for(uint32_t i = 0u; i < 8u * 1000u; ++i) {
+        src.push_back(static_cast<uint16_t>(i * 2654435761u >> 16u));
+    }
+
+    VertexAttributeStream stream;
+    stream.src = reinterpret_cast<const unsigned char*>(src.data());
+    stream.src_stride = 8u * sizeof(uint16_t);
+    stream.src_type = VertexComponentType::UINT16;
+    stream.normalized = true;
+    stream.dst_type = VertexComponentType::FLOAT32;
+    stream.count = 1000u;
+
+    std::vector<float> wide(8u * 1000u);
+    stream.components = 8u;
+    convertVertexStream(stream, reinterpret_cast<unsigned char*>(wide.data()), 8u * sizeof(float));
+
+    std::vector<float> narrow(4u * 1000u);
+    stream.components = 4u;
+    convertVertexStream(stream, reinterpret_cast<unsigned char*>(narrow.data()), 4u * sizeof(float));
+
+    for(size_t element = 0u; element < 1000u; ++element) {
+        for(size_t component = 0u; component < 4u; ++component) {
+            ASSERT_EQ(narrow[element * 4u + component], wide[element * 8u + component]);
+        }
+    }
+}
+
+TEST(VertexStreamConverter, UnsupportedTypesLeaveTheDestinationAlone) {
+    const std::vector<uint8_t> src = { 1u, 2u, 3u, 4u };
+    VertexAttributeStream stream;
+    stream.src = src.data();
+    stream.src_stride = 4u;
+    stream.src_type = VertexComponentType::UNSUPPORTED;
+    stream.dst_type = VertexComponentType::FLOAT32;
+    stream.components = 4u;
+    stream.count = 1u;
+
+    std::vector<unsigned char> dst(16u, 0xABu);
+    convertVertexStream(stream, dst.data(), 16u);
+    EXPECT_EQ(dst, std::vector<unsigned char>(16u, 0xABu));
+}
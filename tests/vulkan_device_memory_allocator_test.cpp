@@ -0,0 +1,229 @@
+#include <gtest/gtest.h>
+
+#include "../src/graphics/api/vulkan_device_memory_allocator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+// masic_tests does not link the Vulkan loader, the allocator talks to this fake driver instead.
+namespace {
+    struct FakeDeviceMemory {
+        VkDeviceSize size = 0u;
+        uint32_t memory_type = 0u;
+        std::unique_ptr<uint8_t[]> host_data;
+        bool mapped = false;
+    };
+
+    std::map<VkDeviceMemory, FakeDeviceMemory> g_device_memory;
+    uintptr_t g_next_memory_handle = 1u;
+    bool g_fail_allocations = false;
+}
+
+VkResult vkAllocateMemory(VkDevice, const VkMemoryAllocateInfo* allocate_info, const VkAllocationCallbacks*, VkDeviceMemory* memory) {
+    if(g_fail_allocations) return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    *memory = reinterpret_cast<VkDeviceMemory>(g_next_memory_handle++);
+    FakeDeviceMemory& fake = g_device_memory[*memory];
+    fake.size = allocate_info->allocationSize;
+    fake.memory_type = allocate_info->memoryTypeIndex;
+    return VK_SUCCESS;
+}
+
+void vkFreeMemory(VkDevice, VkDeviceMemory memory, const VkAllocationCallbacks*) {
+    g_device_memory.erase(memory);
+}
+
+VkResult vkMapMemory(VkDevice, VkDeviceMemory memory, VkDeviceSize, VkDeviceSize, VkMemoryMapFlags, void** data) {
+    FakeDeviceMemory& fake = g_device_memory.at(memory);
+    fake.host_data = std::make_unique<uint8_t[]>(fake.size);
+    fake.mapped = true;
+    *data = fake.host_data.get();
+    return VK_SUCCESS;
+}
+
+void vkUnmapMemory(VkDevice, VkDeviceMemory memory) {
+    g_device_memory.at(memory).mapped = false;
+}
+
+namespace {
+    constexpr uint32_t DEVICE_LOCAL_TYPE = 0u;
+    constexpr uint32_t HOST_COHERENT_TYPE = 1u;
+    constexpr uint32_t HOST_NON_COHERENT_TYPE = 2u;
+    constexpr VkDeviceSize NON_COHERENT_ATOM_SIZE = 128u;
+    constexpr VkDeviceSize HOST_HEAP_SIZE = 256u * 1024u * 1024u;
+
+    VkPhysicalDeviceMemoryProperties makeMemoryProperties() {
+        VkPhysicalDeviceMemoryProperties props{};
+        props.memoryHeapCount = 2u;
+        props.memoryHeaps[0].size = 8ull * 1024u * 1024u * 1024u;
+        props.memoryHeaps[1].size = HOST_HEAP_SIZE;
+        props.memoryTypeCount = 3u;
+        props.memoryTypes[DEVICE_LOCAL_TYPE] = { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0u };
+        props.memoryTypes[HOST_COHERENT_TYPE] = { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 1u };
+        props.memoryTypes[HOST_NON_COHERENT_TYPE] = { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, 1u };
+        return props;
+    }
+
+    VkMemoryRequirements makeRequirements(VkDeviceSize size, VkDeviceSize alignment, uint32_t memory_type) {
+        VkMemoryRequirements mem_req{};
+        mem_req.size = size;
+        mem_req.alignment = alignment;
+        mem_req.memoryTypeBits = 1u << memory_type;
+        return mem_req;
+    }
+
+    bool overlaps(const DeviceAllocation& a, const DeviceAllocation& b) {
+        return a.get_memory() == b.get_memory() && a.get_offset() < b.get_offset() + b.get_size() && b.get_offset() < a.get_offset() + a.get_size();
+    }
+}
+
+class VulkanDeviceMemoryAllocatorTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        g_device_memory.clear();
+        g_fail_allocations = false;
+    }
+
+    void TearDown() override {
+        allocator.destroy();
+        EXPECT_TRUE(g_device_memory.empty());
+    }
+
+    void init(VkDeviceSize buffer_image_granularity) {
+        VkPhysicalDeviceProperties props{};
+        props.limits.bufferImageGranularity = buffer_image_granularity;
+        props.limits.nonCoherentAtomSize = NON_COHERENT_ATOM_SIZE;
+        allocator.init(reinterpret_cast<VkDevice>(uintptr_t(1u)), props, makeMemoryProperties());
+    }
+
+    DeviceAllocation allocate(VkDeviceSize size, VkDeviceSize alignment, uint32_t memory_type, VulkanDeviceMemoryAllocator::AllocationMode mode = VulkanDeviceMemoryAllocator::AllocationMode::LINEAR) {
+        DeviceAllocation allocation;
+        EXPECT_TRUE(allocator.allocate(makeRequirements(size, alignment, memory_type), 0xFFu, mode, allocation));
+        return allocation;
+    }
+
+    VulkanDeviceMemoryAllocator allocator;
+};
+
+TEST_F(VulkanDeviceMemoryAllocatorTest, SmallResourcesShareOneDeviceAllocation) {
+    init(1u);
+    std::vector<DeviceAllocation> allocations;
+    for(uint32_t i = 0u; i < 200u; ++i) {
+        allocations.push_back(allocate(200u + i * 40u, 64u, DEVICE_LOCAL_TYPE));
+        EXPECT_EQ(allocations.back().get_kind(), DeviceAllocation::Kind::SLAB);
+        EXPECT_EQ(allocations.back().get_offset() % 64u, 0u);
+    }
+    EXPECT_EQ(allocator.getDeviceAllocationCount(), 1u);
+    for(size_t i = 0u; i < allocations.size(); ++i) {
+        for(size_t j = i + 1u; j < allocations.size(); ++j) {
+            ASSERT_FALSE(overlaps(allocations[i], allocations[j])) << i << " " << j;
+        }
+    }
+
+    for(DeviceAllocation& allocation : allocations) {
+        allocator.free(allocation);
+        EXPECT_FALSE(allocation.is_valid());
+    }
+    // The last block of a pool is kept for the next request.
+    EXPECT_EQ(allocator.getDeviceAllocationCount(), 1u);
+}
+
+TEST_F(VulkanDeviceMemoryAllocatorTest, MidSizedResourcesTakeAlignedBuddyRanges) {
+    init(1u);
+    DeviceAllocation small = allocate(1000u, 256u, DEVICE_LOCAL_TYPE);
+    DeviceAllocation first = allocate(300u * 1024u, 64u * 1024u, DEVICE_LOCAL_TYPE);
+    DeviceAllocation second = allocate(1024u * 1024u, 1024u * 1024u, DEVICE_LOCAL_TYPE);
+
+    EXPECT_EQ(first.get_kind(), DeviceAllocation::Kind::BUDDY);
+    EXPECT_EQ(second.get_kind(), DeviceAllocation::Kind::BUDDY);
+    EXPECT_EQ(first.get_offset() % (64u * 1024u), 0u);
+    EXPECT_EQ(second.get_offset() % (1024u * 1024u), 0u);
+    EXPECT_FALSE(overlaps(small, first));
+    EXPECT_FALSE(overlaps(small, second));
+    EXPECT_FALSE(overlaps(first, second));
+    EXPECT_EQ(allocator.getDeviceAllocationCount(), 1u);
+
+    allocator.free(small);
+    allocator.free(first);
+    allocator.free(second);
+}
+
+TEST_F(VulkanDeviceMemoryAllocatorTest, LargeResourcesGetDedicatedAllocations) {
+    init(1u);
+    const VkDeviceSize size = VulkanDeviceMemoryAllocator::DEFAULT_BLOCK_SIZE / 2u + 1u;
+    DeviceAllocation allocation = allocate(size, 256u, DEVICE_LOCAL_TYPE);
+    EXPECT_EQ(allocation.get_kind(), DeviceAllocation::Kind::DEDICATED);
+    EXPECT_EQ(allocation.get_offset(), 0u);
+    EXPECT_EQ(g_device_memory.at(allocation.get_memory()).size, size);
+
+    allocator.free(allocation);
+    EXPECT_EQ(allocator.getDeviceAllocationCount(), 0u);
+}
+
+TEST_F(VulkanDeviceMemoryAllocatorTest, LinearAndOptimalResourcesUseSeparateBlocksAboveGranularityOne) {
+    init(1024u);
+    DeviceAllocation buffer = allocate(4096u, 256u, DEVICE_LOCAL_TYPE, VulkanDeviceMemoryAllocator::AllocationMode::LINEAR);
+    DeviceAllocation image = allocate(4096u, 256u, DEVICE_LOCAL_TYPE, VulkanDeviceMemoryAllocator::AllocationMode::OPTIMAL);
+    EXPECT_NE(buffer.get_memory(), image.get_memory());
+    EXPECT_EQ(allocator.getDeviceAllocationCount(), 2u);
+
+    allocator.free(buffer);
+    allocator.free(image);
+}
+
+TEST_F(VulkanDeviceMemoryAllocatorTest, LinearAndOptimalResourcesShareBlocksAtGranularityOne) {
+    init(1u);
+    DeviceAllocation buffer = allocate(4096u, 256u, DEVICE_LOCAL_TYPE, VulkanDeviceMemoryAllocator::AllocationMode::LINEAR);
+    DeviceAllocation image = allocate(4096u, 256u, DEVICE_LOCAL_TYPE, VulkanDeviceMemoryAllocator::AllocationMode::OPTIMAL);
+    EXPECT_EQ(buffer.get_memory(), image.get_memory());
+    EXPECT_FALSE(overlaps(buffer, image));
+    EXPECT_EQ(allocator.getDeviceAllocationCount(), 1u);
+
+    allocator.free(buffer);
+    allocator.free(image);
+}
+
+TEST_F(VulkanDeviceMemoryAllocatorTest, HostVisibleBlocksAreMappedOnce) {
+    init(1u);
+    DeviceAllocation first = allocate(512u, 16u, HOST_COHERENT_TYPE);
+    DeviceAllocation second = allocate(512u, 16u, HOST_COHERENT_TYPE);
+    ASSERT_NE(first.get_host_pointer(), nullptr);
+    EXPECT_EQ(second.get_host_pointer() - first.get_host_pointer(), static_cast<ptrdiff_t>(second.get_offset() - first.get_offset()));
+    EXPECT_TRUE(g_device_memory.at(first.get_memory()).mapped);
+
+    // Small heaps get blocks of an eighth of the heap.
+    EXPECT_EQ(g_device_memory.at(first.get_memory()).size, HOST_HEAP_SIZE / 8u);
+
+    allocator.free(first);
+    allocator.free(second);
+}
+
+TEST_F(VulkanDeviceMemoryAllocatorTest, NonCoherentMemoryIsPaddedToTheAtomSize) {
+    init(1u);
+    DeviceAllocation allocation = allocate(10u, 4u, HOST_NON_COHERENT_TYPE);
+    EXPECT_EQ(allocation.get_offset() % NON_COHERENT_ATOM_SIZE, 0u);
+    EXPECT_EQ(allocation.get_size() % NON_COHERENT_ATOM_SIZE, 0u);
+
+    VkMappedMemoryRange range = allocator.getMappedRange(allocation);
+    EXPECT_EQ(range.memory, allocation.get_memory());
+    EXPECT_EQ(range.offset, allocation.get_offset());
+    EXPECT_EQ(range.size, allocation.get_size());
+
+    allocator.free(allocation);
+}
+
+TEST_F(VulkanDeviceMemoryAllocatorTest, FailsWhenTheDeviceIsOutOfMemory) {
+    init(1u);
+    g_fail_allocations = true;
+    DeviceAllocation allocation;
+    EXPECT_FALSE(allocator.allocate(makeRequirements(256u, 256u, DEVICE_LOCAL_TYPE), 0xFFu, VulkanDeviceMemoryAllocator::AllocationMode::LINEAR, allocation));
+    EXPECT_FALSE(allocator.allocate(makeRequirements(1024u * 1024u, 256u, DEVICE_LOCAL_TYPE), 0xFFu, VulkanDeviceMemoryAllocator::AllocationMode::LINEAR, allocation));
+    EXPECT_FALSE(allocator.allocate(makeRequirements(VulkanDeviceMemoryAllocator::DEFAULT_BLOCK_SIZE, 256u, DEVICE_LOCAL_TYPE), 0xFFu, VulkanDeviceMemoryAllocator::AllocationMode::LINEAR, allocation));
+    EXPECT_EQ(allocator.getDeviceAllocationCount(), 0u);
+
+    g_fail_allocations = false;
+    EXPECT_TRUE(allocator.allocate(makeRequirements(256u, 256u, DEVICE_LOCAL_TYPE), 0xFFu, VulkanDeviceMemoryAllocator::AllocationMode::LINEAR, allocation));
+    allocator.free(allocation);
+}
@@ -0,0 +1,262 @@
+#include <gtest/gtest.h>
+
+#include "../src/graphics/api/vulkan_layout_tracker.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// masic_tests does not link the Vulkan loader, recordBarriers() talks to this fake driver instead.
+namespace {
+    struct RecordedBarrierCall {
+        bool synchronization2 = false;
+        VkPipelineStageFlags src_stages = 0u;
+        VkPipelineStageFlags dst_stages = 0u;
+        std::vector<VkImageMemoryBarrier2> image_barriers2;
+        std::vector<VkBufferMemoryBarrier2> buffer_barriers2;
+        std::vector<VkImageMemoryBarrier> image_barriers;
+        std::vector<VkBufferMemoryBarrier> buffer_barriers;
+    };
+
+    std::vector<RecordedBarrierCall> g_barrier_calls;
+}
+
+void vkCmdPipelineBarrier2(VkCommandBuffer, const VkDependencyInfo* dependency_info) {
+    RecordedBarrierCall& call = g_barrier_calls.emplace_back();
+    call.synchronization2 = true;
+    call.image_barriers2.assign(dependency_info->pImageMemoryBarriers, dependency_info->pImageMemoryBarriers + dependency_info->imageMemoryBarrierCount);
+    call.buffer_barriers2.assign(dependency_info->pBufferMemoryBarriers, dependency_info->pBufferMemoryBarriers + dependency_info->bufferMemoryBarrierCount);
+}
+
+void vkCmdPipelineBarrier(VkCommandBuffer, VkPipelineStageFlags src_stages, VkPipelineStageFlags dst_stages, VkDependencyFlags, uint32_t, const VkMemoryBarrier*,
+                          uint32_t buffer_barrier_count, const VkBufferMemoryBarrier* buffer_barriers, uint32_t image_barrier_count, const VkImageMemoryBarrier* image_barriers) {
+    RecordedBarrierCall& call = g_barrier_calls.emplace_back();
+    call.src_stages = src_stages;
+    call.dst_stages = dst_stages;
+    call.image_barriers.assign(image_barriers, image_barriers + image_barrier_count);
+    call.buffer_barriers.assign(buffer_barriers, buffer_barriers + buffer_barrier_count);
+}
+
+namespace {
+    using Access = VulkanLayoutTracker::Access;
+
+    const VkImage COLOR_TARGET = reinterpret_cast<VkImage>(uintptr_t{0x10});
+    const VkImage TEXTURE = reinterpret_cast<VkImage>(uintptr_t{0x20});
+    const VkBuffer STORAGE = reinterpret_cast<VkBuffer>(uintptr_t{0x30});
+
+    const VkImageSubresourceRange WHOLE_IMAGE{VK_IMAGE_ASPECT_COLOR_BIT, 0u, VK_REMAINING_MIP_LEVELS, 0u, VK_REMAINING_ARRAY_LAYERS};
+
+    VkImageSubresourceRange mipRange(uint32_t base_mip, uint32_t mip_count, uint32_t base_layer = 0u, uint32_t layer_count = 1u) {
+        return VkImageSubresourceRange{VK_IMAGE_ASPECT_COLOR_BIT, base_mip, mip_count, base_layer, layer_count};
+    }
+
+    void expectImageBarrier(const VkImageMemoryBarrier2& barrier, VkImage image,
+                            VkPipelineStageFlags2 src_stage, VkAccessFlags2 src_access, VkPipelineStageFlags2 dst_stage, VkAccessFlags2 dst_access,
+                            VkImageLayout old_layout, VkImageLayout new_layout, const VkImageSubresourceRange& range) {
+        EXPECT_EQ(barrier.sType, VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2);
+        EXPECT_EQ(barrier.image, image);
+        EXPECT_EQ(barrier.srcStageMask, src_stage);
+        EXPECT_EQ(barrier.srcAccessMask, src_access);
+        EXPECT_EQ(barrier.dstStageMask, dst_stage);
+        EXPECT_EQ(barrier.dstAccessMask, dst_access);
+        EXPECT_EQ(barrier.oldLayout, old_layout);
+        EXPECT_EQ(barrier.newLayout, new_layout);
+        EXPECT_EQ(barrier.srcQueueFamilyIndex, VK_QUEUE_FAMILY_IGNORED);
+        EXPECT_EQ(barrier.dstQueueFamilyIndex, VK_QUEUE_FAMILY_IGNORED);
+        EXPECT_EQ(barrier.subresourceRange.aspectMask, range.aspectMask);
+        EXPECT_EQ(barrier.subresourceRange.baseMipLevel, range.baseMipLevel);
+        EXPECT_EQ(barrier.subresourceRange.levelCount, range.levelCount);
+        EXPECT_EQ(barrier.subresourceRange.baseArrayLayer, range.baseArrayLayer);
+        EXPECT_EQ(barrier.subresourceRange.layerCount, range.layerCount);
+    }
+
+    void expectBufferBarrier(const VkBufferMemoryBarrier2& barrier, VkBuffer buffer,
+                             VkPipelineStageFlags2 src_stage, VkAccessFlags2 src_access, VkPipelineStageFlags2 dst_stage, VkAccessFlags2 dst_access,
+                             VkDeviceSize offset, VkDeviceSize size) {
+        EXPECT_EQ(barrier.sType, VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2);
+        EXPECT_EQ(barrier.buffer, buffer);
+        EXPECT_EQ(barrier.srcStageMask, src_stage);
+        EXPECT_EQ(barrier.srcAccessMask, src_access);
+        EXPECT_EQ(barrier.dstStageMask, dst_stage);
+        EXPECT_EQ(barrier.dstAccessMask, dst_access);
+        EXPECT_EQ(barrier.srcQueueFamilyIndex, VK_QUEUE_FAMILY_IGNORED);
+        EXPECT_EQ(barrier.dstQueueFamilyIndex, VK_QUEUE_FAMILY_IGNORED);
+        EXPECT_EQ(barrier.offset, offset);
+        EXPECT_EQ(barrier.size, size);
+    }
+}
+
+// A render target written by one level and sampled by the next ones, the way the render graph drives the tracker.
+TEST(VulkanLayoutTracker, AttachmentThenSampledLevels) {
+    VulkanLayoutTracker tracker;
+    tracker.registerImage(COLOR_TARGET, VK_IMAGE_ASPECT_COLOR_BIT, 4u, 2u, VK_IMAGE_LAYOUT_UNDEFINED);
+    VulkanLayoutTracker::Barriers barriers;
+
+    const Access attachment = VulkanLayoutTracker::getLayoutAccess(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    tracker.requestImage(COLOR_TARGET, WHOLE_IMAGE, attachment);
+    tracker.resolve(barriers);
+    ASSERT_EQ(barriers.image_barriers.size(), 1u); // Every mip of both layers shares one transition
+    EXPECT_TRUE(barriers.buffer_barriers.empty());
+    expectImageBarrier(barriers.image_barriers[0], COLOR_TARGET,
+        VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+        VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, mipRange(0u, 4u, 0u, 2u));
+
+    const Access sampled = VulkanLayoutTracker::getLayoutAccess(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    tracker.requestImage(COLOR_TARGET, WHOLE_IMAGE, sampled);
+    tracker.resolve(barriers);
+    ASSERT_EQ(barriers.image_barriers.size(), 1u);
+    expectImageBarrier(barriers.image_barriers[0], COLOR_TARGET,
+        VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mipRange(0u, 4u, 0u, 2u));
+    EXPECT_EQ(tracker.getImageLayout(COLOR_TARGET, 3u, 1u), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    // A second read in the same layout is already visible.
+    tracker.requestImage(COLOR_TARGET, WHOLE_IMAGE, sampled);
+    tracker.resolve(barriers);
+    EXPECT_TRUE(barriers.empty());
+
+    // Only the requested subresource moves, the transition waits for the reads of the previous levels.
+    const Access transfer_dst = VulkanLayoutTracker::getLayoutAccess(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    tracker.requestImage(COLOR_TARGET, mipRange(0u, 1u, 1u, 1u), transfer_dst);
+    tracker.resolve(barriers);
+    ASSERT_EQ(barriers.image_barriers.size(), 1u);
+    expectImageBarrier(barriers.image_barriers[0], COLOR_TARGET,
+        VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_NONE,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipRange(0u, 1u, 1u, 1u));
+    EXPECT_EQ(tracker.getImageLayout(COLOR_TARGET, 0u, 1u), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    EXPECT_EQ(tracker.getImageLayout(COLOR_TARGET, 0u, 0u), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+// One level of a mip chain blit: the source mip is read while the rest of the chain is written.
+TEST(VulkanLayoutTracker, MipChainLevelSplitsIntoRuns) {
+    VulkanLayoutTracker tracker;
+    tracker.registerImage(TEXTURE, VK_IMAGE_ASPECT_COLOR_BIT, 3u, 1u, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    const Access transfer_dst = VulkanLayoutTracker::getLayoutAccess(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    tracker.setImageState(TEXTURE, WHOLE_IMAGE, transfer_dst);
+
+    tracker.requestImage(TEXTURE, mipRange(0u, 1u), VulkanLayoutTracker::getLayoutAccess(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL));
+    tracker.requestImage(TEXTURE, mipRange(1u, 2u), transfer_dst);
+    VulkanLayoutTracker::Barriers barriers;
+    tracker.resolve(barriers);
+
+    ASSERT_EQ(barriers.image_barriers.size(), 2u);
+    expectImageBarrier(barriers.image_barriers[0], TEXTURE,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, mipRange(0u, 1u));
+    expectImageBarrier(barriers.image_barriers[1], TEXTURE,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipRange(1u, 2u));
+}
+
+TEST(VulkanLayoutTracker, ConflictingLayoutsDropTheBatch) {
+    VulkanLayoutTracker tracker;
+    tracker.registerImage(TEXTURE, VK_IMAGE_ASPECT_COLOR_BIT, 1u, 1u, VK_IMAGE_LAYOUT_UNDEFINED);
+    tracker.requestImage(TEXTURE, WHOLE_IMAGE, VulkanLayoutTracker::getLayoutAccess(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+    tracker.requestImage(TEXTURE, WHOLE_IMAGE, VulkanLayoutTracker::getLayoutAccess(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL));
+
+    VulkanLayoutTracker::Barriers barriers;
+    EXPECT_THROW(tracker.resolve(barriers), std::runtime_error);
+    EXPECT_EQ(tracker.getImageLayout(TEXTURE), VK_IMAGE_LAYOUT_UNDEFINED);
+
+    tracker.resolve(barriers);
+    EXPECT_TRUE(barriers.empty());
+}
+
+// A compute level writes the first half of a buffer, a vertex level reads all of it, a transfer level overwrites the
+// middle. Only ranges with a hazard get a barrier and each barrier waits for exactly what touched its range.
+TEST(VulkanLayoutTracker, BufferRangesAcrossLevels) {
+    VulkanLayoutTracker tracker;
+    tracker.registerBuffer(STORAGE, 1024u);
+    VulkanLayoutTracker::Barriers barriers;
+
+    tracker.requestBuffer(STORAGE, 0u, 512u, Access{VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT});
+    tracker.resolve(barriers);
+    EXPECT_TRUE(barriers.empty()); // Nothing touched the buffer before
+
+    tracker.requestBuffer(STORAGE, 0u, VK_WHOLE_SIZE, Access{VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT, VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT});
+    tracker.resolve(barriers);
+    EXPECT_TRUE(barriers.image_barriers.empty());
+    ASSERT_EQ(barriers.buffer_barriers.size(), 1u);
+    expectBufferBarrier(barriers.buffer_barriers[0], STORAGE,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT, VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT, 0u, 512u);
+
+    tracker.requestBuffer(STORAGE, 256u, 512u, Access{VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT});
+    tracker.resolve(barriers);
+    ASSERT_EQ(barriers.buffer_barriers.size(), 2u);
+    expectBufferBarrier(barriers.buffer_barriers[0], STORAGE,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, 256u, 256u);
+    expectBufferBarrier(barriers.buffer_barriers[1], STORAGE,
+        VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT, VK_ACCESS_2_NONE,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, 512u, 256u);
+}
+
+TEST(VulkanLayoutTracker, UnregisterDropsStateAndPendingRequests) {
+    VulkanLayoutTracker tracker;
+    tracker.registerImage(TEXTURE, VK_IMAGE_ASPECT_COLOR_BIT, 1u, 1u, VK_IMAGE_LAYOUT_UNDEFINED);
+    tracker.registerBuffer(STORAGE, 64u);
+    tracker.requestImage(TEXTURE, WHOLE_IMAGE, VulkanLayoutTracker::getLayoutAccess(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL));
+    tracker.requestBuffer(STORAGE, 0u, VK_WHOLE_SIZE, Access{VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT});
+
+    tracker.unregisterImage(TEXTURE);
+    tracker.unregisterBuffer(STORAGE);
+    EXPECT_FALSE(tracker.isImageRegistered(TEXTURE));
+    EXPECT_FALSE(tracker.isBufferRegistered(STORAGE));
+
+    VulkanLayoutTracker::Barriers barriers;
+    tracker.resolve(barriers);
+    EXPECT_TRUE(barriers.empty());
+    EXPECT_THROW(tracker.requestImage(TEXTURE, WHOLE_IMAGE, Access{}), std::runtime_error);
+
+    // A new resource reusing the handle starts from its own initial layout.
+    tracker.registerImage(TEXTURE, VK_IMAGE_ASPECT_COLOR_BIT, 1u, 1u, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    EXPECT_EQ(tracker.getImageLayout(TEXTURE), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+}
+
+TEST(VulkanLayoutTracker, RecordsOneBarrierCommandPerLevel) {
+    VulkanLayoutTracker tracker;
+    tracker.registerImage(COLOR_TARGET, VK_IMAGE_ASPECT_COLOR_BIT, 1u, 1u, VK_IMAGE_LAYOUT_UNDEFINED);
+    tracker.registerBuffer(STORAGE, 256u);
+    tracker.requestBuffer(STORAGE, 0u, VK_WHOLE_SIZE, Access{VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT});
+    VulkanLayoutTracker::Barriers barriers;
+    tracker.resolve(barriers);
+
+    tracker.requestImage(COLOR_TARGET, WHOLE_IMAGE, VulkanLayoutTracker::getLayoutAccess(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+    tracker.requestBuffer(STORAGE, 0u, VK_WHOLE_SIZE, Access{VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT, VK_ACCESS_2_UNIFORM_READ_BIT});
+    tracker.resolve(barriers);
+    ASSERT_EQ(barriers.image_barriers.size(), 1u);
+    ASSERT_EQ(barriers.buffer_barriers.size(), 1u);
+
+    g_barrier_calls.clear();
+    VulkanLayoutTracker::recordBarriers(VK_NULL_HANDLE, barriers, true);
+    VulkanLayoutTracker::recordBarriers(VK_NULL_HANDLE, barriers, false);
+    VulkanLayoutTracker::recordBarriers(VK_NULL_HANDLE, VulkanLayoutTracker::Barriers{}, true);
+    ASSERT_EQ(g_barrier_calls.size(), 2u);
+
+    const RecordedBarrierCall& sync2 = g_barrier_calls[0];
+    EXPECT_TRUE(sync2.synchronization2);
+    ASSERT_EQ(sync2.image_barriers2.size(), 1u);
+    ASSERT_EQ(sync2.buffer_barriers2.size(), 1u);
+    EXPECT_EQ(sync2.image_barriers2[0].newLayout, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    EXPECT_EQ(sync2.buffer_barriers2[0].srcAccessMask, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+
+    // The synchronization1 fallback merges the stage masks into the command.
+    const RecordedBarrierCall& sync1 = g_barrier_calls[1];
+    EXPECT_FALSE(sync1.synchronization2);
+    EXPECT_EQ(sync1.src_stages, static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_2_TRANSFER_BIT));
+    EXPECT_EQ(sync1.dst_stages, static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT));
+    ASSERT_EQ(sync1.image_barriers.size(), 1u);
+    ASSERT_EQ(sync1.buffer_barriers.size(), 1u);
+    EXPECT_EQ(sync1.image_barriers[0].sType, VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER);
+    EXPECT_EQ(sync1.image_barriers[0].oldLayout, VK_IMAGE_LAYOUT_UNDEFINED);
+    EXPECT_EQ(sync1.image_barriers[0].newLayout, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    EXPECT_EQ(sync1.image_barriers[0].srcAccessMask, 0u);
+    EXPECT_EQ(sync1.buffer_barriers[0].srcAccessMask, static_cast<VkAccessFlags>(VK_ACCESS_2_TRANSFER_WRITE_BIT));
+    EXPECT_EQ(sync1.buffer_barriers[0].dstAccessMask, static_cast<VkAccessFlags>(VK_ACCESS_2_UNIFORM_READ_BIT));
+}
@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+
+#include "../src/graphics/api/vulkan_texture_residency.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    using Step = VulkanTextureResidency::Step;
+    using StepType = VulkanTextureResidency::StepType;
+    using State = VulkanTextureResidency::State;
+
+    constexpr VkDeviceSize PLACEHOLDER_SIZE = 4u;
+
+    // RGBA8 levels of a square texture down to 1x1.
+    std::vector<VkDeviceSize> chainOffsets(uint32_t extent) {
+        std::vector<VkDeviceSize> offsets{ 0u };
+        for(uint32_t level_extent = extent; level_extent > 0u; level_extent >>= 1u) {
+            offsets.push_back(offsets.back() + VkDeviceSize{ level_extent } * level_extent * 4u);
+        }
+        return offsets;
+    }
+
+    VkDeviceSize fullSize(uint32_t extent) {
+        return chainOffsets(extent).back();
+    }
+
+    // Levels of at most TAIL_EXTENT.
+    VkDeviceSize tailSize(uint32_t extent) {
+        const std::vector<VkDeviceSize> offsets = chainOffsets(extent);
+        size_t first_mip = 0u;
+        while((extent >> first_mip) > VulkanTextureResidency::TAIL_EXTENT) ++first_mip;
+        return offsets.back() - offsets[first_mip];
+    }
+
+    size_t addDecoded(VulkanTextureResidency& residency, uint32_t extent) {
+        const size_t texture = residency.add(PLACEHOLDER_SIZE);
+        residency.decoded(texture, chainOffsets(extent), { extent, extent });
+        return texture;
+    }
+
+    std::vector<Step> runFrame(VulkanTextureResidency& residency) {
+        std::vector<Step> steps;
+        residency.beginFrame();
+        residency.update(steps);
+        return steps;
+    }
+
+    size_t countSteps(const std::vector<Step>& steps, StepType type) {
+        return static_cast<size_t>(std::count_if(steps.begin(), steps.end(), [type](const Step& step) { return step.type == type; }));
+    }
+}
+
+TEST(VulkanTextureResidency, TailThenFullChain) {
+    VulkanTextureResidency residency;
+    residency.init(VkDeviceSize{ 1u } << 30u, VkDeviceSize{ 1u } << 30u);
+    const size_t texture = addDecoded(residency, 256u);
+    EXPECT_EQ(residency.getState(texture), State::PLACEHOLDER);
+
+    // 256 and 128 are over TAIL_EXTENT, the tail starts at level 2.
+    EXPECT_EQ(runFrame(residency), (std::vector<Step>{ { StepType::UPLOAD_TAIL, texture, 2u }, { StepType::BEGIN_PROMOTION, texture, 0u } }));
+    EXPECT_EQ(residency.getState(texture), State::TAIL);
+
+    // The pending chain is a new image, it is filled from its smallest level up and then replaces the tail.
+    std::vector<Step> expected;
+    for(uint32_t mip = 9u; mip > 0u; --mip) {
+        expected.push_back({ StepType::UPLOAD_LEVEL, texture, mip - 1u });
+    }
+    expected.push_back({ StepType::COMPLETE_PROMOTION, texture, 0u });
+    EXPECT_EQ(runFrame(residency), expected);
+    EXPECT_EQ(residency.getState(texture), State::FULL);
+    EXPECT_EQ(residency.getStats().promotions, 1u);
+    EXPECT_EQ(residency.getStats().full_resident, 1u);
+    EXPECT_EQ(residency.getStats().resident_bytes, fullSize(256u) + tailSize(256u));
+
+    EXPECT_TRUE(runFrame(residency).empty());
+}
+
+TEST(VulkanTextureResidency, SmallTextureIsCompleteWithItsTail) {
+    VulkanTextureResidency residency;
+    residency.init(VkDeviceSize{ 1u } << 30u, VkDeviceSize{ 1u } << 30u);
+    const size_t texture = addDecoded(residency, 32u);
+
+    EXPECT_EQ(runFrame(residency), (std::vector<Step>{ { StepType::UPLOAD_TAIL, texture, 0u } }));
+    EXPECT_EQ(residency.getState(texture), State::FULL);
+    EXPECT_EQ(residency.getStats().promotions, 0u);
+    EXPECT_TRUE(runFrame(residency).empty());
+}
+
+TEST(VulkanTextureResidency, FailedDecodeKeepsThePlaceholder) {
+    VulkanTextureResidency residency;
+    residency.init(VkDeviceSize{ 1u } << 30u, VkDeviceSize{ 1u } << 30u);
+    const size_t texture = residency.add(PLACEHOLDER_SIZE);
+    residency.decoded(texture, {}, {});
+
+    EXPECT_TRUE(runFrame(residency).empty());
+    EXPECT_EQ(residency.getState(texture), State::PLACEHOLDER);
+    EXPECT_EQ(residency.getStats().resident_bytes, PLACEHOLDER_SIZE);
+    EXPECT_THROW(residency.decoded(texture + 1u, {}, {}), std::runtime_error);
+}
+
+TEST(VulkanTextureResidency, UploadsStayWithinTheFrameBudget) {
+    const VkDeviceSize frame_budget = 2u * tailSize(256u) + 1024u;
+    VulkanTextureResidency residency;
+    residency.init(frame_budget, VkDeviceSize{ 1u } << 30u);
+    for(size_t i = 0u; i < 3u; ++i) {
+        addDecoded(residency, 256u);
+    }
+
+    // Two tails fit, the third waits for the next frame.
+    std::vector<Step> steps = runFrame(residency);
+    EXPECT_EQ(countSteps(steps, StepType::UPLOAD_TAIL), 2u);
+    EXPECT_EQ(residency.getStats().uploaded_bytes, 2u * tailSize(256u));
+    EXPECT_EQ(residency.getState(2u), State::PLACEHOLDER);
+
+    steps = runFrame(residency);
+    EXPECT_EQ(steps.front(), (Step{ StepType::UPLOAD_TAIL, 2u, 2u }));
+    EXPECT_EQ(residency.getState(2u), State::TAIL);
+
+    // Level 0 is over the budget alone, it still goes as the only upload of a frame.
+    size_t level0_uploads = 0u;
+    for(int frame = 0; frame < 32 && residency.getStats().promotions < 3u; ++frame) {
+        steps = runFrame(residency);
+        for(const Step& step : steps) {
+            if(step.type == StepType::UPLOAD_LEVEL && step.mip == 0u) {
+                ++level0_uploads;
+                EXPECT_EQ(residency.getStats().uploaded_bytes, fullSize(256u) - fullSize(128u));
+            }
+        }
+        EXPECT_TRUE(residency.getStats().uploaded_bytes <= frame_budget || countSteps(steps, StepType::UPLOAD_LEVEL) == 1u);
+    }
+    EXPECT_EQ(level0_uploads, 3u);
+    EXPECT_EQ(residency.getStats().full_resident, 3u);
+}
+
+// Only the full chains unused for DEMOTE_AFTER_FRAMES frames are demoted, least recently used first, and only as many
+// as the new promotion needs.
+TEST(VulkanTextureResidency, DemotesLeastRecentlyUsedFirst) {
+    const VkDeviceSize full_resident = fullSize(256u) + tailSize(256u);
+    // Three full chains fit, a fourth one only after two of them went back to their tail.
+    const VkDeviceSize resident_budget = 3u * full_resident + tailSize(256u) - 1u;
+    VulkanTextureResidency residency;
+    residency.init(VkDeviceSize{ 1u } << 30u, resident_budget);
+    for(size_t i = 0u; i < 3u; ++i) {
+        addDecoded(residency, 256u);
+    }
+    runFrame(residency);
+    runFrame(residency);
+    ASSERT_EQ(residency.getStats().full_resident, 3u);
+
+    runFrame(residency);
+    residency.touch(2u);
+    runFrame(residency);
+    residency.touch(0u);
+    while(residency.getFrame() < 2u * VulkanTextureResidency::DEMOTE_AFTER_FRAMES) {
+        EXPECT_TRUE(runFrame(residency).empty());
+        residency.touch(1u);
+    }
+
+    const size_t texture = addDecoded(residency, 256u);
+    EXPECT_EQ(runFrame(residency), (std::vector<Step>{
+        { StepType::UPLOAD_TAIL, texture, 2u },
+        { StepType::DEMOTE, 2u, 0u },
+        { StepType::DEMOTE, 0u, 0u },
+        { StepType::BEGIN_PROMOTION, texture, 0u }
+    }));
+    EXPECT_EQ(residency.getState(0u), State::TAIL);
+    EXPECT_EQ(residency.getState(1u), State::FULL);
+    EXPECT_EQ(residency.getState(2u), State::TAIL);
+    EXPECT_EQ(residency.getStats().demotions, 2u);
+    EXPECT_LE(residency.getStats().resident_bytes, resident_budget);
+
+    runFrame(residency);
+    EXPECT_EQ(residency.getState(texture), State::FULL);
+    EXPECT_LE(residency.getStats().resident_bytes, resident_budget);
+}
+
+// A demoted texture is not promoted again until it is used, then it is decoded again and waits for room in the budget.
+TEST(VulkanTextureResidency, DemotedTextureComesBackWhenUsed) {
+    const VkDeviceSize resident_budget = fullSize(256u) + 2u * tailSize(256u) + PLACEHOLDER_SIZE;
+    VulkanTextureResidency residency;
+    residency.init(VkDeviceSize{ 1u } << 30u, resident_budget);
+    const size_t first = addDecoded(residency, 256u);
+    runFrame(residency);
+    runFrame(residency);
+    ASSERT_EQ(residency.getState(first), State::FULL);
+
+    // Nothing to make room for, the unused chain stays.
+    while(residency.getFrame() < VulkanTextureResidency::DEMOTE_AFTER_FRAMES + 2u) {
+        EXPECT_TRUE(runFrame(residency).empty());
+    }
+    EXPECT_EQ(residency.getState(first), State::FULL);
+
+    const size_t second = addDecoded(residency, 256u);
+    std::vector<Step> steps = runFrame(residency);
+    EXPECT_EQ(countSteps(steps, StepType::DEMOTE), 1u);
+    EXPECT_EQ(residency.getState(first), State::TAIL);
+    runFrame(residency);
+    EXPECT_EQ(residency.getState(second), State::FULL);
+
+    for(int frame = 0; frame < 10; ++frame) {
+        EXPECT_TRUE(runFrame(residency).empty());
+    }
+
+    // Its levels were dropped once it was full, used again it is decoded first.
+    residency.touch(first);
+    EXPECT_EQ(runFrame(residency), (std::vector<Step>{ { StepType::DECODE, first, 0u } }));
+    residency.decoded(first, chainOffsets(256u), { 256u, 256u });
+
+    // The second chain is recent, the first one waits until it is unused for long enough.
+    size_t decodes = 0u;
+    size_t demotions = 0u;
+    for(int frame = 0; frame < 2 * static_cast<int>(VulkanTextureResidency::DEMOTE_AFTER_FRAMES) && residency.getState(first) != State::FULL; ++frame) {
+        residency.touch(first);
+        steps = runFrame(residency);
+        decodes += countSteps(steps, StepType::DECODE);
+        demotions += countSteps(steps, StepType::DEMOTE);
+    }
+    EXPECT_EQ(decodes, 0u);
+    EXPECT_EQ(demotions, 1u);
+    EXPECT_EQ(residency.getState(first), State::FULL);
+    EXPECT_EQ(residency.getState(second), State::TAIL);
+    EXPECT_EQ(residency.getStats().promotions, 3u);
+}